@@ -0,0 +1,267 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "disk/disk.h"
+#include "fs/fs.h"
+#include "fatfs/ff.h"
+
+/*
+ * FatFs file I/O benchmarks.
+ *
+ * The file system lives on a RAM disk.  Each disk transfer busy-waits for a
+ * fixed cost plus a cost per sector, which approximates an SD card on an SPI
+ * bus: issuing a command costs far more than moving one more sector.  Build
+ * with FATFS_CACHE_SECTORS set to 0 to compare against uncached access.
+ */
+
+#define BENCH_SECTOR_SZ         512
+#define BENCH_DISK_SIZE         MYNEWT_VAL(FATFS_BENCH_DISK_SIZE)
+#define BENCH_FILE_SIZE         MYNEWT_VAL(FATFS_BENCH_FILE_SIZE)
+#define BENCH_RANDOM_OPS        MYNEWT_VAL(FATFS_BENCH_RANDOM_OPS)
+#define BENCH_SEQ_CHUNK_SZ      4096
+#define BENCH_RANDOM_CHUNK_SZ   512
+
+static const char bench_path[] = "ram0:/bench.dat";
+
+static uint8_t bench_disk[BENCH_DISK_SIZE];
+static uint8_t bench_buf[BENCH_SEQ_CHUNK_SZ];
+static uint32_t bench_xfers;
+static uint32_t bench_seed;
+
+static void
+bench_disk_delay(uint32_t len)
+{
+    os_cputime_delay_usecs(MYNEWT_VAL(FATFS_BENCH_XFER_USECS) +
+                           len / BENCH_SECTOR_SZ *
+                           MYNEWT_VAL(FATFS_BENCH_SECTOR_USECS));
+    bench_xfers++;
+}
+
+static int
+bench_disk_read(uint8_t id, uint32_t addr, void *buf, uint32_t len)
+{
+    if (addr + len > BENCH_DISK_SIZE) {
+        return DISK_EHW;
+    }
+
+    bench_disk_delay(len);
+    memcpy(buf, bench_disk + addr, len);
+
+    return 0;
+}
+
+static int
+bench_disk_write(uint8_t id, uint32_t addr, const void *buf, uint32_t len)
+{
+    if (addr + len > BENCH_DISK_SIZE) {
+        return DISK_EHW;
+    }
+
+    bench_disk_delay(len);
+    memcpy(bench_disk + addr, buf, len);
+
+    return 0;
+}
+
+static int
+bench_disk_ioctl(uint8_t id, uint32_t cmd, void *arg)
+{
+    switch (cmd) {
+    case DISK_IOCTL_SYNC:
+        return 0;
+
+    case DISK_IOCTL_GET_SIZE:
+        *(uint32_t *)arg = BENCH_DISK_SIZE;
+        return 0;
+
+    default:
+        return DISK_EHW;
+    }
+}
+
+static struct disk_ops bench_disk_ops = {
+    .read = bench_disk_read,
+    .write = bench_disk_write,
+    .ioctl = bench_disk_ioctl,
+};
+
+static uint32_t
+bench_rand(void)
+{
+    bench_seed = bench_seed * 1103515245 + 12345;
+    return bench_seed >> 8;
+}
+
+static void
+bench_report(const char *name, uint32_t iters, uint32_t ticks)
+{
+    uint64_t nsecs;
+
+    nsecs = (uint64_t)os_cputime_ticks_to_usecs(ticks) * 1000;
+    console_printf("%-24s %8" PRIu32 " iters %10" PRIu32 " ns/iter "
+                   "%6" PRIu32 ".%02" PRIu32 " xfers/iter\n",
+                   name, iters, (uint32_t)(nsecs / iters),
+                   bench_xfers / iters, bench_xfers * 100 / iters % 100);
+}
+
+static int
+bench_format(void)
+{
+    static uint8_t work[_MAX_SS * 4];
+    struct fs_dir *dir;
+    FRESULT res;
+
+    if (disk_register("ram0", "fatfs", &bench_disk_ops) != 0) {
+        return SYS_EUNKNOWN;
+    }
+
+    /* The first access through the file system API attaches the disk to
+     * FatFs as drive 0.  It fails, as the disk is not formatted yet.
+     */
+    if (fs_opendir("ram0:/", &dir) == 0) {
+        fs_closedir(dir);
+    }
+
+    /* Use 4 KB clusters, as on a typical SD card. */
+    res = f_mkfs("0:", FM_ANY, 4096, work, sizeof work);
+    if (res != FR_OK) {
+        console_printf("fatfs_bench: f_mkfs failed; res=%d\n", res);
+        return SYS_EUNKNOWN;
+    }
+
+    return 0;
+}
+
+static void
+bench_seq(void)
+{
+    struct fs_file *file;
+    uint32_t bytes_read;
+    uint32_t start;
+    uint32_t off;
+    int rc;
+
+    bench_xfers = 0;
+    start = os_cputime_get32();
+
+    rc = fs_open(bench_path, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+    assert(rc == 0);
+    for (off = 0; off < BENCH_FILE_SIZE; off += BENCH_SEQ_CHUNK_SZ) {
+        memset(bench_buf, off / BENCH_SEQ_CHUNK_SZ, sizeof bench_buf);
+        rc = fs_write(file, bench_buf, BENCH_SEQ_CHUNK_SZ);
+        assert(rc == 0);
+    }
+    rc = fs_close(file);
+    assert(rc == 0);
+
+    bench_report("seq_write_4k", BENCH_FILE_SIZE / BENCH_SEQ_CHUNK_SZ,
+                 os_cputime_get32() - start);
+
+    bench_xfers = 0;
+    start = os_cputime_get32();
+
+    rc = fs_open(bench_path, FS_ACCESS_READ, &file);
+    assert(rc == 0);
+    for (off = 0; off < BENCH_FILE_SIZE; off += BENCH_SEQ_CHUNK_SZ) {
+        rc = fs_read(file, BENCH_SEQ_CHUNK_SZ, bench_buf, &bytes_read);
+        assert(rc == 0 && bytes_read == BENCH_SEQ_CHUNK_SZ);
+        assert(bench_buf[0] == (uint8_t)(off / BENCH_SEQ_CHUNK_SZ));
+    }
+    rc = fs_close(file);
+    assert(rc == 0);
+
+    bench_report("seq_read_4k", BENCH_FILE_SIZE / BENCH_SEQ_CHUNK_SZ,
+                 os_cputime_get32() - start);
+}
+
+static void
+bench_random(void)
+{
+    struct fs_file *file;
+    uint32_t bytes_read;
+    uint32_t start;
+    uint32_t off;
+    int rc;
+    int i;
+
+    rc = fs_open(bench_path, FS_ACCESS_READ | FS_ACCESS_WRITE, &file);
+    assert(rc == 0);
+
+    bench_seed = 1;
+    bench_xfers = 0;
+    start = os_cputime_get32();
+    for (i = 0; i < BENCH_RANDOM_OPS; i++) {
+        off = bench_rand() % (BENCH_FILE_SIZE - BENCH_RANDOM_CHUNK_SZ);
+        rc = fs_seek(file, off);
+        assert(rc == 0);
+        rc = fs_read(file, BENCH_RANDOM_CHUNK_SZ, bench_buf, &bytes_read);
+        assert(rc == 0 && bytes_read == BENCH_RANDOM_CHUNK_SZ);
+    }
+    bench_report("random_read_512", BENCH_RANDOM_OPS,
+                 os_cputime_get32() - start);
+
+    bench_xfers = 0;
+    start = os_cputime_get32();
+    for (i = 0; i < BENCH_RANDOM_OPS; i++) {
+        off = bench_rand() % (BENCH_FILE_SIZE - BENCH_RANDOM_CHUNK_SZ);
+        rc = fs_seek(file, off);
+        assert(rc == 0);
+        rc = fs_write(file, bench_buf, BENCH_RANDOM_CHUNK_SZ);
+        assert(rc == 0);
+    }
+    rc = fs_flush(file);
+    assert(rc == 0);
+    bench_report("random_write_512", BENCH_RANDOM_OPS,
+                 os_cputime_get32() - start);
+
+    rc = fs_close(file);
+    assert(rc == 0);
+}
+
+/**
+ * main
+ *
+ * Runs every benchmark once from the main task, then goes idle.
+ *
+ * @return int NOTE: this function should never return!
+ */
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    console_printf("fatfs_bench: start (%d cached sectors)\n",
+                   MYNEWT_VAL(FATFS_CACHE_SECTORS));
+    if (bench_format() == 0) {
+        bench_seq();
+        bench_random();
+    }
+    console_printf("fatfs_bench: done\n");
+
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+    assert(0);
+
+    return 0;
+}
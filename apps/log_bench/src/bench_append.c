@@ -0,0 +1,89 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "log/log.h"
+#include "log_bench.h"
+
+/*
+ * Log append benchmark.
+ *
+ * Times appends to an empty log until it reaches its last sector, first
+ * with every entry written to flash as it is logged and then with entries
+ * staged in RAM and committed in groups.  The group run includes the final
+ * commit.
+ */
+
+#define BENCH_APPEND_BODY_LEN   MYNEWT_VAL(LOG_BENCH_BODY_LEN)
+#define BENCH_APPEND_GROUP_BUF  MYNEWT_VAL(LOG_BENCH_GROUP_BUF)
+#define BENCH_APPEND_GROUP_CNT  MYNEWT_VAL(LOG_BENCH_GROUP_ENTRIES)
+
+static uint8_t bench_append_buf[BENCH_APPEND_GROUP_BUF];
+static uint16_t bench_append_lens[BENCH_APPEND_GROUP_CNT];
+static struct fcb_entry bench_append_locs[BENCH_APPEND_GROUP_CNT];
+
+static void
+bench_append_time(const char *name)
+{
+    uint8_t body[BENCH_APPEND_BODY_LEN];
+    uint32_t iters;
+    uint32_t start;
+    struct fcb *fcb;
+    int rc;
+
+    rc = log_flush(&log_bench_log);
+    assert(rc == 0);
+
+    fcb = &log_bench_fcb_log.fl_fcb;
+    memset(body, 0xa5, sizeof body);
+    iters = 0;
+
+    start = os_cputime_get32();
+    while (fcb->f_active.fe_area - log_bench_sectors <
+           log_bench_sector_cnt - 1) {
+        rc = log_append_body(&log_bench_log, LOG_MODULE_DEFAULT,
+                             LOG_LEVEL_INFO, LOG_ETYPE_BINARY, body,
+                             sizeof body);
+        assert(rc == 0);
+        iters++;
+    }
+    rc = log_fcb_commit(&log_bench_log);
+    assert(rc == 0);
+
+    log_bench_report(name, iters, os_cputime_get32() - start);
+}
+
+void
+log_bench_append(void)
+{
+    int rc;
+
+    bench_append_time("append_direct");
+
+    rc = log_fcb_init_group(&log_bench_fcb_log, bench_append_buf,
+                            sizeof bench_append_buf, bench_append_locs,
+                            bench_append_lens, BENCH_APPEND_GROUP_CNT, 0);
+    assert(rc == 0);
+
+    bench_append_time("append_group");
+}
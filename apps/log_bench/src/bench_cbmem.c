@@ -0,0 +1,224 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "cbmem/cbmem.h"
+#include "log_bench.h"
+
+/*
+ * RAM ring benchmark.
+ *
+ * Times appends to a mutex-protected cbmem and to a lock-free cbmem_lf, in
+ * single- and multi-writer mode, from the main task.  The contended runs
+ * split the same number of appends between several tasks which yield to
+ * each other every few hundred appends, so that appends in progress are
+ * regularly preempted; the reported time is the wall clock time of the whole
+ * run divided by the total number of appends.  Finally, every entry left in
+ * each ring is walked and read.
+ */
+
+#define BENCH_CBMEM_ENTRIES     MYNEWT_VAL(LOG_BENCH_CBMEM_ENTRIES)
+#define BENCH_CBMEM_BODY_LEN    MYNEWT_VAL(LOG_BENCH_BODY_LEN)
+#define BENCH_CBMEM_BUF_SIZE    4096
+#define BENCH_CBMEM_TASKS       3
+#define BENCH_CBMEM_BASE_PRIO   64
+#define BENCH_CBMEM_YIELD_EVERY 256
+#define BENCH_CBMEM_STACK_SIZE  OS_STACK_ALIGN(512)
+
+static uint8_t bench_cbmem_buf[BENCH_CBMEM_BUF_SIZE];
+static struct cbmem bench_cbmem;
+static struct cbmem_lf bench_cbmem_lf;
+
+static uint8_t bench_cbmem_body[BENCH_CBMEM_BODY_LEN];
+
+static struct os_task bench_cbmem_tasks[BENCH_CBMEM_TASKS];
+static os_stack_t
+bench_cbmem_stacks[BENCH_CBMEM_TASKS][BENCH_CBMEM_STACK_SIZE];
+static struct os_sem bench_cbmem_sem;
+static int bench_cbmem_use_lf;
+
+static void
+bench_cbmem_run(int iters, int idx)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i < iters; i++) {
+        if (bench_cbmem_use_lf) {
+            rc = cbmem_lf_append(&bench_cbmem_lf, bench_cbmem_body,
+                                 sizeof bench_cbmem_body);
+        } else {
+            rc = cbmem_append(&bench_cbmem, bench_cbmem_body,
+                              sizeof bench_cbmem_body);
+        }
+        assert(rc == 0 || rc == SYS_EBUSY);
+
+        if (idx >= 0 && (i + idx) % BENCH_CBMEM_YIELD_EVERY == 0) {
+            os_time_delay(1);
+        }
+    }
+}
+
+static void
+bench_cbmem_task_handler(void *arg)
+{
+    bench_cbmem_run(BENCH_CBMEM_ENTRIES / BENCH_CBMEM_TASKS,
+                    (int)(uintptr_t)arg);
+    os_sem_release(&bench_cbmem_sem);
+    os_time_delay(OS_TIMEOUT_NEVER);
+}
+
+static void
+bench_cbmem_single(const char *name)
+{
+    uint32_t start;
+    uint32_t ticks;
+
+    start = os_cputime_get32();
+    bench_cbmem_run(BENCH_CBMEM_ENTRIES, -1);
+    ticks = os_cputime_get32() - start;
+
+    log_bench_report(name, BENCH_CBMEM_ENTRIES, ticks);
+}
+
+static void
+bench_cbmem_contended(const char *name)
+{
+    uint32_t start;
+    uint32_t ticks;
+    int rc;
+    int i;
+
+    os_sem_init(&bench_cbmem_sem, 0);
+
+    start = os_cputime_get32();
+    for (i = 0; i < BENCH_CBMEM_TASKS; i++) {
+        rc = os_task_init(&bench_cbmem_tasks[i], "bench_cbmem",
+                          bench_cbmem_task_handler,
+                          (void *)(uintptr_t)(i * BENCH_CBMEM_YIELD_EVERY /
+                                              BENCH_CBMEM_TASKS),
+                          BENCH_CBMEM_BASE_PRIO + i, OS_WAIT_FOREVER,
+                          bench_cbmem_stacks[i], BENCH_CBMEM_STACK_SIZE);
+        assert(rc == 0);
+    }
+    for (i = 0; i < BENCH_CBMEM_TASKS; i++) {
+        rc = os_sem_pend(&bench_cbmem_sem, OS_TIMEOUT_NEVER);
+        assert(rc == 0);
+    }
+    ticks = os_cputime_get32() - start;
+
+    for (i = 0; i < BENCH_CBMEM_TASKS; i++) {
+        rc = os_task_remove(&bench_cbmem_tasks[i]);
+        assert(rc == 0);
+    }
+
+    log_bench_report(name,
+                     BENCH_CBMEM_ENTRIES / BENCH_CBMEM_TASKS *
+                     BENCH_CBMEM_TASKS,
+                     ticks);
+}
+
+static int
+bench_cbmem_walk_fn(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
+                    void *arg)
+{
+    uint8_t body[BENCH_CBMEM_BODY_LEN];
+    int rc;
+
+    rc = cbmem_read(cbmem, hdr, body, 0, sizeof body);
+    assert(rc == sizeof body);
+    *(uint32_t *)arg += 1;
+
+    return 0;
+}
+
+static int
+bench_cbmem_lf_walk_fn(struct cbmem_lf *cbmem,
+                       const struct cbmem_lf_entry *entry, void *arg)
+{
+    uint8_t body[BENCH_CBMEM_BODY_LEN];
+    int rc;
+
+    rc = cbmem_lf_read(cbmem, entry, body, 0, sizeof body);
+    assert(rc == sizeof body);
+    *(uint32_t *)arg += 1;
+
+    return 0;
+}
+
+static void
+bench_cbmem_walk(void)
+{
+    uint32_t count;
+    uint32_t start;
+    uint32_t ticks;
+
+    count = 0;
+    start = os_cputime_get32();
+    cbmem_walk(&bench_cbmem, bench_cbmem_walk_fn, &count);
+    ticks = os_cputime_get32() - start;
+    log_bench_report("cbmem_walk", count, ticks);
+}
+
+static void
+bench_cbmem_lf_walk(void)
+{
+    uint32_t count;
+    uint32_t start;
+    uint32_t ticks;
+
+    count = 0;
+    start = os_cputime_get32();
+    cbmem_lf_walk(&bench_cbmem_lf, bench_cbmem_lf_walk_fn, &count);
+    ticks = os_cputime_get32() - start;
+    log_bench_report("cbmem_lf_walk", count, ticks);
+}
+
+void
+log_bench_cbmem(void)
+{
+    int rc;
+
+    memset(bench_cbmem_body, 0xa5, sizeof bench_cbmem_body);
+
+    bench_cbmem_use_lf = 0;
+    rc = cbmem_init(&bench_cbmem, bench_cbmem_buf, sizeof bench_cbmem_buf);
+    assert(rc == 0);
+    bench_cbmem_single("cbmem_append");
+    bench_cbmem_contended("cbmem_append_contended");
+    bench_cbmem_walk();
+
+    bench_cbmem_use_lf = 1;
+    rc = cbmem_lf_init(&bench_cbmem_lf, bench_cbmem_buf,
+                       sizeof bench_cbmem_buf, 0);
+    assert(rc == 0);
+    bench_cbmem_single("cbmem_lf_append");
+    bench_cbmem_lf_walk();
+
+    rc = cbmem_lf_init(&bench_cbmem_lf, bench_cbmem_buf,
+                       sizeof bench_cbmem_buf, CBMEM_LF_F_MULTI_WRITER);
+    assert(rc == 0);
+    bench_cbmem_single("cbmem_lf_append_mw");
+    bench_cbmem_contended("cbmem_lf_append_mw_contended");
+    bench_cbmem_lf_walk();
+}
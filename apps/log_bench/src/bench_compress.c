@@ -0,0 +1,199 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "log/log.h"
+#include "log_bench.h"
+
+/*
+ * Log compression benchmark.
+ *
+ * Appends a fixed number of entries from each corpus, with and without
+ * compression, and reports the stored size as a percentage of the original
+ * size, the time per append and the time per entry of a body walk which
+ * reads every body in full.  The corpora are log_printf() style text and
+ * small CBOR maps, as logged by CBOR-based modules.
+ */
+
+#define BENCH_COMPRESS_ENTRIES  MYNEWT_VAL(LOG_BENCH_COMPRESS_ENTRIES)
+#define BENCH_COMPRESS_MAX_LEN  128
+
+struct bench_compress_size {
+    uint32_t body;
+    uint32_t stored;
+};
+
+static int
+bench_compress_text(int i, uint8_t *buf)
+{
+    switch (i % 4) {
+    case 0:
+        return snprintf((char *)buf, BENCH_COMPRESS_MAX_LEN,
+                        "connection handle=%d disconnected reason=0x%02x",
+                        i % 8, i % 23);
+    case 1:
+        return snprintf((char *)buf, BENCH_COMPRESS_MAX_LEN,
+                        "sensor %d start; value=%d state=idle", i % 5, i * 31);
+    case 2:
+        return snprintf((char *)buf, BENCH_COMPRESS_MAX_LEN,
+                        "flash write failed; rc=%d addr=0x%08x len=%d",
+                        -(i % 7), i * 256, 64);
+    default:
+        return snprintf((char *)buf, BENCH_COMPRESS_MAX_LEN,
+                        "battery %d mV, temperature %d C, uptime %d s",
+                        3000 + i % 300, 20 + i % 9, i * 10);
+    }
+}
+
+static int
+bench_compress_put_uint(uint8_t *buf, int off, uint32_t val)
+{
+    buf[off++] = 0x1a;
+    buf[off++] = val >> 24;
+    buf[off++] = val >> 16;
+    buf[off++] = val >> 8;
+    buf[off++] = val;
+    return off;
+}
+
+static int
+bench_compress_put_str(uint8_t *buf, int off, const char *str)
+{
+    int len;
+
+    len = strlen(str);
+    buf[off++] = 0x60 | len;
+    memcpy(&buf[off], str, len);
+    return off + len;
+}
+
+static int
+bench_compress_cbor(int i, uint8_t *buf)
+{
+    int off;
+
+    /* {"ts": uint, "id": uint, "val": uint, "state": "ok" / "retry"} */
+    off = 0;
+    buf[off++] = 0xa4;
+    off = bench_compress_put_str(buf, off, "ts");
+    off = bench_compress_put_uint(buf, off, 1000000 + i * 250);
+    off = bench_compress_put_str(buf, off, "id");
+    off = bench_compress_put_uint(buf, off, i % 16);
+    off = bench_compress_put_str(buf, off, "val");
+    off = bench_compress_put_uint(buf, off, i * 7);
+    off = bench_compress_put_str(buf, off, "state");
+    off = bench_compress_put_str(buf, off, i % 10 ? "ok" : "retry");
+    return off;
+}
+
+static int
+bench_compress_size_walk(struct log *log, struct log_offset *log_offset,
+                         const struct log_entry_hdr *hdr, const void *dptr,
+                         uint16_t len)
+{
+    struct bench_compress_size *size;
+    const struct fcb_entry *loc;
+
+    size = log_offset->lo_arg;
+    loc = dptr;
+    size->body += len;
+    size->stored += loc->fe_data_len - log_hdr_len(hdr);
+
+    return 0;
+}
+
+static int
+bench_compress_read_walk(struct log *log, struct log_offset *log_offset,
+                         const struct log_entry_hdr *hdr, const void *dptr,
+                         uint16_t len)
+{
+    uint8_t buf[BENCH_COMPRESS_MAX_LEN];
+    int rc;
+
+    rc = log_read_body(log, dptr, buf, 0, len);
+    assert(rc == len);
+    (*(uint32_t *)log_offset->lo_arg)++;
+
+    return 0;
+}
+
+static void
+bench_compress_time(const char *name, int (*gen)(int i, uint8_t *buf),
+                    int compress)
+{
+    struct bench_compress_size size = { 0 };
+    struct log_offset log_offset;
+    uint8_t body[BENCH_COMPRESS_MAX_LEN];
+    char label[32];
+    uint32_t ticks;
+    uint32_t start;
+    uint32_t cnt;
+    int len;
+    int rc;
+    int i;
+
+    rc = log_flush(&log_bench_log);
+    assert(rc == 0);
+    log_set_compress(&log_bench_log, compress);
+
+    ticks = 0;
+    for (i = 0; i < BENCH_COMPRESS_ENTRIES; i++) {
+        len = gen(i, body);
+        start = os_cputime_get32();
+        rc = log_append_body(&log_bench_log, LOG_MODULE_DEFAULT,
+                             LOG_LEVEL_INFO, LOG_ETYPE_BINARY, body, len);
+        ticks += os_cputime_get32() - start;
+        assert(rc == 0);
+    }
+    rc = log_fcb_commit(&log_bench_log);
+    assert(rc == 0);
+    snprintf(label, sizeof label, "%s_append%s", name, compress ? "_lz" : "");
+    log_bench_report(label, BENCH_COMPRESS_ENTRIES, ticks);
+
+    cnt = 0;
+    log_offset = (struct log_offset) {
+        .lo_arg = &cnt,
+    };
+    start = os_cputime_get32();
+    log_walk_body(&log_bench_log, bench_compress_read_walk, &log_offset);
+    ticks = os_cputime_get32() - start;
+    snprintf(label, sizeof label, "%s_read%s", name, compress ? "_lz" : "");
+    log_bench_report(label, cnt, ticks);
+
+    log_offset.lo_arg = &size;
+    log_walk_body(&log_bench_log, bench_compress_size_walk, &log_offset);
+    snprintf(label, sizeof label, "%s_size%s", name, compress ? "_lz" : "");
+    console_printf("%-32s %8" PRIu32 " bytes %9" PRIu32 " stored (%"
+                   PRIu32 "%%)\n", label, size.body, size.stored,
+                   size.body ? size.stored * 100 / size.body : 0);
+}
+
+void
+log_bench_compress(void)
+{
+    bench_compress_time("text", bench_compress_text, 0);
+    bench_compress_time("text", bench_compress_text, 1);
+    bench_compress_time("cbor", bench_compress_cbor, 0);
+    bench_compress_time("cbor", bench_compress_cbor, 1);
+    log_set_compress(&log_bench_log, 0);
+}
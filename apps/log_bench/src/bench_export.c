@@ -0,0 +1,197 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "log/log.h"
+#include "log_bench.h"
+
+/*
+ * Log export benchmark.
+ *
+ * Streams the whole log into fragment-sized mbuf chains, as an SMP log
+ * download does, and reports the time per entry.  log_export_stream() is
+ * timed for two fragment sizes, and log_export_mbuf(), which resumes the
+ * walk from the cursor for every fragment, for the larger one.
+ * "export_copy" is the previous approach, which reads each body into a
+ * freshly allocated chain and then copies it into the fragment.
+ */
+
+#define BENCH_EXPORT_ENTRIES    MYNEWT_VAL(LOG_BENCH_EXPORT_ENTRIES)
+#define BENCH_EXPORT_BODY_LEN   64
+#define BENCH_EXPORT_MBUF_LEN   128
+#define BENCH_EXPORT_BLOCK_LEN  (BENCH_EXPORT_MBUF_LEN + \
+                                 sizeof (struct os_mbuf) + \
+                                 sizeof (struct os_mbuf_pkthdr))
+#define BENCH_EXPORT_MBUF_CNT   16
+
+static os_membuf_t bench_export_mem[
+    OS_MEMPOOL_SIZE(BENCH_EXPORT_MBUF_CNT, BENCH_EXPORT_BLOCK_LEN)];
+static struct os_mempool bench_export_mempool;
+static struct os_mbuf_pool bench_export_pool;
+
+static int
+bench_export_copy_walk(struct log *log, struct log_offset *log_offset,
+                       const struct log_entry_hdr *hdr, const void *dptr,
+                       uint16_t len)
+{
+    struct os_mbuf **frag;
+    struct os_mbuf *om;
+    int rc;
+
+    frag = log_offset->lo_arg;
+
+    om = os_mbuf_get_pkthdr(&bench_export_pool, 0);
+    assert(om != NULL);
+    rc = log_read_mbuf_body(log, dptr, om, 0, len);
+    assert(rc == len);
+
+    rc = os_mbuf_appendfrom(*frag, om, 0, len);
+    assert(rc == 0);
+    os_mbuf_free_chain(om);
+
+    /* The fragment is sent, and its mbufs freed, once it is full. */
+    if (OS_MBUF_PKTLEN(*frag) >= 512) {
+        os_mbuf_free_chain(*frag);
+        *frag = os_mbuf_get_pkthdr(&bench_export_pool, 0);
+        assert(*frag != NULL);
+    }
+
+    return 0;
+}
+
+static struct os_mbuf *
+bench_export_alloc(void *arg)
+{
+    return os_mbuf_get_pkthdr(&bench_export_pool, 0);
+}
+
+static int
+bench_export_tx(struct os_mbuf *om, void *arg)
+{
+    os_mbuf_free_chain(om);
+    return 0;
+}
+
+static void
+bench_export_time_stream(uint16_t frag_len)
+{
+    struct log_export_cursor cursor;
+    char label[32];
+    uint32_t start;
+    uint32_t ticks;
+    int rc;
+
+    log_export_init(&cursor, 0, NULL);
+
+    start = os_cputime_get32();
+    rc = log_export_stream(&log_bench_log, &cursor, frag_len,
+                           bench_export_alloc, bench_export_tx, NULL);
+    ticks = os_cputime_get32() - start;
+    assert(rc == BENCH_EXPORT_ENTRIES);
+
+    snprintf(label, sizeof label, "export_stream%u", frag_len);
+    log_bench_report(label, rc, ticks);
+}
+
+static void
+bench_export_time(uint16_t frag_len)
+{
+    struct log_export_cursor cursor;
+    struct os_mbuf *om;
+    char label[32];
+    uint32_t entries;
+    uint32_t start;
+    uint32_t ticks;
+    int rc;
+
+    log_export_init(&cursor, 0, NULL);
+    entries = 0;
+
+    start = os_cputime_get32();
+    do {
+        om = os_mbuf_get_pkthdr(&bench_export_pool, 0);
+        assert(om != NULL);
+        rc = log_export_mbuf(&log_bench_log, &cursor, om, frag_len);
+        assert(rc >= 0);
+        entries += rc;
+        os_mbuf_free_chain(om);
+    } while (!cursor.lec_done);
+    ticks = os_cputime_get32() - start;
+
+    snprintf(label, sizeof label, "export_mbuf%u", frag_len);
+    log_bench_report(label, entries, ticks);
+}
+
+static void
+bench_export_time_copy(void)
+{
+    struct log_offset log_offset;
+    struct os_mbuf *frag;
+    uint32_t start;
+    uint32_t ticks;
+
+    frag = os_mbuf_get_pkthdr(&bench_export_pool, 0);
+    assert(frag != NULL);
+    log_offset = (struct log_offset) {
+        .lo_arg = &frag,
+    };
+
+    start = os_cputime_get32();
+    log_walk_body(&log_bench_log, bench_export_copy_walk, &log_offset);
+    ticks = os_cputime_get32() - start;
+
+    os_mbuf_free_chain(frag);
+    log_bench_report("export_copy", BENCH_EXPORT_ENTRIES, ticks);
+}
+
+void
+log_bench_export(void)
+{
+    uint8_t body[BENCH_EXPORT_BODY_LEN];
+    int rc;
+    int i;
+
+    rc = os_mempool_init(&bench_export_mempool, BENCH_EXPORT_MBUF_CNT,
+                         BENCH_EXPORT_BLOCK_LEN, bench_export_mem,
+                         "bench_export");
+    assert(rc == 0);
+    rc = os_mbuf_pool_init(&bench_export_pool, &bench_export_mempool,
+                           BENCH_EXPORT_BLOCK_LEN, BENCH_EXPORT_MBUF_CNT);
+    assert(rc == 0);
+
+    rc = log_flush(&log_bench_log);
+    assert(rc == 0);
+
+    memset(body, 'x', sizeof body);
+    for (i = 0; i < BENCH_EXPORT_ENTRIES; i++) {
+        rc = log_append_body(&log_bench_log, LOG_MODULE_DEFAULT,
+                             LOG_LEVEL_INFO, LOG_ETYPE_STRING, body,
+                             sizeof body);
+        assert(rc == 0);
+    }
+
+    bench_export_time_stream(128);
+    bench_export_time_stream(512);
+    bench_export_time(512);
+    bench_export_time_copy();
+}
@@ -0,0 +1,164 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "log/log.h"
+#include "log_bench.h"
+
+/*
+ * Log filter benchmark.
+ *
+ * Fills every sector but one of an FCB log, with each sector written by one
+ * of eight modules in turn and one entry in 64 logged as an error.  Each
+ * query is then timed as a full body walk which checks every header, and
+ * as a log_walk_filtered() walk which skips sectors by their summary.  The
+ * last query matches errors from every module, so no sector can be skipped.
+ */
+
+#define BENCH_FILTER_WALKS      MYNEWT_VAL(LOG_BENCH_FILTER_WALKS)
+#define BENCH_FILTER_BODY_LEN   MYNEWT_VAL(LOG_BENCH_BODY_LEN)
+#define BENCH_FILTER_MODULES    8
+
+struct bench_filter_query {
+    const char *name;
+    struct log_filter filter;
+};
+
+static const struct bench_filter_query bench_filter_queries[] = {
+    {
+        .name = "module",
+        .filter = {
+            .lf_module = LOG_MODULE_PERUSER + 3,
+            .lf_min_level = LOG_LEVEL_DEBUG,
+        },
+    },
+    {
+        .name = "module_error",
+        .filter = {
+            .lf_module = LOG_MODULE_PERUSER + 3,
+            .lf_min_level = LOG_LEVEL_ERROR,
+        },
+    },
+    {
+        .name = "any_error",
+        .filter = {
+            .lf_module = LOG_FILTER_MODULE_ANY,
+            .lf_min_level = LOG_LEVEL_ERROR,
+        },
+    },
+};
+
+struct bench_filter_arg {
+    const struct log_filter *filter;
+    uint32_t matches;
+};
+
+static int
+bench_filter_walk(struct log *log, struct log_offset *log_offset,
+                  const struct log_entry_hdr *hdr, const void *dptr,
+                  uint16_t len)
+{
+    struct bench_filter_arg *arg;
+
+    arg = log_offset->lo_arg;
+    if (arg->filter == NULL || log_filter_match(arg->filter, hdr)) {
+        arg->matches++;
+    }
+
+    return 0;
+}
+
+static void
+bench_filter_time(const struct bench_filter_query *query, int filtered)
+{
+    struct bench_filter_arg arg;
+    struct log_offset log_offset;
+    char label[32];
+    uint32_t ticks;
+    uint32_t start;
+    int i;
+
+    ticks = 0;
+    for (i = 0; i < BENCH_FILTER_WALKS; i++) {
+        arg = (struct bench_filter_arg) { 0 };
+        log_offset = (struct log_offset) {
+            .lo_arg = &arg,
+        };
+
+        start = os_cputime_get32();
+        if (filtered) {
+            log_walk_filtered(&log_bench_log, &query->filter,
+                              bench_filter_walk, &log_offset);
+        } else {
+            arg.filter = &query->filter;
+            log_walk_body(&log_bench_log, bench_filter_walk, &log_offset);
+        }
+        ticks += os_cputime_get32() - start;
+    }
+
+    snprintf(label, sizeof label, "filter_%s_%s", query->name,
+             filtered ? "summary" : "full");
+    log_bench_report(label, BENCH_FILTER_WALKS, ticks);
+    console_printf("%-32s %8" PRIu32 " matches\n", label, arg.matches);
+}
+
+void
+log_bench_filter(void)
+{
+    uint8_t body[BENCH_FILTER_BODY_LEN];
+    struct fcb *fcb;
+    uint8_t module;
+    uint8_t level;
+    int filled;
+    int rc;
+    int i;
+
+    fcb = &log_bench_fcb_log.fl_fcb;
+
+    rc = log_flush(&log_bench_log);
+    assert(rc == 0);
+
+    memset(body, 0xa5, sizeof body);
+
+    /* Stop before the log rotates. */
+    for (i = 0; ; i++) {
+        filled = fcb->f_active.fe_area - log_bench_sectors;
+        if (filled == log_bench_sector_cnt - 1) {
+            break;
+        }
+
+        module = LOG_MODULE_PERUSER + filled % BENCH_FILTER_MODULES;
+        level = i % 64 == 0 ? LOG_LEVEL_ERROR : LOG_LEVEL_INFO;
+        rc = log_append_body(&log_bench_log, module, level, LOG_ETYPE_BINARY,
+                             body, sizeof body);
+        assert(rc == 0);
+    }
+
+    console_printf("%-32s %8d sectors %8d entries\n", "filter_log_size",
+                   filled, i);
+
+    for (i = 0; i < ARRAY_SIZE(bench_filter_queries); i++) {
+        bench_filter_time(&bench_filter_queries[i], 0);
+        bench_filter_time(&bench_filter_queries[i], 1);
+    }
+}
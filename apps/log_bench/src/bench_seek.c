@@ -0,0 +1,175 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "log/log.h"
+#include "log_bench.h"
+
+/*
+ * Log seek benchmark.
+ *
+ * Fills an FCB log one flash sector at a time.  Each time the number of
+ * filled sectors doubles, it times log walks that start at a random entry
+ * index and stop at the first entry visited; this is the lookup done by
+ * "log show" and log reads over SMP.  Every size is timed three times: with
+ * the sector index, with automatic bookmarks and with both detached, which
+ * is the linear scan done without either option.
+ */
+
+#define BENCH_SEEK_MAX_SECTORS  MYNEWT_VAL(LOG_BENCH_MAX_SECTORS)
+#define BENCH_SEEK_ITERATIONS   MYNEWT_VAL(LOG_BENCH_SEEKS)
+#define BENCH_SEEK_BODY_LEN     MYNEWT_VAL(LOG_BENCH_BODY_LEN)
+#define BENCH_SEEK_BMARKS       MYNEWT_VAL(LOG_BENCH_BMARKS)
+
+static struct log_fcb_sector_idx bench_seek_sidx[BENCH_SEEK_MAX_SECTORS];
+static struct log_fcb_bmark bench_seek_bmarks[BENCH_SEEK_BMARKS];
+static uint32_t bench_seek_seed;
+
+static uint32_t
+bench_seek_rand(void)
+{
+    bench_seek_seed = bench_seek_seed * 1103515245 + 12345;
+    return bench_seek_seed >> 8;
+}
+
+static int
+bench_seek_stop(struct log *log, struct log_offset *log_offset,
+                const void *dptr, uint16_t len)
+{
+    struct log_entry_hdr hdr;
+
+    if (log_read_hdr(log, dptr, &hdr) == 0) {
+        *(uint32_t *)log_offset->lo_arg = hdr.ue_index;
+    }
+
+    /* Stop after the first entry; only the seek is of interest. */
+    return 1;
+}
+
+static uint32_t
+bench_seek_once(uint32_t index)
+{
+    struct log_offset log_offset;
+    uint32_t found;
+
+    found = 0;
+    log_offset = (struct log_offset) {
+        .lo_arg = &found,
+        .lo_ts = 0,
+        .lo_index = index,
+    };
+    log_walk(&log_bench_log, bench_seek_stop, &log_offset);
+
+    return found;
+}
+
+static void
+bench_seek_time(const char *name, uint32_t first, uint32_t last)
+{
+    uint32_t total;
+    uint32_t start;
+    uint32_t index;
+    int i;
+
+    bench_seek_seed = 1;
+    total = 0;
+
+    for (i = 0; i < BENCH_SEEK_ITERATIONS; i++) {
+        index = first + bench_seek_rand() % (last - first + 1);
+
+        start = os_cputime_get32();
+        bench_seek_once(index);
+        total += os_cputime_get32() - start;
+    }
+
+    log_bench_report(name, BENCH_SEEK_ITERATIONS, total);
+}
+
+static void
+bench_seek_run(int sectors)
+{
+    uint32_t first;
+    uint32_t last;
+    int bmarks;
+
+    first = bench_seek_once(0);
+    last = g_log_info.li_next_index - 1;
+
+    console_printf("%-32s %8d sectors %8" PRIu32 " entries\n", "log_size",
+                   sectors, last - first + 1);
+
+    /* Hide the bookmarks from lookups without losing them. */
+    bmarks = log_bench_fcb_log.fl_bset.lfs_size;
+    log_bench_fcb_log.fl_bset.lfs_size = 0;
+    bench_seek_time("seek_index", first, last);
+
+    log_bench_fcb_log.fl_sidx = NULL;
+    bench_seek_time("seek_linear", first, last);
+
+    log_bench_fcb_log.fl_bset.lfs_size = bmarks;
+    bench_seek_time("seek_bmarks", first, last);
+    log_bench_fcb_log.fl_sidx = bench_seek_sidx;
+}
+
+void
+log_bench_seek(void)
+{
+    uint8_t body[BENCH_SEEK_BODY_LEN];
+    struct fcb *fcb;
+    int next_run;
+    int filled;
+    int cnt;
+    int rc;
+
+    fcb = &log_bench_fcb_log.fl_fcb;
+    cnt = log_bench_sector_cnt;
+
+    rc = log_fcb_init_sector_idx(&log_bench_fcb_log, bench_seek_sidx, cnt);
+    assert(rc == 0);
+
+    log_fcb_init_auto_bmarks(&log_bench_fcb_log, bench_seek_bmarks,
+                             BENCH_SEEK_BMARKS, 1);
+
+    memset(body, 0xa5, sizeof body);
+
+    /*
+     * Time seeks each time the number of full sectors doubles, and once more
+     * when the last sector is reached; stop there, before the log rotates.
+     */
+    next_run = 1;
+    while (1) {
+        rc = log_append_body(&log_bench_log, LOG_MODULE_DEFAULT,
+                             LOG_LEVEL_INFO, LOG_ETYPE_BINARY, body,
+                             sizeof body);
+        assert(rc == 0);
+
+        filled = fcb->f_active.fe_area - log_bench_sectors;
+        if (filled == next_run || filled == cnt - 1) {
+            bench_seek_run(filled);
+            if (filled == cnt - 1) {
+                break;
+            }
+            next_run *= 2;
+        }
+    }
+}
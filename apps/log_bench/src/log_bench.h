@@ -0,0 +1,58 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_LOG_BENCH_
+#define H_LOG_BENCH_
+
+#include <inttypes.h>
+#include "os/mynewt.h"
+#include "log/log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Prints a single result line: the benchmark name, the number of iterations
+ * and the average time per iteration in nanoseconds.
+ */
+void log_bench_report(const char *name, uint32_t iters, uint32_t ticks);
+
+/**
+ * The log every benchmark runs on.  It covers the whole benchmark flash
+ * area; all logs have to be registered before any is written to, so it is
+ * set up once and shared.
+ */
+extern struct flash_area log_bench_sectors[];
+extern int log_bench_sector_cnt;
+extern struct fcb_log log_bench_fcb_log;
+extern struct log log_bench_log;
+
+void log_bench_seek(void);
+void log_bench_append(void);
+void log_bench_compress(void);
+void log_bench_filter(void);
+void log_bench_export(void);
+void log_bench_cbmem(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "flash_map/flash_map.h"
+#include "log_bench.h"
+
+struct flash_area log_bench_sectors[MYNEWT_VAL(LOG_BENCH_MAX_SECTORS)];
+int log_bench_sector_cnt;
+struct fcb_log log_bench_fcb_log;
+struct log log_bench_log;
+
+void
+log_bench_report(const char *name, uint32_t iters, uint32_t ticks)
+{
+    uint64_t nsecs;
+
+    nsecs = (uint64_t)os_cputime_ticks_to_usecs(ticks) * 1000;
+    console_printf("%-32s %8" PRIu32 " iters %10" PRIu32 " ns/iter\n",
+                   name, iters, (uint32_t)(nsecs / iters));
+}
+
+static int
+log_bench_init(void)
+{
+    struct fcb *fcb;
+    int cnt;
+    int rc;
+    int i;
+
+    rc = flash_area_to_sectors(MYNEWT_VAL(LOG_BENCH_FLASH_AREA), &cnt, NULL);
+    if (rc != 0 || cnt < 2 || cnt > MYNEWT_VAL(LOG_BENCH_MAX_SECTORS)) {
+        console_printf("log_bench: unusable flash area (%d sectors)\n", cnt);
+        return SYS_EINVAL;
+    }
+    flash_area_to_sectors(MYNEWT_VAL(LOG_BENCH_FLASH_AREA), &cnt,
+                          log_bench_sectors);
+
+    for (i = 0; i < cnt; i++) {
+        flash_area_erase(&log_bench_sectors[i], 0,
+                         log_bench_sectors[i].fa_size);
+    }
+
+    fcb = &log_bench_fcb_log.fl_fcb;
+    fcb->f_magic = 0x7EADBADF;
+    fcb->f_version = g_log_info.li_version;
+    fcb->f_sector_cnt = cnt;
+    fcb->f_sectors = log_bench_sectors;
+    rc = fcb_init(fcb);
+    assert(rc == 0);
+
+    log_bench_sector_cnt = cnt;
+    log_register("bench", &log_bench_log, &log_fcb_handler,
+                 &log_bench_fcb_log, LOG_SYSLEVEL);
+
+    return 0;
+}
+
+/**
+ * main
+ *
+ * Runs every benchmark once from the main task, then goes idle.
+ *
+ * @return int NOTE: this function should never return!
+ */
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    console_printf("log_bench: start\n");
+    if (log_bench_init() == 0) {
+        log_bench_seek();
+        log_bench_append();
+        log_bench_compress();
+        log_bench_filter();
+        log_bench_export();
+        log_bench_cbmem();
+    }
+    console_printf("log_bench: done\n");
+
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+    assert(0);
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "fs/fs.h"
+#include "nffs/nffs.h"
+#include "nffs_bench.h"
+
+/*
+ * Write latency benchmark.
+ *
+ * Fills a portion of the file system with files, then overwrites random
+ * ranges within them.  Each overwrite supersedes old data, so garbage
+ * collection runs continuously.  Every write is timed individually and the
+ * latency distribution is reported.  Build once with NFFS_GC_INCREMENTAL set
+ * to 0 and once with it set to 1 to compare one-shot and incremental garbage
+ * collection.
+ */
+
+#define BENCH_GC_NUM_FILES      8
+#define BENCH_GC_WRITE_SZ       256
+#define BENCH_GC_ITERATIONS     MYNEWT_VAL(NFFS_BENCH_GC_WRITES)
+
+static uint32_t bench_gc_usecs[BENCH_GC_ITERATIONS];
+static uint8_t bench_gc_buf[BENCH_GC_WRITE_SZ];
+static uint32_t bench_gc_seed;
+
+static uint32_t
+bench_gc_rand(void)
+{
+    bench_gc_seed = bench_gc_seed * 1103515245 + 12345;
+    return bench_gc_seed >> 8;
+}
+
+static int
+bench_gc_cmp(const void *a, const void *b)
+{
+    uint32_t ua;
+    uint32_t ub;
+
+    ua = *(const uint32_t *)a;
+    ub = *(const uint32_t *)b;
+
+    return (ua > ub) - (ua < ub);
+}
+
+/**
+ * Creates the files the benchmark overwrites.  Together they occupy about a
+ * third of the file system's capacity.
+ *
+ * @return                      The size of each file, in bytes.
+ */
+static uint32_t
+bench_gc_create(struct fs_file **files)
+{
+    char path[16];
+    uint32_t capacity;
+    uint32_t file_size;
+    uint32_t off;
+    int rc;
+    int i;
+
+    capacity = 0;
+    for (i = 0; nffs_bench_area_descs[i].nad_length != 0; i++) {
+        capacity += nffs_bench_area_descs[i].nad_length;
+    }
+    file_size = capacity / 3 / BENCH_GC_NUM_FILES;
+    file_size -= file_size % BENCH_GC_WRITE_SZ;
+
+    for (i = 0; i < BENCH_GC_NUM_FILES; i++) {
+        snprintf(path, sizeof path, "/gc%d", i);
+        rc = fs_open(path, FS_ACCESS_READ | FS_ACCESS_WRITE, &files[i]);
+        assert(rc == 0);
+
+        for (off = 0; off < file_size; off += BENCH_GC_WRITE_SZ) {
+            rc = fs_write(files[i], bench_gc_buf, BENCH_GC_WRITE_SZ);
+            assert(rc == 0);
+        }
+    }
+
+    return file_size;
+}
+
+static void
+bench_gc_print(const char *name, uint32_t usecs)
+{
+    console_printf("%-32s %10" PRIu32 " us\n", name, usecs);
+}
+
+void
+nffs_bench_gc(void)
+{
+    struct fs_file *files[BENCH_GC_NUM_FILES];
+    struct fs_file *file;
+    uint32_t file_size;
+    uint32_t start;
+    uint32_t off;
+    int rc;
+    int i;
+
+    rc = nffs_format(nffs_bench_area_descs);
+    assert(rc == 0);
+
+    file_size = bench_gc_create(files);
+    console_printf("%-32s %8" PRIu32 " bytes %8d files (%s gc)\n",
+                   "gc_file_size", file_size, BENCH_GC_NUM_FILES,
+                   MYNEWT_VAL(NFFS_GC_INCREMENTAL) ? "incremental" :
+                                                      "one-shot");
+
+    bench_gc_seed = 1;
+    for (i = 0; i < BENCH_GC_ITERATIONS; i++) {
+        file = files[bench_gc_rand() % BENCH_GC_NUM_FILES];
+        off = bench_gc_rand() % (file_size / BENCH_GC_WRITE_SZ) *
+              BENCH_GC_WRITE_SZ;
+
+        rc = fs_seek(file, off);
+        assert(rc == 0);
+
+        start = os_cputime_get32();
+        rc = fs_write(file, bench_gc_buf, BENCH_GC_WRITE_SZ);
+        bench_gc_usecs[i] = os_cputime_ticks_to_usecs(os_cputime_get32() -
+                                                      start);
+        assert(rc == 0);
+    }
+
+    for (i = 0; i < BENCH_GC_NUM_FILES; i++) {
+        rc = fs_close(files[i]);
+        assert(rc == 0);
+    }
+
+    qsort(bench_gc_usecs, BENCH_GC_ITERATIONS, sizeof bench_gc_usecs[0],
+          bench_gc_cmp);
+
+    bench_gc_print("write_256_p50",
+                   bench_gc_usecs[BENCH_GC_ITERATIONS / 2]);
+    bench_gc_print("write_256_p99",
+                   bench_gc_usecs[BENCH_GC_ITERATIONS * 99 / 100]);
+    bench_gc_print("write_256_max",
+                   bench_gc_usecs[BENCH_GC_ITERATIONS - 1]);
+}
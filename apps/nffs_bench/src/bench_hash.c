@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "nffs/nffs.h"
+#include "../src/nffs_priv.h"
+#include "nffs_bench.h"
+
+/*
+ * Object hash benchmark.
+ *
+ * Inserts block entries with sequentially allocated IDs, as a restore or a
+ * long run of appends does, then times lookups of random entries.  The
+ * object count doubles from one run to the next.  Setting NFFS_HASH_SIZE to
+ * 256 reproduces the fixed-size table used previously.
+ */
+
+#define BENCH_HASH_MIN_OBJECTS  256
+#define BENCH_HASH_MAX_OBJECTS  MYNEWT_VAL(NFFS_BENCH_HASH_OBJECTS)
+
+static uint32_t bench_hash_seed;
+
+static uint32_t
+bench_hash_rand(void)
+{
+    bench_hash_seed = bench_hash_seed * 1103515245 + 12345;
+    return bench_hash_seed >> 8;
+}
+
+static void
+bench_hash_run(struct nffs_hash_entry *entries, int count)
+{
+    struct nffs_hash_entry *entry;
+    uint32_t start;
+    int found;
+    int rc;
+    int i;
+
+    /* Start from an empty table. */
+    rc = nffs_misc_reset();
+    assert(rc == 0);
+
+    console_printf("%-32s %8d objects %8" PRIu32 " buckets\n", "hash_size",
+                   count, nffs_hash_size);
+
+    start = os_cputime_get32();
+    for (i = 0; i < count; i++) {
+        entries[i].nhe_id = NFFS_ID_BLOCK_MIN + i;
+        entries[i].nhe_flash_loc = NFFS_FLASH_LOC_NONE;
+        nffs_hash_insert(entries + i);
+    }
+    nffs_bench_report("hash_insert", count, os_cputime_get32() - start);
+
+    bench_hash_seed = 1;
+    found = 0;
+    start = os_cputime_get32();
+    for (i = 0; i < count; i++) {
+        entry = nffs_hash_find_block(NFFS_ID_BLOCK_MIN +
+                                     bench_hash_rand() % count);
+        found += entry != NULL;
+    }
+    nffs_bench_report("hash_find", count, os_cputime_get32() - start);
+    assert(found == count);
+}
+
+void
+nffs_bench_hash(void)
+{
+    struct nffs_hash_entry *entries;
+    int count;
+    int rc;
+
+    entries = malloc(BENCH_HASH_MAX_OBJECTS * sizeof *entries);
+    if (entries == NULL) {
+        console_printf("nffs_bench: no memory for hash entries\n");
+        return;
+    }
+
+    for (count = BENCH_HASH_MIN_OBJECTS;
+         count <= BENCH_HASH_MAX_OBJECTS;
+         count *= 2) {
+
+        bench_hash_run(entries, count);
+    }
+
+    /* Don't leave the file system referring to the entries. */
+    rc = nffs_misc_reset();
+    assert(rc == 0);
+
+    free(entries);
+}
@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "fs/fs.h"
+#include "nffs/nffs.h"
+#include "nffs_bench.h"
+
+/*
+ * Mount benchmark.
+ *
+ * Fills a file system with small files, spread over directories of 64 files
+ * each.  Each time the number of files doubles, it times nffs_detect() three
+ * ways: with the checkpoint taken at the previous size, so that only the
+ * newer half of the objects gets replayed; with an up-to-date checkpoint;
+ * and with checkpoints disabled, which is the full scan of every object
+ * header in every area.
+ */
+
+#define BENCH_MOUNT_MAX_FILES   MYNEWT_VAL(NFFS_BENCH_MAX_FILES)
+#define BENCH_MOUNT_ITERATIONS  MYNEWT_VAL(NFFS_BENCH_MOUNTS)
+#define BENCH_MOUNT_DIR_FILES   64
+#define BENCH_MOUNT_FIRST_RUN   16
+
+static void
+bench_mount_create(int idx)
+{
+    struct fs_file *file;
+    char path[32];
+    int rc;
+
+    if (idx % BENCH_MOUNT_DIR_FILES == 0) {
+        snprintf(path, sizeof path, "/d%03d", idx / BENCH_MOUNT_DIR_FILES);
+        rc = fs_mkdir(path);
+        assert(rc == 0);
+    }
+
+    snprintf(path, sizeof path, "/d%03d/f%05d",
+             idx / BENCH_MOUNT_DIR_FILES, idx);
+    rc = fs_open(path, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+    assert(rc == 0);
+    rc = fs_write(file, path, strlen(path));
+    assert(rc == 0);
+    rc = fs_close(file);
+    assert(rc == 0);
+}
+
+static void
+bench_mount_time(const char *name)
+{
+    uint32_t total;
+    uint32_t start;
+    int rc;
+    int i;
+
+    total = 0;
+    for (i = 0; i < BENCH_MOUNT_ITERATIONS; i++) {
+        start = os_cputime_get32();
+        rc = nffs_detect(nffs_bench_area_descs);
+        total += os_cputime_get32() - start;
+        assert(rc == 0);
+    }
+
+    nffs_bench_report(name, BENCH_MOUNT_ITERATIONS, total);
+}
+
+static void
+bench_mount_run(int files)
+{
+    uint32_t start;
+    int rc;
+
+    console_printf("%-32s %8d files\n", "fs_size", files);
+
+    /* The checkpoint still describes the file system at half this size. */
+    if (files > BENCH_MOUNT_FIRST_RUN) {
+        bench_mount_time("mount_ckpt_replay");
+    }
+
+    start = os_cputime_get32();
+    rc = nffs_checkpoint();
+    nffs_bench_report("ckpt_write", 1, os_cputime_get32() - start);
+    assert(rc == 0);
+
+    bench_mount_time("mount_ckpt");
+
+    rc = nffs_checkpoint_config(NULL);
+    assert(rc == 0);
+    bench_mount_time("mount_scan");
+
+    rc = nffs_checkpoint_config(&nffs_bench_ckpt_desc);
+    assert(rc == 0);
+}
+
+void
+nffs_bench_mount(void)
+{
+    int next_run;
+    int i;
+    int rc;
+
+    rc = nffs_checkpoint_config(&nffs_bench_ckpt_desc);
+    assert(rc == 0);
+    rc = nffs_format(nffs_bench_area_descs);
+    assert(rc == 0);
+
+    next_run = BENCH_MOUNT_FIRST_RUN;
+    for (i = 0; i < BENCH_MOUNT_MAX_FILES; i++) {
+        bench_mount_create(i);
+        if (i + 1 == next_run) {
+            bench_mount_run(next_run);
+            next_run *= 2;
+        }
+    }
+
+    rc = nffs_checkpoint_config(NULL);
+    assert(rc == 0);
+}
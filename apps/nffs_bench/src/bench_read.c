@@ -0,0 +1,147 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "fs/fs.h"
+#include "nffs/nffs.h"
+#include "../src/nffs_priv.h"
+#include "nffs_bench.h"
+
+/*
+ * Random read benchmark.
+ *
+ * Writes one large file, then times 4 KB reads at random offsets within it.
+ * The file spans many more data blocks than the block cache holds, so most
+ * reads have to locate their first block by walking the file's block chain.
+ * Build once with NFFS_CACHE_INDEX_SIZE set to 0, which walks from the end of
+ * the file, and once with it set to e.g. 16 to compare against the index.
+ */
+
+#define BENCH_READ_FILE_SIZE    MYNEWT_VAL(NFFS_BENCH_READ_FILE_SIZE)
+#define BENCH_READ_ITERATIONS   MYNEWT_VAL(NFFS_BENCH_READS)
+#define BENCH_READ_CHUNK_SZ     4096
+
+static const char bench_read_path[] = "/bigfile";
+static uint8_t bench_read_buf[BENCH_READ_CHUNK_SZ];
+static uint32_t bench_read_seed;
+
+static uint32_t
+bench_read_rand(void)
+{
+    bench_read_seed = bench_read_seed * 1103515245 + 12345;
+    return bench_read_seed >> 8;
+}
+
+static uint32_t
+bench_read_create(void)
+{
+    struct fs_file *file;
+    uint32_t file_len;
+    uint32_t off;
+    int rc;
+    int i;
+
+    rc = fs_open(bench_read_path, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+    assert(rc == 0);
+
+    for (off = 0; off < BENCH_READ_FILE_SIZE; off += BENCH_READ_CHUNK_SZ) {
+        for (i = 0; i < BENCH_READ_CHUNK_SZ; i++) {
+            bench_read_buf[i] = off + i;
+        }
+        rc = fs_write(file, bench_read_buf, BENCH_READ_CHUNK_SZ);
+        if (rc != 0) {
+            /* Flash area is full; use what was written. */
+            break;
+        }
+    }
+
+    rc = fs_filelen(file, &file_len);
+    assert(rc == 0);
+    rc = fs_close(file);
+    assert(rc == 0);
+
+    return file_len;
+}
+
+static void
+bench_read_at(struct fs_file *file, uint32_t off)
+{
+    uint32_t bytes_read;
+    int rc;
+
+    rc = fs_seek(file, off);
+    assert(rc == 0);
+    rc = fs_read(file, BENCH_READ_CHUNK_SZ, bench_read_buf, &bytes_read);
+    assert(rc == 0 && bytes_read == BENCH_READ_CHUNK_SZ);
+    assert(bench_read_buf[0] == (uint8_t)off);
+}
+
+void
+nffs_bench_read(void)
+{
+    struct fs_file *file;
+    uint32_t file_len;
+    uint32_t start;
+    int rc;
+    int i;
+
+    rc = nffs_format(nffs_bench_area_descs);
+    assert(rc == 0);
+
+    file_len = bench_read_create();
+    console_printf("%-32s %8" PRIu32 " bytes %8d cached blocks\n",
+                   "read_file_size", file_len,
+                   nffs_config.nc_num_cache_blocks);
+    if (file_len < BENCH_READ_CHUNK_SZ * 2) {
+        console_printf("nffs_bench: flash area too small for read test\n");
+        return;
+    }
+
+    /* Start without any of the file cached. */
+    nffs_cache_clear();
+
+    rc = fs_open(bench_read_path, FS_ACCESS_READ, &file);
+    assert(rc == 0);
+
+    /* The first read at the start of the file pays for any index build. */
+    start = os_cputime_get32();
+    bench_read_at(file, 0);
+    nffs_bench_report("read_first", 1, os_cputime_get32() - start);
+
+    bench_read_seed = 1;
+    start = os_cputime_get32();
+    for (i = 0; i < BENCH_READ_ITERATIONS; i++) {
+        bench_read_at(file,
+                      bench_read_rand() % (file_len - BENCH_READ_CHUNK_SZ));
+    }
+    nffs_bench_report("read_random_4k", BENCH_READ_ITERATIONS,
+                      os_cputime_get32() - start);
+
+    start = os_cputime_get32();
+    for (i = 0; i < file_len / BENCH_READ_CHUNK_SZ; i++) {
+        bench_read_at(file, i * BENCH_READ_CHUNK_SZ);
+    }
+    nffs_bench_report("read_seq_4k", file_len / BENCH_READ_CHUNK_SZ,
+                      os_cputime_get32() - start);
+
+    rc = fs_close(file);
+    assert(rc == 0);
+}
@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "flash_map/flash_map.h"
+#include "nffs/nffs.h"
+#include "nffs_bench.h"
+
+#define NFFS_BENCH_MAX_AREAS    MYNEWT_VAL(NFFS_BENCH_MAX_AREAS)
+
+struct nffs_area_desc nffs_bench_area_descs[NFFS_BENCH_MAX_AREAS + 1];
+struct nffs_area_desc nffs_bench_ckpt_desc;
+
+void
+nffs_bench_report(const char *name, uint32_t iters, uint32_t ticks)
+{
+    uint64_t nsecs;
+
+    nsecs = (uint64_t)os_cputime_ticks_to_usecs(ticks) * 1000;
+    console_printf("%-32s %8" PRIu32 " iters %10" PRIu32 " ns/iter\n",
+                   name, iters, (uint32_t)(nsecs / iters));
+}
+
+static int
+nffs_bench_init(void)
+{
+    struct flash_area sectors[NFFS_BENCH_MAX_AREAS];
+    int cnt;
+    int rc;
+
+    /* Size the RAM index for the largest benchmark file system; every file
+     * has an inode and a single data block.  The hash table is sized from
+     * these counts, so the block count also covers the hash benchmark.
+     */
+    nffs_config.nc_num_inodes = MYNEWT_VAL(NFFS_BENCH_MAX_FILES) + 64;
+    nffs_config.nc_num_blocks = max(MYNEWT_VAL(NFFS_BENCH_MAX_FILES) + 64,
+                                    MYNEWT_VAL(NFFS_BENCH_HASH_OBJECTS));
+    rc = nffs_init();
+    if (rc != 0) {
+        console_printf("nffs_bench: nffs_init failed; rc=%d\n", rc);
+        return rc;
+    }
+
+    cnt = NFFS_BENCH_MAX_AREAS;
+    rc = nffs_misc_desc_from_flash_area(MYNEWT_VAL(NFFS_BENCH_FLASH_AREA),
+                                        &cnt, nffs_bench_area_descs);
+    if (rc != 0 || cnt < 2) {
+        console_printf("nffs_bench: unusable flash area (%d areas)\n", cnt);
+        return SYS_EINVAL;
+    }
+
+    /* Each checkpoint slot has to be erasable on its own; use the first two
+     * sectors of the checkpoint flash area as the two slots.
+     */
+    rc = flash_area_to_sectors(MYNEWT_VAL(NFFS_BENCH_CKPT_FLASH_AREA), &cnt,
+                               NULL);
+    if (rc != 0 || cnt < 2 || cnt > NFFS_BENCH_MAX_AREAS) {
+        console_printf("nffs_bench: unusable checkpoint area\n");
+        return SYS_EINVAL;
+    }
+    flash_area_to_sectors(MYNEWT_VAL(NFFS_BENCH_CKPT_FLASH_AREA), &cnt,
+                          sectors);
+    if (sectors[0].fa_size != sectors[1].fa_size) {
+        console_printf("nffs_bench: unusable checkpoint area\n");
+        return SYS_EINVAL;
+    }
+    nffs_bench_ckpt_desc = (struct nffs_area_desc) {
+        .nad_offset = sectors[0].fa_off,
+        .nad_length = sectors[0].fa_size * 2,
+        .nad_flash_id = sectors[0].fa_device_id,
+    };
+
+    return 0;
+}
+
+/**
+ * main
+ *
+ * Runs every benchmark once from the main task, then goes idle.
+ *
+ * @return int NOTE: this function should never return!
+ */
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    console_printf("nffs_bench: start\n");
+    if (nffs_bench_init() == 0) {
+        nffs_bench_mount();
+        nffs_bench_hash();
+        nffs_bench_read();
+        nffs_bench_gc();
+    }
+    console_printf("nffs_bench: done\n");
+
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+    assert(0);
+
+    return 0;
+}
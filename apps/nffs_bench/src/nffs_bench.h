@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_NFFS_BENCH_
+#define H_NFFS_BENCH_
+
+#include <inttypes.h>
+#include "os/mynewt.h"
+#include "nffs/nffs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Prints a single result line: the benchmark name, the number of iterations
+ * and the average time per iteration in nanoseconds.
+ */
+void nffs_bench_report(const char *name, uint32_t iters, uint32_t ticks);
+
+/**
+ * The file system areas and checkpoint region every benchmark runs on.  The
+ * area descriptor array is terminated by a zero-length entry.
+ */
+extern struct nffs_area_desc nffs_bench_area_descs[];
+extern struct nffs_area_desc nffs_bench_ckpt_desc;
+
+void nffs_bench_mount(void);
+void nffs_bench_hash(void);
+void nffs_bench_read(void);
+void nffs_bench_gc(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
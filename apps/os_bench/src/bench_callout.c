@@ -0,0 +1,87 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+#include "os_bench.h"
+
+/*
+ * Callout benchmarks: arm, re-arm and cancel a large number of callouts with
+ * pseudo-random timeouts between 1 tick and about one minute.  With the
+ * sorted callout list the cost of each operation grows with the number of
+ * armed callouts; with OS_CALLOUT_WHEEL it is constant.
+ */
+
+#define BENCH_CALLOUT_CNT       (10000)
+#define BENCH_CALLOUT_MAX_TICKS (60 * OS_TICKS_PER_SEC)
+
+static struct os_callout bench_callouts[BENCH_CALLOUT_CNT];
+static struct os_eventq bench_callout_evq;
+static uint32_t bench_callout_seed;
+
+static os_time_t
+bench_callout_rand_ticks(void)
+{
+    bench_callout_seed = bench_callout_seed * 1103515245 + 12345;
+    return 1 + (bench_callout_seed >> 8) % BENCH_CALLOUT_MAX_TICKS;
+}
+
+static void
+bench_callout_cb(struct os_event *ev)
+{
+}
+
+void
+os_bench_callout(void)
+{
+    uint32_t start;
+    uint32_t ticks;
+    int rc;
+    int i;
+
+    os_eventq_init(&bench_callout_evq);
+    for (i = 0; i < BENCH_CALLOUT_CNT; i++) {
+        os_callout_init(&bench_callouts[i], &bench_callout_evq,
+                        bench_callout_cb, NULL);
+    }
+    bench_callout_seed = 1;
+
+    start = os_cputime_get32();
+    for (i = 0; i < BENCH_CALLOUT_CNT; i++) {
+        rc = os_callout_reset(&bench_callouts[i], bench_callout_rand_ticks());
+        assert(rc == 0);
+    }
+    ticks = os_cputime_get32() - start;
+    os_bench_report("callout_arm", BENCH_CALLOUT_CNT, ticks);
+
+    start = os_cputime_get32();
+    for (i = 0; i < BENCH_CALLOUT_CNT; i++) {
+        rc = os_callout_reset(&bench_callouts[i], bench_callout_rand_ticks());
+        assert(rc == 0);
+    }
+    ticks = os_cputime_get32() - start;
+    os_bench_report("callout_rearm", BENCH_CALLOUT_CNT, ticks);
+
+    start = os_cputime_get32();
+    for (i = 0; i < BENCH_CALLOUT_CNT; i++) {
+        os_callout_stop(&bench_callouts[i]);
+    }
+    ticks = os_cputime_get32() - start;
+    os_bench_report("callout_cancel", BENCH_CALLOUT_CNT, ticks);
+}
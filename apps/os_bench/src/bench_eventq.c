@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+#include "os_bench.h"
+
+/*
+ * Event queue benchmarks.
+ *
+ * The main task puts bursts of events on a queue that is drained by a lower
+ * priority task, the way an interrupt handler hands work to a task.  The
+ * consumer runs either with os_eventq_run(), one event per call, or with
+ * os_eventq_run_batch().  The reported time is the wall clock time per event
+ * including the put.
+ */
+
+#define BENCH_EVENTQ_BURST      (8)
+#define BENCH_EVENTQ_PRIO       (MYNEWT_VAL(OS_MAIN_TASK_PRIO) + 1)
+
+static struct os_eventq bench_eventq;
+static struct os_event bench_eventq_evs[BENCH_EVENTQ_BURST];
+static struct os_task bench_eventq_task;
+static os_stack_t bench_eventq_stack[OS_BENCH_STACK_SIZE];
+static struct os_sem bench_eventq_sem;
+static int bench_eventq_batch;
+static int bench_eventq_cnt;
+
+static void
+bench_eventq_cb(struct os_event *ev)
+{
+    if (++bench_eventq_cnt == BENCH_EVENTQ_BURST) {
+        bench_eventq_cnt = 0;
+        os_sem_release(&bench_eventq_sem);
+    }
+}
+
+static void
+bench_eventq_task_handler(void *arg)
+{
+    while (1) {
+        if (bench_eventq_batch) {
+            os_eventq_run_batch(&bench_eventq, BENCH_EVENTQ_BURST);
+        } else {
+            os_eventq_run(&bench_eventq);
+        }
+    }
+}
+
+static void
+bench_eventq_burst(int batch)
+{
+    uint32_t start;
+    uint32_t ticks;
+    int rc;
+    int i;
+    int j;
+
+    bench_eventq_batch = batch;
+
+    start = os_cputime_get32();
+    for (i = 0; i < OS_BENCH_ITERATIONS / BENCH_EVENTQ_BURST; i++) {
+        for (j = 0; j < BENCH_EVENTQ_BURST; j++) {
+            os_eventq_put(&bench_eventq, &bench_eventq_evs[j]);
+        }
+        rc = os_sem_pend(&bench_eventq_sem, OS_TIMEOUT_NEVER);
+        assert(rc == 0);
+    }
+    ticks = os_cputime_get32() - start;
+
+    os_bench_report(batch ? "eventq_burst_run_batch" : "eventq_burst_run",
+                    i * BENCH_EVENTQ_BURST, ticks);
+}
+
+void
+os_bench_eventq(void)
+{
+    int i;
+
+    os_eventq_init(&bench_eventq);
+    os_sem_init(&bench_eventq_sem, 0);
+    for (i = 0; i < BENCH_EVENTQ_BURST; i++) {
+        bench_eventq_evs[i].ev_cb = bench_eventq_cb;
+    }
+
+    os_task_init(&bench_eventq_task, "bench_evq", bench_eventq_task_handler,
+                 NULL, BENCH_EVENTQ_PRIO, OS_WAIT_FOREVER,
+                 bench_eventq_stack, OS_BENCH_STACK_SIZE);
+
+    bench_eventq_burst(0);
+    bench_eventq_burst(1);
+}
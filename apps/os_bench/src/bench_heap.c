@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "os_bench.h"
+
+/*
+ * Heap benchmark.
+ *
+ * Replays a pseudo-random mix of os_malloc(), os_free() and os_realloc()
+ * calls over a fixed set of slots, with mostly small and occasionally large
+ * sizes, the way a long-running node churns its heap.  Reports the average
+ * and the worst-case time per call; the worst case is what bounds the
+ * latency of a real-time task that allocates.  With OS_HEAP_TLSF it also
+ * reports fragmentation: the share of free heap memory that is not part of
+ * the largest free block.  Compare the results with and without
+ * OS_HEAP_TLSF.
+ */
+
+#define BENCH_HEAP_SLOTS        (128)
+#define BENCH_HEAP_SMALL_MAX    (128)
+#define BENCH_HEAP_LARGE_MAX    (2048)
+
+static void *bench_heap_ptrs[BENCH_HEAP_SLOTS];
+static uint32_t bench_heap_seed;
+
+static uint32_t
+bench_heap_rand(void)
+{
+    bench_heap_seed = bench_heap_seed * 1103515245 + 12345;
+    return bench_heap_seed >> 8;
+}
+
+static size_t
+bench_heap_rand_size(void)
+{
+    if (bench_heap_rand() % 16 == 0) {
+        return 1 + bench_heap_rand() % BENCH_HEAP_LARGE_MAX;
+    } else {
+        return 1 + bench_heap_rand() % BENCH_HEAP_SMALL_MAX;
+    }
+}
+
+void
+os_bench_heap(void)
+{
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+    struct os_heap_info info;
+    uint32_t frag;
+#endif
+    uint32_t worst;
+    uint32_t total;
+    uint32_t start;
+    uint32_t ticks;
+    uint32_t op;
+    void *p;
+    int idx;
+    int i;
+
+    bench_heap_seed = 1;
+    worst = 0;
+    total = 0;
+
+    for (i = 0; i < OS_BENCH_ITERATIONS; i++) {
+        idx = bench_heap_rand() % BENCH_HEAP_SLOTS;
+        op = bench_heap_rand() % 4;
+
+        start = os_cputime_get32();
+        if (bench_heap_ptrs[idx] == NULL) {
+            bench_heap_ptrs[idx] = os_malloc(bench_heap_rand_size());
+        } else if (op == 0) {
+            p = os_realloc(bench_heap_ptrs[idx], bench_heap_rand_size());
+            if (p != NULL) {
+                bench_heap_ptrs[idx] = p;
+            }
+        } else {
+            os_free(bench_heap_ptrs[idx]);
+            bench_heap_ptrs[idx] = NULL;
+        }
+        ticks = os_cputime_get32() - start;
+
+        total += ticks;
+        if (ticks > worst) {
+            worst = ticks;
+        }
+    }
+
+    os_bench_report("heap_churn", OS_BENCH_ITERATIONS, total);
+    os_bench_report("heap_churn_worst", 1, worst);
+
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+    os_heap_info_get(&info);
+    frag = 0;
+    if (info.ohi_free != 0) {
+        frag = (uint64_t)(info.ohi_free - info.ohi_largest_free) * 100 /
+               info.ohi_free;
+    }
+    console_printf("%-32s %8" PRIu32 " used %8" PRIu32 " free %3" PRIu32
+                   "%% fragmented\n", "heap_churn_state",
+                   info.ohi_used, info.ohi_free, frag);
+#endif
+
+    for (i = 0; i < BENCH_HEAP_SLOTS; i++) {
+        os_free(bench_heap_ptrs[i]);
+        bench_heap_ptrs[i] = NULL;
+    }
+}
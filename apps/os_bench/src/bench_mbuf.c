@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "os_bench.h"
+
+/*
+ * Mbuf fan-out benchmark.
+ *
+ * Hands the same packet to a number of subscribers, as CoAP observe
+ * notifications and multicast over several interfaces do: each iteration
+ * makes one copy of the chain per subscriber with os_mbuf_dup() or
+ * os_mbuf_clone(), then frees them all.  Also reports how many pool blocks
+ * the copies occupy.  With OS_MBUF_CLONE disabled, os_mbuf_clone() is
+ * os_mbuf_dup().
+ */
+
+#define BENCH_MBUF_BUF_SIZE     (256)
+#define BENCH_MBUF_BUF_COUNT    (64)
+#define BENCH_MBUF_PKT_LEN      (512)
+#define BENCH_MBUF_MAX_SUBS     (8)
+
+static struct os_mbuf_pool bench_mbuf_pool;
+static struct os_mempool bench_mbuf_mempool;
+static os_membuf_t bench_mbuf_buf[
+    OS_MEMPOOL_SIZE(BENCH_MBUF_BUF_COUNT, BENCH_MBUF_BUF_SIZE)];
+
+static uint8_t bench_mbuf_data[BENCH_MBUF_PKT_LEN];
+
+static void
+bench_mbuf_fanout(const char *label, struct os_mbuf *(*copy)(struct os_mbuf *),
+                  struct os_mbuf *pkt, int num_subs)
+{
+    struct os_mbuf *subs[BENCH_MBUF_MAX_SUBS];
+    char name[32];
+    uint32_t start;
+    uint32_t ticks;
+    int used;
+    int i;
+    int j;
+
+    assert(num_subs <= BENCH_MBUF_MAX_SUBS);
+
+    used = 0;
+    start = os_cputime_get32();
+    for (i = 0; i < OS_BENCH_ITERATIONS; i++) {
+        for (j = 0; j < num_subs; j++) {
+            subs[j] = copy(pkt);
+            assert(subs[j] != NULL);
+        }
+        if (i == 0) {
+            used = bench_mbuf_mempool.mp_num_blocks -
+                   bench_mbuf_mempool.mp_num_free;
+        }
+        for (j = 0; j < num_subs; j++) {
+            os_mbuf_free_chain(subs[j]);
+        }
+    }
+    ticks = os_cputime_get32() - start;
+
+    snprintf(name, sizeof name, "%s(%d)", label, num_subs);
+    os_bench_report(name, OS_BENCH_ITERATIONS, ticks);
+    console_printf("%-32s %8d blocks in use\n", name, used);
+}
+
+void
+os_bench_mbuf(void)
+{
+    struct os_mbuf *pkt;
+    int rc;
+
+    rc = os_mempool_init(&bench_mbuf_mempool, BENCH_MBUF_BUF_COUNT,
+                         BENCH_MBUF_BUF_SIZE, bench_mbuf_buf,
+                         "bench_mbuf");
+    assert(rc == 0);
+    rc = os_mbuf_pool_init(&bench_mbuf_pool, &bench_mbuf_mempool,
+                           BENCH_MBUF_BUF_SIZE, BENCH_MBUF_BUF_COUNT);
+    assert(rc == 0);
+
+    pkt = os_mbuf_get_pkthdr(&bench_mbuf_pool, 0);
+    assert(pkt != NULL);
+    rc = os_mbuf_append(pkt, bench_mbuf_data, sizeof bench_mbuf_data);
+    assert(rc == 0);
+
+    bench_mbuf_fanout("mbuf_dup", os_mbuf_dup, pkt, 1);
+    bench_mbuf_fanout("mbuf_dup", os_mbuf_dup, pkt, BENCH_MBUF_MAX_SUBS);
+    bench_mbuf_fanout("mbuf_clone", os_mbuf_clone, pkt, 1);
+    bench_mbuf_fanout("mbuf_clone", os_mbuf_clone, pkt, BENCH_MBUF_MAX_SUBS);
+
+    os_mbuf_free_chain(pkt);
+}
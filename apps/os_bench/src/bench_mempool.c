@@ -0,0 +1,154 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "os_bench.h"
+
+/*
+ * Memory pool benchmarks.
+ *
+ * bench_mempool_single measures an os_memblock_get() / os_memblock_put() pair
+ * from the main task with no other users of the pool.
+ *
+ * bench_mempool_contended runs several tasks that all allocate and free
+ * blocks from the same pool.  Each task yields to the others every few
+ * hundred operations, so that the tick and the wakeups of the other tasks
+ * regularly preempt a get or put in progress.  The reported time is the wall
+ * clock time of the whole run divided by the total number of get/put pairs.
+ * Compare the results with and without OS_MEMPOOL_LOCKFREE.
+ */
+
+#define BENCH_MEMPOOL_BLOCKS        (32)
+#define BENCH_MEMPOOL_BLOCK_SIZE    (32)
+#define BENCH_MEMPOOL_MAX_TASKS     (4)
+#define BENCH_MEMPOOL_BASE_PRIO     (64)
+#define BENCH_MEMPOOL_YIELD_EVERY   (256)
+
+static struct os_mempool bench_mempool;
+static os_membuf_t bench_mempool_buf[
+    OS_MEMPOOL_SIZE(BENCH_MEMPOOL_BLOCKS, BENCH_MEMPOOL_BLOCK_SIZE)];
+
+static struct os_task bench_mempool_tasks[BENCH_MEMPOOL_MAX_TASKS];
+static os_stack_t
+bench_mempool_stacks[BENCH_MEMPOOL_MAX_TASKS][OS_BENCH_STACK_SIZE];
+static struct os_sem bench_mempool_sem;
+
+static void
+bench_mempool_run(int iters, int idx)
+{
+    void *blocks[2];
+    int rc;
+    int i;
+
+    for (i = 0; i < iters; i++) {
+        blocks[0] = os_memblock_get(&bench_mempool);
+        blocks[1] = os_memblock_get(&bench_mempool);
+        assert(blocks[0] != NULL && blocks[1] != NULL);
+        assert(blocks[0] != blocks[1]);
+
+        rc = os_memblock_put(&bench_mempool, blocks[1]);
+        assert(rc == 0);
+        rc = os_memblock_put(&bench_mempool, blocks[0]);
+        assert(rc == 0);
+
+        if (idx >= 0 && (i + idx) % BENCH_MEMPOOL_YIELD_EVERY == 0) {
+            os_time_delay(1);
+        }
+    }
+}
+
+static void
+bench_mempool_task_handler(void *arg)
+{
+    bench_mempool_run(OS_BENCH_ITERATIONS, (int)(uintptr_t)arg);
+    os_sem_release(&bench_mempool_sem);
+    os_time_delay(OS_TIMEOUT_NEVER);
+}
+
+static void
+bench_mempool_single(void)
+{
+    uint32_t start;
+    uint32_t ticks;
+
+    start = os_cputime_get32();
+    bench_mempool_run(OS_BENCH_ITERATIONS, -1);
+    ticks = os_cputime_get32() - start;
+
+    os_bench_report("mempool_get_put", OS_BENCH_ITERATIONS, ticks);
+}
+
+static void
+bench_mempool_contended(int num_tasks)
+{
+    char name[32];
+    uint32_t start;
+    uint32_t ticks;
+    int rc;
+    int i;
+
+    assert(num_tasks <= BENCH_MEMPOOL_MAX_TASKS);
+
+    os_sem_init(&bench_mempool_sem, 0);
+
+    start = os_cputime_get32();
+    for (i = 0; i < num_tasks; i++) {
+        rc = os_task_init(&bench_mempool_tasks[i], "bench_mempool",
+                          bench_mempool_task_handler,
+                          (void *)(uintptr_t)(i * BENCH_MEMPOOL_YIELD_EVERY /
+                                              num_tasks),
+                          BENCH_MEMPOOL_BASE_PRIO + i, OS_WAIT_FOREVER,
+                          bench_mempool_stacks[i], OS_BENCH_STACK_SIZE);
+        assert(rc == 0);
+    }
+    for (i = 0; i < num_tasks; i++) {
+        rc = os_sem_pend(&bench_mempool_sem, OS_TIMEOUT_NEVER);
+        assert(rc == 0);
+    }
+    ticks = os_cputime_get32() - start;
+
+    for (i = 0; i < num_tasks; i++) {
+        rc = os_task_remove(&bench_mempool_tasks[i]);
+        assert(rc == 0);
+    }
+
+    assert(bench_mempool.mp_num_free == BENCH_MEMPOOL_BLOCKS);
+    assert(os_mempool_is_sane(&bench_mempool));
+
+    snprintf(name, sizeof name, "mempool_contended(%d)", num_tasks);
+    os_bench_report(name, num_tasks * OS_BENCH_ITERATIONS, ticks);
+}
+
+void
+os_bench_mempool(void)
+{
+    int rc;
+
+    rc = os_mempool_init(&bench_mempool, BENCH_MEMPOOL_BLOCKS,
+                         BENCH_MEMPOOL_BLOCK_SIZE, bench_mempool_buf,
+                         "bench_mempool");
+    assert(rc == 0);
+
+    bench_mempool_single();
+    bench_mempool_contended(2);
+    bench_mempool_contended(BENCH_MEMPOOL_MAX_TASKS);
+}
@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "os_bench.h"
+
+/*
+ * Scheduler benchmarks.
+ *
+ * bench_sched_ready measures the cost of making a low priority task ready
+ * (and picking the next task) while a number of higher priority tasks are
+ * already in the run list.  With the sorted run list this cost grows with the
+ * number of ready tasks; with OS_SCHED_PRIO_BITMAP it stays constant.  The
+ * run list is populated with dummy tasks that never actually run: everything
+ * happens inside a single critical section.
+ *
+ * bench_sched_ctx_sw measures the semaphore ping-pong round trip between two
+ * real tasks, i.e. two wakeups and two context switches.
+ */
+
+#define BENCH_SCHED_MAX_READY   (64)
+#define BENCH_SCHED_PROBE_PRIO  (OS_IDLE_PRIO - 1)
+
+static struct os_task bench_sched_dummy[BENCH_SCHED_MAX_READY];
+static struct os_task bench_sched_probe;
+
+static struct os_task bench_sched_task1;
+static struct os_task bench_sched_task2;
+static os_stack_t bench_sched_stack1[OS_BENCH_STACK_SIZE];
+static os_stack_t bench_sched_stack2[OS_BENCH_STACK_SIZE];
+static struct os_sem bench_sched_sem1;
+static struct os_sem bench_sched_sem2;
+static struct os_sem bench_sched_done;
+static uint32_t bench_sched_ticks;
+
+static void
+bench_sched_dummy_add(struct os_task *t, uint8_t prio)
+{
+    memset(t, 0, sizeof *t);
+    t->t_name = "bench";
+    t->t_prio = prio;
+    t->t_state = OS_TASK_READY;
+    STAILQ_INSERT_TAIL(&g_os_task_list, t, t_os_task_list);
+    os_sched_insert(t);
+}
+
+static void
+bench_sched_ready(int num_ready)
+{
+    char name[32];
+    uint32_t start;
+    uint32_t ticks;
+    os_sr_t sr;
+    int i;
+
+    assert(num_ready <= BENCH_SCHED_MAX_READY);
+
+    OS_ENTER_CRITICAL(sr);
+
+    for (i = 0; i < num_ready; i++) {
+        bench_sched_dummy_add(&bench_sched_dummy[i], i + 1);
+    }
+    bench_sched_dummy_add(&bench_sched_probe, BENCH_SCHED_PROBE_PRIO);
+
+    start = os_cputime_get32();
+    for (i = 0; i < OS_BENCH_ITERATIONS; i++) {
+        os_sched_sleep(&bench_sched_probe, OS_TIMEOUT_NEVER);
+        os_sched_wakeup(&bench_sched_probe);
+        (void)os_sched_next_task();
+    }
+    ticks = os_cputime_get32() - start;
+
+    os_sched_remove(&bench_sched_probe);
+    for (i = 0; i < num_ready; i++) {
+        os_sched_remove(&bench_sched_dummy[i]);
+    }
+
+    OS_EXIT_CRITICAL(sr);
+
+    snprintf(name, sizeof name, "sched_ready(%d)", num_ready);
+    os_bench_report(name, OS_BENCH_ITERATIONS, ticks);
+}
+
+static void
+bench_sched_task1_handler(void *arg)
+{
+    uint32_t start;
+    int i;
+
+    while (1) {
+        os_sem_pend(&bench_sched_done, OS_TIMEOUT_NEVER);
+
+        start = os_cputime_get32();
+        for (i = 0; i < OS_BENCH_ITERATIONS; i++) {
+            os_sem_release(&bench_sched_sem2);
+            os_sem_pend(&bench_sched_sem1, OS_TIMEOUT_NEVER);
+        }
+        bench_sched_ticks = os_cputime_get32() - start;
+
+        os_sem_release(&bench_sched_done);
+        os_time_delay(1);
+    }
+}
+
+static void
+bench_sched_task2_handler(void *arg)
+{
+    while (1) {
+        os_sem_pend(&bench_sched_sem2, OS_TIMEOUT_NEVER);
+        os_sem_release(&bench_sched_sem1);
+    }
+}
+
+static void
+bench_sched_ctx_sw(void)
+{
+    os_sem_init(&bench_sched_sem1, 0);
+    os_sem_init(&bench_sched_sem2, 0);
+    os_sem_init(&bench_sched_done, 0);
+
+    os_task_init(&bench_sched_task1, "bench_ctx1", bench_sched_task1_handler,
+                 NULL, OS_BENCH_TASK1_PRIO, OS_WAIT_FOREVER,
+                 bench_sched_stack1, OS_BENCH_STACK_SIZE);
+    os_task_init(&bench_sched_task2, "bench_ctx2", bench_sched_task2_handler,
+                 NULL, OS_BENCH_TASK2_PRIO, OS_WAIT_FOREVER,
+                 bench_sched_stack2, OS_BENCH_STACK_SIZE);
+
+    /* Kick off task1; it preempts this task immediately and releases the
+     * semaphore again when it is finished.
+     */
+    os_sem_release(&bench_sched_done);
+    os_sem_pend(&bench_sched_done, OS_TIMEOUT_NEVER);
+
+    os_bench_report("sched_ctx_sw_round_trip", OS_BENCH_ITERATIONS,
+                    bench_sched_ticks);
+}
+
+void
+os_bench_sched(void)
+{
+    bench_sched_ready(0);
+    bench_sched_ready(8);
+    bench_sched_ready(32);
+    bench_sched_ready(BENCH_SCHED_MAX_READY);
+    bench_sched_ctx_sw();
+}
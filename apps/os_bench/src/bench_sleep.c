@@ -0,0 +1,177 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "os_bench.h"
+
+/*
+ * Sleep list benchmarks.
+ *
+ * bench_sleep_insert measures putting a task to sleep and waking it up again
+ * while a number of other tasks are already sleeping with later wakeup times.
+ * As in the scheduler benchmark, the sleepers are dummy tasks that only exist
+ * inside a critical section.
+ *
+ * bench_sleep_tick runs a set of real tasks that repeatedly sleep for short,
+ * staggered periods and reports the time spent in the tick handler waking
+ * them up, as collected by OS_SCHED_TIMER_EXP_MONITOR.
+ */
+
+#define BENCH_SLEEP_MAX_TASKS   (48)
+#define BENCH_SLEEP_BASE_PRIO   (64)
+#define BENCH_SLEEP_STACK_SIZE  OS_STACK_ALIGN(512)
+#define BENCH_SLEEP_RUN_TICKS   (2 * OS_TICKS_PER_SEC)
+
+static struct os_task bench_sleep_dummy[BENCH_SLEEP_MAX_TASKS];
+static struct os_task bench_sleep_probe;
+
+static struct os_task bench_sleep_tasks[BENCH_SLEEP_MAX_TASKS];
+static os_stack_t
+bench_sleep_stacks[BENCH_SLEEP_MAX_TASKS][BENCH_SLEEP_STACK_SIZE];
+static volatile int bench_sleep_done;
+
+static void
+bench_sleep_dummy_add(struct os_task *t, uint8_t prio)
+{
+    memset(t, 0, sizeof *t);
+    t->t_name = "bench";
+    t->t_prio = prio;
+    t->t_state = OS_TASK_READY;
+    STAILQ_INSERT_TAIL(&g_os_task_list, t, t_os_task_list);
+    os_sched_insert(t);
+}
+
+static void
+bench_sleep_insert(int num_sleeping)
+{
+    char name[32];
+    uint32_t start;
+    uint32_t ticks;
+    os_sr_t sr;
+    int i;
+
+    assert(num_sleeping <= BENCH_SLEEP_MAX_TASKS);
+
+    OS_ENTER_CRITICAL(sr);
+
+    for (i = 0; i < num_sleeping; i++) {
+        bench_sleep_dummy_add(&bench_sleep_dummy[i], BENCH_SLEEP_BASE_PRIO);
+        os_sched_sleep(&bench_sleep_dummy[i], OS_TICKS_PER_SEC * (i + 1));
+    }
+    bench_sleep_dummy_add(&bench_sleep_probe, OS_IDLE_PRIO - 1);
+
+    start = os_cputime_get32();
+    for (i = 0; i < OS_BENCH_ITERATIONS; i++) {
+        os_sched_sleep(&bench_sleep_probe, OS_TICKS_PER_SEC * 3600);
+        os_sched_wakeup(&bench_sleep_probe);
+    }
+    ticks = os_cputime_get32() - start;
+
+    os_sched_remove(&bench_sleep_probe);
+    for (i = 0; i < num_sleeping; i++) {
+        os_sched_remove(&bench_sleep_dummy[i]);
+    }
+
+    OS_EXIT_CRITICAL(sr);
+
+    snprintf(name, sizeof name, "sleep_insert(%d)", num_sleeping);
+    os_bench_report(name, OS_BENCH_ITERATIONS, ticks);
+}
+
+static void
+bench_sleep_task_handler(void *arg)
+{
+    int period;
+
+    period = 1 + (int)(uintptr_t)arg % 7;
+    while (!bench_sleep_done) {
+        os_time_delay(period);
+    }
+    os_time_delay(OS_TIMEOUT_NEVER);
+}
+
+static void
+bench_sleep_tick(int num_tasks)
+{
+#if MYNEWT_VAL(OS_SCHED_TIMER_EXP_MONITOR)
+    struct os_sched_timer_mon mon;
+    os_sr_t sr;
+#endif
+    int rc;
+    int i;
+
+    assert(num_tasks <= BENCH_SLEEP_MAX_TASKS);
+
+    bench_sleep_done = 0;
+    for (i = 0; i < num_tasks; i++) {
+        rc = os_task_init(&bench_sleep_tasks[i], "bench_sleep",
+                          bench_sleep_task_handler, (void *)(uintptr_t)i,
+                          BENCH_SLEEP_BASE_PRIO + i, OS_WAIT_FOREVER,
+                          bench_sleep_stacks[i], BENCH_SLEEP_STACK_SIZE);
+        assert(rc == 0);
+    }
+
+#if MYNEWT_VAL(OS_SCHED_TIMER_EXP_MONITOR)
+    OS_ENTER_CRITICAL(sr);
+    memset(&g_os_sched_timer_mon, 0, sizeof g_os_sched_timer_mon);
+    OS_EXIT_CRITICAL(sr);
+#endif
+
+    os_time_delay(BENCH_SLEEP_RUN_TICKS);
+
+#if MYNEWT_VAL(OS_SCHED_TIMER_EXP_MONITOR)
+    OS_ENTER_CRITICAL(sr);
+    mon = g_os_sched_timer_mon;
+    OS_EXIT_CRITICAL(sr);
+#endif
+
+    bench_sleep_done = 1;
+    os_time_delay(OS_TICKS_PER_SEC / 10);
+    for (i = 0; i < num_tasks; i++) {
+        rc = os_task_remove(&bench_sleep_tasks[i]);
+        assert(rc == 0);
+    }
+
+#if MYNEWT_VAL(OS_SCHED_TIMER_EXP_MONITOR)
+    console_printf("sleep_tick(%d): calls=%" PRIu32 " avg=%" PRIu32
+                   " min=%" PRIu32 " max=%" PRIu32 " usecs woken_max=%" PRIu32
+                   "\n",
+                   num_tasks, mon.stm_cnt,
+                   mon.stm_cnt ?
+                       os_cputime_ticks_to_usecs(mon.stm_cum) / mon.stm_cnt :
+                       0,
+                   os_cputime_ticks_to_usecs(mon.stm_min),
+                   os_cputime_ticks_to_usecs(mon.stm_max),
+                   mon.stm_woken_max);
+#endif
+}
+
+void
+os_bench_sleep(void)
+{
+    bench_sleep_insert(0);
+    bench_sleep_insert(8);
+    bench_sleep_insert(BENCH_SLEEP_MAX_TASKS);
+    bench_sleep_tick(8);
+    bench_sleep_tick(BENCH_SLEEP_MAX_TASKS);
+}
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "os_bench.h"
+#ifdef ARCH_sim
+#include "sim/sim.h"
+#endif
+
+/*
+ * Wakeup coalescing benchmark.
+ *
+ * A handful of periodic callouts with unrelated periods run for a few
+ * seconds while the main task sleeps, first without slack and then with a
+ * slack of an eighth of each period.  The benchmark reports the number of
+ * distinct ticks on which callouts fired per second, i.e. the wakeups the
+ * timers cost on a tickless target, and on the native BSP also the number
+ * of times the simulated CPU actually came out of idle per second.  Slack
+ * only has an effect with OS_CALLOUT_SLACK.
+ */
+
+#define BENCH_WAKEUP_SECS       (4)
+#define BENCH_WAKEUP_CNT        (5)
+#define BENCH_WAKEUP_PRIO       (MYNEWT_VAL(OS_MAIN_TASK_PRIO) + 2)
+
+static struct os_eventq bench_wakeup_evq;
+static struct os_callout bench_wakeup_callouts[BENCH_WAKEUP_CNT];
+static struct os_task bench_wakeup_task;
+static os_stack_t bench_wakeup_stack[OS_BENCH_STACK_SIZE];
+
+/* Periods in milliseconds. */
+static const uint32_t bench_wakeup_periods[BENCH_WAKEUP_CNT] = {
+    100, 130, 170, 230, 290,
+};
+
+static os_time_t bench_wakeup_last;
+static uint32_t bench_wakeup_fires;
+static uint32_t bench_wakeup_ticks;
+
+static void
+bench_wakeup_cb(struct os_event *ev)
+{
+    struct os_callout *c;
+    os_time_t now;
+    int idx;
+
+    c = ev->ev_arg;
+    idx = c - bench_wakeup_callouts;
+
+    now = os_time_get();
+    if (bench_wakeup_fires == 0 || now != bench_wakeup_last) {
+        bench_wakeup_ticks++;
+        bench_wakeup_last = now;
+    }
+    bench_wakeup_fires++;
+
+    os_callout_reset(c, os_time_ms_to_ticks32(bench_wakeup_periods[idx]));
+}
+
+static void
+bench_wakeup_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&bench_wakeup_evq);
+    }
+}
+
+static void
+bench_wakeup_run(int slack)
+{
+    uint32_t period;
+    int i;
+
+    bench_wakeup_fires = 0;
+    bench_wakeup_ticks = 0;
+
+    for (i = 0; i < BENCH_WAKEUP_CNT; i++) {
+        period = bench_wakeup_periods[i];
+        os_callout_set_slack(&bench_wakeup_callouts[i],
+                             slack ? os_time_ms_to_ticks32(period / 8) : 0);
+        os_callout_reset(&bench_wakeup_callouts[i],
+                         os_time_ms_to_ticks32(period));
+    }
+
+#ifdef ARCH_sim
+    sim_wakeup_stats_reset();
+#endif
+
+    os_time_delay(BENCH_WAKEUP_SECS * OS_TICKS_PER_SEC);
+
+    for (i = 0; i < BENCH_WAKEUP_CNT; i++) {
+        os_callout_stop(&bench_wakeup_callouts[i]);
+    }
+
+    console_printf("%-32s %8" PRIu32 " fires %6" PRIu32 " timer wakeups/s",
+                   slack ? "wakeup_slack" : "wakeup_exact",
+                   bench_wakeup_fires, bench_wakeup_ticks / BENCH_WAKEUP_SECS);
+#ifdef ARCH_sim
+    console_printf(" %6" PRIu32 " idle wakeups/s", sim_wakeups_per_sec());
+#endif
+    console_printf("\n");
+}
+
+void
+os_bench_wakeup(void)
+{
+    int i;
+
+    os_eventq_init(&bench_wakeup_evq);
+    for (i = 0; i < BENCH_WAKEUP_CNT; i++) {
+        os_callout_init(&bench_wakeup_callouts[i], &bench_wakeup_evq,
+                        bench_wakeup_cb, &bench_wakeup_callouts[i]);
+    }
+
+    os_task_init(&bench_wakeup_task, "bench_wakeup",
+                 bench_wakeup_task_handler, NULL, BENCH_WAKEUP_PRIO,
+                 OS_WAIT_FOREVER, bench_wakeup_stack, OS_BENCH_STACK_SIZE);
+
+    bench_wakeup_run(0);
+    bench_wakeup_run(1);
+}
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "os_bench.h"
+
+void
+os_bench_report(const char *name, uint32_t iters, uint32_t ticks)
+{
+    uint64_t nsecs;
+
+    nsecs = (uint64_t)os_cputime_ticks_to_usecs(ticks) * 1000;
+    console_printf("%-32s %8" PRIu32 " iters %10" PRIu32 " ns/iter\n",
+                   name, iters, (uint32_t)(nsecs / iters));
+}
+
+/**
+ * main
+ *
+ * Runs every benchmark once from the main task, then goes idle.
+ *
+ * @return int NOTE: this function should never return!
+ */
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    console_printf("os_bench: start\n");
+    os_bench_sched();
+    os_bench_callout();
+    os_bench_sleep();
+    os_bench_mempool();
+    os_bench_mbuf();
+    os_bench_eventq();
+    os_bench_wakeup();
+    os_bench_heap();
+    console_printf("os_bench: done\n");
+
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+    assert(0);
+
+    return 0;
+}
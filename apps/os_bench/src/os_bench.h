@@ -0,0 +1,57 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_OS_BENCH_
+#define H_OS_BENCH_
+
+#include <inttypes.h>
+#include "os/mynewt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OS_BENCH_ITERATIONS     MYNEWT_VAL(OS_BENCH_ITERATIONS)
+
+/* Priorities of the helper tasks; higher than the main task. */
+#define OS_BENCH_TASK1_PRIO     (MYNEWT_VAL(OS_MAIN_TASK_PRIO) - 2)
+#define OS_BENCH_TASK2_PRIO     (MYNEWT_VAL(OS_MAIN_TASK_PRIO) - 1)
+
+#define OS_BENCH_STACK_SIZE     OS_STACK_ALIGN(1024)
+
+/**
+ * Prints a single result line: the benchmark name, the number of iterations
+ * and the average time per iteration in nanoseconds.
+ */
+void os_bench_report(const char *name, uint32_t iters, uint32_t ticks);
+
+void os_bench_sched(void);
+void os_bench_callout(void);
+void os_bench_sleep(void);
+void os_bench_mempool(void);
+void os_bench_mbuf(void);
+void os_bench_eventq(void);
+void os_bench_wakeup(void);
+void os_bench_heap(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
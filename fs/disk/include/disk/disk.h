@@ -35,6 +35,13 @@ extern "C" {
 #define DISK_EOS          4  /* OS error */
 #define DISK_EUNINIT      5  /* File system not initialized */
 
+/* Commands for the ioctl disk operation.  A driver returns nonzero for a
+ * command it does not support.
+ */
+#define DISK_IOCTL_SYNC             1  /* Complete any buffered writes */
+#define DISK_IOCTL_GET_SIZE         2  /* uint32_t: disk size in bytes */
+#define DISK_IOCTL_GET_ERASE_SIZE   3  /* uint32_t: erase block size in bytes */
+
 struct disk_ops {
     int (*read)(uint8_t, uint32_t, void *, uint32_t);
     int (*write)(uint8_t, uint32_t, const void *, uint32_t);
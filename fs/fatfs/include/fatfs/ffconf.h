@@ -4,6 +4,8 @@
 
 #define _FFCONF 68020	/* Revision ID */
 
+#include "syscfg/syscfg.h"
+
 /*---------------------------------------------------------------------------/
 / Function Configurations
 /---------------------------------------------------------------------------*/
@@ -39,7 +41,7 @@
 /  f_findnext(). (0:Disable, 1:Enable 2:Enable with matching altname[] too) */
 
 
-#define	_USE_MKFS		0
+#define	_USE_MKFS		MYNEWT_VAL(FATFS_USE_MKFS)
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
@@ -578,60 +578,484 @@ static struct disk_ops *dops_from_handle(BYTE pdrv)
     return NULL;
 }
 
-DRESULT
-disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
+#define FATFS_SECTOR_SIZE           _MAX_SS
+#define FATFS_CACHE_SECTORS         MYNEWT_VAL(FATFS_CACHE_SECTORS)
+#define FATFS_CACHE_XFER_SECTORS    MYNEWT_VAL(FATFS_CACHE_XFER_SECTORS)
+
+#if FATFS_CACHE_SECTORS > 0
+
+/*
+ * Write-back sector cache.
+ *
+ * Single-sector requests, which FatFs issues for FAT and directory sectors
+ * and for partial file sectors, go through a small LRU cache.  Writes are
+ * deferred until the sector is evicted or FatFs requests a CTRL_SYNC.
+ * Multi-sector requests carry whole file sectors; they go straight to the
+ * disk as a single transfer and only consult the cache to stay coherent with
+ * it.
+ *
+ * When dirty sectors are written back, runs of consecutive sectors are
+ * gathered into one transfer of up to FATFS_CACHE_XFER_SECTORS sectors.
+ *
+ * NOTE: like the rest of this file, the cache assumes FatFs is only used
+ * from a single task.
+ */
+
+#define FATFS_CACHE_PDRV_NONE       0xff
+
+#define FATFS_CACHE_F_DIRTY         0x01
+
+struct fatfs_cache_sector {
+    TAILQ_ENTRY(fatfs_cache_sector) fcs_lru;
+    DWORD fcs_sector;
+    BYTE fcs_pdrv;
+    uint8_t fcs_flags;
+    uint8_t *fcs_data;
+};
+
+TAILQ_HEAD(fatfs_cache_list, fatfs_cache_sector);
+
+static struct fatfs_cache_sector fatfs_cache_sectors[FATFS_CACHE_SECTORS];
+static uint8_t fatfs_cache_data[FATFS_CACHE_SECTORS][FATFS_SECTOR_SIZE];
+
+/* Most recently used sector first. */
+static struct fatfs_cache_list fatfs_cache_lru =
+    TAILQ_HEAD_INITIALIZER(fatfs_cache_lru);
+
+#if FATFS_CACHE_XFER_SECTORS > 1
+static uint8_t fatfs_cache_xfer_buf[FATFS_CACHE_XFER_SECTORS *
+                                    FATFS_SECTOR_SIZE];
+#endif
+
+static void
+fatfs_cache_init(void)
 {
+    struct fatfs_cache_sector *cs;
+    int i;
+
+    TAILQ_INIT(&fatfs_cache_lru);
+    for (i = 0; i < FATFS_CACHE_SECTORS; i++) {
+        cs = fatfs_cache_sectors + i;
+        cs->fcs_pdrv = FATFS_CACHE_PDRV_NONE;
+        cs->fcs_flags = 0;
+        cs->fcs_data = fatfs_cache_data[i];
+        TAILQ_INSERT_TAIL(&fatfs_cache_lru, cs, fcs_lru);
+    }
+}
+
+static struct fatfs_cache_sector *
+fatfs_cache_find(BYTE pdrv, DWORD sector)
+{
+    struct fatfs_cache_sector *cs;
+    int i;
+
+    for (i = 0; i < FATFS_CACHE_SECTORS; i++) {
+        cs = fatfs_cache_sectors + i;
+        if (cs->fcs_pdrv == pdrv && cs->fcs_sector == sector) {
+            return cs;
+        }
+    }
+
+    return NULL;
+}
+
+static struct fatfs_cache_sector *
+fatfs_cache_find_dirty(BYTE pdrv, DWORD sector)
+{
+    struct fatfs_cache_sector *cs;
+
+    cs = fatfs_cache_find(pdrv, sector);
+    if (cs == NULL || !(cs->fcs_flags & FATFS_CACHE_F_DIRTY)) {
+        return NULL;
+    }
+
+    return cs;
+}
+
+static void
+fatfs_cache_touch(struct fatfs_cache_sector *cs)
+{
+    TAILQ_REMOVE(&fatfs_cache_lru, cs, fcs_lru);
+    TAILQ_INSERT_HEAD(&fatfs_cache_lru, cs, fcs_lru);
+}
+
+static void
+fatfs_cache_discard(struct fatfs_cache_sector *cs)
+{
+    cs->fcs_pdrv = FATFS_CACHE_PDRV_NONE;
+    cs->fcs_flags = 0;
+    TAILQ_REMOVE(&fatfs_cache_lru, cs, fcs_lru);
+    TAILQ_INSERT_TAIL(&fatfs_cache_lru, cs, fcs_lru);
+}
+
+/**
+ * Writes back a dirty sector, together with as many dirty neighbours as fit
+ * in a single transfer.
+ */
+static DRESULT
+fatfs_cache_write_back(struct disk_ops *dops, struct fatfs_cache_sector *cs)
+{
+#if FATFS_CACHE_XFER_SECTORS > 1
+    struct fatfs_cache_sector *run[FATFS_CACHE_XFER_SECTORS];
+    struct fatfs_cache_sector *prev;
+    DWORD sector;
+    BYTE pdrv;
+    int count;
     int rc;
-    uint32_t address;
-    uint32_t num_bytes;
-    struct disk_ops *dops;
+    int i;
 
-    /* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
-    address = (uint32_t) sector * 512;
-    num_bytes = (uint32_t) count * 512;
+    pdrv = cs->fcs_pdrv;
 
-    dops = dops_from_handle(pdrv);
-    if (dops == NULL) {
-        return STA_NOINIT;
+    /* Back up to the start of the run, keeping the requested sector within
+     * the transfer.
+     */
+    for (i = 1; i < FATFS_CACHE_XFER_SECTORS && cs->fcs_sector != 0; i++) {
+        prev = fatfs_cache_find_dirty(pdrv, cs->fcs_sector - 1);
+        if (prev == NULL) {
+            break;
+        }
+        cs = prev;
+    }
+
+    sector = cs->fcs_sector;
+    count = 0;
+    while (cs != NULL && count < FATFS_CACHE_XFER_SECTORS) {
+        memcpy(fatfs_cache_xfer_buf + count * FATFS_SECTOR_SIZE, cs->fcs_data,
+               FATFS_SECTOR_SIZE);
+        run[count++] = cs;
+        cs = fatfs_cache_find_dirty(pdrv, sector + count);
+    }
+
+    rc = dops->write(pdrv, sector * FATFS_SECTOR_SIZE, fatfs_cache_xfer_buf,
+                     count * FATFS_SECTOR_SIZE);
+    if (rc != 0) {
+        return RES_ERROR;
+    }
+
+    for (i = 0; i < count; i++) {
+        run[i]->fcs_flags &= ~FATFS_CACHE_F_DIRTY;
     }
+#else
+    int rc;
 
-    rc = dops->read(pdrv, address, (void *) buff, num_bytes);
-    if (rc < 0) {
-        return STA_NOINIT;
+    rc = dops->write(cs->fcs_pdrv, cs->fcs_sector * FATFS_SECTOR_SIZE,
+                     cs->fcs_data, FATFS_SECTOR_SIZE);
+    if (rc != 0) {
+        return RES_ERROR;
     }
+    cs->fcs_flags &= ~FATFS_CACHE_F_DIRTY;
+#endif
 
     return RES_OK;
 }
 
-DRESULT
-disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
+/**
+ * Writes back every dirty sector belonging to the specified drive.
+ */
+static DRESULT
+fatfs_cache_sync(BYTE pdrv, struct disk_ops *dops)
 {
+    struct fatfs_cache_sector *cs;
+    DRESULT res;
+    int i;
+
+    for (i = 0; i < FATFS_CACHE_SECTORS; i++) {
+        cs = fatfs_cache_sectors + i;
+        if (cs->fcs_pdrv == pdrv && cs->fcs_flags & FATFS_CACHE_F_DIRTY) {
+            res = fatfs_cache_write_back(dops, cs);
+            if (res != RES_OK) {
+                return res;
+            }
+        }
+    }
+
+    return RES_OK;
+}
+
+/**
+ * Claims the least recently used cache entry for the specified sector,
+ * writing back its previous contents if necessary.  The entry's data is left
+ * uninitialized.
+ */
+static DRESULT
+fatfs_cache_alloc(BYTE pdrv, struct disk_ops *dops, DWORD sector,
+                  struct fatfs_cache_sector **out_cs)
+{
+    struct fatfs_cache_sector *cs;
+    struct disk_ops *victim_dops;
+    DRESULT res;
+
+    cs = TAILQ_LAST(&fatfs_cache_lru, fatfs_cache_list);
+    if (cs->fcs_flags & FATFS_CACHE_F_DIRTY) {
+        victim_dops = dops;
+        if (cs->fcs_pdrv != pdrv) {
+            victim_dops = dops_from_handle(cs->fcs_pdrv);
+        }
+
+        /* A sector of a drive that is no longer known cannot be written
+         * anywhere; drop it.
+         */
+        if (victim_dops != NULL) {
+            res = fatfs_cache_write_back(victim_dops, cs);
+            if (res != RES_OK) {
+                return res;
+            }
+        }
+    }
+
+    cs->fcs_pdrv = pdrv;
+    cs->fcs_sector = sector;
+    cs->fcs_flags = 0;
+    fatfs_cache_touch(cs);
+
+    *out_cs = cs;
+    return RES_OK;
+}
+
+static DRESULT
+fatfs_cache_read(BYTE pdrv, struct disk_ops *dops, BYTE *buff, DWORD sector,
+                 UINT count)
+{
+    struct fatfs_cache_sector *cs;
+    DRESULT res;
     int rc;
-    uint32_t address;
-    uint32_t num_bytes;
+    int i;
+
+    if (count == 1) {
+        cs = fatfs_cache_find(pdrv, sector);
+        if (cs == NULL) {
+            res = fatfs_cache_alloc(pdrv, dops, sector, &cs);
+            if (res != RES_OK) {
+                return res;
+            }
+
+            rc = dops->read(pdrv, sector * FATFS_SECTOR_SIZE, cs->fcs_data,
+                            FATFS_SECTOR_SIZE);
+            if (rc != 0) {
+                fatfs_cache_discard(cs);
+                return RES_ERROR;
+            }
+        } else {
+            fatfs_cache_touch(cs);
+        }
+
+        memcpy(buff, cs->fcs_data, FATFS_SECTOR_SIZE);
+        return RES_OK;
+    }
+
+    rc = dops->read(pdrv, sector * FATFS_SECTOR_SIZE, buff,
+                    count * FATFS_SECTOR_SIZE);
+    if (rc != 0) {
+        return RES_ERROR;
+    }
+
+    /* Sectors that have not been written back yet are newer than what was
+     * just read from the disk.
+     */
+    for (i = 0; i < FATFS_CACHE_SECTORS; i++) {
+        cs = fatfs_cache_sectors + i;
+        if (cs->fcs_pdrv == pdrv && cs->fcs_flags & FATFS_CACHE_F_DIRTY &&
+            cs->fcs_sector - sector < count) {
+
+            memcpy(buff + (cs->fcs_sector - sector) * FATFS_SECTOR_SIZE,
+                   cs->fcs_data, FATFS_SECTOR_SIZE);
+        }
+    }
+
+    return RES_OK;
+}
+
+static DRESULT
+fatfs_cache_write(BYTE pdrv, struct disk_ops *dops, const BYTE *buff,
+                  DWORD sector, UINT count)
+{
+    struct fatfs_cache_sector *cs;
+    DRESULT res;
+    int rc;
+    int i;
+
+    if (count == 1) {
+        cs = fatfs_cache_find(pdrv, sector);
+        if (cs == NULL) {
+            res = fatfs_cache_alloc(pdrv, dops, sector, &cs);
+            if (res != RES_OK) {
+                return res;
+            }
+        } else {
+            fatfs_cache_touch(cs);
+        }
+
+        memcpy(cs->fcs_data, buff, FATFS_SECTOR_SIZE);
+        cs->fcs_flags |= FATFS_CACHE_F_DIRTY;
+        return RES_OK;
+    }
+
+    rc = dops->write(pdrv, sector * FATFS_SECTOR_SIZE, buff,
+                     count * FATFS_SECTOR_SIZE);
+    if (rc != 0) {
+        return RES_ERROR;
+    }
+
+    /* Cached copies of the written sectors are now stale, and any pending
+     * write-back of them is superseded.
+     */
+    for (i = 0; i < FATFS_CACHE_SECTORS; i++) {
+        cs = fatfs_cache_sectors + i;
+        if (cs->fcs_pdrv == pdrv && cs->fcs_sector - sector < count) {
+            memcpy(cs->fcs_data,
+                   buff + (cs->fcs_sector - sector) * FATFS_SECTOR_SIZE,
+                   FATFS_SECTOR_SIZE);
+            cs->fcs_flags &= ~FATFS_CACHE_F_DIRTY;
+        }
+    }
+
+    return RES_OK;
+}
+
+#else /* FATFS_CACHE_SECTORS > 0 */
+
+static void
+fatfs_cache_init(void)
+{
+}
+
+static DRESULT
+fatfs_cache_sync(BYTE pdrv, struct disk_ops *dops)
+{
+    return RES_OK;
+}
+
+static DRESULT
+fatfs_cache_read(BYTE pdrv, struct disk_ops *dops, BYTE *buff, DWORD sector,
+                 UINT count)
+{
+    int rc;
+
+    rc = dops->read(pdrv, sector * FATFS_SECTOR_SIZE, buff,
+                    count * FATFS_SECTOR_SIZE);
+    if (rc != 0) {
+        return RES_ERROR;
+    }
+
+    return RES_OK;
+}
+
+static DRESULT
+fatfs_cache_write(BYTE pdrv, struct disk_ops *dops, const BYTE *buff,
+                  DWORD sector, UINT count)
+{
+    int rc;
+
+    rc = dops->write(pdrv, sector * FATFS_SECTOR_SIZE, buff,
+                     count * FATFS_SECTOR_SIZE);
+    if (rc != 0) {
+        return RES_ERROR;
+    }
+
+    return RES_OK;
+}
+
+#endif /* FATFS_CACHE_SECTORS > 0 */
+
+DRESULT
+disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
+{
     struct disk_ops *dops;
 
-    /* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
-    address = (uint32_t) sector * 512;
-    num_bytes = (uint32_t) count * 512;
+    dops = dops_from_handle(pdrv);
+    if (dops == NULL) {
+        return RES_NOTRDY;
+    }
+
+    return fatfs_cache_read(pdrv, dops, buff, sector, count);
+}
+
+DRESULT
+disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
+{
+    struct disk_ops *dops;
 
     dops = dops_from_handle(pdrv);
     if (dops == NULL) {
-        return STA_NOINIT;
+        return RES_NOTRDY;
+    }
+
+    return fatfs_cache_write(pdrv, dops, buff, sector, count);
+}
+
+/**
+ * Queries the disk driver for a size, in bytes.
+ *
+ * @return                      The size, or 0 if the driver does not report
+ *                                  it.
+ */
+static uint32_t
+disk_ioctl_get_size(BYTE pdrv, struct disk_ops *dops, uint32_t cmd)
+{
+    uint32_t size;
+    int rc;
+
+    if (dops->ioctl == NULL) {
+        return 0;
     }
 
-    rc = dops->write(pdrv, address, (const void *) buff, num_bytes);
-    if (rc < 0) {
-        return STA_NOINIT;
+    size = 0;
+    rc = dops->ioctl(pdrv, cmd, &size);
+    if (rc != 0) {
+        return 0;
     }
 
-    return RES_OK;
+    return size;
 }
 
 DRESULT
 disk_ioctl(BYTE pdrv, BYTE cmd, void* buff)
 {
-    return RES_OK;
+    struct disk_ops *dops;
+    uint32_t size;
+    DRESULT res;
+    int rc;
+
+    dops = dops_from_handle(pdrv);
+    if (dops == NULL) {
+        return RES_NOTRDY;
+    }
+
+    switch (cmd) {
+    case CTRL_SYNC:
+        res = fatfs_cache_sync(pdrv, dops);
+        if (res != RES_OK) {
+            return res;
+        }
+        if (dops->ioctl != NULL) {
+            rc = dops->ioctl(pdrv, DISK_IOCTL_SYNC, NULL);
+            if (rc != 0) {
+                return RES_ERROR;
+            }
+        }
+        return RES_OK;
+
+    case GET_SECTOR_COUNT:
+        size = disk_ioctl_get_size(pdrv, dops, DISK_IOCTL_GET_SIZE);
+        if (size == 0) {
+            return RES_ERROR;
+        }
+        *(DWORD *)buff = size / FATFS_SECTOR_SIZE;
+        return RES_OK;
+
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = FATFS_SECTOR_SIZE;
+        return RES_OK;
+
+    case GET_BLOCK_SIZE:
+        /* Erase block size in sectors; 1 if unknown. */
+        size = disk_ioctl_get_size(pdrv, dops, DISK_IOCTL_GET_ERASE_SIZE);
+        *(DWORD *)buff = max(size / FATFS_SECTOR_SIZE, 1);
+        return RES_OK;
+
+    default:
+        return RES_PARERR;
+    }
 }
 
 /* FIXME: _FS_NORTC=1 because there is not hal_rtc interface */
@@ -647,5 +1071,7 @@ fatfs_pkg_init(void)
     /* Ensure this function only gets called by sysinit. */
     SYSINIT_ASSERT_ACTIVE();
 
+    fatfs_cache_init();
+
     fs_register(&fatfs_ops);
 }
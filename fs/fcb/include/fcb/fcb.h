@@ -56,6 +56,8 @@ struct fcb {
     uint8_t f_sector_cnt;	/* Number of elements in sector array */
     uint8_t f_scratch_cnt;	/* How many sectors should be kept empty */
     struct flash_area *f_sectors; /* Array of sectors, must be contiguous */
+    uint16_t *f_elem_cnts;	/* Optional, f_sector_cnt long; per-sector */
+				/* element count cache */
 
     /* Flash circular buffer internal state */
     struct os_mutex f_mtx;	/* Locking for accessing the FCB data */
@@ -63,6 +65,7 @@ struct fcb {
     struct fcb_entry f_active;
     uint16_t f_active_id;
     uint8_t f_align;		/* writes to flash have to aligned to this */
+    struct flash_area *f_erasing; /* rotated out, erase in progress */
 };
 
 /**
@@ -90,6 +93,30 @@ int fcb_init(struct fcb *fcb);
 int fcb_append(struct fcb *, uint16_t len, struct fcb_entry *loc);
 int fcb_append_finish(struct fcb *, struct fcb_entry *append_loc);
 
+/**
+ * Elements can also be encoded in RAM first and appended in bulk with
+ * fcb_append_batch().  fcb_element_size() returns the number of bytes an
+ * element with len bytes of data takes, in RAM and in flash.
+ * fcb_element_encode() writes the element header to buf and returns the
+ * offset of the data within the element; once the data has been copied
+ * there, fcb_element_encode_finish() adds the CRC and padding.
+ */
+int fcb_element_size(struct fcb *, uint16_t len);
+int fcb_element_encode(struct fcb *, uint8_t *buf, uint16_t len);
+int fcb_element_encode_finish(struct fcb *, uint8_t *buf, uint16_t len);
+
+/**
+ * fcb_append_batch() appends cnt encoded elements, stored back to back in
+ * buf, with a single flash write.  lens[] holds the data length of each
+ * element.  Only whole elements which fit in the active area are written;
+ * if the first one does not, a new area is taken into use first.  The
+ * location of each written element is stored in locs[].
+ *
+ * Returns the number of elements written, or one of FCB_ERR_XXX.
+ */
+int fcb_append_batch(struct fcb *, const void *buf, const uint16_t *lens,
+                     int cnt, struct fcb_entry *locs);
+
 /**
  * Walk over all entries in FCB.
  * cb gets called for every entry. If cb wants to stop the walk, it should
@@ -103,7 +130,19 @@ int fcb_walk(struct fcb *, struct flash_area *, fcb_walk_cb cb, void *cb_arg);
 int fcb_getnext(struct fcb *, struct fcb_entry *loc);
 
 /**
- * Erases the data from oldest sector.
+ * fcb_getprev() finds the previous valid entry backwards from loc, and fills
+ * in the location of that entry.  If loc->fe_area is NULL, the last entry is
+ * returned.  Finding an entry takes a scan of its sector from the start.
+ *
+ * Returns FCB_ERR_NOVAR when there are no more entries.
+ */
+int fcb_getprev(struct fcb *, struct fcb_entry *loc);
+
+/**
+ * Erases the data from oldest sector.  Unless it is also the active one, the
+ * sector is dropped from the FCB first and erased without holding the FCB
+ * lock, so appends to other sectors can proceed during the erase.  It is not
+ * taken into use again until the erase completes.
  */
 int fcb_rotate(struct fcb *);
 
@@ -123,7 +162,9 @@ int fcb_free_sector_cnt(struct fcb *fcb);
 int fcb_is_empty(struct fcb *fcb);
 
 /**
- * Element at offset *entries* from last position (backwards).
+ * Element at offset *entries* from last position (backwards).  Sectors are
+ * scanned backwards from the active one; if f_elem_cnts is set, the sectors
+ * which the FCB has moved past are only counted once.
  */
 int
 fcb_offset_last_n(struct fcb *fcb, uint8_t entries,
@@ -146,7 +146,11 @@ TEST_CASE_DECL(fcb_test_reset)
 TEST_CASE_DECL(fcb_test_rotate)
 TEST_CASE_DECL(fcb_test_multiple_scratch)
 TEST_CASE_DECL(fcb_test_last_of_n)
+TEST_CASE_DECL(fcb_test_last_of_n_cache)
+TEST_CASE_DECL(fcb_test_getprev)
 TEST_CASE_DECL(fcb_test_area_info)
+TEST_CASE_DECL(fcb_test_append_batch)
+TEST_CASE_DECL(fcb_test_append_batch_torn)
 
 TEST_SUITE(fcb_test_all)
 {
@@ -160,7 +164,11 @@ TEST_SUITE(fcb_test_all)
     fcb_test_rotate();
     fcb_test_multiple_scratch();
     fcb_test_last_of_n();
+    fcb_test_last_of_n_cache();
+    fcb_test_getprev();
     fcb_test_area_info();
+    fcb_test_append_batch();
+    fcb_test_append_batch_torn();
 }
 
 int
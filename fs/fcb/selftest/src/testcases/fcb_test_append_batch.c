@@ -0,0 +1,176 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#define FCB_TEST_BATCH_CNT  100
+
+static uint8_t fcb_test_batch_buf[8 * 1024];
+static uint16_t fcb_test_batch_lens[FCB_TEST_BATCH_CNT];
+static struct fcb_entry fcb_test_batch_locs[FCB_TEST_BATCH_CNT];
+
+/*
+ * Encode elements with lengths first_len, first_len + 1, ... into the batch
+ * buffer.  Returns the number of bytes used.
+ */
+static int
+fcb_test_batch_encode(struct fcb *fcb, int first_len, int cnt)
+{
+    uint8_t *elem;
+    int total;
+    int len;
+    int off;
+    int i;
+    int j;
+
+    total = 0;
+    for (i = 0; i < cnt; i++) {
+        len = first_len + i;
+        elem = fcb_test_batch_buf + total;
+        off = fcb_element_encode(fcb, elem, len);
+        TEST_ASSERT_FATAL(off > 0);
+        for (j = 0; j < len; j++) {
+            elem[off + j] = fcb_test_append_data(len, j);
+        }
+        TEST_ASSERT(fcb_element_encode_finish(fcb, elem, len) ==
+                    fcb_element_size(fcb, len));
+        fcb_test_batch_lens[i] = len;
+        total += fcb_element_size(fcb, len);
+        TEST_ASSERT_FATAL(total <= sizeof(fcb_test_batch_buf));
+    }
+    return total;
+}
+
+TEST_CASE_SELF(fcb_test_append_batch)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    uint8_t test_data[128];
+    int var_cnt;
+    int total;
+    int cnt;
+    int rc;
+    int i;
+
+    fcb_tc_pretest(2);
+
+    fcb = &test_fcb;
+
+    /* Starting with an empty element. */
+    fcb_test_batch_encode(fcb, 0, FCB_TEST_BATCH_CNT);
+    rc = fcb_append_batch(fcb, fcb_test_batch_buf, fcb_test_batch_lens,
+                          FCB_TEST_BATCH_CNT, fcb_test_batch_locs);
+    TEST_ASSERT_FATAL(rc == FCB_TEST_BATCH_CNT);
+    for (i = 0; i < FCB_TEST_BATCH_CNT; i++) {
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_area == &test_fcb_area[0]);
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_data_len == i);
+    }
+
+    /* A regular append picks up where the batch left off. */
+    for (i = 0; i < FCB_TEST_BATCH_CNT; i++) {
+        test_data[i] = fcb_test_append_data(FCB_TEST_BATCH_CNT, i);
+    }
+    rc = fcb_append(fcb, FCB_TEST_BATCH_CNT, &loc);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+                          FCB_TEST_BATCH_CNT);
+    TEST_ASSERT(rc == 0);
+    rc = fcb_append_finish(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+
+    var_cnt = 0;
+    rc = fcb_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == FCB_TEST_BATCH_CNT + 1);
+
+    /*
+     * Only the elements which fit in the active area get written.  These
+     * use both 1 and 2 byte length encodings.
+     */
+    fcb_test_batch_encode(fcb, 100, FCB_TEST_BATCH_CNT / 2);
+    do {
+        cnt = fcb_append_batch(fcb, fcb_test_batch_buf, fcb_test_batch_lens,
+                               FCB_TEST_BATCH_CNT / 2, fcb_test_batch_locs);
+        TEST_ASSERT_FATAL(cnt > 0);
+    } while (cnt == FCB_TEST_BATCH_CNT / 2);
+    TEST_ASSERT(fcb_test_batch_locs[cnt - 1].fe_area == &test_fcb_area[0]);
+
+    /* The rest go to the next area. */
+    total = 0;
+    for (i = 0; i < cnt; i++) {
+        total += fcb_element_size(fcb, fcb_test_batch_lens[i]);
+    }
+    rc = fcb_append_batch(fcb, fcb_test_batch_buf + total,
+                          fcb_test_batch_lens + cnt,
+                          FCB_TEST_BATCH_CNT / 2 - cnt,
+                          fcb_test_batch_locs + cnt);
+    TEST_ASSERT(rc == FCB_TEST_BATCH_CNT / 2 - cnt);
+    TEST_ASSERT(fcb_test_batch_locs[cnt].fe_area == &test_fcb_area[1]);
+    TEST_ASSERT(fcb_test_batch_locs[cnt].fe_elem_off ==
+                sizeof(struct fcb_disk_area));
+}
+
+TEST_CASE_SELF(fcb_test_append_batch_torn)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    uint32_t off;
+    int var_cnt;
+    int total;
+    int rc;
+
+    fcb_tc_pretest(2);
+
+    fcb = &test_fcb;
+
+    /* Write a batch, but stop in the middle of its last element. */
+    total = fcb_test_batch_encode(fcb, 1, 10);
+    off = fcb->f_active.fe_elem_off;
+    rc = flash_area_write(fcb->f_active.fe_area, off, fcb_test_batch_buf,
+                          total - fcb_element_size(fcb, 10) / 2);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* After a restart, the elements before the cut are intact. */
+    memset(fcb, 0, sizeof(*fcb));
+    fcb->f_sector_cnt = 2;
+    fcb->f_sectors = test_fcb_area;
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(fcb->f_active.fe_elem_off == off + total);
+
+    var_cnt = 1;
+    rc = fcb_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 10);
+
+    /* New elements go after the partial one. */
+    fcb_test_batch_encode(fcb, 10, 5);
+    rc = fcb_append_batch(fcb, fcb_test_batch_buf, fcb_test_batch_lens, 5,
+                          fcb_test_batch_locs);
+    TEST_ASSERT(rc == 5);
+
+    var_cnt = 1;
+    rc = fcb_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 15);
+
+    memset(&loc, 0, sizeof(loc));
+    rc = fcb_getnext(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(loc.fe_data_len == 1);
+}
@@ -0,0 +1,152 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+#include "fcb_test.h"
+
+static void
+fcb_test_getprev_append(struct fcb *fcb, int len, int finish,
+                        struct fcb_entry *loc)
+{
+    uint8_t test_data[128];
+    int rc;
+    int i;
+
+    for (i = 0; i < len; i++) {
+        test_data[i] = fcb_test_append_data(len, i);
+    }
+    rc = fcb_append(fcb, len, loc);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write(loc->fe_area, loc->fe_data_off, test_data, len);
+    TEST_ASSERT_FATAL(rc == 0);
+    if (finish) {
+        rc = fcb_append_finish(fcb, loc);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+TEST_CASE_SELF(fcb_test_getprev)
+{
+    struct fcb *fcb = &test_fcb;
+    struct fcb_entry loc;
+    struct fcb_entry prev;
+    int rc;
+    int i, j;
+
+    fcb_tc_pretest(3);
+
+    /*
+     * Empty FCB returns error.
+     */
+    prev.fe_area = NULL;
+    rc = fcb_getprev(fcb, &prev);
+    TEST_ASSERT_FATAL(rc == FCB_ERR_NOVAR);
+
+    /*
+     * Add one entry. getprev should find that guy, and then error.
+     */
+    fcb_test_getprev_append(fcb, 8, 1, &loc);
+
+    prev.fe_area = NULL;
+    rc = fcb_getprev(fcb, &prev);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(prev.fe_area == loc.fe_area);
+    TEST_ASSERT(prev.fe_elem_off == loc.fe_elem_off);
+
+    rc = fcb_getprev(fcb, &prev);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+
+    /*
+     * Add enough entries to go to 3 sectors, should find them all.
+     */
+    fcb_tc_pretest(3);
+    for (i = 0; ; i++) {
+        fcb_test_getprev_append(fcb, i % 100 + 1, 1, &loc);
+        if (loc.fe_area == &test_fcb_area[2]) {
+            break;
+        }
+    }
+
+    prev.fe_area = NULL;
+    for (j = i; j >= 0; j--) {
+        rc = fcb_getprev(fcb, &prev);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(prev.fe_data_len == j % 100 + 1);
+    }
+    rc = fcb_getprev(fcb, &prev);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+
+    /*
+     * Clean the area. Fill 2 whole sectors with corrupt entries. And one
+     * good one. Should find the one good one, followed by error.
+     */
+    fcb_tc_pretest(3);
+    for (i = 0; ; i++) {
+        fcb_test_getprev_append(fcb, i % 100 + 1, 0, &loc);
+        if (loc.fe_area == &test_fcb_area[2]) {
+            rc = fcb_append_finish(fcb, &loc);
+            TEST_ASSERT(rc == 0);
+            break;
+        }
+    }
+
+    prev.fe_area = NULL;
+    rc = fcb_getprev(fcb, &prev);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(prev.fe_area == loc.fe_area);
+    TEST_ASSERT(prev.fe_elem_off == loc.fe_elem_off);
+
+    rc = fcb_getprev(fcb, &prev);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+
+    /*
+     * Fill up, rotate one sector, and add one more.  Should follow from
+     * the end of the sector array to the start.
+     */
+    fcb_tc_pretest(3);
+    for (i = 0; ; i++) {
+        rc = fcb_append(fcb, i % 100 + 8, &loc);
+        if (rc == FCB_ERR_NOSPACE) {
+            break;
+        }
+        TEST_ASSERT(rc == 0);
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+    }
+
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+
+    rc = fcb_append(fcb, i % 100 + 8, &loc);
+    TEST_ASSERT(rc == 0);
+    rc = fcb_append_finish(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(loc.fe_area == &test_fcb_area[0]);
+
+    prev.fe_area = NULL;
+    for (j = i; j >= 0; j--) {
+        rc = fcb_getprev(fcb, &prev);
+        if (rc == FCB_ERR_NOVAR) {
+            TEST_ASSERT(prev.fe_area == &test_fcb_area[1]);
+            break;
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(prev.fe_data_len == j % 100 + 8);
+    }
+    TEST_ASSERT(j > 0);
+}
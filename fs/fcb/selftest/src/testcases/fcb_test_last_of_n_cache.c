@@ -0,0 +1,100 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+#include "fcb_test.h"
+
+TEST_CASE_SELF(fcb_test_last_of_n_cache)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    struct fcb_entry last_n;
+    struct fcb_entry walk;
+    struct flash_area *fap;
+    uint16_t elem_cnts[4];
+    int cnt;
+    int rc;
+    int i;
+    int n;
+
+    fcb_test_wipe();
+    fcb = &test_fcb;
+    memset(fcb, 0, sizeof(*fcb));
+    fcb->f_sector_cnt = 4;
+    fcb->f_scratch_cnt = 1;
+    fcb->f_sectors = test_fcb_area;
+    fcb->f_elem_cnts = elem_cnts;
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*
+     * Fill the FCB and rotate it a few times, so that the entries wrap
+     * around the sector array.
+     */
+    for (i = 0; i < 2000; i++) {
+        rc = fcb_append(fcb, i % 64 + 100, &loc);
+        if (rc == FCB_ERR_NOSPACE) {
+            rc = fcb_rotate(fcb);
+            TEST_ASSERT_FATAL(rc == 0);
+            rc = fcb_append(fcb, i % 64 + 100, &loc);
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    cnt = 0;
+    memset(&walk, 0, sizeof(walk));
+    while (fcb_getnext(fcb, &walk) == 0) {
+        cnt++;
+    }
+    TEST_ASSERT_FATAL(cnt > 0 && cnt < 2000);
+
+    /*
+     * Compare with a forward walk, twice; the second round is served from
+     * the cache.
+     */
+    for (i = 0; i < 2; i++) {
+        for (n = 1; n <= 255; n += 31) {
+            rc = fcb_offset_last_n(fcb, n, &last_n);
+            TEST_ASSERT_FATAL(rc == 0);
+
+            memset(&walk, 0, sizeof(walk));
+            do {
+                rc = fcb_getnext(fcb, &walk);
+                TEST_ASSERT_FATAL(rc == 0);
+            } while (walk.fe_area != last_n.fe_area ||
+                     walk.fe_elem_off != last_n.fe_elem_off);
+
+            cnt = 1;
+            while (fcb_getnext(fcb, &walk) == 0) {
+                cnt++;
+            }
+            TEST_ASSERT(cnt == n);
+        }
+    }
+
+    /*
+     * The oldest sector got counted; rotating invalidates its count.
+     */
+    fap = fcb->f_oldest;
+    TEST_ASSERT(elem_cnts[fap - test_fcb_area] != 0xffff);
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(elem_cnts[fap - test_fcb_area] == 0xffff);
+}
@@ -82,6 +82,10 @@ fcb_init(struct fcb *fcb)
     fcb->f_active.fe_area = newest_fap;
     fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
     fcb->f_active_id = newest;
+    fcb->f_erasing = NULL;
+    for (i = 0; i < fcb->f_sector_cnt; i++) {
+        fcb_elem_cnt_reset(fcb, &fcb->f_sectors[i]);
+    }
 
     /* Require alignment to be a power of two.  Some code depends on this
      * assumption.
@@ -111,7 +115,7 @@ fcb_free_sector_cnt(struct fcb *fcb)
     fa = fcb->f_active.fe_area;
     for (i = 0; i < fcb->f_sector_cnt; i++) {
         fa = fcb_getnext_area(fcb, fa);
-        if (fa == fcb->f_oldest) {
+        if (fa == fcb->f_oldest || fa == fcb->f_erasing) {
             break;
         }
     }
@@ -222,28 +226,53 @@ int
 fcb_offset_last_n(struct fcb *fcb, uint8_t entries,
         struct fcb_entry *last_n_entry)
 {
-    struct fcb_entry loc;
-    int i;
+    struct flash_area *fap;
+    struct flash_area *first;
+    int needed;
+    int cnt;
+    int rc;
 
     /* assure a minimum amount of entries */
     if (!entries) {
         entries = 1;
     }
 
-    i = 0;
-    memset(&loc, 0, sizeof(loc));
-    while (!fcb_getnext(fcb, &loc)) {
-        if (i == 0) {
-            /* Start from the beginning of fcb entries */
-            *last_n_entry = loc;
-        } else if (i > (entries - 1)) {
-            /* Update last_n_entry after n entries and keep updating */
-            fcb_getnext(fcb, last_n_entry);
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+
+    /* Walk back from the active sector until one holds the entry. */
+    needed = entries;
+    first = NULL;
+    fap = fcb->f_active.fe_area;
+    while (1) {
+        cnt = fcb_area_elem_cnt(fcb, fap);
+        if (cnt >= needed) {
+            fcb_area_scan(fcb, fap, UINT32_MAX, cnt - needed + 1,
+                          last_n_entry);
+            rc = 0;
+            break;
+        }
+        needed -= cnt;
+        if (cnt > 0) {
+            first = fap;
         }
-        i++;
+        if (fap == fcb->f_oldest) {
+            /* Fewer entries than requested; start from the oldest one. */
+            if (first) {
+                fcb_area_scan(fcb, first, UINT32_MAX, 1, last_n_entry);
+                rc = 0;
+            } else {
+                rc = FCB_ERR_NOVAR;
+            }
+            break;
+        }
+        fap = fcb_getprev_area(fcb, fap);
     }
+    os_mutex_release(&fcb->f_mtx);
 
-    return (i == 0) ? FCB_ERR_NOVAR : 0;
+    return rc;
 }
 
 /**
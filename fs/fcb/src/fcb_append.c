@@ -17,6 +17,9 @@
  * under the License.
  */
 #include <stddef.h>
+#include <string.h>
+
+#include <crc/crc8.h>
 
 #include "fcb/fcb.h"
 #include "fcb_priv.h"
@@ -36,7 +39,7 @@ fcb_new_area(struct fcb *fcb, int cnt)
         if (!rfa) {
             rfa = fa;
         }
-        if (fa == fcb->f_oldest) {
+        if (fa == fcb->f_oldest || fa == fcb->f_erasing) {
             return NULL;
         }
     } while (i++ < cnt);
@@ -66,11 +69,34 @@ fcb_append_to_scratch(struct fcb *fcb)
     return FCB_OK;
 }
 
+/*
+ * Move the active area to a new one which has room for an element taking
+ * elem_sz bytes of flash.  Called with fcb->f_mtx held.
+ */
+static int
+fcb_append_new_area(struct fcb *fcb, int elem_sz)
+{
+    struct flash_area *fa;
+    int rc;
+
+    fa = fcb_new_area(fcb, fcb->f_scratch_cnt);
+    if (!fa || (fa->fa_size < sizeof(struct fcb_disk_area) + elem_sz)) {
+        return FCB_ERR_NOSPACE;
+    }
+    rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
+    if (rc) {
+        return rc;
+    }
+    fcb->f_active.fe_area = fa;
+    fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
+    fcb->f_active_id++;
+    return FCB_OK;
+}
+
 int
 fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
 {
     struct fcb_entry *active;
-    struct flash_area *fa;
     uint8_t tmp_str[2];
     int cnt;
     int rc;
@@ -88,19 +114,10 @@ fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
     }
     active = &fcb->f_active;
     if (active->fe_elem_off + len + cnt > active->fe_area->fa_size) {
-        fa = fcb_new_area(fcb, fcb->f_scratch_cnt);
-        if (!fa || (fa->fa_size <
-            sizeof(struct fcb_disk_area) + len + cnt)) {
-            rc = FCB_ERR_NOSPACE;
-            goto err;
-        }
-        rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
+        rc = fcb_append_new_area(fcb, len + cnt);
         if (rc) {
             goto err;
         }
-        fcb->f_active.fe_area = fa;
-        fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
-        fcb->f_active_id++;
     }
 
     rc = flash_area_write(active->fe_area, active->fe_elem_off, tmp_str, cnt);
@@ -143,3 +160,135 @@ fcb_append_finish(struct fcb *fcb, struct fcb_entry *loc)
     }
     return 0;
 }
+
+/*
+ * Offset of the data from the start of an element holding len bytes.
+ */
+static int
+fcb_element_data_off(struct fcb *fcb, uint16_t len)
+{
+    return fcb_len_in_flash(fcb, len < 0x80 ? 1 : 2);
+}
+
+int
+fcb_element_size(struct fcb *fcb, uint16_t len)
+{
+    if (len >= FCB_MAX_LEN) {
+        return FCB_ERR_ARGS;
+    }
+    return fcb_element_data_off(fcb, len) + fcb_len_in_flash(fcb, len) +
+      fcb_len_in_flash(fcb, FCB_CRC_SZ);
+}
+
+int
+fcb_element_encode(struct fcb *fcb, uint8_t *buf, uint16_t len)
+{
+    int cnt;
+    int off;
+
+    cnt = fcb_put_len(buf, len);
+    if (cnt < 0) {
+        return cnt;
+    }
+    off = fcb_len_in_flash(fcb, cnt);
+    memset(buf + cnt, flash_area_erased_val(fcb->f_sectors), off - cnt);
+
+    return off;
+}
+
+int
+fcb_element_encode_finish(struct fcb *fcb, uint8_t *buf, uint16_t len)
+{
+    uint8_t erased_val;
+    uint8_t crc8;
+    int cnt;
+    int off;
+    int end;
+
+    erased_val = flash_area_erased_val(fcb->f_sectors);
+    cnt = len < 0x80 ? 1 : 2;
+    off = fcb_len_in_flash(fcb, cnt);
+
+    crc8 = crc8_init();
+    crc8 = crc8_calc(crc8, buf, cnt);
+    crc8 = crc8_calc(crc8, buf + off, len);
+
+    end = off + fcb_len_in_flash(fcb, len);
+    memset(buf + off + len, erased_val, end - off - len);
+    buf[end] = crc8;
+    off = end + fcb_len_in_flash(fcb, FCB_CRC_SZ);
+    memset(buf + end + FCB_CRC_SZ, erased_val, off - end - FCB_CRC_SZ);
+
+    return off;
+}
+
+int
+fcb_append_batch(struct fcb *fcb, const void *buf, const uint16_t *lens,
+                 int cnt, struct fcb_entry *locs)
+{
+    struct fcb_entry *active;
+    uint32_t off;
+    int elem_sz;
+    int total;
+    int n;
+    int rc;
+
+    if (cnt <= 0) {
+        return FCB_ERR_ARGS;
+    }
+    elem_sz = fcb_element_size(fcb, lens[0]);
+    if (elem_sz < 0) {
+        return elem_sz;
+    }
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    active = &fcb->f_active;
+    if (active->fe_elem_off + elem_sz > active->fe_area->fa_size) {
+        rc = fcb_append_new_area(fcb, elem_sz);
+        if (rc) {
+            goto err;
+        }
+    }
+
+    /*
+     * Take as many whole elements as fit in the active area.
+     */
+    off = active->fe_elem_off;
+    total = 0;
+    n = 0;
+    while (1) {
+        locs[n].fe_area = active->fe_area;
+        locs[n].fe_elem_off = off + total;
+        locs[n].fe_data_off = locs[n].fe_elem_off +
+          fcb_element_data_off(fcb, lens[n]);
+        locs[n].fe_data_len = lens[n];
+        total += elem_sz;
+        if (++n == cnt) {
+            break;
+        }
+        elem_sz = fcb_element_size(fcb, lens[n]);
+        if (elem_sz < 0 || off + total + elem_sz > active->fe_area->fa_size) {
+            break;
+        }
+    }
+
+    rc = flash_area_write(active->fe_area, off, buf, total);
+    if (rc) {
+        rc = FCB_ERR_FLASH;
+        goto err;
+    }
+    active->fe_elem_off = off + total;
+    active->fe_data_off = locs[n - 1].fe_data_off;
+    active->fe_data_len = fcb_len_in_flash(fcb, lens[n - 1]) +
+      fcb_len_in_flash(fcb, FCB_CRC_SZ);
+
+    os_mutex_release(&fcb->f_mtx);
+
+    return n;
+err:
+    os_mutex_release(&fcb->f_mtx);
+    return rc;
+}
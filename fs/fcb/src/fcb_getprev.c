@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+
+#include "fcb/fcb.h"
+#include "fcb_priv.h"
+
+struct flash_area *
+fcb_getprev_area(struct fcb *fcb, struct flash_area *fap)
+{
+    if (fap == &fcb->f_sectors[0]) {
+        fap = &fcb->f_sectors[fcb->f_sector_cnt];
+    }
+    return fap - 1;
+}
+
+/*
+ * Scans the valid elements in fap which start before end_off.  Stops at the
+ * stop'th one if stop is non-zero.  The last element scanned is stored in
+ * loc.  Returns the number of elements scanned.
+ */
+int
+fcb_area_scan(struct fcb *fcb, struct flash_area *fap, uint32_t end_off,
+  int stop, struct fcb_entry *loc)
+{
+    struct fcb_entry cur;
+    int cnt;
+    int rc;
+
+    cnt = 0;
+    cur.fe_area = fap;
+    cur.fe_elem_off = sizeof(struct fcb_disk_area);
+    while (cur.fe_elem_off < end_off) {
+        rc = fcb_elem_info(fcb, &cur);
+        if (rc == 0) {
+            *loc = cur;
+            if (++cnt == stop) {
+                break;
+            }
+        } else if (rc != FCB_ERR_CRC) {
+            break;
+        }
+        cur.fe_elem_off = cur.fe_data_off +
+          fcb_len_in_flash(fcb, cur.fe_data_len) +
+          fcb_len_in_flash(fcb, FCB_CRC_SZ);
+    }
+    return cnt;
+}
+
+/*
+ * Number of valid elements in fap.  The sectors the FCB has moved past do
+ * not change until erased, so their counts can be cached.
+ */
+int
+fcb_area_elem_cnt(struct fcb *fcb, struct flash_area *fap)
+{
+    struct fcb_entry loc;
+    uint16_t *cntp;
+    int cnt;
+
+    cntp = NULL;
+    if (fcb->f_elem_cnts && fap != fcb->f_active.fe_area) {
+        cntp = &fcb->f_elem_cnts[fap - fcb->f_sectors];
+        if (*cntp != FCB_ELEM_CNT_UNKNOWN) {
+            return *cntp;
+        }
+    }
+    cnt = fcb_area_scan(fcb, fap, UINT32_MAX, 0, &loc);
+    if (cntp) {
+        *cntp = cnt;
+    }
+    return cnt;
+}
+
+int
+fcb_getprev(struct fcb *fcb, struct fcb_entry *loc)
+{
+    struct flash_area *fap;
+    uint32_t end_off;
+    int rc;
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    if (loc->fe_area == NULL) {
+        /*
+         * Find the last element.
+         */
+        fap = fcb->f_active.fe_area;
+        end_off = UINT32_MAX;
+    } else {
+        fap = loc->fe_area;
+        end_off = loc->fe_elem_off;
+    }
+    while (1) {
+        if (fcb_area_scan(fcb, fap, end_off, 0, loc) > 0) {
+            rc = 0;
+            break;
+        }
+        if (fap == fcb->f_oldest) {
+            rc = FCB_ERR_NOVAR;
+            break;
+        }
+        fap = fcb_getprev_area(fcb, fap);
+        end_off = UINT32_MAX;
+    }
+    os_mutex_release(&fcb->f_mtx);
+    return rc;
+}
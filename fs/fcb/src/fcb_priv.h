@@ -28,6 +28,8 @@ extern "C" {
 
 #define FCB_ID_GT(a, b) (((int16_t)(a) - (int16_t)(b)) > 0)
 
+#define FCB_ELEM_CNT_UNKNOWN	0xffff
+
 struct fcb_disk_area {
     uint32_t fd_magic;
     uint8_t  fd_ver;
@@ -50,6 +52,18 @@ fcb_len_in_flash(struct fcb *fcb, uint16_t len)
 int fcb_getnext_in_area(struct fcb *fcb, struct fcb_entry *loc);
 struct flash_area *fcb_getnext_area(struct fcb *fcb, struct flash_area *fap);
 int fcb_getnext_nolock(struct fcb *fcb, struct fcb_entry *loc);
+struct flash_area *fcb_getprev_area(struct fcb *fcb, struct flash_area *fap);
+int fcb_area_scan(struct fcb *fcb, struct flash_area *fap, uint32_t end_off,
+  int stop, struct fcb_entry *loc);
+int fcb_area_elem_cnt(struct fcb *fcb, struct flash_area *fap);
+
+static inline void
+fcb_elem_cnt_reset(struct fcb *fcb, struct flash_area *fap)
+{
+    if (fcb->f_elem_cnts) {
+        fcb->f_elem_cnts[fap - fcb->f_sectors] = FCB_ELEM_CNT_UNKNOWN;
+    }
+}
 
 int fcb_elem_info(struct fcb *, struct fcb_entry *);
 int fcb_elem_crc8(struct fcb *, struct fcb_entry *loc, uint8_t *crc8p);
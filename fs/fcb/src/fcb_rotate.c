@@ -31,7 +31,35 @@ fcb_rotate(struct fcb *fcb)
         return FCB_ERR_ARGS;
     }
 
+    if (fcb->f_oldest != fcb->f_active.fe_area && !fcb->f_erasing) {
+        /*
+         * Drop the sector from the FCB, then erase it unlocked.  New areas
+         * are not taken into use past f_erasing.
+         */
+        fap = fcb->f_oldest;
+        fcb->f_erasing = fap;
+        fcb->f_oldest = fcb_getnext_area(fcb, fap);
+        os_mutex_release(&fcb->f_mtx);
+
+        rc = flash_area_erase(fap, 0, fap->fa_size);
+
+        os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+        if (rc) {
+            /* Put the sector back; its contents are now unreliable, but
+             * elements which fail their CRC are skipped.
+             */
+            if (fcb->f_oldest == fcb_getnext_area(fcb, fap)) {
+                fcb->f_oldest = fap;
+            }
+            rc = FCB_ERR_FLASH;
+        }
+        fcb_elem_cnt_reset(fcb, fap);
+        fcb->f_erasing = NULL;
+        goto out;
+    }
+
     rc = flash_area_erase(fcb->f_oldest, 0, fcb->f_oldest->fa_size);
+    fcb_elem_cnt_reset(fcb, fcb->f_oldest);
     if (rc) {
         rc = FCB_ERR_FLASH;
         goto out;
@@ -74,6 +74,8 @@ struct fcb2 {
     struct os_mutex f_mtx;	/* Locking for accessing the FCB data */
     struct fcb2_entry f_active;
     uint16_t f_active_id;
+    uint16_t f_erasing_sec; /* Rotated out, erase in progress */
+    uint8_t f_erasing;      /* Whether f_erasing_sec is valid */
 };
 
 /**
@@ -158,6 +160,61 @@ int fcb2_write(struct fcb2_entry *loc, uint16_t off, const void *buf,
  */
 int fcb2_append_finish(struct fcb2_entry *append_loc);
 
+/**
+ * Returns the number of bytes an element with len bytes of data takes,
+ * both when encoded in RAM and in flash (not counting its sector entry).
+ * Elements are encoded for the alignment of the first sector range.
+ *
+ * @param fcb            FCB the element is for.
+ * @param len            Size of the element data.
+ *
+ * @return Element size on success. Otherwise one of FCB2_XXX error codes.
+ */
+int fcb2_element_size(struct fcb2 *fcb, uint16_t len);
+
+/**
+ * Starts encoding an element in RAM for fcb2_append_batch().
+ *
+ * @param fcb            FCB the element is for.
+ * @param buf            Buffer with room for fcb2_element_size() bytes.
+ * @param len            Size of the element data.
+ *
+ * @return Offset within buf where the element data is to be copied.
+ *         Otherwise one of FCB2_XXX error codes.
+ */
+int fcb2_element_encode(struct fcb2 *fcb, uint8_t *buf, uint16_t len);
+
+/**
+ * Finishes encoding an element in RAM, adding its CRC and padding.
+ *
+ * @param fcb            FCB the element is for.
+ * @param buf            Buffer passed to fcb2_element_encode().
+ * @param len            Size of the element data.
+ *
+ * @return Element size.
+ */
+int fcb2_element_encode_finish(struct fcb2 *fcb, uint8_t *buf, uint16_t len);
+
+/**
+ * Appends elements encoded with fcb2_element_encode() and stored back to
+ * back in buf.  The sector entries of the elements are written first,
+ * followed by the data of all of them in a single flash write.  Only whole
+ * elements which fit in the active sector are written; if the first one
+ * does not, a new sector is taken into use first.
+ *
+ * @param fcb            FCB the elements are being appended to.
+ * @param buf            Encoded elements.
+ * @param lens           Data length of each element.
+ * @param cnt            Number of elements in buf.
+ * @param locs           Filled with the location of each written element.
+ *
+ * @return Number of elements written. Otherwise one of FCB2_XXX error
+ *         codes; FCB2_ERR_ARGS if the active sector range has a different
+ *         alignment than the first one.
+ */
+int fcb2_append_batch(struct fcb2 *fcb, const void *buf, const uint16_t *lens,
+                      int cnt, struct fcb2_entry *locs);
+
 /**
  * Callback routine getting called when walking through FCB entries.
  * Entry data can be read by using fcb2_read().
@@ -222,7 +279,10 @@ int fcb2_getprev(struct fcb2 *fcb, struct fcb2_entry *loc);
 int fcb2_read(struct fcb2_entry *loc, uint16_t off, void *buf, uint16_t len);
 
 /**
- * Erases the data from oldest sector.
+ * Erases the data from oldest sector.  Unless it is also the active one, the
+ * sector is dropped from the FCB first and erased without holding the FCB
+ * lock, so appends to other sectors can proceed during the erase.  It is not
+ * taken into use again until the erase completes.
  *
  * @param fcb            FCB where to erase the sector
  *
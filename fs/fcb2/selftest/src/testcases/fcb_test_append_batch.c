@@ -0,0 +1,196 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#define FCB_TEST_BATCH_CNT  100
+
+static uint8_t fcb_test_batch_buf[8 * 1024];
+static uint16_t fcb_test_batch_lens[FCB_TEST_BATCH_CNT];
+static struct fcb2_entry fcb_test_batch_locs[FCB_TEST_BATCH_CNT];
+static uint8_t fcb_test_batch_sector[0x4000];
+
+/*
+ * Encode elements with lengths first_len, first_len + 1, ... into the batch
+ * buffer.  Returns the number of bytes used.
+ */
+static int
+fcb_test_batch_encode(struct fcb2 *fcb, int first_len, int cnt)
+{
+    uint8_t *elem;
+    int total;
+    int len;
+    int off;
+    int i;
+    int j;
+
+    total = 0;
+    for (i = 0; i < cnt; i++) {
+        len = first_len + i;
+        elem = fcb_test_batch_buf + total;
+        off = fcb2_element_encode(fcb, elem, len);
+        TEST_ASSERT_FATAL(off >= 0);
+        for (j = 0; j < len; j++) {
+            elem[off + j] = fcb_test_append_data(len, j);
+        }
+        TEST_ASSERT(fcb2_element_encode_finish(fcb, elem, len) ==
+                    fcb2_element_size(fcb, len));
+        fcb_test_batch_lens[i] = len;
+        total += fcb2_element_size(fcb, len);
+        TEST_ASSERT_FATAL(total <= sizeof(fcb_test_batch_buf));
+    }
+    return total;
+}
+
+TEST_CASE_SELF(fcb_test_append_batch)
+{
+    struct fcb2 *fcb;
+    struct fcb2_entry loc;
+    uint8_t test_data[FCB_TEST_BATCH_CNT + 1];
+    int var_cnt;
+    int written;
+    int total;
+    int cnt;
+    int rc;
+    int i;
+
+    fcb_tc_pretest(2);
+
+    fcb = &test_fcb;
+
+    fcb_test_batch_encode(fcb, 1, FCB_TEST_BATCH_CNT);
+    rc = fcb2_append_batch(fcb, fcb_test_batch_buf, fcb_test_batch_lens,
+                           FCB_TEST_BATCH_CNT, fcb_test_batch_locs);
+    TEST_ASSERT_FATAL(rc == FCB_TEST_BATCH_CNT);
+    for (i = 0; i < FCB_TEST_BATCH_CNT; i++) {
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_sector == 0);
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_entry_num == i + 1);
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_data_len == i + 1);
+    }
+
+    /* A regular append picks up where the batch left off. */
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = fcb_test_append_data(sizeof(test_data), i);
+    }
+    rc = fcb2_append(fcb, sizeof(test_data), &loc);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(loc.fe_entry_num == FCB_TEST_BATCH_CNT + 1);
+    rc = fcb2_write(&loc, 0, test_data, sizeof(test_data));
+    TEST_ASSERT(rc == 0);
+    rc = fcb2_append_finish(&loc);
+    TEST_ASSERT(rc == 0);
+
+    var_cnt = 1;
+    rc = fcb2_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == FCB_TEST_BATCH_CNT + 2);
+
+    /* Only the elements which fit in the active sector get written. */
+    fcb_test_batch_encode(fcb, 100, FCB_TEST_BATCH_CNT / 2);
+    written = FCB_TEST_BATCH_CNT + 1;
+    do {
+        cnt = fcb2_append_batch(fcb, fcb_test_batch_buf, fcb_test_batch_lens,
+                                FCB_TEST_BATCH_CNT / 2, fcb_test_batch_locs);
+        TEST_ASSERT_FATAL(cnt > 0);
+        written += cnt;
+    } while (cnt == FCB_TEST_BATCH_CNT / 2);
+    TEST_ASSERT(fcb_test_batch_locs[cnt - 1].fe_sector == 0);
+
+    /* The rest go to the next sector. */
+    total = 0;
+    for (i = 0; i < cnt; i++) {
+        total += fcb2_element_size(fcb, fcb_test_batch_lens[i]);
+    }
+    rc = fcb2_append_batch(fcb, fcb_test_batch_buf + total,
+                           fcb_test_batch_lens + cnt,
+                           FCB_TEST_BATCH_CNT / 2 - cnt,
+                           fcb_test_batch_locs + cnt);
+    TEST_ASSERT(rc == FCB_TEST_BATCH_CNT / 2 - cnt);
+    TEST_ASSERT(fcb_test_batch_locs[cnt].fe_sector == 1);
+    TEST_ASSERT(fcb_test_batch_locs[cnt].fe_entry_num == 1);
+    written += rc;
+
+    /* Everything reads back. */
+    cnt = 0;
+    memset(&loc, 0, sizeof(loc));
+    while (fcb2_getnext(fcb, &loc) == 0) {
+        cnt++;
+    }
+    TEST_ASSERT(cnt == written);
+}
+
+TEST_CASE_SELF(fcb_test_append_batch_torn)
+{
+    struct flash_area *fap;
+    struct fcb2 *fcb;
+    struct fcb2_entry *last;
+    int var_cnt;
+    int rc;
+
+    fcb_tc_pretest(2);
+
+    fcb = &test_fcb;
+
+    fcb_test_batch_encode(fcb, 1, 10);
+    rc = fcb2_append_batch(fcb, fcb_test_batch_buf, fcb_test_batch_lens, 10,
+                           fcb_test_batch_locs);
+    TEST_ASSERT_FATAL(rc == 10);
+
+    /*
+     * Recreate the sector as if power was lost halfway through the data
+     * of the last element.
+     */
+    fap = &test_fcb_ranges[0].fsr_flash_area;
+    last = &fcb_test_batch_locs[9];
+    rc = flash_area_read(fap, 0, fcb_test_batch_sector,
+                         sizeof(fcb_test_batch_sector));
+    TEST_ASSERT_FATAL(rc == 0);
+    memset(fcb_test_batch_sector + last->fe_data_off + last->fe_data_len / 2,
+           0xff, fcb2_element_size(fcb, last->fe_data_len) -
+                 last->fe_data_len / 2);
+    rc = flash_area_erase(fap, 0, sizeof(fcb_test_batch_sector));
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write(fap, 0, fcb_test_batch_sector,
+                          sizeof(fcb_test_batch_sector));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* After a restart, the elements before the cut are intact. */
+    memset(fcb, 0, sizeof(*fcb));
+    fcb->f_sector_cnt = 2;
+    fcb->f_ranges = test_fcb_ranges;
+    fcb->f_range_cnt = 1;
+    rc = fcb2_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    var_cnt = 1;
+    rc = fcb2_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 10);
+
+    /* New elements go after the partial one. */
+    fcb_test_batch_encode(fcb, 10, 5);
+    rc = fcb2_append_batch(fcb, fcb_test_batch_buf, fcb_test_batch_lens, 5,
+                           fcb_test_batch_locs);
+    TEST_ASSERT(rc == 5);
+    TEST_ASSERT(fcb_test_batch_locs[0].fe_entry_num == 11);
+
+    var_cnt = 1;
+    rc = fcb2_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 15);
+}
@@ -86,6 +86,7 @@ fcb2_init(struct fcb2 *fcb)
         fcb2_len_in_flash(newest_srp, sizeof(struct fcb2_disk_area));
     fcb->f_active.fe_entry_num = 0;
     fcb->f_active_id = newest;
+    fcb->f_erasing = 0;
 
     while (1) {
         rc = fcb2_getnext_in_area(fcb, &fcb->f_active);
@@ -110,7 +111,8 @@ fcb2_free_sector_cnt(struct fcb2 *fcb)
     sector = fcb->f_active.fe_sector;
     for (i = 0; i < fcb->f_sector_cnt; i++) {
         sector = fcb2_getnext_sector(fcb, sector);
-        if (sector == fcb->f_oldest_sec) {
+        if (sector == fcb->f_oldest_sec ||
+            (fcb->f_erasing && sector == fcb->f_erasing_sec)) {
             break;
         }
     }
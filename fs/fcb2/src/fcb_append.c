@@ -17,10 +17,12 @@
  * under the License.
  */
 #include <stddef.h>
+#include <string.h>
 
 #include "fcb/fcb2.h"
 #include "fcb_priv.h"
 #include "crc/crc8.h"
+#include "crc/crc16.h"
 
 int
 fcb2_new_sector(struct fcb2 *fcb, int cnt)
@@ -34,7 +36,8 @@ fcb2_new_sector(struct fcb2 *fcb, int cnt)
         if (new_sector < 0) {
             new_sector = sector;
         }
-        if (sector == fcb->f_oldest_sec) {
+        if (sector == fcb->f_oldest_sec ||
+            (fcb->f_erasing && sector == fcb->f_erasing_sec)) {
             new_sector = -1;
             break;
         }
@@ -159,13 +162,50 @@ fcb2_element_length_in_flash(const struct fcb2_entry *loc, int len)
         fcb2_len_in_flash(loc->fe_range, FCB2_CRC_LEN);
 }
 
+/*
+ * Move the active sector to a new one which has room for an element with
+ * len bytes of data.  Called with fcb->f_mtx held.
+ */
+static int
+fcb2_append_new_sector(struct fcb2 *fcb, uint16_t len)
+{
+    struct flash_sector_range *range;
+    int sector;
+    int rc;
+
+    sector = fcb2_new_sector(fcb, fcb->f_scratch_cnt);
+    if (sector < 0) {
+        return FCB2_ERR_NOSPACE;
+    }
+    range = fcb2_get_sector_range(fcb, sector);
+    if (range->fsr_sector_size <
+        fcb2_len_in_flash(range, sizeof(struct fcb2_disk_area)) +
+        fcb2_len_in_flash(range, len) +
+        fcb2_len_in_flash(range, FCB2_CRC_LEN)) {
+        return FCB2_ERR_NOSPACE;
+    }
+    rc = fcb2_sector_hdr_init(fcb, sector, fcb->f_active_id + 1);
+    if (rc) {
+        return rc;
+    }
+    fcb->f_active.fe_range = range;
+    fcb->f_active.fe_sector = sector;
+    /* Start with offset just after sector header */
+    fcb->f_active.fe_data_off =
+        fcb2_len_in_flash(range, sizeof(struct fcb2_disk_area));
+    /* No entries as yet */
+    fcb->f_active.fe_entry_num = 1;
+    fcb->f_active.fe_data_len = 0;
+    fcb->f_active_id++;
+    return FCB2_OK;
+}
+
 int
 fcb2_append(struct fcb2 *fcb, uint16_t len, struct fcb2_entry *append_loc)
 {
     struct fcb2_entry *active;
     struct flash_sector_range *range;
     uint8_t flash_entry[FCB2_ENTRY_SIZE];
-    int sector;
     int rc;
 
     if (len == 0 || len >= FCB2_MAX_LEN) {
@@ -179,33 +219,12 @@ fcb2_append(struct fcb2 *fcb, uint16_t len, struct fcb2_entry *append_loc)
     active = &fcb->f_active;
     if (fcb2_active_sector_free_space(fcb) < fcb2_element_length_in_flash(active,
                                                                           len)) {
-        sector = fcb2_new_sector(fcb, fcb->f_scratch_cnt);
-        if (sector >= 0) {
-            range = fcb2_get_sector_range(fcb, sector);
-        }
-        if (sector < 0 || (range->fsr_sector_size <
-            fcb2_len_in_flash(range, sizeof(struct fcb2_disk_area)) +
-            fcb2_len_in_flash(range, len) +
-            fcb2_len_in_flash(range, FCB2_CRC_LEN))) {
-            rc = FCB2_ERR_NOSPACE;
-            goto err;
-        }
-        rc = fcb2_sector_hdr_init(fcb, sector, fcb->f_active_id + 1);
+        rc = fcb2_append_new_sector(fcb, len);
         if (rc) {
             goto err;
         }
-        fcb->f_active.fe_range = range;
-        fcb->f_active.fe_sector = sector;
-        /* Start with offset just after sector header */
-        fcb->f_active.fe_data_off =
-            fcb2_len_in_flash(range, sizeof(struct fcb2_disk_area));
-        /* No entries as yet */
-        fcb->f_active.fe_entry_num = 1;
-        fcb->f_active.fe_data_len = 0;
-        fcb->f_active_id++;
-    } else {
-        range = active->fe_range;
     }
+    range = active->fe_range;
 
     /* Write new entry at the end of the sector */
     flash_entry[0] = (uint8_t)(fcb->f_active.fe_data_off >> 16);
@@ -259,3 +278,171 @@ fcb2_append_finish(struct fcb2_entry *loc)
     }
     return 0;
 }
+
+int
+fcb2_element_size(struct fcb2 *fcb, uint16_t len)
+{
+    if (len == 0 || len >= FCB2_MAX_LEN) {
+        return FCB2_ERR_ARGS;
+    }
+    return fcb2_len_in_flash(&fcb->f_ranges[0], len) +
+        fcb2_len_in_flash(&fcb->f_ranges[0], FCB2_CRC_LEN);
+}
+
+int
+fcb2_element_encode(struct fcb2 *fcb, uint8_t *buf, uint16_t len)
+{
+    if (len == 0 || len >= FCB2_MAX_LEN) {
+        return FCB2_ERR_ARGS;
+    }
+    /* Data goes first; the entry is written to the end of the sector. */
+    return 0;
+}
+
+int
+fcb2_element_encode_finish(struct fcb2 *fcb, uint8_t *buf, uint16_t len)
+{
+    const struct flash_sector_range *range = &fcb->f_ranges[0];
+    uint8_t erased_val;
+    uint16_t crc;
+    int off;
+    int end;
+
+    erased_val = flash_area_erased_val(&range->fsr_flash_area);
+    crc = crc16_ccitt(0xFFFF, buf, len);
+
+    off = fcb2_len_in_flash(range, len);
+    memset(buf + len, erased_val, off - len);
+    put_be16(buf + off, crc);
+    end = off + fcb2_len_in_flash(range, FCB2_CRC_LEN);
+    memset(buf + off + FCB2_CRC_LEN, erased_val, end - off - FCB2_CRC_LEN);
+
+    return end;
+}
+
+/*
+ * Write the sector entries for locs[0..cnt-1].  The entries are stored
+ * back to back, growing down from the end of the sector, so they are
+ * written in chunks of consecutive entries, highest entry number first.
+ */
+static int
+fcb2_append_batch_entries(struct fcb2_entry *locs, int cnt)
+{
+    uint8_t buf[FCB2_TMP_BUF_SZ * 4];
+    struct flash_sector_range *range;
+    uint8_t *flash_entry;
+    int entry_sz;
+    int chunk;
+    int i;
+    int j;
+    int rc;
+
+    range = locs[0].fe_range;
+    entry_sz = fcb2_len_in_flash(range, FCB2_ENTRY_SIZE);
+    for (i = 0; i < cnt; i += chunk) {
+        chunk = min(cnt - i, (int)(sizeof(buf) / entry_sz));
+        memset(buf, flash_area_erased_val(&range->fsr_flash_area),
+               chunk * entry_sz);
+        for (j = 0; j < chunk; j++) {
+            flash_entry = buf + (chunk - 1 - j) * entry_sz;
+            flash_entry[0] = (uint8_t)(locs[i + j].fe_data_off >> 16);
+            flash_entry[1] = (uint8_t)(locs[i + j].fe_data_off >> 8);
+            flash_entry[2] = (uint8_t)(locs[i + j].fe_data_off >> 0);
+            flash_entry[3] = (uint8_t)(locs[i + j].fe_data_len >> 8);
+            flash_entry[4] = (uint8_t)(locs[i + j].fe_data_len >> 0);
+            flash_entry[5] = crc8_calc(crc8_init(), flash_entry,
+                                       FCB2_ENTRY_SIZE - 1);
+        }
+        rc = fcb2_write_to_sector(&locs[i],
+            (locs[i].fe_entry_num + chunk - 1) * -entry_sz, buf,
+            chunk * entry_sz);
+        if (rc) {
+            return FCB2_ERR_FLASH;
+        }
+    }
+    return 0;
+}
+
+int
+fcb2_append_batch(struct fcb2 *fcb, const void *buf, const uint16_t *lens,
+                  int cnt, struct fcb2_entry *locs)
+{
+    struct fcb2_entry *active;
+    int entry_sz;
+    int elem_sz;
+    int total;
+    int space;
+    int n;
+    int rc;
+
+    if (cnt <= 0) {
+        return FCB2_ERR_ARGS;
+    }
+    elem_sz = fcb2_element_size(fcb, lens[0]);
+    if (elem_sz < 0) {
+        return elem_sz;
+    }
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB2_ERR_ARGS;
+    }
+    active = &fcb->f_active;
+    if (fcb2_active_sector_free_space(fcb) < elem_sz) {
+        rc = fcb2_append_new_sector(fcb, lens[0]);
+        if (rc) {
+            goto err;
+        }
+    }
+    /* Elements were encoded for the alignment of the first range. */
+    if (active->fe_range->fsr_align != fcb->f_ranges[0].fsr_align) {
+        rc = FCB2_ERR_ARGS;
+        goto err;
+    }
+
+    /*
+     * Take as many whole elements as fit in the active sector, together
+     * with their entries.
+     */
+    entry_sz = fcb2_len_in_flash(active->fe_range, FCB2_ENTRY_SIZE);
+    space = fcb2_active_sector_free_space(fcb);
+    total = 0;
+    n = 0;
+    while (1) {
+        locs[n] = *active;
+        locs[n].fe_data_off += total;
+        locs[n].fe_data_len = lens[n];
+        locs[n].fe_entry_num += n;
+        total += elem_sz;
+        if (++n == cnt) {
+            break;
+        }
+        elem_sz = fcb2_element_size(fcb, lens[n]);
+        if (elem_sz < 0 || total + elem_sz + n * entry_sz > space) {
+            break;
+        }
+    }
+
+    /*
+     * Entries go first, as with fcb2_append(); if the data write is cut
+     * short, the elements which did not make it fail their CRC check.
+     */
+    rc = fcb2_append_batch_entries(locs, n);
+    if (rc) {
+        goto err;
+    }
+    rc = fcb2_write_to_sector(active, active->fe_data_off, buf, total);
+    if (rc) {
+        rc = FCB2_ERR_FLASH;
+        goto err;
+    }
+    active->fe_data_off += total;
+    active->fe_entry_num += n;
+
+    os_mutex_release(&fcb->f_mtx);
+
+    return n;
+err:
+    os_mutex_release(&fcb->f_mtx);
+    return rc;
+}
@@ -32,6 +32,33 @@ fcb2_rotate(struct fcb2 *fcb)
         return FCB2_ERR_ARGS;
     }
 
+    if (fcb->f_oldest_sec != fcb->f_active.fe_sector && !fcb->f_erasing) {
+        /*
+         * Drop the sector from the FCB, then erase it unlocked.  New sectors
+         * are not taken into use past f_erasing_sec.
+         */
+        sector = fcb->f_oldest_sec;
+        fcb->f_erasing_sec = sector;
+        fcb->f_erasing = 1;
+        fcb->f_oldest_sec = fcb2_getnext_sector(fcb, sector);
+        os_mutex_release(&fcb->f_mtx);
+
+        rc = fcb2_sector_erase(fcb, sector);
+
+        os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+        if (rc) {
+            /* Put the sector back; its contents are now unreliable, but
+             * entries which fail their CRC are skipped.
+             */
+            if (fcb->f_oldest_sec == fcb2_getnext_sector(fcb, sector)) {
+                fcb->f_oldest_sec = sector;
+            }
+            rc = FCB2_ERR_FLASH;
+        }
+        fcb->f_erasing = 0;
+        goto out;
+    }
+
     rc = fcb2_sector_erase(fcb, fcb->f_oldest_sec);
     if (rc) {
         rc = FCB2_ERR_FLASH;
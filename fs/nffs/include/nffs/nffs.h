@@ -53,6 +53,8 @@ struct nffs_config {
 
 extern struct nffs_config nffs_config;
 
+struct os_eventq;
+
 struct nffs_area_desc {
     uint32_t nad_offset;    /* Flash offset of start of area. */
     uint32_t nad_length;    /* Size of area, in bytes. */
@@ -62,6 +64,9 @@ struct nffs_area_desc {
 int nffs_init(void);
 int nffs_detect(const struct nffs_area_desc *area_descs);
 int nffs_format(const struct nffs_area_desc *area_descs);
+int nffs_checkpoint_config(const struct nffs_area_desc *ckpt_desc);
+int nffs_checkpoint(void);
+void nffs_gc_eventq_set(struct os_eventq *evq);
 
 int nffs_misc_desc_from_flash_area(int idx, int *cnt, struct nffs_area_desc *nad);
 
@@ -27,7 +27,7 @@
 #include "nffs/nffs.h"
 #include "nffs_test.h"
 #include "nffs_test_priv.h"
-#include "nffs_priv.h"
+#include "nffs/../../src/nffs_priv.h"
 
 int print_verbose;
 
@@ -199,12 +199,6 @@ print_nffs_flash_areas(int verbose)
     }
 }
 
-static int
-nffs_hash_fn(uint32_t id)
-{
-    return id % NFFS_HASH_SIZE;
-}
-
 void
 print_hashlist(struct nffs_hash_entry *he)
 {
@@ -524,7 +518,7 @@ print_hash_entries(int verbose)
     struct nffs_hash_entry *next;
 
     printf("\nnffs_hash_entries:\n");
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         he = SLIST_FIRST(nffs_hash + i);
         while (he != NULL) {
             next = SLIST_NEXT(he, nhe_next);
@@ -30,7 +30,7 @@
 #include "nffs/nffs.h"
 #include "nffs_test.h"
 #include "nffs_test_priv.h"
-#include "nffs_priv.h"
+#include "nffs/../../src/nffs_priv.h"
 
 #ifdef __cplusplus
 extern "C" {
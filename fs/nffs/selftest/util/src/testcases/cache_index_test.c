@@ -0,0 +1,175 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+#define NFFS_TEST_CACHE_INDEX_BLOCKS    48
+#define NFFS_TEST_CACHE_INDEX_APPEND    8
+
+static char nffs_test_cache_index_data[NFFS_BLOCK_MAX_DATA_SZ_MAX *
+                                       (NFFS_TEST_CACHE_INDEX_BLOCKS +
+                                        NFFS_TEST_CACHE_INDEX_APPEND)];
+
+/**
+ * Ensures each entry in the file's block index refers to a block of the file
+ * and records the correct end offset for it.
+ */
+static void
+nffs_test_cache_index_assert_valid(struct fs_file *fs_file)
+{
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+    struct nffs_cache_inode *cache_inode;
+    struct nffs_hash_entry *entry;
+    struct nffs_block block;
+    struct nffs_file *file;
+    uint32_t block_end;
+    int idx;
+    int rc;
+
+    file = (struct nffs_file *)fs_file;
+    rc = nffs_cache_inode_ensure(&cache_inode, file->nf_inode_entry);
+    TEST_ASSERT(rc == 0);
+
+    TEST_ASSERT(cache_inode->nci_index_count <=
+                MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE));
+
+    idx = cache_inode->nci_index_count - 1;
+    block_end = cache_inode->nci_file_size;
+    entry = file->nf_inode_entry->nie_last_block_entry;
+    while (entry != NULL && idx >= 0) {
+        rc = nffs_block_from_hash_entry(&block, entry);
+        TEST_ASSERT(rc == 0);
+
+        if (entry == cache_inode->nci_index[idx].ncie_block_entry) {
+            TEST_ASSERT(cache_inode->nci_index[idx].ncie_end_offset ==
+                        block_end);
+            idx--;
+        }
+
+        block_end -= block.nb_data_len;
+        entry = block.nb_prev;
+    }
+
+    /* All entries were found, in order. */
+    TEST_ASSERT(idx == -1);
+#endif
+}
+
+static void
+nffs_test_cache_index_read(struct fs_file *file, uint32_t offset,
+                           uint32_t len)
+{
+    static char buf[512];
+    uint32_t bytes_read;
+    int rc;
+
+    TEST_ASSERT(len <= sizeof buf);
+
+    rc = fs_seek(file, offset);
+    TEST_ASSERT(rc == 0);
+    rc = fs_read(file, len, buf, &bytes_read);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(bytes_read == len);
+    TEST_ASSERT(memcmp(buf, nffs_test_cache_index_data + offset, len) == 0);
+}
+
+static void
+nffs_test_cache_index_read_random(struct fs_file *file, uint32_t file_len,
+                                  int count)
+{
+    static uint32_t seed = 1;
+    uint32_t offset;
+    uint32_t len;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        offset = (seed >> 8) % file_len;
+        len = 1 + (seed >> 4) % 256;
+        if (offset + len > file_len) {
+            len = file_len - offset;
+        }
+
+        nffs_test_cache_index_read(file, offset, len);
+        nffs_test_util_assert_cache_is_sane("/myfile.txt");
+        nffs_test_cache_index_assert_valid(file);
+    }
+}
+
+TEST_CASE_SELF(nffs_test_cache_index)
+{
+    struct fs_file *file;
+    uint32_t block_sz;
+    uint32_t file_len;
+    int rc;
+    int i;
+
+    /*** Setup. */
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < sizeof nffs_test_cache_index_data; i++) {
+        nffs_test_cache_index_data[i] = i * 7 + (i >> 8);
+    }
+
+    block_sz = nffs_block_max_data_sz;
+    file_len = block_sz * NFFS_TEST_CACHE_INDEX_BLOCKS;
+    nffs_test_util_create_file("/myfile.txt", nffs_test_cache_index_data,
+                               file_len);
+    nffs_cache_clear();
+
+    rc = fs_open("/myfile.txt", FS_ACCESS_READ, &file);
+    TEST_ASSERT(rc == 0);
+
+    /*** Random reads across the whole file. */
+    nffs_test_cache_index_read_random(file, file_len, 200);
+
+    /*** Long backward seeks skip the gap instead of caching it. */
+    nffs_cache_clear();
+    nffs_test_cache_index_read(file, 0, 1);
+    nffs_test_util_assert_cache_range("/myfile.txt", 0, block_sz);
+    nffs_test_cache_index_read(file, file_len - 1, 1);
+    nffs_test_util_assert_cache_range("/myfile.txt", file_len - block_sz,
+                                      file_len);
+    nffs_test_cache_index_read(file, 0, 1);
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) >= 8
+    nffs_test_util_assert_cache_range("/myfile.txt", 0, block_sz);
+#endif
+
+    /*** Reads after appending past the last indexed block. */
+    nffs_test_util_append_file("/myfile.txt",
+                               nffs_test_cache_index_data + file_len,
+                               block_sz * NFFS_TEST_CACHE_INDEX_APPEND);
+    file_len += block_sz * NFFS_TEST_CACHE_INDEX_APPEND;
+    nffs_test_cache_index_read(file, file_len - 1, 1);
+    nffs_test_cache_index_read(file, file_len - block_sz * 6, 1);
+    nffs_test_cache_index_assert_valid(file);
+    nffs_test_cache_index_read_random(file, file_len, 100);
+
+    /*** Reads after garbage collection. */
+    rc = nffs_gc(NULL);
+    TEST_ASSERT(rc == 0);
+    nffs_test_cache_index_read_random(file, file_len, 100);
+
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+
+    nffs_test_util_assert_contents("/myfile.txt", nffs_test_cache_index_data,
+                                   file_len);
+}
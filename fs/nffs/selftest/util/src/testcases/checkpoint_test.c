@@ -0,0 +1,146 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+TEST_CASE_SELF(nffs_test_checkpoint)
+{
+    int rc;
+
+    static const struct nffs_area_desc area_descs[] = {
+        { 0x00000000, 16 * 1024 },
+        { 0x00004000, 16 * 1024 },
+        { 0x00008000, 16 * 1024 },
+        { 0x0000c000, 16 * 1024 },
+        { 0x00010000, 64 * 1024 },
+        { 0x00020000, 128 * 1024 },
+        { 0x00040000, 128 * 1024 },
+        { 0x00060000, 128 * 1024 },
+        { 0x00080000, 128 * 1024 },
+        { 0x000a0000, 128 * 1024 },
+        { 0, 0 },
+    };
+
+    /* Two 128 kB slots: 0xc0000 and 0xe0000. */
+    static const struct nffs_area_desc ckpt_desc = {
+        0x000c0000, 256 * 1024
+    };
+
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "mydir",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) { {
+                    .filename = "a",
+                    .contents = "aaaa1234",
+                    .contents_len = 8,
+                }, {
+                    .filename = "c",
+                    .contents = "cccc",
+                    .contents_len = 4,
+                }, {
+                    .filename = "d",
+                    .contents = "dddd",
+                    .contents_len = 4,
+                }, {
+                    .filename = NULL,
+                } },
+            }, {
+                .filename = "empty",
+                .is_dir = 1,
+            }, {
+                .filename = "e",
+                .contents = "eeee",
+                .contents_len = 4,
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    /*** Setup. */
+    rc = nffs_checkpoint_config(&ckpt_desc);
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_format(area_descs);
+    TEST_ASSERT(rc == 0);
+
+    rc = fs_mkdir("/mydir");
+    TEST_ASSERT(rc == 0);
+    rc = fs_mkdir("/empty");
+    TEST_ASSERT(rc == 0);
+    nffs_test_util_create_file("/mydir/a", "aaaa", 4);
+    nffs_test_util_create_file("/mydir/b", "bbbb", 4);
+    nffs_test_util_create_file("/mydir/c", "cccc", 4);
+
+    /* First checkpoint; lands in slot 0. */
+    rc = nffs_checkpoint();
+    TEST_ASSERT(rc == 0);
+
+    nffs_test_util_append_file("/mydir/a", "1234", 4);
+    rc = fs_unlink("/mydir/b");
+    TEST_ASSERT(rc == 0);
+
+    /* Second checkpoint; lands in slot 1. */
+    rc = nffs_checkpoint();
+    TEST_ASSERT(rc == 0);
+
+    /* These objects are only picked up by replaying the areas past their
+     * checkpointed offsets.
+     */
+    nffs_test_util_create_file("/mydir/d", "dddd", 4);
+    nffs_test_util_create_file("/e", "eeee", 4);
+
+    /*** Restore from the newest checkpoint. */
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_restore_checkpoint(area_descs);
+    TEST_ASSERT(rc == 0);
+    nffs_test_assert_system_once(expected_system);
+
+    /*** Corrupt the newest checkpoint; the older one should be used. */
+    rc = flash_native_memset(
+        ckpt_desc.nad_offset + ckpt_desc.nad_length / 2 +
+            sizeof (struct nffs_disk_checkpoint),
+        0x5a, 1);
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_restore_checkpoint(area_descs);
+    TEST_ASSERT(rc == 0);
+    nffs_test_assert_system_once(expected_system);
+
+    /*** Garbage collection invalidates the checkpoint. */
+    nffs_test_assert_system(expected_system, area_descs);
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_restore_checkpoint(area_descs);
+    TEST_ASSERT(rc != 0);
+
+    rc = nffs_detect(area_descs);
+    TEST_ASSERT(rc == 0);
+    nffs_test_assert_system_once(expected_system);
+
+    rc = nffs_checkpoint_config(NULL);
+    TEST_ASSERT(rc == 0);
+}
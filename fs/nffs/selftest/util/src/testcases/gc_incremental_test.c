@@ -0,0 +1,285 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+static const struct nffs_area_desc nffs_test_gc_incr_areas[] = {
+    { 0x00000000, 16 * 1024 },
+    { 0x00004000, 16 * 1024 },
+    { 0x00008000, 16 * 1024 },
+    { 0, 0 },
+};
+
+static void
+nffs_test_gc_incr_setup(void)
+{
+    struct nffs_test_block_desc blocks[8] = {
+        { .data = "1", .data_len = 1 },
+        { .data = "2", .data_len = 1 },
+        { .data = "3", .data_len = 1 },
+        { .data = "4", .data_len = 1 },
+        { .data = "5", .data_len = 1 },
+        { .data = "6", .data_len = 1 },
+        { .data = "7", .data_len = 1 },
+        { .data = "8", .data_len = 1 },
+    };
+    int rc;
+
+    rc = nffs_format(nffs_test_gc_incr_areas);
+    TEST_ASSERT(rc == 0);
+
+    nffs_test_util_create_file_blocks("/a", blocks, 8);
+    nffs_test_util_create_file("/b", "bbbbbbbb", 8);
+    nffs_test_util_create_file("/c", "cccc", 4);
+    rc = fs_mkdir("/d");
+    TEST_ASSERT(rc == 0);
+    nffs_test_util_create_file("/d/e", "eeee", 4);
+}
+
+static void
+nffs_test_gc_incr_overwrite(const char *filename, uint32_t offset,
+                            const char *data, int len)
+{
+    struct fs_file *file;
+    int rc;
+
+    rc = fs_open(filename, FS_ACCESS_WRITE, &file);
+    TEST_ASSERT(rc == 0);
+    rc = fs_seek(file, offset);
+    TEST_ASSERT(rc == 0);
+    rc = fs_write(file, data, len);
+    TEST_ASSERT(rc == 0);
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+}
+
+/**
+ * Modifies the file system while a garbage collection cycle is in progress.
+ * Each call makes a different change.
+ *
+ * @return                      1 if a change was made; 0 if there are no
+ *                                  changes left.
+ */
+static int
+nffs_test_gc_incr_mutate(int idx)
+{
+    int rc;
+
+    switch (idx) {
+    case 0:
+        nffs_test_util_append_file("/a", "9", 1);
+        break;
+
+    case 1:
+        nffs_test_gc_incr_overwrite("/b", 2, "XY", 2);
+        break;
+
+    case 2:
+        rc = fs_unlink("/c");
+        TEST_ASSERT(rc == 0);
+        break;
+
+    case 3:
+        nffs_test_util_create_file("/d/f", "ffff", 4);
+        break;
+
+    case 4:
+        rc = fs_rename("/d/e", "/g");
+        TEST_ASSERT(rc == 0);
+        break;
+
+    default:
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Starts a garbage collection cycle and advances it one object at a time,
+ * changing the file system between steps.
+ *
+ * If NFFS_GC_INCREMENTAL is enabled, the file system operations advance the
+ * cycle as well and may complete it.
+ */
+static void
+nffs_test_gc_incr_start(void)
+{
+    uint32_t src_cur;
+    uint32_t dst_cur;
+    uint8_t src_idx;
+    uint8_t dst_idx;
+    int active;
+    int rc;
+    int i;
+
+    rc = nffs_gc_begin();
+    TEST_ASSERT(rc == 0);
+
+    src_idx = nffs_gc_src_area_idx;
+    dst_idx = nffs_scratch_area_idx;
+    TEST_ASSERT(src_idx != NFFS_AREA_ID_NONE);
+
+    for (i = 0; ; i++) {
+        rc = nffs_gc_step(1, 0);
+        TEST_ASSERT(rc == 0);
+
+        active = nffs_gc_src_area_idx == src_idx;
+#if !MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+        TEST_ASSERT(active);
+#endif
+
+        src_cur = nffs_areas[src_idx].na_cur;
+        dst_cur = nffs_areas[dst_idx].na_cur;
+        if (!nffs_test_gc_incr_mutate(i)) {
+            break;
+        }
+
+        /* New objects go to neither area of the cycle. */
+        if (active && nffs_gc_src_area_idx == src_idx) {
+            TEST_ASSERT(nffs_areas[src_idx].na_cur == src_cur);
+#if !MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+            TEST_ASSERT(nffs_areas[dst_idx].na_cur == dst_cur);
+#endif
+        }
+    }
+}
+
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+/**
+ * Starts a garbage collection cycle and lets file system writes alone carry
+ * it to completion.
+ */
+static void
+nffs_test_gc_incr_write_steps(void)
+{
+    int rc;
+    int i;
+
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "a",
+                .contents = "12345678",
+                .contents_len = 8,
+            }, {
+                .filename = "b",
+                .contents = "XYbbbbbb",
+                .contents_len = 8,
+            }, {
+                .filename = "c",
+                .contents = "cccc",
+                .contents_len = 4,
+            }, {
+                .filename = "d",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) { {
+                    .filename = "e",
+                    .contents = "eeee",
+                    .contents_len = 4,
+                }, {
+                    .filename = NULL,
+                } },
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    nffs_test_gc_incr_setup();
+
+    rc = nffs_gc_begin();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_gc_src_area_idx != NFFS_AREA_ID_NONE);
+
+    /* Each write copies up to NFFS_GC_STEP_BYTES; the source area holds far
+     * less than that.
+     */
+    for (i = 0; nffs_gc_src_area_idx != NFFS_AREA_ID_NONE; i++) {
+        TEST_ASSERT_FATAL(i < 2);
+        nffs_test_gc_incr_overwrite("/b", 0, "XY", 2);
+    }
+
+    nffs_test_assert_system(expected_system, nffs_test_gc_incr_areas);
+}
+#endif
+
+TEST_CASE_SELF(nffs_test_gc_incremental)
+{
+    int rc;
+
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "a",
+                .contents = "123456789",
+                .contents_len = 9,
+            }, {
+                .filename = "b",
+                .contents = "bbXYbbbb",
+                .contents_len = 8,
+            }, {
+                .filename = "d",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) { {
+                    .filename = "f",
+                    .contents = "ffff",
+                    .contents_len = 4,
+                }, {
+                    .filename = NULL,
+                } },
+            }, {
+                .filename = "g",
+                .contents = "eeee",
+                .contents_len = 4,
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    /*** Complete a cycle in small steps. */
+    nffs_test_gc_incr_setup();
+    nffs_test_gc_incr_start();
+
+    while (nffs_gc_src_area_idx != NFFS_AREA_ID_NONE) {
+        rc = nffs_gc_step(1, 0);
+        TEST_ASSERT(rc == 0);
+    }
+
+    nffs_test_assert_system(expected_system, nffs_test_gc_incr_areas);
+
+    /*** Reboot in the middle of a cycle; nothing may be lost. */
+    nffs_test_gc_incr_setup();
+    nffs_test_gc_incr_start();
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(nffs_test_gc_incr_areas);
+    TEST_ASSERT(rc == 0);
+
+    nffs_test_assert_system(expected_system, nffs_test_gc_incr_areas);
+
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+    /*** Writes advance a cycle without explicit steps. */
+    nffs_test_gc_incr_write_steps();
+#endif
+}
@@ -56,6 +56,7 @@ struct nffs_inode_entry *nffs_root_dir;
 struct nffs_inode_entry *nffs_lost_found_dir;
 
 static struct os_mutex nffs_mutex;
+static struct os_eventq *nffs_gc_evq;
 
 static int nffs_open(const char *path, uint8_t access_flags,
   struct fs_file **out_file);
@@ -123,6 +124,13 @@ STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_readcnt_filename)
     STATS_NAME(nffs_stats, nffs_readcnt_object)
     STATS_NAME(nffs_stats, nffs_readcnt_detect)
+    STATS_NAME(nffs_stats, nffs_gcstep_bg)
+    STATS_NAME(nffs_stats, nffs_gcpause_lt1ms)
+    STATS_NAME(nffs_stats, nffs_gcpause_lt4ms)
+    STATS_NAME(nffs_stats, nffs_gcpause_lt16ms)
+    STATS_NAME(nffs_stats, nffs_gcpause_lt64ms)
+    STATS_NAME(nffs_stats, nffs_gcpause_lt256ms)
+    STATS_NAME(nffs_stats, nffs_gcpause_ge256ms)
 STATS_NAME_END(nffs_stats)
 
 static void
@@ -143,6 +151,68 @@ nffs_unlock(void)
     assert(rc == 0 || rc == OS_NOT_STARTED);
 }
 
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+static void nffs_gc_ev_cb(struct os_event *ev);
+
+static struct os_event nffs_gc_ev = {
+    .ev_cb = nffs_gc_ev_cb,
+};
+
+static void
+nffs_gc_ev_cb(struct os_event *ev)
+{
+    int more;
+    int rc;
+
+    nffs_lock();
+    rc = nffs_gc_step(MYNEWT_VAL(NFFS_GC_STEP_BYTES), 1);
+    more = rc == 0 && nffs_gc_src_area_idx != NFFS_AREA_ID_NONE;
+    nffs_unlock();
+
+    /* Requeue rather than loop, so that other events get to run between
+     * steps.
+     */
+    if (more && nffs_gc_evq != NULL) {
+        os_eventq_put(nffs_gc_evq, &nffs_gc_ev);
+    }
+}
+#endif
+
+/**
+ * Does the garbage collection work owed by an operation that is about to
+ * write to flash.  With NFFS_GC_INCREMENTAL enabled, this starts a cycle once
+ * free space runs low, and advances the cycle in progress by one bounded
+ * step.  Must be called before the operation takes any pointers to cached
+ * blocks.
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+static int
+nffs_gc_write_step(void)
+{
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+    int rc;
+
+    if (nffs_gc_start_due()) {
+        rc = nffs_gc_begin();
+        if (rc != 0) {
+            return rc;
+        }
+
+        if (nffs_gc_evq != NULL) {
+            os_eventq_put(nffs_gc_evq, &nffs_gc_ev);
+        }
+    }
+
+    rc = nffs_gc_step(MYNEWT_VAL(NFFS_GC_STEP_BYTES), 0);
+    if (rc != 0) {
+        return rc;
+    }
+#endif
+
+    return 0;
+}
+
 static int
 nffs_stats_init(void)
 {
@@ -373,6 +443,11 @@ nffs_write(struct fs_file *fs_file, const void *data, int len)
         goto done;
     }
 
+    rc = nffs_gc_write_step();
+    if (rc != 0) {
+        goto done;
+    }
+
     rc = nffs_write_to_file(file, data, len);
     if (rc != 0) {
         goto done;
@@ -407,6 +482,11 @@ nffs_unlink(const char *path)
         goto done;
     }
 
+    rc = nffs_gc_write_step();
+    if (rc != 0) {
+        goto done;
+    }
+
     rc = nffs_path_unlink(path);
     if (rc != 0) {
         goto done;
@@ -447,6 +527,11 @@ nffs_rename(const char *from, const char *to)
         goto done;
     }
 
+    rc = nffs_gc_write_step();
+    if (rc != 0) {
+        goto done;
+    }
+
     rc = nffs_path_rename(from, to);
     if (rc != 0) {
         goto done;
@@ -481,6 +566,11 @@ nffs_mkdir(const char *path)
         goto done;
     }
 
+    rc = nffs_gc_write_step();
+    if (rc != 0) {
+        goto done;
+    }
+
     rc = nffs_path_new_dir(path, NULL);
     if (rc != 0) {
         goto done;
@@ -681,12 +771,114 @@ nffs_detect(const struct nffs_area_desc *area_descs)
     int rc;
 
     nffs_lock();
-    rc = nffs_restore_full(area_descs);
+
+    /* Prefer the checkpoint, if there is a usable one; otherwise scan every
+     * area.
+     */
+    rc = nffs_restore_checkpoint(area_descs);
+    if (rc != 0) {
+        rc = nffs_restore_full(area_descs);
+    }
+
+    nffs_unlock();
+
+    return rc;
+}
+
+/**
+ * Writes a checkpoint of the in-RAM index to the region configured with
+ * nffs_checkpoint_config().  A subsequent nffs_detect() loads the checkpoint
+ * and only reads the objects written after it, rather than every object in
+ * the file system.  Nothing is written if the file system has not changed
+ * since the last checkpoint.
+ *
+ * @return                  0 on success;
+ *                          FS_EINVAL if no checkpoint region is configured;
+ *                          FS_EFULL if the index does not fit in the
+ *                              region;
+ *                          other nonzero on error.
+ */
+int
+nffs_checkpoint(void)
+{
+    int rc;
+
+    nffs_lock();
+    rc = nffs_checkpoint_write();
     nffs_unlock();
 
     return rc;
 }
 
+/**
+ * Sets the event queue on which incremental garbage collection steps run in
+ * the background (NFFS_GC_INCREMENTAL).  Once a cycle has started, one step
+ * is queued at a time until the cycle completes.  Pointing this at the queue
+ * of a low priority task keeps the steps out of the way of other work.  With
+ * no queue, cycles only advance as files are written.
+ *
+ * @param evq               The event queue to use; null to disable
+ *                              background steps.
+ */
+void
+nffs_gc_eventq_set(struct os_eventq *evq)
+{
+    nffs_lock();
+    nffs_gc_evq = evq;
+    nffs_unlock();
+}
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+#if MYNEWT_VAL(NFFS_CHECKPOINT_INTERVAL) > 0
+static struct os_callout nffs_checkpoint_timer;
+
+static void
+nffs_checkpoint_timer_exp(struct os_event *ev)
+{
+    nffs_checkpoint();
+    os_callout_reset(&nffs_checkpoint_timer,
+                     MYNEWT_VAL(NFFS_CHECKPOINT_INTERVAL) * OS_TICKS_PER_SEC);
+}
+#endif
+
+/**
+ * Called on system shutdown.  Writes a checkpoint so that the next mount can
+ * skip the full scan.
+ */
+int
+nffs_checkpoint_sysdown(int reason)
+{
+    nffs_checkpoint();
+    return SYSDOWN_COMPLETE;
+}
+
+static void
+nffs_checkpoint_pkg_init(void)
+{
+    const struct flash_area *fa;
+    struct nffs_area_desc desc;
+    int rc;
+
+    rc = flash_area_open(MYNEWT_VAL(NFFS_CHECKPOINT_FLASH_AREA), &fa);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    desc.nad_offset = fa->fa_off;
+    desc.nad_length = fa->fa_size;
+    desc.nad_flash_id = fa->fa_device_id;
+    flash_area_close(fa);
+
+    rc = nffs_checkpoint_config(&desc);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT_INTERVAL) > 0
+    os_callout_init(&nffs_checkpoint_timer, os_eventq_dflt_get(),
+                    nffs_checkpoint_timer_exp, NULL);
+    os_callout_reset(&nffs_checkpoint_timer,
+                     MYNEWT_VAL(NFFS_CHECKPOINT_INTERVAL) * OS_TICKS_PER_SEC);
+#endif
+}
+#endif
+
 /**
  * Initializes internal nffs memory and data structures.  This must be called
  * before any nffs operations are attempted.
@@ -790,6 +982,14 @@ nffs_pkg_init(void)
         MYNEWT_VAL(NFFS_FLASH_AREA), &cnt, descs);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    nffs_checkpoint_pkg_init();
+#endif
+
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+    nffs_gc_eventq_set(os_eventq_dflt_get());
+#endif
+
     /* Attempt to restore an existing nffs file system from flash. */
     rc = nffs_detect(descs);
     switch (rc) {
@@ -214,6 +214,131 @@ nffs_cache_inode_range(const struct nffs_cache_inode *cache_inode,
                cache_block->ncb_block.nb_data_len;
 }
 
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+
+static void
+nffs_cache_index_clear(struct nffs_cache_inode *cache_inode)
+{
+    cache_inode->nci_index_count = 0;
+    cache_inode->nci_index_stride = 0;
+}
+
+/**
+ * Rebuilds the sparse block index of the specified cached inode.  The file's
+ * block list is walked backwards from its last block, recording every
+ * stride'th block.  Whenever the index fills up, every other entry is dropped
+ * and the stride doubles, so the index always spans the whole file.  The last
+ * block is not indexed; it is the only block whose length can change without
+ * a garbage collection cycle.
+ *
+ * @param cache_inode           The cached inode to index.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+nffs_cache_index_build(struct nffs_cache_inode *cache_inode)
+{
+    struct nffs_cache_index_entry *index;
+    struct nffs_cache_index_entry tmp;
+    struct nffs_hash_entry *block_entry;
+    struct nffs_block block;
+    uint32_t block_end;
+    uint32_t stride;
+    uint32_t pos;
+    int count;
+    int i;
+    int rc;
+
+    nffs_cache_index_clear(cache_inode);
+
+    index = cache_inode->nci_index;
+    count = 0;
+    stride = 1;
+
+    block_entry = cache_inode->nci_inode.ni_inode_entry->nie_last_block_entry;
+    block_end = cache_inode->nci_file_size;
+    for (pos = 0; block_entry != NULL; pos++) {
+        rc = nffs_block_from_hash_entry(&block, block_entry);
+        if (rc != 0) {
+            return rc;
+        }
+
+        if (pos > 0 && count == MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) &&
+            pos % (stride * 2) == 0) {
+
+            /* Entry i was recorded at position (i + 1) * stride; keep the
+             * ones that are multiples of the new stride.
+             */
+            for (i = 0; i < count / 2; i++) {
+                index[i] = index[i * 2 + 1];
+            }
+            count /= 2;
+            stride *= 2;
+        }
+
+        if (pos > 0 && pos % stride == 0 &&
+            count < MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE)) {
+
+            index[count].ncie_block_entry = block_entry;
+            index[count].ncie_end_offset = block_end;
+            count++;
+        }
+
+        block_end -= block.nb_data_len;
+        block_entry = block.nb_prev;
+    }
+
+    /* Entries were recorded from the end of the file; put them in ascending
+     * offset order for searching.
+     */
+    for (i = 0; i < count / 2; i++) {
+        tmp = index[i];
+        index[i] = index[count - 1 - i];
+        index[count - 1 - i] = tmp;
+    }
+
+    cache_inode->nci_index_count = count;
+    cache_inode->nci_index_stride = stride;
+
+    return 0;
+}
+
+/**
+ * Searches the index of the specified cached inode for the first indexed
+ * block that ends after the given file offset.
+ *
+ * @return                      The position of the index entry on success;
+ *                                  -1 if the offset lies beyond the last
+ *                                  indexed block.
+ */
+static int
+nffs_cache_index_find(const struct nffs_cache_inode *cache_inode,
+                      uint32_t seek_offset)
+{
+    int lo;
+    int hi;
+    int mid;
+
+    lo = 0;
+    hi = cache_inode->nci_index_count;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (cache_inode->nci_index[mid].ncie_end_offset <= seek_offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo == cache_inode->nci_index_count) {
+        return -1;
+    }
+
+    return lo;
+}
+
+#endif
+
 static void
 nffs_cache_reclaim_blocks(void)
 {
@@ -295,6 +420,11 @@ nffs_cache_inode_refresh(void)
         /* Clear entire block list. */
         nffs_cache_inode_free_blocks(cache_inode);
 
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+        /* Garbage collection may have merged the indexed blocks. */
+        nffs_cache_index_clear(cache_inode);
+#endif
+
         inode_entry = cache_inode->nci_inode.ni_inode_entry;
         rc = nffs_inode_from_entry(&cache_inode->nci_inode, inode_entry);
         if (rc != 0) {
@@ -363,6 +493,14 @@ nffs_cache_insert_block(struct nffs_cache_inode *cache_inode,
  *      b. Else, clear the cache, and populate it with the single entry
  *         corresponding to the requested block.
  *
+ * If the inode's sparse block index is enabled (NFFS_CACHE_INDEX_SIZE), the
+ * backwards walk in step 3 starts from the nearest indexed block rather than
+ * from the end of the file.  In step 2, a gap spanning more than two index
+ * strides is not bridged; the cache is cleared and the walk starts from the
+ * nearest indexed block instead.  The index is built the first time a walk
+ * from the end of the file grows long, and rebuilt when appends have taken
+ * the end of the file too far beyond the last indexed block.
+ *
  * @param cache_inode           The cached file inode to seek within.
  * @param seek_offset           The file offset to seek to.
  * @param out_cache_block       On success, the requested cached block gets
@@ -384,6 +522,12 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
     uint32_t cache_end;
     uint32_t block_start;
     uint32_t block_end;
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+    struct nffs_cache_index_entry *index;
+    uint32_t walk_len;
+    int from_end;
+    int idx;
+#endif
     int rc;
 
     /* Empty files have no blocks that can be cached. */
@@ -391,6 +535,11 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
         return FS_ENOENT;
     }
 
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+    from_end = 0;
+    walk_len = 0;
+#endif
+
     nffs_cache_inode_range(cache_inode, &cache_start, &cache_end);
     if (cache_end != 0 && seek_offset < cache_start) {
         /* Seeking prior to cache.  Iterate backwards from cache start. */
@@ -398,6 +547,23 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
         block_entry = cache_block->ncb_block.nb_prev;
         block_end = cache_block->ncb_file_offset;
         cache_block = NULL;
+
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+        /* If the gap spans more than two index strides, jump over it rather
+         * than caching every block in between.
+         */
+        index = cache_inode->nci_index;
+        idx = nffs_cache_index_find(cache_inode, seek_offset);
+        if (idx != -1 && idx + 2 < cache_inode->nci_index_count &&
+            index[idx + 2].ncie_end_offset <= cache_start) {
+
+            nffs_cache_inode_free_blocks(cache_inode);
+            cache_start = 0;
+            cache_end = 0;
+            block_entry = index[idx].ncie_block_entry;
+            block_end = index[idx].ncie_end_offset;
+        }
+#endif
     } else if (seek_offset < cache_end) {
         /* Seeking within cache.  Iterate backwards from cache end. */
         cache_block = TAILQ_LAST(&cache_inode->nci_block_list,
@@ -414,6 +580,16 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
         block_entry =
             cache_inode->nci_inode.ni_inode_entry->nie_last_block_entry;
         block_end = cache_inode->nci_file_size;
+
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+        index = cache_inode->nci_index;
+        idx = nffs_cache_index_find(cache_inode, seek_offset);
+        if (idx != -1) {
+            block_entry = index[idx].ncie_block_entry;
+            block_end = index[idx].ncie_end_offset;
+        }
+        from_end = idx == -1;
+#endif
     }
 
     /* Scan backwards until we find the block containing the seek offest. */
@@ -491,6 +667,27 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
         }
         block_entry = pred_entry;
         block_end = block_start;
+
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+        /* A long walk from the end of the file means the index is missing or
+         * no longer reaches the end of the file.  Rebuild it and resume from
+         * the nearest indexed block.
+         */
+        if (from_end && ++walk_len > cache_inode->nci_index_stride + 1) {
+            rc = nffs_cache_index_build(cache_inode);
+            if (rc != 0) {
+                return rc;
+            }
+            from_end = 0;
+
+            index = cache_inode->nci_index;
+            idx = nffs_cache_index_find(cache_inode, seek_offset);
+            if (idx != -1 && index[idx].ncie_end_offset < block_end) {
+                block_entry = index[idx].ncie_block_entry;
+                block_end = index[idx].ncie_end_offset;
+            }
+        }
+#endif
     }
 
     return 0;
@@ -0,0 +1,946 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "hal/hal_flash.h"
+#include "nffs/nffs.h"
+#include "nffs_priv.h"
+
+/*
+ * Mount checkpoints.
+ *
+ * A checkpoint is a snapshot of the RAM index: the state of each area and the
+ * flash location of every live inode and data block, along with the links
+ * between them.  It is kept outside of the file system areas, in a region
+ * split into two slots which are written alternately.  A slot is erased
+ * before it is written and its header goes out last, so an interrupted write
+ * leaves an invalid slot and the previous checkpoint intact.
+ *
+ * Objects are only ever appended to an area until the area is garbage
+ * collected.  A checkpoint therefore stays usable as the file system is
+ * written to: restore loads it, then replays the objects that follow each
+ * area's checkpointed write offset.  Garbage collection and formatting
+ * rewrite areas, so they erase every slot before touching flash.
+ */
+
+/** Flash region holding the checkpoint slots; 0-length if disabled. */
+static struct nffs_area_desc nffs_checkpoint_desc;
+
+/** Bitmap of slots which may contain a checkpoint header. */
+static uint8_t nffs_checkpoint_used_slots;
+
+/** Slot holding the checkpoint the RAM index derives from; -1 if none. */
+static int nffs_checkpoint_cur_slot = -1;
+
+/** Greatest sequence number found in or written to either slot. */
+static uint32_t nffs_checkpoint_seq;
+
+/** Sum of the area write offsets recorded in the current checkpoint. */
+static uint32_t nffs_checkpoint_cur_sum;
+
+/** Buffered sequential access to the records in a checkpoint slot. */
+struct nffs_checkpoint_stream {
+    uint32_t ncs_offset;    /* Flash offset of next buffer read / flush. */
+    uint32_t ncs_end;       /* End of the records. */
+    uint16_t ncs_crc;       /* CRC of the records flushed so far. */
+    uint16_t ncs_buf_off;   /* Read offset within nffs_flash_buf. */
+    uint16_t ncs_buf_len;   /* Bytes held in nffs_flash_buf. */
+};
+
+/** State kept while inode records are loaded. */
+struct nffs_checkpoint_loader {
+    struct nffs_inode_entry *ncl_parent;    /* Parent of previous inode. */
+    struct nffs_inode_entry *ncl_prev;      /* Previous inode loaded. */
+    int ncl_pending;                        /* Referenced, not yet loaded. */
+};
+
+int
+nffs_checkpoint_enabled(void)
+{
+    return nffs_checkpoint_desc.nad_length != 0;
+}
+
+static uint32_t
+nffs_checkpoint_slot_len(void)
+{
+    return nffs_checkpoint_desc.nad_length / NFFS_CHECKPOINT_NUM_SLOTS;
+}
+
+static uint32_t
+nffs_checkpoint_slot_offset(int slot)
+{
+    return nffs_checkpoint_desc.nad_offset +
+           slot * nffs_checkpoint_slot_len();
+}
+
+static void
+nffs_checkpoint_stream_init(struct nffs_checkpoint_stream *stream, int slot,
+                            uint32_t body_len)
+{
+    memset(stream, 0, sizeof *stream);
+    stream->ncs_offset = nffs_checkpoint_slot_offset(slot) +
+                         sizeof (struct nffs_disk_checkpoint);
+    stream->ncs_end = stream->ncs_offset + body_len;
+}
+
+/**
+ * Sums the write offsets of all non-scratch areas.  As areas are only
+ * appended to between garbage collection cycles, an unchanged sum indicates
+ * that nothing has been written.
+ */
+static uint32_t
+nffs_checkpoint_area_cur_sum(void)
+{
+    uint32_t sum;
+    int i;
+
+    sum = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            sum += nffs_areas[i].na_cur;
+        }
+    }
+
+    return sum;
+}
+
+/**
+ * Reads and sanity checks the header of the specified slot.  The records are
+ * not read; their CRC is checked separately.
+ *
+ * @return                      0 if the slot has a plausible header;
+ *                              FS_ENOENT if the slot is empty;
+ *                              FS_ECORRUPT if the header is invalid;
+ *                              FS_EHW on flash error.
+ */
+static int
+nffs_checkpoint_read_hdr(int slot, struct nffs_disk_checkpoint *out_hdr)
+{
+    int rc;
+
+    rc = hal_flash_read(nffs_checkpoint_desc.nad_flash_id,
+                        nffs_checkpoint_slot_offset(slot), out_hdr,
+                        sizeof *out_hdr);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    if (out_hdr->ndc_magic != NFFS_CHECKPOINT_MAGIC) {
+        return FS_ENOENT;
+    }
+
+    if (out_hdr->ndc_ver != NFFS_CHECKPOINT_VER ||
+        out_hdr->ndc_body_len >
+            nffs_checkpoint_slot_len() - sizeof *out_hdr) {
+
+        return FS_ECORRUPT;
+    }
+
+    return 0;
+}
+
+static int
+nffs_checkpoint_erase(int slot)
+{
+    int rc;
+
+    rc = hal_flash_erase(nffs_checkpoint_desc.nad_flash_id,
+                         nffs_checkpoint_slot_offset(slot),
+                         nffs_checkpoint_slot_len());
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    nffs_checkpoint_used_slots &= ~(1 << slot);
+
+    return 0;
+}
+
+/**
+ * Designates the flash region which holds mount checkpoints.  The region is
+ * split into two equally sized slots, each of which must start on a sector
+ * boundary so that it can be erased independently of the other.  The region
+ * must not overlap any of the file system's areas.  For the checkpoint to be
+ * used on mount, this must be called before nffs_detect().
+ *
+ * @param ckpt_desc             The checkpoint region; NULL disables
+ *                                  checkpoints.
+ *
+ * @return                      0 on success;
+ *                              FS_EINVAL if the region is too small;
+ *                              FS_EHW on flash error.
+ */
+int
+nffs_checkpoint_config(const struct nffs_area_desc *ckpt_desc)
+{
+    struct nffs_disk_checkpoint hdr;
+    int rc;
+    int i;
+
+    memset(&nffs_checkpoint_desc, 0, sizeof nffs_checkpoint_desc);
+    nffs_checkpoint_used_slots = 0;
+    nffs_checkpoint_cur_slot = -1;
+    nffs_checkpoint_seq = 0;
+
+    if (ckpt_desc == NULL || ckpt_desc->nad_length == 0) {
+        return 0;
+    }
+
+    if (ckpt_desc->nad_length / NFFS_CHECKPOINT_NUM_SLOTS <= sizeof hdr) {
+        return FS_EINVAL;
+    }
+    nffs_checkpoint_desc = *ckpt_desc;
+
+    /* Note which slots need erasing when the checkpoint gets invalidated, and
+     * continue the sequence from the most recent one.
+     */
+    for (i = 0; i < NFFS_CHECKPOINT_NUM_SLOTS; i++) {
+        rc = nffs_checkpoint_read_hdr(i, &hdr);
+        switch (rc) {
+        case 0:
+            if (hdr.ndc_seq > nffs_checkpoint_seq) {
+                nffs_checkpoint_seq = hdr.ndc_seq;
+            }
+            /* Fall through. */
+
+        case FS_ECORRUPT:
+            nffs_checkpoint_used_slots |= 1 << i;
+            break;
+
+        case FS_ENOENT:
+            break;
+
+        default:
+            memset(&nffs_checkpoint_desc, 0, sizeof nffs_checkpoint_desc);
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+static int
+nffs_checkpoint_flush(struct nffs_checkpoint_stream *stream)
+{
+    int rc;
+
+    if (stream->ncs_buf_len == 0) {
+        return 0;
+    }
+
+    rc = hal_flash_write(nffs_checkpoint_desc.nad_flash_id, stream->ncs_offset,
+                         nffs_flash_buf, stream->ncs_buf_len);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    stream->ncs_crc = crc16_ccitt(stream->ncs_crc, nffs_flash_buf,
+                                  stream->ncs_buf_len);
+    stream->ncs_offset += stream->ncs_buf_len;
+    stream->ncs_buf_len = 0;
+
+    return 0;
+}
+
+static int
+nffs_checkpoint_emit(struct nffs_checkpoint_stream *stream, const void *rec,
+                     int len)
+{
+    int rc;
+
+    if (stream->ncs_offset + stream->ncs_buf_len + len > stream->ncs_end) {
+        return FS_EFULL;
+    }
+
+    if (stream->ncs_buf_len + len > sizeof nffs_flash_buf) {
+        rc = nffs_checkpoint_flush(stream);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    memcpy(nffs_flash_buf + stream->ncs_buf_len, rec, len);
+    stream->ncs_buf_len += len;
+
+    return 0;
+}
+
+static int
+nffs_checkpoint_read(struct nffs_checkpoint_stream *stream, void *dst,
+                     int len)
+{
+    uint32_t chunk_len;
+    uint8_t *u8p;
+    int copy_len;
+    int rc;
+
+    u8p = dst;
+    while (len > 0) {
+        if (stream->ncs_buf_off == stream->ncs_buf_len) {
+            chunk_len = stream->ncs_end - stream->ncs_offset;
+            if (chunk_len == 0) {
+                return FS_ECORRUPT;
+            }
+            if (chunk_len > sizeof nffs_flash_buf) {
+                chunk_len = sizeof nffs_flash_buf;
+            }
+
+            rc = hal_flash_read(nffs_checkpoint_desc.nad_flash_id,
+                                stream->ncs_offset, nffs_flash_buf,
+                                chunk_len);
+            if (rc != 0) {
+                return FS_EHW;
+            }
+
+            stream->ncs_offset += chunk_len;
+            stream->ncs_buf_off = 0;
+            stream->ncs_buf_len = chunk_len;
+        }
+
+        copy_len = stream->ncs_buf_len - stream->ncs_buf_off;
+        if (copy_len > len) {
+            copy_len = len;
+        }
+
+        memcpy(u8p, nffs_flash_buf + stream->ncs_buf_off, copy_len);
+        stream->ncs_buf_off += copy_len;
+        u8p += copy_len;
+        len -= copy_len;
+    }
+
+    return 0;
+}
+
+/**
+ * Indicates whether an inode belongs in a checkpoint.  Only fully restored
+ * inodes that are linked into the directory tree get recorded.
+ */
+static int
+nffs_checkpoint_inode_is_live(struct nffs_inode_entry *inode_entry)
+{
+    if (nffs_inode_is_dummy(inode_entry) ||
+        nffs_inode_getflags(inode_entry, NFFS_INODE_FLAG_DELETED)) {
+
+        return 0;
+    }
+
+    return inode_entry == nffs_root_dir ||
+           nffs_inode_getflags(inode_entry, NFFS_INODE_FLAG_INTREE);
+}
+
+/**
+ * Indicates whether a data block belongs in a checkpoint; blocks of unlinked
+ * files that are still open are left out.  This reads the block header to
+ * determine the owning inode.
+ */
+static int
+nffs_checkpoint_block_is_live(struct nffs_hash_entry *entry, int *out_live)
+{
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_disk_block disk_block;
+    uint32_t area_offset;
+    uint8_t area_idx;
+    int rc;
+
+    *out_live = 0;
+
+    if (nffs_hash_entry_is_dummy(entry)) {
+        return 0;
+    }
+
+    nffs_flash_loc_expand(entry->nhe_flash_loc, &area_idx, &area_offset);
+    rc = nffs_block_read_disk(area_idx, area_offset, &disk_block);
+    if (rc != 0) {
+        return rc;
+    }
+
+    inode_entry = nffs_hash_find_inode(disk_block.ndb_inode_id);
+    *out_live = inode_entry != NULL &&
+                nffs_checkpoint_inode_is_live(inode_entry);
+
+    return 0;
+}
+
+static int
+nffs_checkpoint_emit_inode(struct nffs_checkpoint_stream *stream,
+                           struct nffs_inode_entry *inode_entry,
+                           uint32_t parent_id)
+{
+    struct nffs_disk_checkpoint_inode disk_inode;
+    struct nffs_hash_entry *last_block_entry;
+
+    /* Dummies only exist transiently during restore. */
+    if (nffs_inode_is_dummy(inode_entry)) {
+        return FS_ECORRUPT;
+    }
+
+    disk_inode.ndci_id = inode_entry->nie_hash_entry.nhe_id;
+    disk_inode.ndci_flash_loc = inode_entry->nie_hash_entry.nhe_flash_loc;
+    disk_inode.ndci_parent_id = parent_id;
+    disk_inode.ndci_lastblock_id = NFFS_ID_NONE;
+
+    if (nffs_hash_id_is_file(disk_inode.ndci_id)) {
+        last_block_entry = inode_entry->nie_last_block_entry;
+        if (last_block_entry != NULL) {
+            if (nffs_hash_entry_is_dummy(last_block_entry)) {
+                return FS_ECORRUPT;
+            }
+            disk_inode.ndci_lastblock_id = last_block_entry->nhe_id;
+        }
+    }
+
+    return nffs_checkpoint_emit(stream, &disk_inode, sizeof disk_inode);
+}
+
+/**
+ * Writes a checkpoint of the RAM index to the slot not holding the current
+ * checkpoint.  Nothing is written if no objects have been written to flash
+ * since the current checkpoint.
+ *
+ * @return                      0 on success;
+ *                              FS_EINVAL if checkpoints are not configured;
+ *                              FS_EUNINIT if there is no file system;
+ *                              FS_EFULL if the index does not fit in a slot;
+ *                              other nonzero on error.
+ */
+int
+nffs_checkpoint_write(void)
+{
+    struct nffs_disk_checkpoint_block disk_block;
+    struct nffs_disk_checkpoint_area disk_area;
+    struct nffs_checkpoint_stream stream;
+    struct nffs_disk_checkpoint hdr;
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_inode_entry *child;
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    struct nffs_area *area;
+    uint32_t slot_offset;
+    uint32_t cur_sum;
+    int slot;
+    int live;
+    int rc;
+    int i;
+
+    if (!nffs_checkpoint_enabled()) {
+        return FS_EINVAL;
+    }
+
+    if (!nffs_misc_ready()) {
+        return FS_EUNINIT;
+    }
+
+    /* Objects in the middle of being moved between areas can't be recorded
+     * reliably; complete the garbage collection cycle first.
+     */
+    if (nffs_gc_src_area_idx != NFFS_AREA_ID_NONE) {
+        rc = nffs_gc(NULL);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    cur_sum = nffs_checkpoint_area_cur_sum();
+    if (nffs_checkpoint_cur_slot != -1 && cur_sum == nffs_checkpoint_cur_sum) {
+        return 0;
+    }
+
+    /* Leave the current checkpoint in place until this one is complete. */
+    if (nffs_checkpoint_cur_slot == 0) {
+        slot = 1;
+    } else {
+        slot = 0;
+    }
+    slot_offset = nffs_checkpoint_slot_offset(slot);
+
+    rc = nffs_checkpoint_erase(slot);
+    if (rc != 0) {
+        return rc;
+    }
+
+    memset(&hdr, 0, sizeof hdr);
+    nffs_checkpoint_stream_init(&stream, slot,
+                                nffs_checkpoint_slot_len() - sizeof hdr);
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        area = nffs_areas + i;
+
+        disk_area.ndca_offset = area->na_offset;
+        disk_area.ndca_length = area->na_length;
+        disk_area.ndca_cur = area->na_cur;
+        disk_area.ndca_id = area->na_id;
+        disk_area.ndca_gc_seq = area->na_gc_seq;
+        disk_area.ndca_flash_id = area->na_flash_id;
+
+        rc = nffs_checkpoint_emit(&stream, &disk_area, sizeof disk_area);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    /* Blocks precede inodes so that each file's last block can be looked up
+     * as its inode is loaded.
+     */
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (!nffs_hash_id_is_block(entry->nhe_id)) {
+            continue;
+        }
+
+        rc = nffs_checkpoint_block_is_live(entry, &live);
+        if (rc != 0) {
+            return rc;
+        }
+        if (!live) {
+            continue;
+        }
+
+        disk_block.ndcb_id = entry->nhe_id;
+        disk_block.ndcb_flash_loc = entry->nhe_flash_loc;
+        rc = nffs_checkpoint_emit(&stream, &disk_block, sizeof disk_block);
+        if (rc != 0) {
+            return rc;
+        }
+        hdr.ndc_num_blocks++;
+    }
+
+    /* The root directory, followed by the children of each directory in
+     * sorted order.  Recording the sibling order spares the restore from
+     * comparing filenames on flash.
+     */
+    rc = nffs_checkpoint_emit_inode(&stream, nffs_root_dir, NFFS_ID_NONE);
+    if (rc != 0) {
+        return rc;
+    }
+    hdr.ndc_num_inodes++;
+
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (!nffs_hash_id_is_dir(entry->nhe_id)) {
+            continue;
+        }
+
+        inode_entry = (struct nffs_inode_entry *)entry;
+        if (!nffs_checkpoint_inode_is_live(inode_entry)) {
+            continue;
+        }
+
+        SLIST_FOREACH(child, &inode_entry->nie_child_list, nie_sibling_next) {
+            rc = nffs_checkpoint_emit_inode(&stream, child, entry->nhe_id);
+            if (rc != 0) {
+                return rc;
+            }
+            hdr.ndc_num_inodes++;
+        }
+    }
+
+    rc = nffs_checkpoint_flush(&stream);
+    if (rc != 0) {
+        return rc;
+    }
+
+    hdr.ndc_magic = NFFS_CHECKPOINT_MAGIC;
+    hdr.ndc_seq = nffs_checkpoint_seq + 1;
+    hdr.ndc_body_len = stream.ncs_offset - slot_offset - sizeof hdr;
+    hdr.ndc_next_file_id = nffs_hash_next_file_id;
+    hdr.ndc_next_dir_id = nffs_hash_next_dir_id;
+    hdr.ndc_next_block_id = nffs_hash_next_block_id;
+    hdr.ndc_block_max_data_sz = nffs_block_max_data_sz;
+    hdr.ndc_ver = NFFS_CHECKPOINT_VER;
+    hdr.ndc_num_areas = nffs_num_areas;
+    hdr.ndc_scratch_area_idx = nffs_scratch_area_idx;
+    hdr.ndc_crc16 = crc16_ccitt(stream.ncs_crc, &hdr,
+                                NFFS_DISK_CHECKPOINT_OFFSET_CRC);
+
+    nffs_checkpoint_used_slots |= 1 << slot;
+    rc = hal_flash_write(nffs_checkpoint_desc.nad_flash_id, slot_offset, &hdr,
+                         sizeof hdr);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    nffs_checkpoint_seq = hdr.ndc_seq;
+    nffs_checkpoint_cur_slot = slot;
+    nffs_checkpoint_cur_sum = cur_sum;
+
+    return 0;
+}
+
+/**
+ * Checks the CRC of the specified slot's header and records.
+ *
+ * @return                      0 if the checkpoint is intact;
+ *                              FS_ECORRUPT if it is not;
+ *                              FS_EHW on flash error.
+ */
+static int
+nffs_checkpoint_validate(int slot, const struct nffs_disk_checkpoint *hdr)
+{
+    struct nffs_checkpoint_stream stream;
+    uint32_t chunk_len;
+    uint32_t body_len;
+    uint16_t crc;
+    int rc;
+
+    body_len = hdr->ndc_num_areas * sizeof (struct nffs_disk_checkpoint_area) +
+               hdr->ndc_num_blocks *
+                   sizeof (struct nffs_disk_checkpoint_block) +
+               hdr->ndc_num_inodes *
+                   sizeof (struct nffs_disk_checkpoint_inode);
+    if (body_len != hdr->ndc_body_len) {
+        return FS_ECORRUPT;
+    }
+
+    nffs_checkpoint_stream_init(&stream, slot, body_len);
+
+    crc = 0;
+    while (stream.ncs_offset < stream.ncs_end) {
+        chunk_len = stream.ncs_end - stream.ncs_offset;
+        if (chunk_len > sizeof nffs_flash_buf) {
+            chunk_len = sizeof nffs_flash_buf;
+        }
+
+        rc = hal_flash_read(nffs_checkpoint_desc.nad_flash_id,
+                            stream.ncs_offset, nffs_flash_buf, chunk_len);
+        if (rc != 0) {
+            return FS_EHW;
+        }
+
+        crc = crc16_ccitt(crc, nffs_flash_buf, chunk_len);
+        stream.ncs_offset += chunk_len;
+    }
+
+    crc = crc16_ccitt(crc, hdr, NFFS_DISK_CHECKPOINT_OFFSET_CRC);
+    if (crc != hdr->ndc_crc16) {
+        return FS_ECORRUPT;
+    }
+
+    return 0;
+}
+
+/**
+ * Looks up an inode entry, inserting an empty one if it has not been loaded
+ * yet.  Empty entries have an invalid flash location until their own record
+ * is loaded.
+ */
+static int
+nffs_checkpoint_inode_get(uint32_t id, struct nffs_checkpoint_loader *loader,
+                          struct nffs_inode_entry **out_inode_entry)
+{
+    struct nffs_inode_entry *inode_entry;
+
+    inode_entry = nffs_hash_find_inode(id);
+    if (inode_entry == NULL) {
+        inode_entry = nffs_inode_entry_alloc();
+        if (inode_entry == NULL) {
+            return FS_ENOMEM;
+        }
+
+        inode_entry->nie_hash_entry.nhe_id = id;
+        inode_entry->nie_hash_entry.nhe_flash_loc = NFFS_FLASH_LOC_NONE;
+        inode_entry->nie_refcnt = 1;
+        nffs_hash_insert(&inode_entry->nie_hash_entry);
+
+        loader->ncl_pending++;
+    }
+
+    *out_inode_entry = inode_entry;
+    return 0;
+}
+
+static int
+nffs_checkpoint_load_inode(const struct nffs_disk_checkpoint_inode *disk_inode,
+                           struct nffs_checkpoint_loader *loader)
+{
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_inode_entry *parent;
+    int rc;
+
+    if (!nffs_hash_id_is_inode(disk_inode->ndci_id) ||
+        disk_inode->ndci_flash_loc == NFFS_FLASH_LOC_NONE) {
+
+        return FS_ECORRUPT;
+    }
+
+    rc = nffs_checkpoint_inode_get(disk_inode->ndci_id, loader, &inode_entry);
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Each inode is recorded once. */
+    if (inode_entry->nie_hash_entry.nhe_flash_loc != NFFS_FLASH_LOC_NONE) {
+        return FS_ECORRUPT;
+    }
+    inode_entry->nie_hash_entry.nhe_flash_loc = disk_inode->ndci_flash_loc;
+    loader->ncl_pending--;
+
+    if (nffs_hash_id_is_file(disk_inode->ndci_id) &&
+        disk_inode->ndci_lastblock_id != NFFS_ID_NONE) {
+
+        inode_entry->nie_last_block_entry =
+            nffs_hash_find_block(disk_inode->ndci_lastblock_id);
+        if (inode_entry->nie_last_block_entry == NULL) {
+            return FS_ECORRUPT;
+        }
+    }
+
+    if (disk_inode->ndci_parent_id == NFFS_ID_NONE) {
+        if (disk_inode->ndci_id != NFFS_ID_ROOT_DIR) {
+            return FS_ECORRUPT;
+        }
+
+        nffs_root_dir = inode_entry;
+        nffs_inode_setflags(inode_entry, NFFS_INODE_FLAG_INTREE);
+        return 0;
+    }
+
+    if (!nffs_hash_id_is_dir(disk_inode->ndci_parent_id)) {
+        return FS_ECORRUPT;
+    }
+
+    rc = nffs_checkpoint_inode_get(disk_inode->ndci_parent_id, loader,
+                                   &parent);
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* The children of a directory were recorded consecutively and in order;
+     * append each one to its parent's list.
+     */
+    if (parent == loader->ncl_parent) {
+        SLIST_INSERT_AFTER(loader->ncl_prev, inode_entry, nie_sibling_next);
+    } else {
+        if (!SLIST_EMPTY(&parent->nie_child_list)) {
+            return FS_ECORRUPT;
+        }
+        SLIST_INSERT_HEAD(&parent->nie_child_list, inode_entry,
+                          nie_sibling_next);
+    }
+    nffs_inode_setflags(inode_entry, NFFS_INODE_FLAG_INTREE);
+
+    loader->ncl_parent = parent;
+    loader->ncl_prev = inode_entry;
+
+    return 0;
+}
+
+/**
+ * Populates the RAM index from the specified checkpoint.  The areas must
+ * already have been detected; if any of them differs from its checkpointed
+ * state, the checkpoint is stale and FS_ECORRUPT is returned.
+ */
+static int
+nffs_checkpoint_load(int slot, const struct nffs_disk_checkpoint *hdr,
+                     uint16_t *out_max_data_len)
+{
+    struct nffs_disk_checkpoint_inode disk_inode;
+    struct nffs_disk_checkpoint_block disk_block;
+    struct nffs_disk_checkpoint_area disk_area;
+    struct nffs_checkpoint_loader loader;
+    struct nffs_checkpoint_stream stream;
+    struct nffs_hash_entry *entry;
+    struct nffs_area *area;
+    uint32_t cur_sum;
+    uint32_t i;
+    int rc;
+
+    if (hdr->ndc_num_areas != nffs_num_areas ||
+        hdr->ndc_scratch_area_idx != nffs_scratch_area_idx) {
+
+        return FS_ECORRUPT;
+    }
+
+    nffs_checkpoint_stream_init(&stream, slot, hdr->ndc_body_len);
+
+    cur_sum = 0;
+    for (i = 0; i < hdr->ndc_num_areas; i++) {
+        rc = nffs_checkpoint_read(&stream, &disk_area, sizeof disk_area);
+        if (rc != 0) {
+            return rc;
+        }
+
+        /* An area that has been garbage collected or reformatted since the
+         * checkpoint was taken no longer matches it.
+         */
+        area = nffs_areas + i;
+        if (disk_area.ndca_offset != area->na_offset ||
+            disk_area.ndca_length != area->na_length ||
+            disk_area.ndca_flash_id != area->na_flash_id ||
+            disk_area.ndca_id != area->na_id ||
+            disk_area.ndca_gc_seq != area->na_gc_seq) {
+
+            return FS_ECORRUPT;
+        }
+
+        if (i != nffs_scratch_area_idx) {
+            if (disk_area.ndca_cur < sizeof (struct nffs_disk_area) ||
+                disk_area.ndca_cur > area->na_length) {
+
+                return FS_ECORRUPT;
+            }
+
+            area->na_cur = disk_area.ndca_cur;
+            cur_sum += disk_area.ndca_cur;
+        }
+    }
+
+    for (i = 0; i < hdr->ndc_num_blocks; i++) {
+        rc = nffs_checkpoint_read(&stream, &disk_block, sizeof disk_block);
+        if (rc != 0) {
+            return rc;
+        }
+
+        if (!nffs_hash_id_is_block(disk_block.ndcb_id) ||
+            nffs_hash_find(disk_block.ndcb_id) != NULL) {
+
+            return FS_ECORRUPT;
+        }
+
+        entry = nffs_block_entry_alloc();
+        if (entry == NULL) {
+            return FS_ENOMEM;
+        }
+
+        entry->nhe_id = disk_block.ndcb_id;
+        entry->nhe_flash_loc = disk_block.ndcb_flash_loc;
+        nffs_hash_insert(entry);
+    }
+
+    memset(&loader, 0, sizeof loader);
+    for (i = 0; i < hdr->ndc_num_inodes; i++) {
+        rc = nffs_checkpoint_read(&stream, &disk_inode, sizeof disk_inode);
+        if (rc != 0) {
+            return rc;
+        }
+
+        rc = nffs_checkpoint_load_inode(&disk_inode, &loader);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    /* Every referenced directory must have been recorded. */
+    if (loader.ncl_pending != 0 || nffs_root_dir == NULL) {
+        return FS_ECORRUPT;
+    }
+
+    nffs_hash_next_file_id = hdr->ndc_next_file_id;
+    nffs_hash_next_dir_id = hdr->ndc_next_dir_id;
+    nffs_hash_next_block_id = hdr->ndc_next_block_id;
+    *out_max_data_len = hdr->ndc_block_max_data_sz;
+
+    nffs_checkpoint_cur_slot = slot;
+    nffs_checkpoint_cur_sum = cur_sum;
+
+    return 0;
+}
+
+/**
+ * Loads the most recent intact checkpoint into the RAM index.  The older
+ * checkpoint is used if the newer one fails its CRC check.  On success, the
+ * write offset of each area is set to its checkpointed value; the caller is
+ * expected to replay the objects that follow.
+ *
+ * @param out_max_data_len      On success, the maximum block data length in
+ *                                  effect when the checkpoint was written
+ *                                  gets written here.
+ *
+ * @return                      0 on success;
+ *                              FS_ENOENT if there is no usable checkpoint;
+ *                              FS_ECORRUPT if the checkpoint is stale;
+ *                              other nonzero on error.  On failure the RAM
+ *                                  index may be partially populated.
+ */
+int
+nffs_checkpoint_restore(uint16_t *out_max_data_len)
+{
+    struct nffs_disk_checkpoint hdrs[NFFS_CHECKPOINT_NUM_SLOTS];
+    int valid[NFFS_CHECKPOINT_NUM_SLOTS];
+    int first;
+    int slot;
+    int rc;
+    int i;
+
+    if (!nffs_checkpoint_enabled()) {
+        return FS_ENOENT;
+    }
+
+    nffs_checkpoint_cur_slot = -1;
+
+    for (i = 0; i < NFFS_CHECKPOINT_NUM_SLOTS; i++) {
+        rc = nffs_checkpoint_read_hdr(i, hdrs + i);
+        if (rc == FS_EHW) {
+            return rc;
+        }
+        valid[i] = rc == 0;
+    }
+
+    if (valid[1] && (!valid[0] || hdrs[1].ndc_seq > hdrs[0].ndc_seq)) {
+        first = 1;
+    } else {
+        first = 0;
+    }
+
+    for (i = 0; i < NFFS_CHECKPOINT_NUM_SLOTS; i++) {
+        slot = first ^ i;
+        if (!valid[slot]) {
+            continue;
+        }
+
+        rc = nffs_checkpoint_validate(slot, hdrs + slot);
+        switch (rc) {
+        case 0:
+            return nffs_checkpoint_load(slot, hdrs + slot, out_max_data_len);
+
+        case FS_ECORRUPT:
+            break;
+
+        default:
+            return rc;
+        }
+    }
+
+    return FS_ENOENT;
+}
+
+/**
+ * Erases every slot that may hold a checkpoint.  This must be called before
+ * any operation which rewrites existing area contents.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_checkpoint_invalidate(void)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i < NFFS_CHECKPOINT_NUM_SLOTS; i++) {
+        if (nffs_checkpoint_used_slots & (1 << i)) {
+            rc = nffs_checkpoint_erase(i);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    }
+
+    nffs_checkpoint_cur_slot = -1;
+
+    return 0;
+}
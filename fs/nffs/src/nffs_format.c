@@ -113,6 +113,11 @@ nffs_format_full(const struct nffs_area_desc *area_descs)
     /* Start from a clean state. */
     nffs_misc_reset();
 
+    rc = nffs_checkpoint_invalidate();
+    if (rc != 0) {
+        return rc;
+    }
+
     /* Select largest area to be the initial scratch area. */
     nffs_scratch_area_idx = 0;
     for (i = 1; area_descs[i].nad_length != 0; i++) {
@@ -31,6 +31,27 @@
  */
 unsigned int nffs_gc_count;
 
+/**
+ * The area being collected by the cycle in progress; NFFS_AREA_ID_NONE if no
+ * cycle is in progress.  No new objects are written to this area or to the
+ * destination area until the cycle completes.
+ */
+uint8_t nffs_gc_src_area_idx = NFFS_AREA_ID_NONE;
+
+/** Progress of the cycle in progress. */
+static struct {
+    /* Next hash bucket to scan for objects in the source area. */
+    uint32_t ngs_bucket;
+
+    /* Number of bytes the current step may still copy. */
+    int32_t ngs_budget;
+
+    /* Sum of the write offsets of all areas when the last cycle ended. */
+    uint32_t ngs_cur_sum;
+
+    uint8_t ngs_to_area_idx;
+} nffs_gc_state;
+
 static int
 nffs_gc_copy_object(struct nffs_hash_entry *entry, uint16_t object_size,
                     uint8_t to_area_idx)
@@ -51,6 +72,7 @@ nffs_gc_copy_object(struct nffs_hash_entry *entry, uint16_t object_size,
     }
 
     entry->nhe_flash_loc = nffs_flash_loc(to_area_idx, to_area_offset);
+    nffs_gc_state.ngs_budget -= object_size;
 
     return 0;
 }
@@ -260,6 +282,7 @@ nffs_gc_block_chain_collate(struct nffs_hash_entry *last_entry,
     }
 
     last_entry->nhe_flash_loc = nffs_flash_loc(to_area_idx, to_area_offset);
+    nffs_gc_state.ngs_budget -= sizeof disk_block + data_len;
 
     rc = 0;
 
@@ -363,6 +386,12 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
                 if (rc != 0) {
                     return rc;
                 }
+                if (nffs_gc_state.ngs_budget <= 0) {
+                    /* The rest of the file's blocks are still in the source
+                     * area; the next step picks them up from there.
+                     */
+                    return 0;
+                }
                 last_entry = entry;
                 data_len = block.nb_data_len;
                 multiple_blocks = 0;
@@ -374,6 +403,9 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
                 if (rc != 0) {
                     return rc;
                 }
+                if (nffs_gc_state.ngs_budget <= 0) {
+                    return 0;
+                }
 
                 last_entry = NULL;
                 data_len = 0;
@@ -396,7 +428,28 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
 }
 
 /**
- * Triggers a garbage collection cycle.  This is implemented as follows:
+ * Sums the write offsets of all non-scratch areas.  The sum only grows
+ * between garbage collection cycles, so the difference between two sums is
+ * the number of bytes written in between.
+ */
+static uint32_t
+nffs_gc_area_cur_sum(void)
+{
+    uint32_t sum;
+    int i;
+
+    sum = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            sum += nffs_areas[i].na_cur;
+        }
+    }
+
+    return sum;
+}
+
+/**
+ * Starts a garbage collection cycle.  This is implemented as follows:
  *
  *  (1) The non-scratch area with the lowest garbage collection sequence
  *      number is selected as the "source area."  If there are other areas
@@ -406,6 +459,110 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
  *      transforming it into a non-scratch ID.  The former scratch area is now
  *      known as the "destination area."
  *
+ * The objects are copied by subsequent calls to nffs_gc_step().  Until the
+ * cycle completes, nffs_misc_reserve_space() places new objects in neither
+ * the source nor the destination area.  If the system resets before the
+ * cycle completes, the destination area is discarded on the next restore
+ * and the source area is collected again.
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+int
+nffs_gc_begin(void)
+{
+    struct nffs_area *from_area;
+    uint8_t from_area_idx;
+    int rc;
+
+    assert(nffs_gc_src_area_idx == NFFS_AREA_ID_NONE);
+
+    /* Any checkpoint is about to be rendered stale. */
+    rc = nffs_checkpoint_invalidate();
+    if (rc != 0) {
+        return rc;
+    }
+
+    from_area_idx = nffs_gc_select_area();
+    from_area = nffs_areas + from_area_idx;
+
+    rc = nffs_format_from_scratch_area(nffs_scratch_area_idx,
+                                       from_area->na_id);
+    if (rc != 0) {
+        return rc;
+    }
+
+    nffs_gc_src_area_idx = from_area_idx;
+    nffs_gc_state.ngs_to_area_idx = nffs_scratch_area_idx;
+    nffs_gc_state.ngs_bucket = 0;
+
+    return 0;
+}
+
+/**
+ * Completes the cycle in progress once every object has been moved out of the
+ * source area:
+ *
+ *  (4) The source area is reformatted as a scratch sector (i.e., its header
+ *      indicates an ID of 0xffff).  The area's garbage collection sequence
+ *      number is incremented prior to rewriting the header.  This area is now
+ *      the new scratch sector.
+ */
+static int
+nffs_gc_finish(void)
+{
+    struct nffs_area *from_area;
+    struct nffs_area *to_area;
+    uint8_t from_area_idx;
+    int rc;
+
+    from_area_idx = nffs_gc_src_area_idx;
+    from_area = nffs_areas + from_area_idx;
+    to_area = nffs_areas + nffs_gc_state.ngs_to_area_idx;
+
+    /* The amount of written data should never increase as a result of a gc
+     * cycle.
+     */
+    assert(to_area->na_cur <= from_area->na_cur);
+
+    /* Turn the source area into the new scratch area. */
+    from_area->na_gc_seq++;
+    rc = nffs_format_area(from_area_idx, 1);
+    if (rc != 0) {
+        return rc;
+    }
+
+    nffs_scratch_area_idx = from_area_idx;
+    nffs_gc_src_area_idx = NFFS_AREA_ID_NONE;
+    nffs_gc_state.ngs_cur_sum = nffs_gc_area_cur_sum();
+
+    STATS_INC(nffs_stats, nffs_gccnt);
+
+    return 0;
+}
+
+static void
+nffs_gc_record_pause(uint32_t usecs, int background)
+{
+    if (background) {
+        STATS_INC(nffs_stats, nffs_gcstep_bg);
+    } else if (usecs < 1000) {
+        STATS_INC(nffs_stats, nffs_gcpause_lt1ms);
+    } else if (usecs < 4000) {
+        STATS_INC(nffs_stats, nffs_gcpause_lt4ms);
+    } else if (usecs < 16000) {
+        STATS_INC(nffs_stats, nffs_gcpause_lt16ms);
+    } else if (usecs < 64000) {
+        STATS_INC(nffs_stats, nffs_gcpause_lt64ms);
+    } else if (usecs < 256000) {
+        STATS_INC(nffs_stats, nffs_gcpause_lt256ms);
+    } else {
+        STATS_INC(nffs_stats, nffs_gcpause_ge256ms);
+    }
+}
+
+/**
+ * Advances the garbage collection cycle in progress:
+ *
  *  (3) The RAM representation is exhaustively searched for objects which are
  *      resident in the source area.  The copy is accomplished as follows:
  *
@@ -420,55 +577,51 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
  *              are consolidated and copied to the destination area as a single
  *              new block.
  *
- *  (4) The source area is reformatted as a scratch sector (i.e., its header
- *      indicates an ID of 0xffff).  The area's garbage collection sequence
- *      number is incremented prior to rewriting the header.  This area is now
- *      the new scratch sector.
+ * The step ends once it has copied at least the specified number of bytes;
+ * at least one object is copied per step.  Objects are copied whole, so a
+ * step can exceed its budget by up to one maximum-size data block.  The
+ * search resumes at the hash bucket where the previous step stopped.  Any
+ * object written to the file system between steps is placed outside the
+ * source area, so it never needs to be copied.  Once the search is complete,
+ * the cycle is completed as described in nffs_gc_finish().
  *
  * NOTE:
- *     Garbage collection invalidates all cached data blocks.  Whenever this
- *     function is called, all existing nffs_cache_block pointers are rendered
- *     invalid.  If you maintain any such pointers, you need to reset them
- *     after calling this function.  Cached inodes are not invalidated by
- *     garbage collection.
- *
- *     If a parent function potentially calls this function, the caller of the
- *     parent function needs to explicitly check if garbage collection
- *     occurred.  This is done by inspecting the nffs_gc_count variable before
- *     and after calling the function.
+ *     Each step invalidates all cached data blocks; see nffs_gc().
  *
- * @param out_area_idx      On success, the ID of the cleaned up area gets
- *                              written here.  Pass null if you do not need
- *                              this information.
+ * @param budget            The number of bytes this step may copy.
+ * @param background        1 if the step runs in the background, i.e., no
+ *                              file system operation is waiting on it; 0
+ *                              otherwise.  Only used for statistics.
  *
  * @return                  0 on success; nonzero on error.
  */
 int
-nffs_gc(uint8_t *out_area_idx)
+nffs_gc_step(int32_t budget, int background)
 {
     struct nffs_hash_entry *entry;
     struct nffs_hash_entry *next;
-    struct nffs_area *from_area;
-    struct nffs_area *to_area;
     struct nffs_inode_entry *inode_entry;
     uint32_t area_offset;
+    uint32_t start;
     uint8_t from_area_idx;
+    uint8_t to_area_idx;
     uint8_t area_idx;
     int rc;
-    int i;
 
-    from_area_idx = nffs_gc_select_area();
-    from_area = nffs_areas + from_area_idx;
-    to_area = nffs_areas + nffs_scratch_area_idx;
-
-    rc = nffs_format_from_scratch_area(nffs_scratch_area_idx,
-                                       from_area->na_id);
-    if (rc != 0) {
-        return rc;
+    if (nffs_gc_src_area_idx == NFFS_AREA_ID_NONE) {
+        return 0;
     }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
-        entry = SLIST_FIRST(nffs_hash + i);
+    start = os_cputime_get32();
+
+    from_area_idx = nffs_gc_src_area_idx;
+    to_area_idx = nffs_gc_state.ngs_to_area_idx;
+    nffs_gc_state.ngs_budget = budget;
+
+    for (; nffs_gc_state.ngs_bucket < nffs_hash_size;
+         nffs_gc_state.ngs_bucket++) {
+
+        entry = SLIST_FIRST(nffs_hash + nffs_gc_state.ngs_bucket);
         while (entry != NULL) {
             next = SLIST_NEXT(entry, nhe_next);
 
@@ -478,8 +631,7 @@ nffs_gc(uint8_t *out_area_idx)
                                       &area_idx, &area_offset);
                 inode_entry = (struct nffs_inode_entry *)entry;
                 if (area_idx == from_area_idx) {
-                    rc = nffs_gc_copy_inode(inode_entry,
-                                            nffs_scratch_area_idx);
+                    rc = nffs_gc_copy_inode(inode_entry, to_area_idx);
                     if (rc != 0) {
                         return rc;
                     }
@@ -490,35 +642,32 @@ nffs_gc(uint8_t *out_area_idx)
                  */
                 if (nffs_hash_id_is_file(entry->nhe_id)) {
                     rc = nffs_gc_inode_blocks(inode_entry, from_area_idx,
-                                              nffs_scratch_area_idx, &next);
+                                              to_area_idx, &next);
                     if (rc != 0) {
                         return rc;
                     }
                 }
             }
 
+            /* If the budget runs out, the next step rescans this bucket from
+             * the start; a file's blocks may only have been partly copied.
+             * Objects that have been copied are no longer in the source area,
+             * so they are skipped.
+             */
+            if (nffs_gc_state.ngs_budget <= 0) {
+                goto done;
+            }
+
             entry = next;
         }
     }
 
-    /* The amount of written data should never increase as a result of a gc
-     * cycle.
-     */
-    assert(to_area->na_cur <= from_area->na_cur);
-
-    /* Turn the source area into the new scratch area. */
-    from_area->na_gc_seq++;
-    rc = nffs_format_area(from_area_idx, 1);
+    rc = nffs_gc_finish();
     if (rc != 0) {
         return rc;
     }
 
-    if (out_area_idx != NULL) {
-        *out_area_idx = nffs_scratch_area_idx;
-    }
-
-    nffs_scratch_area_idx = from_area_idx;
-
+done:
     /* Garbage collection renders the cache invalid:
      *     o All cached blocks are now invalid; drop them.
      *     o Flash locations of inodes may have changed; the cached inodes need
@@ -533,7 +682,118 @@ nffs_gc(uint8_t *out_area_idx)
      * reset its pointers to cached objects.
      */
     nffs_gc_count++;
-    STATS_INC(nffs_stats, nffs_gccnt);
+
+    nffs_gc_record_pause(
+        os_cputime_ticks_to_usecs(os_cputime_get32() - start), background);
+
+    return 0;
+}
+
+/**
+ * Indicates whether an incremental garbage collection cycle should be started
+ * ahead of need.  This is the case when the free space in the non-scratch
+ * areas has dropped below NFFS_GC_START_FREE_PCT percent of their capacity.
+ * To bound the flash wear caused by early cycles, a cycle is only started
+ * early after at least as many bytes as the next source area holds have been
+ * written since the last cycle ended.
+ *
+ * @return                  1 if a cycle should be started; 0 otherwise.
+ */
+int
+nffs_gc_start_due(void)
+{
+    uint32_t capacity;
+    uint32_t free_space;
+    uint32_t cur_sum;
+    int i;
+
+    if (nffs_gc_src_area_idx != NFFS_AREA_ID_NONE ||
+        nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
+
+        return 0;
+    }
+
+    capacity = 0;
+    free_space = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            capacity += nffs_areas[i].na_length;
+            free_space += nffs_area_free_space(nffs_areas + i);
+        }
+    }
+
+    if ((uint64_t)free_space * 100 >=
+        (uint64_t)capacity * MYNEWT_VAL(NFFS_GC_START_FREE_PCT)) {
+
+        return 0;
+    }
+
+    cur_sum = nffs_gc_area_cur_sum();
+    if (cur_sum - nffs_gc_state.ngs_cur_sum <
+        nffs_areas[nffs_gc_select_area()].na_length) {
+
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Abandons any cycle in progress.  Called when the RAM representation is
+ * reset; the next restore completes or discards the cycle.
+ */
+void
+nffs_gc_reset(void)
+{
+    memset(&nffs_gc_state, 0, sizeof nffs_gc_state);
+    nffs_gc_src_area_idx = NFFS_AREA_ID_NONE;
+}
+
+/**
+ * Performs a full garbage collection cycle; if an incremental cycle is in
+ * progress, it is completed instead.
+ *
+ * NOTE:
+ *     Garbage collection invalidates all cached data blocks.  Whenever this
+ *     function is called, all existing nffs_cache_block pointers are rendered
+ *     invalid.  If you maintain any such pointers, you need to reset them
+ *     after calling this function.  Cached inodes are not invalidated by
+ *     garbage collection.
+ *
+ *     If a parent function potentially calls this function, the caller of the
+ *     parent function needs to explicitly check if garbage collection
+ *     occurred.  This is done by inspecting the nffs_gc_count variable before
+ *     and after calling the function.
+ *
+ * @param out_area_idx      On success, the ID of the cleaned up area gets
+ *                              written here.  Pass null if you do not need
+ *                              this information.
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+int
+nffs_gc(uint8_t *out_area_idx)
+{
+    uint8_t to_area_idx;
+    int rc;
+
+    if (nffs_gc_src_area_idx == NFFS_AREA_ID_NONE) {
+        rc = nffs_gc_begin();
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    to_area_idx = nffs_gc_state.ngs_to_area_idx;
+
+    rc = nffs_gc_step(INT32_MAX, 0);
+    if (rc != 0) {
+        return rc;
+    }
+    assert(nffs_gc_src_area_idx == NFFS_AREA_ID_NONE);
+
+    if (out_area_idx != NULL) {
+        *out_area_idx = to_area_idx;
+    }
 
     return 0;
 }
@@ -24,6 +24,10 @@
 #include "nffs_priv.h"
 
 struct nffs_hash_list *nffs_hash;
+uint32_t nffs_hash_size;
+
+/* log2 of nffs_hash_size, subtracted from 32. */
+static uint8_t nffs_hash_shift;
 
 uint32_t nffs_hash_next_dir_id;
 uint32_t nffs_hash_next_file_id;
@@ -53,38 +57,16 @@ nffs_hash_id_is_block(uint32_t id)
     return id >= NFFS_ID_BLOCK_MIN && id < NFFS_ID_BLOCK_MAX;
 }
 
-static int
+/**
+ * Maps an object ID to a bucket index.  IDs are allocated sequentially
+ * within each object type's range; multiplying by 2^32 / phi and keeping the
+ * top bits (Fibonacci hashing) spreads both consecutive and strided IDs
+ * evenly across the table.
+ */
+uint32_t
 nffs_hash_fn(uint32_t id)
 {
-    return id % NFFS_HASH_SIZE;
-}
-
-static struct nffs_hash_entry *
-nffs_hash_find_reorder(uint32_t id)
-{
-    struct nffs_hash_entry *entry;
-    struct nffs_hash_entry *prev;
-    struct nffs_hash_list *list;
-    int idx;
-
-    idx = nffs_hash_fn(id);
-    list = nffs_hash + idx;
-
-    prev = NULL;
-    SLIST_FOREACH(entry, list, nhe_next) {
-        if (entry->nhe_id == id) {
-            /* Put entry at the front of the list. */
-            if (prev != NULL) {
-                SLIST_NEXT(prev, nhe_next) = SLIST_NEXT(entry, nhe_next);
-                SLIST_INSERT_HEAD(list, entry, nhe_next);
-            }
-            return entry;
-        }
-
-        prev = entry;
-    }
-
-    return NULL;
+    return (id * 0x9e3779b9) >> nffs_hash_shift;
 }
 
 struct nffs_hash_entry *
@@ -92,7 +74,7 @@ nffs_hash_find(uint32_t id)
 {
     struct nffs_hash_entry *entry;
     struct nffs_hash_list *list;
-    int idx;
+    uint32_t idx;
 
     idx = nffs_hash_fn(id);
     list = nffs_hash + idx;
@@ -113,7 +95,7 @@ nffs_hash_find_inode(uint32_t id)
 
     assert(nffs_hash_id_is_inode(id));
 
-    entry = nffs_hash_find_reorder(id);
+    entry = nffs_hash_find(id);
     return (struct nffs_inode_entry *)entry;
 }
 
@@ -124,7 +106,7 @@ nffs_hash_find_block(uint32_t id)
 
     assert(nffs_hash_id_is_block(id));
 
-    entry = nffs_hash_find_reorder(id);
+    entry = nffs_hash_find(id);
     return entry;
 }
 
@@ -149,7 +131,7 @@ nffs_hash_insert(struct nffs_hash_entry *entry)
 {
     struct nffs_hash_list *list;
     struct nffs_inode_entry *nie;
-    int idx;
+    uint32_t idx;
 
     assert(nffs_hash_find(entry->nhe_id) == NULL);
     idx = nffs_hash_fn(entry->nhe_id);
@@ -172,7 +154,7 @@ nffs_hash_remove(struct nffs_hash_entry *entry)
 {
     struct nffs_hash_list *list;
     struct nffs_inode_entry *nie = NULL;
-    int idx;
+    uint32_t idx;
 
     if (nffs_hash_id_is_inode(entry->nhe_id)) {
         nie = nffs_hash_find_inode(entry->nhe_id);
@@ -194,19 +176,58 @@ nffs_hash_remove(struct nffs_hash_entry *entry)
     assert(nffs_hash_find(entry->nhe_id) == NULL);
 }
 
+/**
+ * Determines the number of hash buckets.  Unless set explicitly, the table
+ * is sized from the inode and block pools: one bucket per two to four
+ * objects, so that chains stay short however full the pools get.
+ */
+static uint32_t
+nffs_hash_calc_size(void)
+{
+    uint32_t want;
+    uint32_t size;
+
+    want = MYNEWT_VAL(NFFS_HASH_SIZE);
+    if (want == 0) {
+        want = (nffs_config.nc_num_inodes + nffs_config.nc_num_blocks) / 2;
+        if (want < NFFS_HASH_SIZE_MIN) {
+            want = NFFS_HASH_SIZE_MIN;
+        }
+    }
+
+    /* Round down to a power of two. */
+    size = 2;
+    while (size <= want / 2) {
+        size *= 2;
+    }
+
+    return size;
+}
+
 int
 nffs_hash_init(void)
 {
-    int i;
+    uint32_t size;
+    uint32_t i;
+
+    size = nffs_hash_calc_size();
 
     free(nffs_hash);
 
-    nffs_hash = malloc(NFFS_HASH_SIZE * sizeof *nffs_hash);
+    nffs_hash = malloc(size * sizeof *nffs_hash);
     if (nffs_hash == NULL) {
+        nffs_hash_size = 0;
         return FS_ENOMEM;
     }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    nffs_hash_size = size;
+    nffs_hash_shift = 32;
+    while (size > 1) {
+        nffs_hash_shift--;
+        size /= 2;
+    }
+
+    for (i = 0; i < nffs_hash_size; i++) {
         SLIST_INIT(nffs_hash + i);
     }
 
@@ -196,7 +196,8 @@ nffs_misc_reserve_space_area(uint8_t area_idx, uint16_t space,
 
 /**
  * Finds an area that can accommodate an object of the specified size.  If no
- * such area exists, this function performs a garbage collection cycle.
+ * such area exists, this function completes the garbage collection cycle in
+ * progress, if any, and performs further cycles as needed.
  *
  * @param space                 The number of bytes of free space required.
  * @param out_area_idx          On success, the index of the suitable area gets
@@ -214,9 +215,11 @@ nffs_misc_reserve_space(uint16_t space,
     int rc;
     int i;
 
-    /* Find the first area with sufficient free space. */
+    /* Find the first area with sufficient free space.  While a garbage
+     * collection cycle is in progress, its source area is off limits too.
+     */
     for (i = 0; i < nffs_num_areas; i++) {
-        if (i != nffs_scratch_area_idx) {
+        if (i != nffs_scratch_area_idx && i != nffs_gc_src_area_idx) {
             rc = nffs_misc_reserve_space_area(i, space, out_area_offset);
             if (rc == 0) {
                 *out_area_idx = i;
@@ -422,6 +425,7 @@ nffs_misc_reset(void)
     nffs_root_dir = NULL;
     nffs_lost_found_dir = NULL;
     nffs_scratch_area_idx = NFFS_AREA_ID_NONE;
+    nffs_gc_reset();
 
     nffs_hash_next_file_id = NFFS_ID_FILE_MIN;
     nffs_hash_next_dir_id = NFFS_ID_DIR_MIN;
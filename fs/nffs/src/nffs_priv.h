@@ -32,7 +32,7 @@
 extern "C" {
 #endif
 
-#define NFFS_HASH_SIZE               256
+#define NFFS_HASH_SIZE_MIN           256
 
 #define NFFS_ID_DIR_MIN              0
 #define NFFS_ID_DIR_MAX              0x10000000
@@ -62,6 +62,10 @@ extern "C" {
 
 #define NFFS_BLOCK_MAX_DATA_SZ_MAX   2048
 
+#define NFFS_CHECKPOINT_MAGIC        0x4e434b50
+#define NFFS_CHECKPOINT_VER          0
+#define NFFS_CHECKPOINT_NUM_SLOTS    2
+
 #define NFFS_DETECT_FAIL_IGNORE     1
 #define NFFS_DETECT_FAIL_FORMAT     2
 
@@ -106,6 +110,59 @@ struct nffs_disk_block {
 
 #define NFFS_DISK_BLOCK_OFFSET_CRC  18
 
+/**
+ * On-disk header of a checkpoint slot.  The header is written after the
+ * records it describes, so a slot with a valid magic number is complete.
+ */
+struct nffs_disk_checkpoint {
+    uint32_t ndc_magic;             /* NFFS_CHECKPOINT_MAGIC */
+    uint32_t ndc_seq;               /* Greater supersedes lesser. */
+    uint32_t ndc_body_len;          /* Bytes of records following header. */
+    uint32_t ndc_next_file_id;
+    uint32_t ndc_next_dir_id;
+    uint32_t ndc_next_block_id;
+    uint32_t ndc_num_inodes;
+    uint32_t ndc_num_blocks;
+    uint16_t ndc_block_max_data_sz;
+    uint8_t ndc_ver;                /* NFFS_CHECKPOINT_VER */
+    uint8_t ndc_num_areas;
+    uint8_t ndc_scratch_area_idx;
+    uint8_t reserved8;
+    uint16_t ndc_crc16;             /* Covers records and rest of header. */
+    /* Followed by 'ndc_num_areas' area records, 'ndc_num_blocks' block
+     * records and 'ndc_num_inodes' inode records.
+     */
+};
+
+#define NFFS_DISK_CHECKPOINT_OFFSET_CRC 38
+
+/** Checkpointed state of one area. */
+struct nffs_disk_checkpoint_area {
+    uint32_t ndca_offset;
+    uint32_t ndca_length;
+    uint32_t ndca_cur;              /* Objects past this get replayed. */
+    uint16_t ndca_id;
+    uint8_t ndca_gc_seq;
+    uint8_t ndca_flash_id;
+};
+
+/**
+ * Checkpointed inode.  Inodes are recorded in directory order; the children
+ * of a directory are always consecutive.
+ */
+struct nffs_disk_checkpoint_inode {
+    uint32_t ndci_id;
+    uint32_t ndci_flash_loc;
+    uint32_t ndci_parent_id;        /* NFFS_ID_NONE for the root dir. */
+    uint32_t ndci_lastblock_id;     /* NFFS_ID_NONE if no data. */
+};
+
+/** Checkpointed data block. */
+struct nffs_disk_checkpoint_block {
+    uint32_t ndcb_id;
+    uint32_t ndcb_flash_loc;
+};
+
 /**
  * What gets stored in the hash table.  Each entry represents a data block or
  * an inode.
@@ -228,12 +285,29 @@ struct nffs_cache_block {
 
 TAILQ_HEAD(nffs_cache_block_list, nffs_cache_block);
 
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+/** A single entry in a cached inode's sparse block index. */
+struct nffs_cache_index_entry {
+    struct nffs_hash_entry *ncie_block_entry;   /* Indexed data block. */
+    uint32_t ncie_end_offset;                   /* File offset of block end. */
+};
+#endif
+
 /** Represents a single cached file inode. */
 struct nffs_cache_inode {
     TAILQ_ENTRY(nffs_cache_inode) nci_link;        /* Sorted; LRU at tail. */
     struct nffs_inode nci_inode;                   /* Full inode. */
     struct nffs_cache_block_list nci_block_list;   /* List of cached blocks. */
     uint32_t nci_file_size;                        /* Total file size. */
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+    /* Every nci_index_stride'th block, in ascending offset order.  The last
+     * block of the file is never indexed since it is the only one whose
+     * length can change.
+     */
+    struct nffs_cache_index_entry nci_index[MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE)];
+    uint16_t nci_index_count;
+    uint16_t nci_index_stride;
+#endif
 };
 
 struct nffs_dirent {
@@ -267,6 +341,13 @@ STATS_SECT_START(nffs_stats)
     STATS_SECT_ENTRY(nffs_readcnt_filename)
     STATS_SECT_ENTRY(nffs_readcnt_object)
     STATS_SECT_ENTRY(nffs_readcnt_detect)
+    STATS_SECT_ENTRY(nffs_gcstep_bg)
+    STATS_SECT_ENTRY(nffs_gcpause_lt1ms)
+    STATS_SECT_ENTRY(nffs_gcpause_lt4ms)
+    STATS_SECT_ENTRY(nffs_gcpause_lt16ms)
+    STATS_SECT_ENTRY(nffs_gcpause_lt64ms)
+    STATS_SECT_ENTRY(nffs_gcpause_lt256ms)
+    STATS_SECT_ENTRY(nffs_gcpause_ge256ms)
 STATS_SECT_END
 extern STATS_SECT_DECL(nffs_stats) nffs_stats;
 
@@ -290,12 +371,14 @@ extern uint8_t nffs_num_areas;
 extern uint8_t nffs_scratch_area_idx;
 extern uint16_t nffs_block_max_data_sz;
 extern unsigned int nffs_gc_count;
+extern uint8_t nffs_gc_src_area_idx;
 extern struct nffs_area_desc *nffs_current_area_descs;
 
 #define NFFS_FLASH_BUF_SZ        256
 extern uint8_t nffs_flash_buf[NFFS_FLASH_BUF_SZ];
 
 extern struct nffs_hash_list *nffs_hash;
+extern uint32_t nffs_hash_size;
 extern struct nffs_inode_entry *nffs_root_dir;
 extern struct nffs_inode_entry *nffs_lost_found_dir;
 
@@ -346,6 +429,12 @@ int nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t to,
                     struct nffs_cache_block **out_cache_block);
 void nffs_cache_clear(void);
 
+/* @checkpoint */
+int nffs_checkpoint_enabled(void);
+int nffs_checkpoint_write(void);
+int nffs_checkpoint_restore(uint16_t *out_max_data_len);
+int nffs_checkpoint_invalidate(void);
+
 /* @crc */
 int nffs_crc_flash(uint16_t initial_crc, uint8_t area_idx,
                    uint32_t area_offset, uint32_t len, uint16_t *out_crc);
@@ -386,6 +475,10 @@ int nffs_format_full(const struct nffs_area_desc *area_descs);
 /* @gc */
 int nffs_gc(uint8_t *out_area_idx);
 int nffs_gc_until(uint32_t space, uint8_t *out_area_idx);
+int nffs_gc_begin(void);
+int nffs_gc_step(int32_t budget, int background);
+int nffs_gc_start_due(void);
+void nffs_gc_reset(void);
 
 /* @flash */
 struct nffs_area *nffs_flash_find_area(uint16_t logical_id);
@@ -405,6 +498,7 @@ int nffs_hash_id_is_dir(uint32_t id);
 int nffs_hash_id_is_file(uint32_t id);
 int nffs_hash_id_is_inode(uint32_t id);
 int nffs_hash_id_is_block(uint32_t id);
+uint32_t nffs_hash_fn(uint32_t id);
 struct nffs_hash_entry *nffs_hash_find(uint32_t id);
 struct nffs_inode_entry *nffs_hash_find_inode(uint32_t id);
 struct nffs_hash_entry *nffs_hash_find_block(uint32_t id);
@@ -497,13 +591,14 @@ int nffs_path_new_dir(const char *path,
 
 /* @restore */
 int nffs_restore_full(const struct nffs_area_desc *area_descs);
+int nffs_restore_checkpoint(const struct nffs_area_desc *area_descs);
 
 /* @write */
 int nffs_write_to_file(struct nffs_file *file, const void *data, int len);
 
 
 #define NFFS_HASH_FOREACH(entry, i, next)                               \
-    for ((i) = 0; (i) < NFFS_HASH_SIZE; (i)++)                          \
+    for ((i) = 0; (i) < nffs_hash_size; (i)++)                          \
         for ((entry) = SLIST_FIRST(nffs_hash + (i));                    \
              (entry) && (((next)) = SLIST_NEXT((entry), nhe_next), 1);  \
              (entry) = ((next)))
@@ -32,6 +32,9 @@
  */
 static uint16_t nffs_restore_largest_block_data_len;
 
+/** The number of valid objects restored from flash by the current restore. */
+static uint32_t nffs_restore_num_objects;
+
 /**
  * Checks that each block a chain of data blocks was properly restored.
  *
@@ -281,74 +284,83 @@ nffs_restore_sweep(void)
     struct nffs_inode inode;
     struct nffs_block block;
     int del = 0;
+    int pass;
     int rc;
     int i;
 
     /* Iterate through every object in the hash table, deleting all inodes that
-     * should be removed.
+     * should be removed.  Blocks are checked in a second pass, once all
+     * inodes have been swept; deleting a file whose block chain is broken
+     * can leave blocks behind which only then become detectable as orphans.
      */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
-        list = nffs_hash + i;
-
-        entry = SLIST_FIRST(list);
-        while (entry != NULL) {
-            next = SLIST_NEXT(entry, nhe_next);
-            if (nffs_hash_id_is_inode(entry->nhe_id)) {
-                inode_entry = (struct nffs_inode_entry *)entry;
-
-                /*
-                 * If this is a dummy inode directory, the file system
-                 * is corrupt.  Move the directory's children inodes to
-                 * the lost+found directory.
-                 */
-                rc = nffs_restore_migrate_orphan_children(inode_entry);
-                if (rc != 0) {
-                    return rc;
-                }
-
-                /* Determine if this inode needs to be deleted. */
-                rc = nffs_restore_should_sweep_inode_entry(inode_entry, &del);
-                if (rc != 0) {
-                    return rc;
-                }
-
-                rc = nffs_inode_from_entry(&inode, inode_entry);
-                if (rc != 0 && rc != FS_ENOENT) {
-                    return rc;
-                }
-
-                if (del) {
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < nffs_hash_size; i++) {
+            list = nffs_hash + i;
+
+            entry = SLIST_FIRST(list);
+            while (entry != NULL) {
+                next = SLIST_NEXT(entry, nhe_next);
+                if (pass == 0 && nffs_hash_id_is_inode(entry->nhe_id)) {
+                    inode_entry = (struct nffs_inode_entry *)entry;
 
-                    /* Remove the inode and all its children from RAM.  We
-                     * expect some file system corruption; the children are
-                     * subject to garbage collection and may not exist in the
-                     * hash.  Remove what is actually present and ignore
-                     * corruption errors.
+                    /*
+                     * If this is a dummy inode directory, the file system
+                     * is corrupt.  Move the directory's children inodes to
+                     * the lost+found directory.
                      */
-                    rc = nffs_inode_unlink_from_ram_corrupt_ok(&inode, &next);
+                    rc = nffs_restore_migrate_orphan_children(inode_entry);
                     if (rc != 0) {
                         return rc;
                     }
-                    next = SLIST_FIRST(list);
-                }
-            } else if (nffs_hash_id_is_block(entry->nhe_id)) {
-                if (nffs_hash_id_is_dummy(entry->nhe_id)) {
-                    del = 1;
-                    nffs_block_delete_from_ram(entry);
-                } else {
-                    rc = nffs_block_from_hash_entry(&block, entry);
+
+                    /* Determine if this inode needs to be deleted. */
+                    rc = nffs_restore_should_sweep_inode_entry(inode_entry,
+                                                               &del);
+                    if (rc != 0) {
+                        return rc;
+                    }
+
+                    rc = nffs_inode_from_entry(&inode, inode_entry);
                     if (rc != 0 && rc != FS_ENOENT) {
+                        return rc;
+                    }
+
+                    if (del) {
+
+                        /* Remove the inode and all its children from RAM.
+                         * We expect some file system corruption; the
+                         * children are subject to garbage collection and may
+                         * not exist in the hash.  Remove what is actually
+                         * present and ignore corruption errors.
+                         */
+                        rc = nffs_inode_unlink_from_ram_corrupt_ok(&inode,
+                                                                   &next);
+                        if (rc != 0) {
+                            return rc;
+                        }
+                        next = SLIST_FIRST(list);
+                    }
+                } else if (pass == 1 &&
+                           nffs_hash_id_is_block(entry->nhe_id)) {
+
+                    if (nffs_hash_id_is_dummy(entry->nhe_id)) {
                         del = 1;
                         nffs_block_delete_from_ram(entry);
+                    } else {
+                        rc = nffs_block_from_hash_entry(&block, entry);
+                        if (rc != 0 && rc != FS_ENOENT) {
+                            del = 1;
+                            nffs_block_delete_from_ram(entry);
+                        }
+                    }
+                    if (del) {
+                        del = 0;
+                        next = SLIST_FIRST(list);
                     }
                 }
-                if (del) {
-                    del = 0;
-                    next = SLIST_FIRST(list);
-                }
-            }
 
-            entry = next;
+                entry = next;
+            }
         }
     }
 
@@ -1030,7 +1042,8 @@ nffs_restore_disk_object_size(const struct nffs_disk_object *disk_object)
 
 /**
  * Reads the specified area from disk and loads its contents into the RAM
- * representation.
+ * representation.  Reading starts at the area's current write offset and
+ * continues until the end of the written region.
  *
  * @param area_idx              The index of the area to read.
  *
@@ -1045,7 +1058,6 @@ nffs_restore_area_contents(int area_idx)
 
     area = nffs_areas + area_idx;
 
-    area->na_cur = sizeof (struct nffs_disk_area);
     while (1) {
         rc = nffs_restore_disk_object(area_idx, area->na_cur,  &disk_object);
         switch (rc) {
@@ -1064,6 +1076,7 @@ nffs_restore_area_contents(int area_idx)
                 area->na_cur++;
             } else {
                 STATS_INC(nffs_stats, nffs_object_count); /* restored objects */
+                nffs_restore_num_objects++;
                 area->na_cur += nffs_restore_disk_object_size(&disk_object);
             }
             break;
@@ -1123,6 +1136,38 @@ nffs_restore_detect_one_area(uint8_t flash_id, uint32_t area_offset,
     return 0;
 }
 
+/**
+ * Invalidates a data block resident in the destination area of an
+ * interrupted garbage collection cycle.  The source area still contains the
+ * block, so it gets restored again when the source area is reread.
+ *
+ * The owning inode may reside in a third area, in which case it is not
+ * reread.  If the block is the inode's last block, the entry is turned into a
+ * dummy rather than freed; the inode's reference is then reconnected when the
+ * block is restored from the source area.
+ *
+ * @param block_entry           The block to invalidate.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+nffs_restore_corrupt_scratch_block(struct nffs_hash_entry *block_entry)
+{
+    struct nffs_block block;
+    int rc;
+
+    rc = nffs_block_from_hash_entry(&block, block_entry);
+    if (rc == 0 && block.nb_inode_entry != NULL &&
+        block.nb_inode_entry->nie_last_block_entry == block_entry) {
+
+        block_entry->nhe_flash_loc = NFFS_FLASH_LOC_NONE;
+        nffs_inode_setflags(block.nb_inode_entry, NFFS_INODE_FLAG_DUMMYLSTBLK);
+        return 0;
+    }
+
+    return nffs_block_delete_from_ram(block_entry);
+}
+
 /**
  * Repairs the effects of a corrupt scratch area.  Scratch area corruption can
  * occur when the system resets while a garbage collection cycle is in
@@ -1159,7 +1204,7 @@ nffs_restore_corrupt_scratch(void)
     }
 
     /* Invalidate all objects resident in the bad area. */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         entry = SLIST_FIRST(&nffs_hash[i]);
         while (entry != NULL) {
             next = SLIST_NEXT(entry, nhe_next);
@@ -1168,7 +1213,7 @@ nffs_restore_corrupt_scratch(void)
                                  &area_idx, &area_offset);
             if (area_idx == bad_idx) {
                 if (nffs_hash_id_is_block(entry->nhe_id)) {
-                    rc = nffs_block_delete_from_ram(entry);
+                    rc = nffs_restore_corrupt_scratch_block(entry);
                     if (rc != 0) {
                         return rc;
                     }
@@ -1185,6 +1230,7 @@ nffs_restore_corrupt_scratch(void)
     /* Now that the objects in the scratch area have been invalidated, reload
      * everything from the good area.
      */
+    nffs_areas[good_idx].na_cur = sizeof (struct nffs_disk_area);
     rc = nffs_restore_area_contents(good_idx);
     if (rc != 0) {
         return rc;
@@ -1274,20 +1320,18 @@ nffs_log_contents(void)
 }
 
 /**
- * Searches for a valid nffs file system among the specified areas.  This
- * function succeeds if a file system is detected among any subset of the
- * supplied areas.  If the area set does not contain a valid file system,
- * a new one can be created via a call to nffs_format().
+ * Reads the header of each of the specified areas and populates the RAM
+ * representation of the usable ones.
  *
  * @param area_descs        The area set to search.  This array must be
  *                              terminated with a 0-length area.
+ * @param scan              1 to restore the contents of each area;
+ *                          0 to only read the area headers.
  *
- * @return                  0 on success;
- *                          FS_ECORRUPT if no valid file system was detected;
- *                          other nonzero on error.
+ * @return                  0 on success; nonzero on failure.
  */
-int
-nffs_restore_full(const struct nffs_area_desc *area_descs)
+static int
+nffs_restore_areas(const struct nffs_area_desc *area_descs, int scan)
 {
     struct nffs_disk_area disk_area;
     int cur_area_idx;
@@ -1295,19 +1339,9 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
     int rc;
     int i;
 
-    /* Start from a clean state. */
-    rc = nffs_misc_reset();
-    if (rc) {
-        return rc;
-    }
-    nffs_restore_largest_block_data_len = 0;
-    nffs_current_area_descs = (struct nffs_area_desc*) area_descs;
-
-    /* Read each area from flash. */
     for (i = 0; area_descs[i].nad_length != 0; i++) {
         if (i > NFFS_MAX_AREAS) {
-            rc = FS_EINVAL;
-            goto err;
+            return FS_EINVAL;
         }
 
         rc = nffs_restore_detect_one_area(area_descs[i].nad_flash_id,
@@ -1324,7 +1358,7 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             break;
 
         default:
-            goto err;
+            return rc;
         }
 
         if (use_area) {
@@ -1342,7 +1376,7 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
 
             rc = nffs_misc_set_num_areas(nffs_num_areas + 1);
             if (rc != 0) {
-                goto err;
+                return rc;
             }
 
             nffs_areas[cur_area_idx].na_offset = area_descs[i].nad_offset;
@@ -1357,11 +1391,102 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             } else {
                 nffs_areas[cur_area_idx].na_cur =
                     sizeof (struct nffs_disk_area);
-                nffs_restore_area_contents(cur_area_idx);
+                if (scan) {
+                    nffs_restore_area_contents(cur_area_idx);
+                }
             }
         }
     }
 
+    return 0;
+}
+
+/**
+ * Performs the final steps of a restore, once all objects have been loaded
+ * into RAM.
+ *
+ * @param sweep             Whether the RAM representation needs to be
+ *                              swept of invalidated objects.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+static int
+nffs_restore_finish(int sweep)
+{
+    int rc;
+
+    /* Ensure this file system contains a valid scratch area. */
+    rc = nffs_misc_validate_scratch();
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Make sure the file system contains a valid root directory. */
+    rc = nffs_misc_validate_root_dir();
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Ensure there is a "/lost+found" directory. */
+    rc = nffs_misc_create_lost_found_dir();
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Delete from RAM any objects that were invalidated when subsequent areas
+     * were restored.
+     */
+    if (sweep) {
+        nffs_restore_sweep();
+    }
+
+    /* Set the maximum data block size according to the size of the smallest
+     * area.
+     */
+    rc = nffs_misc_set_max_block_data_len(nffs_restore_largest_block_data_len);
+    if (rc != 0) {
+        return rc;
+    }
+
+    NFFS_LOG_DEBUG("CONTENTS\n");
+    nffs_log_contents();
+
+    return 0;
+}
+
+/**
+ * Searches for a valid nffs file system among the specified areas.  This
+ * function succeeds if a file system is detected among any subset of the
+ * supplied areas.  If the area set does not contain a valid file system,
+ * a new one can be created via a call to nffs_format().
+ *
+ * @param area_descs        The area set to search.  This array must be
+ *                              terminated with a 0-length area.
+ *
+ * @return                  0 on success;
+ *                          FS_ECORRUPT if no valid file system was detected;
+ *                          other nonzero on error.
+ */
+int
+nffs_restore_full(const struct nffs_area_desc *area_descs)
+{
+    int rc;
+
+    /* Start from a clean state. */
+    rc = nffs_misc_reset();
+    if (rc) {
+        return rc;
+    }
+    nffs_restore_largest_block_data_len = 0;
+    nffs_restore_num_objects = 0;
+    nffs_current_area_descs = (struct nffs_area_desc*) area_descs;
+
+    /* Read each area from flash. */
+    rc = nffs_restore_areas(area_descs, 1);
+    if (rc != 0) {
+        goto err;
+    }
+
     /* All areas have been restored from flash. */
 
     if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
@@ -1377,40 +1502,84 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
         }
     }
 
-    /* Ensure this file system contains a valid scratch area. */
-    rc = nffs_misc_validate_scratch();
+    rc = nffs_restore_finish(1);
     if (rc != 0) {
         goto err;
     }
 
-    /* Make sure the file system contains a valid root directory. */
-    rc = nffs_misc_validate_root_dir();
+    return 0;
+
+err:
+    nffs_misc_reset();
+    return rc;
+}
+
+/**
+ * Restores the file system from the most recent checkpoint, rather than from
+ * a scan of every object in every area.  The checkpoint is loaded into RAM,
+ * then only the objects written after it are read from flash.  The final
+ * sweep, which reads the header of every data block, is only performed if
+ * such objects were found.
+ *
+ * Objects recorded in the checkpoint are not CRC checked again.
+ *
+ * @param area_descs        The area set to restore.  This array must be
+ *                              terminated with a 0-length area.
+ *
+ * @return                  0 on success;
+ *                          FS_ENOENT if there is no usable checkpoint;
+ *                          FS_ECORRUPT if the checkpoint does not match
+ *                              the areas;
+ *                          other nonzero on error.  On failure, the
+ *                              caller should fall back to
+ *                              nffs_restore_full().
+ */
+int
+nffs_restore_checkpoint(const struct nffs_area_desc *area_descs)
+{
+    int rc;
+    int i;
+
+    if (!nffs_checkpoint_enabled()) {
+        return FS_ENOENT;
+    }
+
+    rc = nffs_misc_reset();
+    if (rc) {
+        return rc;
+    }
+    nffs_restore_largest_block_data_len = 0;
+    nffs_restore_num_objects = 0;
+    nffs_current_area_descs = (struct nffs_area_desc*) area_descs;
+
+    rc = nffs_restore_areas(area_descs, 0);
     if (rc != 0) {
         goto err;
     }
 
-    /* Ensure there is a "/lost+found" directory. */
-    rc = nffs_misc_create_lost_found_dir();
+    /* A missing scratch area can only be repaired by a full restore. */
+    if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
+        rc = FS_ECORRUPT;
+        goto err;
+    }
+
+    rc = nffs_checkpoint_restore(&nffs_restore_largest_block_data_len);
     if (rc != 0) {
         goto err;
     }
 
-    /* Delete from RAM any objects that were invalidated when subsequent areas
-     * were restored.
-     */
-    nffs_restore_sweep();
+    /* Replay the objects written since the checkpoint. */
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            nffs_restore_area_contents(i);
+        }
+    }
 
-    /* Set the maximum data block size according to the size of the smallest
-     * area.
-     */
-    rc = nffs_misc_set_max_block_data_len(nffs_restore_largest_block_data_len);
+    rc = nffs_restore_finish(nffs_restore_num_objects != 0);
     if (rc != 0) {
         goto err;
     }
 
-    NFFS_LOG_DEBUG("CONTENTS\n");
-    nffs_log_contents();
-
     return 0;
 
 err:
@@ -85,7 +85,16 @@ int
 mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len);
 
 /**
- * TODO
+ * Perform a disk control operation on the MMC
+ *
+ * Supports DISK_IOCTL_SYNC and DISK_IOCTL_GET_SIZE; the size is read from
+ * the card's CSD register and capped at 4GiB, as addresses are 32-bit.
+ *
+ * @param mmc_id Id of the MMC device (currently must be 0)
+ * @param cmd One of the DISK_IOCTL_* commands
+ * @param arg Command argument or result
+ *
+ * @return 0 on success, MMC_PARAM_ERROR if the command is not supported
  */
 int
 mmc_ioctl(uint8_t mmc_id, uint32_t cmd, void *arg);
@@ -29,6 +29,7 @@
 #define CMD0                (0)            /* GO_IDLE_STATE */
 #define CMD1                (1)            /* SEND_OP_COND (MMC) */
 #define CMD8                (8)            /* SEND_IF_COND */
+#define CMD9                (9)            /* SEND_CSD */
 #define CMD12               (12)           /* STOP_TRANSMISSION */
 #define CMD16               (16)           /* SET_BLOCKLEN */
 #define CMD17               (17)           /* READ_SINGLE_BLOCK */
@@ -62,6 +63,7 @@
 #define STOP_TRAN_TOKEN     (0xFD)
 
 #define BLOCK_LEN           (512)
+#define CSD_LEN             (16)
 
 static uint8_t g_block_buf[BLOCK_LEN];
 
@@ -583,13 +585,120 @@ out:
     return (rc);
 }
 
+/**
+ * Reads the card's CSD register.
+ *
+ * @return 0 on success, non-zero on failure
+ */
+static int
+mmc_read_csd(struct mmc_cfg *mmc, uint8_t *csd)
+{
+    uint8_t res;
+    int rc;
+    int n;
+    os_time_t timeout;
+
+    rc = MMC_OK;
+
+    hal_gpio_write(mmc->ss_pin, 0);
+
+    res = send_mmc_cmd(mmc, CMD9, 0);
+    if (res) {
+        rc = error_by_response(res);
+        goto out;
+    }
+
+    /* The register is sent like a data block. */
+    timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
+    do {
+        res = hal_spi_tx_val(mmc->spi_num, 0xff);
+        if (res != 0xFF) break;
+        os_time_delay(OS_TICKS_PER_SEC / 20);
+    } while (os_time_get() < timeout);
+
+    if (res != START_BLOCK) {
+        rc = MMC_TIMEOUT;
+        goto out;
+    }
+
+    for (n = 0; n < CSD_LEN; n++) {
+        csd[n] = hal_spi_tx_val(mmc->spi_num, 0xff);
+    }
+
+    /* CRC-16 */
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+
+out:
+    hal_gpio_write(mmc->ss_pin, 1);
+    return (rc);
+}
+
+/**
+ * Computes the card capacity in bytes from its CSD register, limited to what
+ * the 32-bit byte addresses of this driver can reach.
+ */
+static uint32_t
+mmc_csd_size(const uint8_t *csd)
+{
+    uint64_t size;
+    uint32_t c_size;
+    uint8_t c_size_mult;
+    uint8_t read_bl_len;
+
+    if ((csd[0] >> 6) == 1) {
+        /* CSD Version 2.0 (SDHC/SDXC): C_SIZE[69:48], 512KiB units */
+        c_size = ((uint32_t)(csd[7] & 0x3f) << 16) | (csd[8] << 8) | csd[9];
+        size = ((uint64_t)c_size + 1) * 512 * 1024;
+    } else {
+        /* CSD Version 1.0 (SDSC) and MMC: C_SIZE[73:62], C_SIZE_MULT[49:47],
+         * READ_BL_LEN[83:80]
+         */
+        read_bl_len = csd[5] & 0x0f;
+        c_size = ((uint32_t)(csd[6] & 0x03) << 10) | (csd[7] << 2) |
+                 (csd[8] >> 6);
+        c_size_mult = ((csd[9] & 0x03) << 1) | (csd[10] >> 7);
+        size = ((uint64_t)c_size + 1) << (c_size_mult + 2 + read_bl_len);
+    }
+
+    if (size > UINT32_MAX) {
+        size = UINT32_MAX & ~(BLOCK_LEN - 1);
+    }
+
+    return (uint32_t)size;
+}
+
 /*
  *
  */
 int
 mmc_ioctl(uint8_t mmc_id, uint32_t cmd, void *arg)
 {
-    return 0;
+    uint8_t csd[CSD_LEN];
+    struct mmc_cfg *mmc;
+    int rc;
+
+    mmc = mmc_cfg_dev(mmc_id);
+    if (mmc == NULL) {
+        return (MMC_DEVICE_ERROR);
+    }
+
+    switch (cmd) {
+    case DISK_IOCTL_SYNC:
+        /* Writes have completed by the time mmc_write() returns. */
+        return MMC_OK;
+
+    case DISK_IOCTL_GET_SIZE:
+        rc = mmc_read_csd(mmc, csd);
+        if (rc != MMC_OK) {
+            return rc;
+        }
+        *(uint32_t *)arg = mmc_csd_size(csd);
+        return MMC_OK;
+
+    default:
+        return MMC_PARAM_ERROR;
+    }
 }
 
 /*
@@ -667,6 +667,8 @@ sensor_mgr_init(void)
      */
     os_callout_init(&sensor_mgr.mgr_wakeup_callout, sensor_mgr_evq_get(),
             sensor_mgr_wakeup_event, NULL);
+    os_callout_set_slack(&sensor_mgr.mgr_wakeup_callout,
+            os_time_ms_to_ticks32(MYNEWT_VAL(SENSOR_MGR_WAKEUP_SLACK_MS)));
 
     /* Initialize sensor cputime update callout and set it to fire after an
      * hour, CPU time gets wrapped in 4295 seconds,
@@ -681,6 +683,10 @@ sensor_mgr_init(void)
 
     os_callout_init(&st_up_osco, sensor_mgr_evq_get(),
             sensor_base_ts_update_event, NULL);
+    /* The update is not time critical; let it piggyback on another wakeup
+     * within a minute.
+     */
+    os_callout_set_slack(&st_up_osco, OS_TICKS_PER_SEC * 60);
     os_callout_reset(&st_up_osco, OS_TICKS_PER_SEC);
 
     os_mutex_init(&sensor_mgr.mgr_lock);
@@ -45,6 +45,10 @@ struct os_callout {
     struct os_eventq *c_evq;
     /** Number of ticks in the future to expire the callout */
     os_time_t c_ticks;
+#if MYNEWT_VAL(OS_CALLOUT_SLACK)
+    /** Number of ticks the callout may be delayed by to share a wakeup */
+    os_time_t c_slack;
+#endif
 
 
     TAILQ_ENTRY(os_callout) c_next;
@@ -99,6 +103,28 @@ void os_callout_stop(struct os_callout *);
  */
 int os_callout_reset(struct os_callout *, os_time_t);
 
+/**
+ * Set the slack of a callout: the number of ticks by which it may expire
+ * later than requested.  os_callout_reset() moves the expiry time within
+ * that window onto a tick with as many low-order zero bits as possible, so
+ * that callouts with overlapping windows expire on the same tick and the
+ * system wakes up once for all of them.  The slack applies from the next
+ * os_callout_reset() on; os_callout_init() sets it to 0.
+ *
+ * Without OS_CALLOUT_SLACK this function has no effect.
+ *
+ * @param c The callout to set the slack of
+ * @param slack The number of ticks the callout may be delayed by
+ */
+#if MYNEWT_VAL(OS_CALLOUT_SLACK)
+void os_callout_set_slack(struct os_callout *c, os_time_t slack);
+#else
+static inline void
+os_callout_set_slack(struct os_callout *c, os_time_t slack)
+{
+}
+#endif
+
 /**
  * Returns the number of ticks which remains to callout.
  *
@@ -147,6 +147,18 @@ struct os_event *os_eventq_get(struct os_eventq *);
  */
 void os_eventq_run(struct os_eventq *evq);
 
+/**
+ * Pull up to max items off the event queue and call their event callbacks.
+ * Blocks until the first item is available, then keeps processing items as
+ * long as more are queued, without sleeping in between.
+ *
+ * @param evq The event queue to pull the items off.
+ * @param max The maximum number of items to process; must be at least 1.
+ *
+ * @return The number of items processed.
+ */
+int os_eventq_run_batch(struct os_eventq *evq, int max);
+
 
 /**
  * Poll the list of event queues specified by the evq parameter
@@ -30,6 +30,8 @@
 #define H_OS_HEAP_
 
 #include <stddef.h>
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -70,6 +72,39 @@ void os_free(void *mem);
  */
 void *os_realloc(void *ptr, size_t size);
 
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+/**
+ * Usage of the heap behind os_malloc(), as returned by os_heap_info_get().
+ */
+struct os_heap_info {
+    /** Bytes obtained from the system for the heap, including overhead. */
+    uint32_t ohi_total;
+    /** Bytes in allocated blocks. */
+    uint32_t ohi_used;
+    /** Highest value ohi_used has reached. */
+    uint32_t ohi_used_max;
+    /** Bytes in free blocks. */
+    uint32_t ohi_free;
+    /** Number of free blocks. */
+    uint32_t ohi_free_blocks;
+    /**
+     * Size of the largest free block; the largest allocation that can
+     * succeed without growing the heap.
+     */
+    uint32_t ohi_largest_free;
+};
+
+/**
+ * Reports the usage of the heap behind os_malloc().  Only available with
+ * OS_HEAP_TLSF.
+ *
+ * @param info The structure to fill in
+ *
+ * @return 0 on success
+ */
+int os_heap_info_get(struct os_heap_info *info);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
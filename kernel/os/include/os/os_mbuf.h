@@ -54,6 +54,14 @@ struct os_mbuf_pool {
      */
     struct os_mempool *omp_pool;
 
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    /**
+     * The mbuf pool to allocate the headers of clones of this pool's mbufs
+     * out of; NULL to use this pool.
+     */
+    struct os_mbuf_pool *omp_clone_pool;
+#endif
+
     STAILQ_ENTRY(os_mbuf_pool) omp_next;
 };
 
@@ -102,12 +110,49 @@ struct os_mbuf {
 
     SLIST_ENTRY(os_mbuf) om_next;
 
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    /**
+     * The mbuf whose data buffer holds this mbuf's data; NULL if the data is
+     * in this mbuf's own buffer.
+     */
+    struct os_mbuf *om_ref;
+    /**
+     * Number of references to this mbuf's memory block: one for the mbuf
+     * itself until it is freed, plus one for every mbuf whose om_ref points
+     * here.  The block is returned to its pool when this drops to zero.
+     */
+    uint16_t om_refcnt;
+#endif
+
     /**
      * Pointer to the beginning of the data, after this buffer
      */
     uint8_t om_databuf[0];
 };
 
+/**
+ * A read-only view of one contiguous segment of data in an mbuf chain.
+ */
+struct os_mbuf_iovec {
+    /** Start of the segment */
+    const uint8_t *omv_data;
+    /** Length of the segment, in bytes */
+    uint16_t omv_len;
+};
+
+/**
+ * Iterator over the data segments of an mbuf chain.  Initialize with
+ * os_mbuf_iter_init(); the fields are private.
+ */
+struct os_mbuf_iter {
+    /** Current mbuf */
+    const struct os_mbuf *omi_om;
+    /** Offset of the next byte within the current mbuf */
+    uint16_t omi_off;
+    /** Number of bytes left to iterate over */
+    int omi_rem;
+};
+
 /**
  * Structure representing a queue of mbufs.
  */
@@ -173,6 +218,19 @@ struct os_mqueue {
     ((om)->om_pkthdr_len - sizeof (struct os_mbuf_pkthdr))
 
 
+/**
+ * Indicates whether an mbuf's data buffer may be shared with other mbufs,
+ * i.e., whether the mbuf is a clone or has been cloned.  The data of such an
+ * mbuf is read-only, and it has no leading or trailing space; modify it only
+ * with the mbuf functions (e.g., os_mbuf_copyinto()), which copy it first.
+ */
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+#define OS_MBUF_IS_SHARED(__om) \
+    ((__om)->om_ref != NULL || (__om)->om_refcnt > 1)
+#else
+#define OS_MBUF_IS_SHARED(__om) (0)
+#endif
+
 /** @cond INTERNAL_HIDDEN */
 
 /*
@@ -184,6 +242,10 @@ _os_mbuf_leadingspace(struct os_mbuf *om)
     uint16_t startoff;
     uint16_t leadingspace;
 
+    if (OS_MBUF_IS_SHARED(om)) {
+        return 0;
+    }
+
     startoff = 0;
     if (OS_MBUF_IS_PKTHDR(om)) {
         startoff = om->om_pkthdr_len;
@@ -218,6 +280,10 @@ _os_mbuf_trailingspace(struct os_mbuf *om)
 {
     struct os_mbuf_pool *omp;
 
+    if (OS_MBUF_IS_SHARED(om)) {
+        return 0;
+    }
+
     omp = om->om_omp;
 
     return (&om->om_databuf[0] + omp->omp_databuf_len) -
@@ -298,7 +364,9 @@ int os_msys_register(struct os_mbuf_pool *);
 
 /**
  * Allocate a mbuf from msys.  Based upon the data size requested,
- * os_msys_get() will choose the mbuf pool that has the best fit.
+ * os_msys_get() will choose the mbuf pool that has the best fit.  If that
+ * pool is exhausted and MSYS_SPILL_TO_LARGER is enabled, the next larger
+ * pools are tried in turn.
  *
  * @param dsize The estimated size of the data being stored in the mbuf
  * @param leadingspace The amount of leadingspace to allocate in the mbuf
@@ -323,6 +391,22 @@ void os_msys_reset(void);
  */
 struct os_mbuf *os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len);
 
+/**
+ * Allocate a packet header mbuf chain from MSYS that holds total_len bytes
+ * of data.  Every mbuf in the chain is taken from the pool that best fits
+ * the data that remains, so the chain is made up of as few, and as small,
+ * buffers as possible.
+ *
+ * The packet length of the returned chain is total_len and the data is
+ * uninitialized; fill it in with os_mbuf_copyinto().
+ *
+ * @param total_len The number of data bytes the chain must hold
+ * @param user_hdr_len The length to allocate for the packet header structure
+ *
+ * @return A freshly allocated mbuf chain on success, NULL on failure.
+ */
+struct os_mbuf *os_msys_get_chain(uint16_t total_len, uint16_t user_hdr_len);
+
 /**
  * Count the number of blocks in all the mbuf pools that are allocated.
  *
@@ -383,6 +467,41 @@ struct os_mbuf *os_mbuf_get_pkthdr(struct os_mbuf_pool *omp,
  */
 struct os_mbuf *os_mbuf_dup(struct os_mbuf *m);
 
+/**
+ * Clone a chain of mbufs.  The clone gets its own mbuf headers (and packet
+ * header), but refers to the data of the original chain rather than copying
+ * it; the data is freed once the original and all of its clones have been
+ * freed.  The data of both chains becomes read-only: functions that modify
+ * it in place (os_mbuf_copyinto()) first give the mbuf a private copy, and
+ * functions that grow a chain (os_mbuf_append(), os_mbuf_prepend(), etc.)
+ * add new mbufs.
+ *
+ * The headers are allocated out of the clone pool of each mbuf's pool, if
+ * one is configured, and out of the mbuf's own pool otherwise.
+ *
+ * If OS_MBUF_CLONE is disabled, this is equivalent to os_mbuf_dup().
+ *
+ * @param om  The mbuf chain to clone
+ *
+ * @return A pointer to the new chain of mbufs, NULL on failure.
+ */
+struct os_mbuf *os_mbuf_clone(struct os_mbuf *om);
+
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+/**
+ * Configures the pool that os_mbuf_clone() allocates the headers of clones
+ * of an mbuf pool's mbufs out of.  A clone header only needs room for a
+ * packet header, so a pool of small buffers saves memory; clone headers for
+ * which the clone pool is too small come out of the original pool.
+ *
+ * @param omp       The mbuf pool being cloned from
+ * @param clone_omp The mbuf pool to allocate clone headers out of; NULL to
+ *                      use omp itself.
+ */
+void os_mbuf_pool_set_clone_pool(struct os_mbuf_pool *omp,
+                                 struct os_mbuf_pool *clone_omp);
+#endif
+
 /**
  * Locates the specified absolute offset within an mbuf chain.  The offset
  * can be one past than the total length of the chain, but no greater.
@@ -414,6 +533,56 @@ struct os_mbuf *os_mbuf_off(const struct os_mbuf *om, int off,
  */
 int os_mbuf_copydata(const struct os_mbuf *m, int off, int len, void *dst);
 
+/**
+ * Prepares an iterator that walks the data of an mbuf chain in place, one
+ * contiguous segment at a time, starting "off" bytes from the beginning of
+ * the chain and continuing for "len" bytes.  Nothing is copied; the chain
+ * must not be modified or freed while the iterator is in use.
+ *
+ * @param iter                  The iterator to initialize.
+ * @param om                    The mbuf chain to iterate over.
+ * @param off                   The offset into the chain to start at.
+ * @param len                   The number of bytes to iterate over.
+ *
+ * @return                      0 on success;
+ *                              -1 if the mbuf does not contain enough data.
+ */
+int os_mbuf_iter_init(struct os_mbuf_iter *iter, const struct os_mbuf *om,
+                      int off, int len);
+
+/**
+ * Retrieves the next data segment from an mbuf iterator.  Empty mbufs in
+ * the chain are skipped.
+ *
+ * @param iter                  The iterator to advance.
+ * @param seg                   On success, describes the segment.
+ *
+ * @return                      0 on success;
+ *                              OS_ENOENT if there is no more data.
+ */
+int os_mbuf_iter_next(struct os_mbuf_iter *iter, struct os_mbuf_iovec *seg);
+
+/**
+ * Describes "len" bytes of an mbuf chain, starting "off" bytes from the
+ * beginning, as an array of read-only segments that point into the mbufs
+ * themselves.  This lets the data be handed to a driver or a transport
+ * (DMA, writev(), etc.) without first flattening the chain.
+ *
+ * @param om                    The mbuf chain to describe.
+ * @param off                   The offset into the chain to start at.
+ * @param len                   The number of bytes to describe.
+ * @param iov                   The array to fill in.
+ * @param max_iov               The number of entries in iov.
+ *
+ * @return                      The number of segments the data spans, which
+ *                                  is greater than max_iov if the array was
+ *                                  too small (only max_iov entries are filled
+ *                                  in);
+ *                              -1 if the mbuf does not contain enough data.
+ */
+int os_mbuf_to_iovec(const struct os_mbuf *om, int off, int len,
+                     struct os_mbuf_iovec *iov, int max_iov);
+
 /**
  * @brief Calculates the length of an mbuf chain.
  *
@@ -610,6 +779,9 @@ void *os_mbuf_extend(struct os_mbuf *om, uint16_t len);
  * extra bytes to the contiguous region, in an attempt to avoid being
  * called next time.
  *
+ * The contiguous region is never shared with a clone, so it may be
+ * modified in place.
+ *
  * @param omp The mbuf pool to take the mbufs out of
  * @param om The mbuf chain to make contiguous
  * @param len The number of bytes in the chain to make contiguous
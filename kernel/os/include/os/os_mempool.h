@@ -68,7 +68,22 @@ struct os_mempool {
     /** Address of memory buffer used by pool */
     uint32_t mp_membuf_addr;
     STAILQ_ENTRY(os_mempool) mp_list;
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    /**
+     * Free list head, along with a generation count that is swapped
+     * together with it on architectures that implement the lock-free
+     * free list with a double-word compare-and-swap.
+     */
+    union {
+        struct {
+            SLIST_HEAD(,os_memblock);
+            uint32_t mp_head_gen;
+        };
+        uint64_t mp_head_word;
+    } __attribute__((aligned(8)));
+#else
     SLIST_HEAD(,os_memblock);
+#endif
     /** Name for memory block */
     char *name;
 };
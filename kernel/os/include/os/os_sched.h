@@ -37,10 +37,28 @@ extern "C" {
 /** @cond INTERNAL_HIDDEN */
 struct os_task;
 
+#if MYNEWT_VAL(OS_SCHED_TIMER_EXP_MONITOR)
+/**
+ * Structure keeping track of time spent waking up sleeping tasks from the OS
+ * tick, i.e. inside os_sched_os_timer_exp().  Tick unit is os_cputime.
+ */
+struct os_sched_timer_mon {
+    uint32_t stm_cnt;           /* number of calls made */
+    uint32_t stm_min;           /* least number of ticks spent in a call */
+    uint32_t stm_max;           /* most number of ticks spent in a call */
+    uint32_t stm_cum;           /* cumulative number of ticks spent */
+    uint32_t stm_woken_max;     /* most tasks woken up in a call */
+};
+
+extern struct os_sched_timer_mon g_os_sched_timer_mon;
+#endif
+
 TAILQ_HEAD(os_task_list, os_task);
 
 extern struct os_task *g_current_task;
+#if !MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
 extern struct os_task_list g_os_run_list;
+#endif
 extern struct os_task_list g_os_sleep_list;
 
 void os_sched_ctx_sw_hook(struct os_task *);
@@ -92,12 +110,14 @@ struct os_task *os_sched_next_task(void);
 void os_sched(struct os_task *);
 
 /** @cond INTERNAL_HIDDEN */
+void os_sched_init(void);
 void os_sched_os_timer_exp(void);
 os_error_t os_sched_insert(struct os_task *);
 int os_sched_sleep(struct os_task *, os_time_t nticks);
 int os_sched_wakeup(struct os_task *);
 int os_sched_remove(struct os_task *);
 void os_sched_resort(struct os_task *);
+void os_sched_set_prio(struct os_task *, uint8_t prio);
 os_time_t os_sched_wakeup_ticks(os_time_t now);
 
 /** @endcond */
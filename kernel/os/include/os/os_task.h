@@ -132,6 +132,15 @@ struct os_task {
     STAILQ_ENTRY(os_task) t_os_task_list;
     TAILQ_ENTRY(os_task) t_os_list;
     SLIST_ENTRY(os_task) t_obj_list;
+
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    /** Sleep heap: first child */
+    struct os_task *t_sleep_child;
+    /** Sleep heap: next sibling */
+    struct os_task *t_sleep_next;
+    /** Sleep heap: previous sibling, or parent if first child */
+    struct os_task *t_sleep_prev;
+#endif
 };
 
 /** @cond INTERNAL_HIDDEN */
@@ -17,62 +17,8 @@
  * under the License.
  */
 
-#include <assert.h>
-#include <stddef.h>
-#include <stdio.h>
-#include <setjmp.h>
-#include <signal.h>
-#include <string.h>
-#include <sys/time.h>
-
 #include "os/mynewt.h"
 #include "os_test/os_test.h"
-#include "testutil/testutil.h"
-#include "os_test_priv.h"
-
-/*
- * Most of this file is the driver for the kernel selftest running in sim
- * In the sim environment, we can initialize and restart mynewt at will
- * where that is not the case when the test cases are run in a target env.
- */
-void
-os_test_restart(void)
-{
-    struct sigaction sa;
-    struct itimerval it;
-    int rc;
-
-    g_os_started = 0;
-
-    memset(&sa, 0, sizeof sa);
-    sa.sa_handler = SIG_IGN;
-
-    sigaction(SIGALRM, &sa, NULL);
-    sigaction(SIGVTALRM, &sa, NULL);
-
-    memset(&it, 0, sizeof(it));
-    rc = setitimer(ITIMER_VIRTUAL, &it, NULL);
-    if (rc != 0) {
-        perror("Cannot set itimer");
-        abort();
-    }
-
-   tu_restart();
-}
-
-int
-os_test_all(void)
-{
-    os_mempool_test_suite();
-    os_mutex_test_suite();
-    os_sem_test_suite();
-    os_mbuf_test_suite();
-    os_eventq_test_suite();
-    os_callout_test_suite();
-    os_time_test_suite();
-
-    return tu_case_failed;
-}
 
 int
 main(int argc, char **argv)
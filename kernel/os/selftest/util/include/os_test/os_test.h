@@ -28,11 +28,13 @@ extern "C" {
 
 TEST_SUITE_DECL(os_mutex_test_suite);
 TEST_SUITE_DECL(os_sem_test_suite);
+TEST_SUITE_DECL(os_sched_test_suite);
 TEST_SUITE_DECL(os_mempool_test_suite);
 TEST_SUITE_DECL(os_time_test_suite);
 TEST_SUITE_DECL(os_mbuf_test_suite);
 TEST_SUITE_DECL(os_eventq_test_suite);
 TEST_SUITE_DECL(os_callout_test_suite);
+TEST_SUITE_DECL(os_heap_test_suite);
 
 TEST_CASE_DECL(os_time_test_change);
 
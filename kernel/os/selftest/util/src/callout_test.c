@@ -228,10 +228,14 @@ callout_task_stop_listen(void *arg)
 TEST_CASE_DECL(callout_test_speak)
 TEST_CASE_DECL(callout_test_stop)
 TEST_CASE_DECL(callout_test)
+TEST_CASE_DECL(callout_test_order)
+TEST_CASE_DECL(callout_test_slack)
 
 TEST_SUITE(os_callout_test_suite)
 {
     callout_test();
     callout_test_stop();
     callout_test_speak();
+    callout_test_order();
+    callout_test_slack();
 }
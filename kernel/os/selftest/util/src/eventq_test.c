@@ -76,6 +76,7 @@ TEST_CASE_DECL(event_test_poll_sr)
 TEST_CASE_DECL(event_test_poll_timeout_sr)
 TEST_CASE_DECL(event_test_poll_single_sr)
 TEST_CASE_DECL(event_test_poll_0timo)
+TEST_CASE_DECL(event_test_batch)
 
 /* This is the task function  to send data */
 void
@@ -259,4 +260,5 @@ TEST_SUITE(os_eventq_test_suite)
     event_test_poll_timeout_sr();
     event_test_poll_single_sr();
     event_test_poll_0timo();
+    event_test_batch();
 }
@@ -61,6 +61,7 @@ void
 os_mbuf_test_misc_assert_sane(struct os_mbuf *om, void *data,
                               int buflen, int pktlen, int pkthdr_len)
 {
+    struct os_mbuf *owner;
     uint8_t *data_min;
     uint8_t *data_max;
     int totlen;
@@ -79,8 +80,16 @@ os_mbuf_test_misc_assert_sane(struct os_mbuf *om, void *data,
             TEST_ASSERT(om->om_pkthdr_len == pkthdr_len);
         }
 
-        data_min = om->om_databuf + om->om_pkthdr_len;
-        data_max = om->om_databuf + om->om_omp->omp_databuf_len - om->om_len;
+        /* The data of a clone lives in another mbuf's buffer. */
+        owner = om;
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+        if (om->om_ref != NULL) {
+            owner = om->om_ref;
+        }
+#endif
+        data_min = owner->om_databuf + (owner == om ? om->om_pkthdr_len : 0);
+        data_max = owner->om_databuf + owner->om_omp->omp_databuf_len -
+                   om->om_len;
         TEST_ASSERT(om->om_data >= data_min && om->om_data <= data_max);
 
         if (data != NULL) {
@@ -103,6 +112,10 @@ TEST_CASE_DECL(os_mbuf_test_adj)
 TEST_CASE_DECL(os_mbuf_test_get_pkthdr)
 TEST_CASE_DECL(os_mbuf_test_widen)
 TEST_CASE_DECL(os_mbuf_test_pack_chains)
+TEST_CASE_DECL(os_mbuf_test_msys)
+TEST_CASE_DECL(os_mbuf_test_iovec)
+TEST_CASE_DECL(os_mbuf_test_clone)
+TEST_CASE_DECL(os_mbuf_test_clone_pool)
 
 TEST_SUITE(os_mbuf_test_suite)
 {
@@ -115,4 +128,8 @@ TEST_SUITE(os_mbuf_test_suite)
     os_mbuf_test_get_pkthdr();
     os_mbuf_test_widen();
     os_mbuf_test_pack_chains();
+    os_mbuf_test_msys();
+    os_mbuf_test_iovec();
+    os_mbuf_test_clone();
+    os_mbuf_test_clone_pool();
 }
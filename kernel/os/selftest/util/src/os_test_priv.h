@@ -31,6 +31,7 @@
 #include "mbuf_test.h"
 #include "mempool_test.h"
 #include "mutex_test.h"
+#include "sched_test.h"
 #include "sem_test.h"
 
 #ifdef __cplusplus
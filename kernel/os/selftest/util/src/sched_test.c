@@ -0,0 +1,47 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "os_test_priv.h"
+
+volatile int g_sched_test_run_cnt;
+volatile uint8_t g_sched_test_run_prio[SCHED_TEST_MAX_TASKS];
+
+/**
+ * Records the priority of the calling task in the order the tasks get to run.
+ */
+void
+sched_test_record_handler(void *arg)
+{
+    struct os_task *t;
+
+    t = os_sched_get_current_task();
+    TEST_ASSERT_FATAL(g_sched_test_run_cnt < SCHED_TEST_MAX_TASKS);
+    g_sched_test_run_prio[g_sched_test_run_cnt++] = t->t_prio;
+}
+
+TEST_CASE_DECL(os_sched_test_prio_order)
+TEST_CASE_DECL(os_sched_test_resort)
+
+TEST_SUITE(os_sched_test_suite)
+{
+    os_sched_test_prio_order();
+    os_sched_test_resort();
+}
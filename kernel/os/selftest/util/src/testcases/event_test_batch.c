@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define EVENT_TEST_BATCH_NUM    (8)
+
+static int event_test_batch_order[EVENT_TEST_BATCH_NUM];
+static int event_test_batch_cnt;
+
+static void
+event_test_batch_cb(struct os_event *ev)
+{
+    event_test_batch_order[event_test_batch_cnt++] = (intptr_t)ev->ev_arg;
+}
+
+/**
+ * Tests that events come off a queue in the order they were put, that putting
+ * an already queued event and removing an event keep the queue consistent,
+ * that a removed event can be put on another queue, and that
+ * os_eventq_run_batch() drains at most the requested number of events.  The
+ * queue is never empty when read, so the OS need not be running.
+ */
+TEST_CASE_SELF(event_test_batch)
+{
+    struct os_event evs[EVENT_TEST_BATCH_NUM];
+    struct os_event *evp;
+    struct os_eventq evq2;
+    struct os_eventq evq;
+    int rc;
+    int i;
+
+    os_eventq_init(&evq);
+
+    memset(evs, 0, sizeof evs);
+    for (i = 0; i < EVENT_TEST_BATCH_NUM; i++) {
+        evs[i].ev_cb = event_test_batch_cb;
+        evs[i].ev_arg = (void *)(intptr_t)i;
+        os_eventq_put(&evq, &evs[i]);
+    }
+
+    /* Putting an event that is already queued is a no-op. */
+    os_eventq_put(&evq, &evs[0]);
+    os_eventq_put(&evq, &evs[5]);
+
+    /* Remove an event from the middle of the queue. */
+    os_eventq_remove(&evq, &evs[3]);
+    TEST_ASSERT(!OS_EVENT_QUEUED(&evs[3]));
+
+    evp = os_eventq_get_no_wait(&evq);
+    TEST_ASSERT_FATAL(evp == &evs[0]);
+    TEST_ASSERT(!OS_EVENT_QUEUED(evp));
+
+    /* Requeue the event; it goes to the back. */
+    os_eventq_put(&evq, &evs[0]);
+
+    event_test_batch_cnt = 0;
+    rc = os_eventq_run_batch(&evq, 4);
+    TEST_ASSERT(rc == 4);
+    TEST_ASSERT(event_test_batch_cnt == 4);
+    TEST_ASSERT(event_test_batch_order[0] == 1);
+    TEST_ASSERT(event_test_batch_order[1] == 2);
+    TEST_ASSERT(event_test_batch_order[2] == 4);
+    TEST_ASSERT(event_test_batch_order[3] == 5);
+
+    /* Only three events are left; the batch stops when the queue is empty. */
+    rc = os_eventq_run_batch(&evq, EVENT_TEST_BATCH_NUM);
+    TEST_ASSERT(rc == 3);
+    TEST_ASSERT(event_test_batch_cnt == 7);
+    TEST_ASSERT(event_test_batch_order[4] == 6);
+    TEST_ASSERT(event_test_batch_order[5] == 7);
+    TEST_ASSERT(event_test_batch_order[6] == 0);
+
+    TEST_ASSERT(os_eventq_get_no_wait(&evq) == NULL);
+    for (i = 0; i < EVENT_TEST_BATCH_NUM; i++) {
+        TEST_ASSERT(!OS_EVENT_QUEUED(&evs[i]));
+    }
+
+    /* Remove an event that is queued behind others, then put it on another
+     * queue.  It must only come off the second queue.
+     */
+    os_eventq_init(&evq2);
+    os_eventq_put(&evq, &evs[1]);
+    os_eventq_put(&evq, &evs[0]);
+    os_eventq_put(&evq, &evs[2]);
+    os_eventq_remove(&evq, &evs[0]);
+    TEST_ASSERT(!OS_EVENT_QUEUED(&evs[0]));
+
+    os_eventq_put(&evq2, &evs[0]);
+    TEST_ASSERT(OS_EVENT_QUEUED(&evs[0]));
+
+    TEST_ASSERT(os_eventq_get_no_wait(&evq) == &evs[1]);
+    TEST_ASSERT(os_eventq_get_no_wait(&evq) == &evs[2]);
+    TEST_ASSERT(os_eventq_get_no_wait(&evq) == NULL);
+    TEST_ASSERT(os_eventq_get_no_wait(&evq2) == &evs[0]);
+    TEST_ASSERT(os_eventq_get_no_wait(&evq2) == NULL);
+}
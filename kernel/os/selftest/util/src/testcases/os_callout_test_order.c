@@ -0,0 +1,89 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+#define CALLOUT_ORDER_CNT   (24)
+
+static struct os_callout callout_order[CALLOUT_ORDER_CNT];
+
+/* Expiry times spanning several timing wheel levels, out of order. */
+static const os_time_t callout_order_ticks[CALLOUT_ORDER_CNT] = {
+    5, 300, 1, 17, 16, 15, 280, 64, 2, 255, 256, 257,
+    33, 5, 120, 7, 300, 31, 32, 200, 9, 3, 128, 270,
+};
+
+static void
+callout_order_cb(struct os_event *ev)
+{
+}
+
+TEST_CASE_TASK(callout_test_order)
+{
+    struct os_eventq evq;
+    struct os_callout *c;
+    struct os_event *ev;
+    os_time_t prev_ticks;
+    os_time_t start;
+    os_time_t now;
+    os_time_t tm;
+    os_sr_t sr;
+    int rc;
+    int i;
+
+    os_eventq_init(&evq);
+
+    start = os_time_get();
+    for (i = 0; i < CALLOUT_ORDER_CNT; i++) {
+        os_callout_init(&callout_order[i], &evq, callout_order_cb, NULL);
+        rc = os_callout_reset(&callout_order[i], callout_order_ticks[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* Stop a few; they must never fire. */
+    os_callout_stop(&callout_order[2]);
+    os_callout_stop(&callout_order[10]);
+    os_callout_stop(&callout_order[16]);
+
+    /* The next wakeup must not be later than the first callout expiry. */
+    OS_ENTER_CRITICAL(sr);
+    now = os_time_get();
+    tm = os_callout_wakeup_ticks(now);
+    OS_EXIT_CRITICAL(sr);
+    TEST_ASSERT(tm <= start + 2 - now);
+
+    prev_ticks = start;
+    for (i = 0; i < CALLOUT_ORDER_CNT - 3; i++) {
+        ev = os_eventq_get(&evq);
+        c = (struct os_callout *)ev;
+
+        TEST_ASSERT_FATAL(c != &callout_order[2] &&
+                          c != &callout_order[10] &&
+                          c != &callout_order[16]);
+        TEST_ASSERT(!os_callout_queued(c));
+        TEST_ASSERT(OS_TIME_TICK_GEQ(os_time_get(), c->c_ticks));
+        TEST_ASSERT(OS_TIME_TICK_GEQ(c->c_ticks, prev_ticks));
+        prev_ticks = c->c_ticks;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    tm = os_callout_wakeup_ticks(os_time_get());
+    OS_EXIT_CRITICAL(sr);
+    TEST_ASSERT(tm == OS_TIMEOUT_NEVER);
+}
@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+#define CALLOUT_SLACK_CNT   (6)
+
+static struct os_callout callout_slack[CALLOUT_SLACK_CNT];
+
+static const os_time_t callout_slack_ticks[CALLOUT_SLACK_CNT] = {
+    10, 13, 100, 1000, 5, 1,
+};
+static const os_time_t callout_slack_slack[CALLOUT_SLACK_CNT] = {
+    16, 16, 64, 500, 0, 1,
+};
+
+static void
+callout_slack_cb(struct os_event *ev)
+{
+}
+
+#if MYNEWT_VAL(OS_CALLOUT_SLACK)
+/**
+ * Returns the tick in [start, start + len] with the most trailing zero bits.
+ */
+static os_time_t
+callout_slack_best(os_time_t start, os_time_t len)
+{
+    os_time_t best;
+    os_time_t t;
+    os_time_t i;
+
+    best = start;
+    for (i = 1; i <= len; i++) {
+        t = start + i;
+        if (t == 0) {
+            return 0;
+        }
+        if (best != 0 && __builtin_ctz(t) > __builtin_ctz(best)) {
+            best = t;
+        }
+    }
+
+    return best;
+}
+#endif
+
+TEST_CASE_SELF(callout_test_slack)
+{
+    struct os_eventq evq;
+    os_time_t expected;
+    os_time_t now;
+    os_sr_t sr;
+    int rc;
+    int i;
+
+    os_eventq_init(&evq);
+
+    OS_ENTER_CRITICAL(sr);
+
+    now = os_time_get();
+    for (i = 0; i < CALLOUT_SLACK_CNT; i++) {
+        os_callout_init(&callout_slack[i], &evq, callout_slack_cb, NULL);
+        os_callout_set_slack(&callout_slack[i], callout_slack_slack[i]);
+        rc = os_callout_reset(&callout_slack[i], callout_slack_ticks[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    for (i = 0; i < CALLOUT_SLACK_CNT; i++) {
+#if MYNEWT_VAL(OS_CALLOUT_SLACK)
+        expected = callout_slack_best(now + callout_slack_ticks[i],
+                                      callout_slack_slack[i]);
+#else
+        expected = now + callout_slack_ticks[i];
+#endif
+        TEST_ASSERT(callout_slack[i].c_ticks == expected);
+        TEST_ASSERT(os_callout_remaining_ticks(&callout_slack[i], now) >=
+                    callout_slack_ticks[i]);
+    }
+
+    OS_EXIT_CRITICAL(sr);
+
+    /* Without slack the callout expires exactly when asked to. */
+    TEST_ASSERT(callout_slack[4].c_ticks == now + 5);
+
+    for (i = 0; i < CALLOUT_SLACK_CNT; i++) {
+        os_callout_stop(&callout_slack[i]);
+        TEST_ASSERT(!os_callout_queued(&callout_slack[i]));
+    }
+}
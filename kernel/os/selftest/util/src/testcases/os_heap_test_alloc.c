@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+#define HEAP_TEST_CNT   (64)
+
+TEST_CASE_SELF(os_heap_test_alloc)
+{
+    uint8_t *ptrs[HEAP_TEST_CNT];
+    size_t size;
+    int i;
+    int j;
+
+    for (i = 0; i < HEAP_TEST_CNT; i++) {
+        size = 1 + i * 37 % 700;
+        ptrs[i] = os_malloc(size);
+        TEST_ASSERT_FATAL(ptrs[i] != NULL);
+        /* Suitably aligned for doubles and 64-bit integers. */
+        TEST_ASSERT(((uintptr_t)ptrs[i] & 7) == 0);
+        memset(ptrs[i], i, size);
+    }
+
+    /* Free every other block and allocate again into the holes. */
+    for (i = 0; i < HEAP_TEST_CNT; i += 2) {
+        os_free(ptrs[i]);
+    }
+    for (i = 0; i < HEAP_TEST_CNT; i += 2) {
+        size = 1 + i * 37 % 700;
+        ptrs[i] = os_malloc(size);
+        TEST_ASSERT_FATAL(ptrs[i] != NULL);
+        TEST_ASSERT(((uintptr_t)ptrs[i] & 7) == 0);
+        memset(ptrs[i], i, size);
+    }
+
+    /* No two blocks overlap. */
+    for (i = 0; i < HEAP_TEST_CNT; i++) {
+        size = 1 + i * 37 % 700;
+        for (j = 0; j < size; j++) {
+            TEST_ASSERT_FATAL(ptrs[i][j] == i);
+        }
+    }
+
+    for (i = 0; i < HEAP_TEST_CNT; i++) {
+        os_free(ptrs[i]);
+    }
+
+    /* Freeing NULL is a no-op. */
+    os_free(NULL);
+}
@@ -0,0 +1,72 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+/**
+ * Freed neighbours must merge into a single block that can satisfy a
+ * request for their combined size.
+ */
+TEST_CASE_SELF(os_heap_test_coalesce)
+{
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+    struct os_heap_info before;
+    struct os_heap_info info;
+    uint8_t *a;
+    uint8_t *b;
+    uint8_t *c;
+    uint8_t *d;
+    int rc;
+
+    rc = os_heap_info_get(&before);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    a = os_malloc(256);
+    b = os_malloc(256);
+    c = os_malloc(256);
+    d = os_malloc(16);
+    TEST_ASSERT_FATAL(a != NULL && b != NULL && c != NULL && d != NULL);
+
+    /* The blocks are carved out of the heap one after the other. */
+    TEST_ASSERT(b > a && c > b);
+
+    rc = os_heap_info_get(&info);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(info.ohi_used >= before.ohi_used + 3 * 256 + 16);
+    TEST_ASSERT(info.ohi_used_max >= info.ohi_used);
+
+    os_free(a);
+    os_free(c);
+    os_free(b);
+
+    /* a, b and c merged; a request for more than any one of them fits
+     * where a was.
+     */
+    b = os_malloc(700);
+    TEST_ASSERT(b == a);
+
+    os_free(b);
+    os_free(d);
+
+    rc = os_heap_info_get(&info);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(info.ohi_used == before.ohi_used);
+    TEST_ASSERT(info.ohi_free_blocks <= before.ohi_free_blocks + 1);
+#endif
+}
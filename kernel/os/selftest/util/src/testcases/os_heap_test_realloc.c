@@ -0,0 +1,72 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+static int
+heap_test_check(const uint8_t *p, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        if (p[i] != (uint8_t)i) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+TEST_CASE_SELF(os_heap_test_realloc)
+{
+    uint8_t *blocker;
+    uint8_t *p;
+    int i;
+
+    /* realloc(NULL) allocates. */
+    p = os_realloc(NULL, 16);
+    TEST_ASSERT_FATAL(p != NULL);
+    for (i = 0; i < 16; i++) {
+        p[i] = i;
+    }
+
+    /* Grow in small steps; the contents must follow the block. */
+    for (i = 32; i <= 1024; i += 96) {
+        p = os_realloc(p, i);
+        TEST_ASSERT_FATAL(p != NULL);
+        TEST_ASSERT_FATAL(heap_test_check(p, 16));
+    }
+
+    /* Grow with the following memory in use, forcing a move. */
+    blocker = os_malloc(64);
+    TEST_ASSERT_FATAL(blocker != NULL);
+    p = os_realloc(p, 4096);
+    TEST_ASSERT_FATAL(p != NULL);
+    TEST_ASSERT(heap_test_check(p, 16));
+
+    /* Shrinking keeps the data. */
+    p = os_realloc(p, 8);
+    TEST_ASSERT_FATAL(p != NULL);
+    TEST_ASSERT(heap_test_check(p, 8));
+
+    /* realloc(p, 0) frees. */
+    p = os_realloc(p, 0);
+    TEST_ASSERT(p == NULL);
+
+    os_free(blocker);
+}
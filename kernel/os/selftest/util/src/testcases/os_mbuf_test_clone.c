@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define MBUF_TEST_CLONE_LEN     (300)
+
+TEST_CASE_SELF(os_mbuf_test_clone)
+{
+    uint8_t exp_om[MBUF_TEST_CLONE_LEN + 10];
+    uint8_t exp_c[MBUF_TEST_CLONE_LEN + 4];
+    uint8_t exp_c2[MBUF_TEST_CLONE_LEN];
+    struct os_mbuf *om;
+    struct os_mbuf *c;
+    struct os_mbuf *c2;
+    int rc;
+
+    os_mbuf_test_setup();
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, MBUF_TEST_CLONE_LEN);
+    TEST_ASSERT_FATAL(rc == 0);
+    memcpy(exp_om, os_mbuf_test_data, MBUF_TEST_CLONE_LEN);
+    memcpy(exp_c + 4, os_mbuf_test_data, MBUF_TEST_CLONE_LEN);
+
+    c = os_mbuf_clone(om);
+    TEST_ASSERT_FATAL(c != NULL);
+    os_mbuf_test_misc_assert_sane(c, os_mbuf_test_data, om->om_len,
+                                  MBUF_TEST_CLONE_LEN, om->om_pkthdr_len);
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    TEST_ASSERT(c->om_data == om->om_data);
+    TEST_ASSERT(OS_MBUF_IS_SHARED(om));
+    TEST_ASSERT(OS_MBUF_IS_SHARED(c));
+    TEST_ASSERT(OS_MBUF_LEADINGSPACE(c) == 0);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == 0);
+#endif
+
+    /* Writes to either chain are not visible in the other. */
+    rc = os_mbuf_copyinto(c, 10, "xyz", 3);
+    TEST_ASSERT_FATAL(rc == 0);
+    memcpy(exp_c + 4 + 10, "xyz", 3);
+
+    rc = os_mbuf_copyinto(om, 200, "abcd", 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    memcpy(exp_om + 200, "abcd", 4);
+
+    c = os_mbuf_prepend(c, 4);
+    TEST_ASSERT_FATAL(c != NULL);
+    rc = os_mbuf_copyinto(c, 0, "1234", 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    memcpy(exp_c, "1234", 4);
+
+    rc = os_mbuf_append(om, "0123456789", 10);
+    TEST_ASSERT_FATAL(rc == 0);
+    memcpy(exp_om + MBUF_TEST_CLONE_LEN, "0123456789", 10);
+
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == sizeof exp_om);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, exp_om, sizeof exp_om) == 0);
+    TEST_ASSERT(OS_MBUF_PKTLEN(c) == sizeof exp_c);
+    TEST_ASSERT(os_mbuf_cmpf(c, 0, exp_c, sizeof exp_c) == 0);
+
+    /* Clone of a clone. */
+    os_mbuf_adj(c, 4);
+    memcpy(exp_c2, exp_c + 4, sizeof exp_c2);
+    c2 = os_mbuf_clone(c);
+    TEST_ASSERT_FATAL(c2 != NULL);
+    TEST_ASSERT(os_mbuf_cmpf(c2, 0, exp_c2, sizeof exp_c2) == 0);
+
+    /* The data outlives whichever chain is freed first. */
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(os_mbuf_cmpf(c, 0, exp_c2, sizeof exp_c2) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(c2, 0, exp_c2, sizeof exp_c2) == 0);
+
+    rc = os_mbuf_free_chain(c);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(os_mbuf_cmpf(c2, 0, exp_c2, sizeof exp_c2) == 0);
+
+    rc = os_mbuf_free_chain(c2);
+    TEST_ASSERT(rc == 0);
+
+    /* Data pulled up in a clone can be written in place, even if it was
+     * contiguous already.
+     */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 100);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    c = os_mbuf_clone(om);
+    TEST_ASSERT_FATAL(c != NULL);
+    c = os_mbuf_pullup(c, 8);
+    TEST_ASSERT_FATAL(c != NULL);
+    memcpy(c->om_data, "pullup!!", 8);
+
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data, 100) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(c, 0, "pullup!!", 8) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(c, 8, os_mbuf_test_data + 8, 92) == 0);
+
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT(rc == 0);
+    rc = os_mbuf_free_chain(c);
+    TEST_ASSERT(rc == 0);
+
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+}
@@ -0,0 +1,129 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define MBUF_TEST_CLONE_POOL_LEN        (300)
+#define MBUF_TEST_CLONE_POOL_BUF_SIZE   \
+    (sizeof (struct os_mbuf) + sizeof (struct os_mbuf_pkthdr))
+#define MBUF_TEST_CLONE_POOL_BUF_COUNT  (8)
+
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+static os_membuf_t os_mbuf_test_small_membuf[
+    OS_MEMPOOL_SIZE(MBUF_TEST_CLONE_POOL_BUF_SIZE,
+                    MBUF_TEST_CLONE_POOL_BUF_COUNT)];
+static struct os_mempool os_mbuf_test_small_mempool;
+static struct os_mbuf_pool os_mbuf_test_small_pool;
+
+static void
+os_mbuf_test_clone_pool_assert_data_pool(const struct os_mbuf *om)
+{
+    for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
+        TEST_ASSERT(om->om_omp == &os_mbuf_pool ||
+                    (om->om_ref != NULL &&
+                     om->om_ref->om_omp == &os_mbuf_pool));
+    }
+}
+#endif
+
+TEST_CASE_SELF(os_mbuf_test_clone_pool)
+{
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    uint8_t exp[MBUF_TEST_CLONE_POOL_LEN + 8];
+    struct os_mbuf *om;
+    struct os_mbuf *c;
+    struct os_mbuf *d;
+    int rc;
+
+    os_mbuf_test_setup();
+
+    rc = os_mempool_init(&os_mbuf_test_small_mempool,
+                         MBUF_TEST_CLONE_POOL_BUF_COUNT,
+                         MBUF_TEST_CLONE_POOL_BUF_SIZE,
+                         os_mbuf_test_small_membuf, "mbuf_small_pool");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&os_mbuf_test_small_pool,
+                           &os_mbuf_test_small_mempool,
+                           MBUF_TEST_CLONE_POOL_BUF_SIZE,
+                           MBUF_TEST_CLONE_POOL_BUF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_mbuf_pool_set_clone_pool(&os_mbuf_pool, &os_mbuf_test_small_pool);
+
+    /* Two partly filled buffers, so the head can be pulled up. */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 100);
+    TEST_ASSERT_FATAL(rc == 0);
+    d = os_mbuf_get(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(d != NULL);
+    rc = os_mbuf_append(d, os_mbuf_test_data + 100,
+                        MBUF_TEST_CLONE_POOL_LEN - 100);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_mbuf_concat(om, d);
+    memcpy(exp, os_mbuf_test_data, MBUF_TEST_CLONE_POOL_LEN);
+
+    /* Clone headers come from the small pool. */
+    c = os_mbuf_clone(om);
+    TEST_ASSERT_FATAL(c != NULL);
+    TEST_ASSERT(c->om_omp == &os_mbuf_test_small_pool);
+    TEST_ASSERT(SLIST_NEXT(c, om_next)->om_omp == &os_mbuf_test_small_pool);
+
+    /* A dup of a clone copies the data into full-sized buffers. */
+    d = os_mbuf_dup(c);
+    TEST_ASSERT_FATAL(d != NULL);
+    os_mbuf_test_clone_pool_assert_data_pool(d);
+    TEST_ASSERT(OS_MBUF_PKTLEN(d) == MBUF_TEST_CLONE_POOL_LEN);
+    TEST_ASSERT(os_mbuf_cmpf(d, 0, exp, MBUF_TEST_CLONE_POOL_LEN) == 0);
+    os_mbuf_free_chain(d);
+
+    /* Pulling up a clone moves its data into a full-sized buffer. */
+    c = os_mbuf_pullup(c, 150);
+    TEST_ASSERT_FATAL(c != NULL);
+    TEST_ASSERT(c->om_len >= 150);
+    os_mbuf_test_clone_pool_assert_data_pool(c);
+    TEST_ASSERT(OS_MBUF_PKTLEN(c) == MBUF_TEST_CLONE_POOL_LEN);
+    TEST_ASSERT(os_mbuf_cmpf(c, 0, exp, MBUF_TEST_CLONE_POOL_LEN) == 0);
+
+    /* Appending to and prepending to a clone do the same. */
+    rc = os_mbuf_append(c, "abcd", 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    memcpy(exp + MBUF_TEST_CLONE_POOL_LEN, "abcd", 4);
+    c = os_mbuf_prepend(c, 4);
+    TEST_ASSERT_FATAL(c != NULL);
+    rc = os_mbuf_copyinto(c, 0, "1234", 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    memmove(exp + 4, exp, MBUF_TEST_CLONE_POOL_LEN + 4);
+    memcpy(exp, "1234", 4);
+    os_mbuf_test_clone_pool_assert_data_pool(c);
+    TEST_ASSERT(OS_MBUF_PKTLEN(c) == sizeof exp);
+    TEST_ASSERT(os_mbuf_cmpf(c, 0, exp, sizeof exp) == 0);
+
+    /* The original is untouched. */
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data,
+                             MBUF_TEST_CLONE_POOL_LEN) == 0);
+
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT(rc == 0);
+    rc = os_mbuf_free_chain(c);
+    TEST_ASSERT(rc == 0);
+
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+    TEST_ASSERT(os_mbuf_test_small_mempool.mp_num_free ==
+                MBUF_TEST_CLONE_POOL_BUF_COUNT);
+#endif
+}
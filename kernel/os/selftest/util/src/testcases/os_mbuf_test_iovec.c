@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+static void
+os_mbuf_test_iovec_check(const struct os_mbuf *om, int off, int len)
+{
+    struct os_mbuf_iovec iov[MBUF_TEST_POOL_BUF_COUNT];
+    struct os_mbuf_iovec seg;
+    struct os_mbuf_iter iter;
+    int cnt;
+    int cur;
+    int rc;
+    int i;
+
+    cnt = os_mbuf_to_iovec(om, off, len, iov, MBUF_TEST_POOL_BUF_COUNT);
+    TEST_ASSERT_FATAL(cnt >= 0 && cnt <= MBUF_TEST_POOL_BUF_COUNT);
+
+    cur = off;
+    for (i = 0; i < cnt; i++) {
+        TEST_ASSERT(iov[i].omv_len > 0);
+        TEST_ASSERT(memcmp(iov[i].omv_data, os_mbuf_test_data + cur,
+                           iov[i].omv_len) == 0);
+        cur += iov[i].omv_len;
+    }
+    TEST_ASSERT(cur == off + len);
+
+    /* A short array reports how many entries it should have had. */
+    if (cnt > 1) {
+        TEST_ASSERT(os_mbuf_to_iovec(om, off, len, iov, 1) == cnt);
+    }
+
+    rc = os_mbuf_iter_init(&iter, om, off, len);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < cnt; i++) {
+        rc = os_mbuf_iter_next(&iter, &seg);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(seg.omv_data == iov[i].omv_data);
+        TEST_ASSERT(seg.omv_len == iov[i].omv_len);
+    }
+    TEST_ASSERT(os_mbuf_iter_next(&iter, &seg) == OS_ENOENT);
+}
+
+TEST_CASE_SELF(os_mbuf_test_iovec)
+{
+    struct os_mbuf_iovec iov[1];
+    struct os_mbuf_iter iter;
+    struct os_mbuf *om;
+    struct os_mbuf *om2;
+    int len;
+    int rc;
+
+    os_mbuf_test_setup();
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    /* Empty chain. */
+    TEST_ASSERT(os_mbuf_to_iovec(om, 0, 0, iov, 1) == 0);
+    TEST_ASSERT(os_mbuf_to_iovec(om, 0, 1, iov, 1) == -1);
+
+    rc = os_mbuf_append(om, os_mbuf_test_data, 100);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Empty mbuf in the middle of the chain; it must be skipped. */
+    om2 = os_mbuf_get(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om2 != NULL);
+    os_mbuf_concat(om, om2);
+
+    om2 = os_mbuf_get(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om2 != NULL);
+    rc = os_mbuf_append(om2, os_mbuf_test_data + 100, 500);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_mbuf_concat(om, om2);
+    len = OS_MBUF_PKTLEN(om);
+    TEST_ASSERT_FATAL(len == 600);
+
+    os_mbuf_test_iovec_check(om, 0, len);
+    os_mbuf_test_iovec_check(om, 0, 0);
+    os_mbuf_test_iovec_check(om, 0, 50);
+    os_mbuf_test_iovec_check(om, 50, 100);
+    os_mbuf_test_iovec_check(om, 100, 300);
+    os_mbuf_test_iovec_check(om, 99, len - 99);
+    os_mbuf_test_iovec_check(om, len, 0);
+
+    /* Out of range. */
+    TEST_ASSERT(os_mbuf_to_iovec(om, 0, len + 1, iov, 1) == -1);
+    TEST_ASSERT(os_mbuf_to_iovec(om, len + 1, 0, iov, 1) == -1);
+    TEST_ASSERT(os_mbuf_iter_init(&iter, om, 10, len) == -1);
+
+    os_mbuf_free_chain(om);
+}
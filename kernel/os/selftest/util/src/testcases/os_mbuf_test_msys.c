@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define MBUF_TEST_SMALL_BUF_SIZE    (96)
+#define MBUF_TEST_SMALL_BUF_COUNT   (4)
+
+static os_membuf_t os_mbuf_small_membuf[
+    OS_MEMPOOL_SIZE(MBUF_TEST_SMALL_BUF_COUNT, MBUF_TEST_SMALL_BUF_SIZE)];
+static struct os_mbuf_pool os_mbuf_small_pool;
+static struct os_mempool os_mbuf_small_mempool;
+
+TEST_CASE_SELF(os_mbuf_test_msys)
+{
+    struct os_mbuf *small[MBUF_TEST_SMALL_BUF_COUNT];
+    struct os_mbuf *om;
+    struct os_mbuf *cur;
+    uint8_t buf[MBUF_TEST_DATA_LEN];
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+
+    rc = os_mempool_init(&os_mbuf_small_mempool, MBUF_TEST_SMALL_BUF_COUNT,
+                         MBUF_TEST_SMALL_BUF_SIZE, os_mbuf_small_membuf,
+                         "mbuf_small_pool");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&os_mbuf_small_pool, &os_mbuf_small_mempool,
+                           MBUF_TEST_SMALL_BUF_SIZE,
+                           MBUF_TEST_SMALL_BUF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Register the larger pool first; msys keeps them sorted by size. */
+    os_msys_reset();
+    rc = os_msys_register(&os_mbuf_pool);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_msys_register(&os_mbuf_small_pool);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Best fit. */
+    for (i = 1; i < MBUF_TEST_POOL_BUF_SIZE * 2; i++) {
+        om = os_msys_get(i, 0);
+        TEST_ASSERT_FATAL(om != NULL);
+        if (i <= os_mbuf_small_pool.omp_databuf_len) {
+            TEST_ASSERT(om->om_omp == &os_mbuf_small_pool);
+        } else {
+            TEST_ASSERT(om->om_omp == &os_mbuf_pool);
+        }
+        os_mbuf_free(om);
+    }
+
+    /* Exhausted best fit pool. */
+    for (i = 0; i < MBUF_TEST_SMALL_BUF_COUNT; i++) {
+        small[i] = os_msys_get(1, 0);
+        TEST_ASSERT_FATAL(small[i] != NULL);
+        TEST_ASSERT(small[i]->om_omp == &os_mbuf_small_pool);
+    }
+    om = os_msys_get(1, 0);
+#if MYNEWT_VAL(MSYS_SPILL_TO_LARGER)
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(om->om_omp == &os_mbuf_pool);
+    os_mbuf_free(om);
+#else
+    TEST_ASSERT(om == NULL);
+#endif
+    for (i = 0; i < MBUF_TEST_SMALL_BUF_COUNT; i++) {
+        os_mbuf_free(small[i]);
+    }
+
+    /* Chained allocation. */
+    om = os_msys_get_chain(0, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(om->om_omp == &os_mbuf_small_pool);
+    os_mbuf_test_misc_assert_sane(om, NULL, 0, 0,
+                                  sizeof (struct os_mbuf_pkthdr));
+    os_mbuf_free_chain(om);
+
+    om = os_msys_get_chain(MBUF_TEST_DATA_LEN, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    for (cur = om; SLIST_NEXT(cur, om_next) != NULL;
+         cur = SLIST_NEXT(cur, om_next)) {
+        TEST_ASSERT(OS_MBUF_TRAILINGSPACE(cur) == 0);
+    }
+    TEST_ASSERT(cur->om_len > 0);
+
+    rc = os_mbuf_copyinto(om, 0, os_mbuf_test_data, MBUF_TEST_DATA_LEN);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_mbuf_test_misc_assert_sane(om, os_mbuf_test_data, om->om_len,
+                                  MBUF_TEST_DATA_LEN,
+                                  sizeof (struct os_mbuf_pkthdr));
+    rc = os_mbuf_copydata(om, 0, MBUF_TEST_DATA_LEN, buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(memcmp(buf, os_mbuf_test_data, MBUF_TEST_DATA_LEN) == 0);
+    os_mbuf_free_chain(om);
+
+    /* Not enough buffers. */
+    om = os_msys_get_chain(MBUF_TEST_POOL_BUF_SIZE *
+                           (MBUF_TEST_POOL_BUF_COUNT + 1), 0);
+    TEST_ASSERT(om == NULL);
+    TEST_ASSERT(os_msys_num_free() ==
+                MBUF_TEST_POOL_BUF_COUNT + MBUF_TEST_SMALL_BUF_COUNT);
+
+    os_msys_reset();
+}
@@ -0,0 +1,56 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "taskpool/taskpool.h"
+#include "os_test_priv.h"
+
+TEST_CASE_TASK(os_sched_test_resort)
+{
+    struct os_task *t;
+    os_sr_t sr;
+    int i;
+
+    g_sched_test_run_cnt = 0;
+
+    taskpool_alloc_assert(sched_test_record_handler,
+                          MYNEWT_VAL(OS_MAIN_TASK_PRIO) + 2);
+    taskpool_alloc_assert(sched_test_record_handler,
+                          MYNEWT_VAL(OS_MAIN_TASK_PRIO) + 3);
+    t = taskpool_alloc_assert(sched_test_record_handler,
+                              MYNEWT_VAL(OS_MAIN_TASK_PRIO) + 5);
+    taskpool_alloc_assert(sched_test_record_handler,
+                          MYNEWT_VAL(OS_MAIN_TASK_PRIO) + 4);
+
+    /* Move the lowest priority ready task ahead of the others the old way:
+     * change t_prio in place and let the scheduler find where it was queued.
+     */
+    OS_ENTER_CRITICAL(sr);
+    t->t_prio = MYNEWT_VAL(OS_MAIN_TASK_PRIO) + 1;
+    os_sched_resort(t);
+    OS_EXIT_CRITICAL(sr);
+
+    taskpool_wait_assert(OS_TICKS_PER_SEC);
+
+    TEST_ASSERT_FATAL(g_sched_test_run_cnt == SCHED_TEST_MAX_TASKS);
+    for (i = 0; i < SCHED_TEST_MAX_TASKS; i++) {
+        TEST_ASSERT(g_sched_test_run_prio[i] ==
+                    MYNEWT_VAL(OS_MAIN_TASK_PRIO) + 1 + i);
+    }
+}
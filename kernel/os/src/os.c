@@ -237,8 +237,9 @@ os_init(int (*main_fn)(int argc, char **arg))
     SEGGER_RTT_Init();
 #endif
 
-    TAILQ_INIT(&g_callout_list);
+    os_callout_module_init();
     STAILQ_INIT(&g_os_task_list);
+    os_sched_init();
     os_eventq_init(os_eventq_dflt_get());
 
     /* Initialize device list. */
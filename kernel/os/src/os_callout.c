@@ -26,7 +26,223 @@
 #include "os/mynewt.h"
 #include "os_priv.h"
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+/*
+ * Hierarchical timing wheel.
+ *
+ * Level k has OS_CALLOUT_WHEEL_SLOTS slots, each covering 16^k ticks.  A
+ * callout that expires less than 16^(k + 1) ticks after
+ * os_callout_wheel_time is queued in level k, in the slot selected by bits
+ * [4k, 4k + 3] of its expiry time.  Callouts in level 0 therefore expire
+ * exactly on the tick of their slot.  Whenever os_callout_wheel_time crosses
+ * a multiple of 16^k, the matching slot of level k is "cascaded": its
+ * callouts are requeued relative to the new time, which moves each of them to
+ * a lower level.  Eight levels cover the whole 32-bit tick range.
+ *
+ * Slots are singly-headed lists threaded through c_next; tqe_prev points at
+ * the previous callout's tqe_next (or at the slot head), so a callout can be
+ * unlinked in constant time without knowing its slot.  A bitmap per level
+ * records which slots are non-empty.
+ */
+#define OS_CALLOUT_WHEEL_BITS       (4)
+#define OS_CALLOUT_WHEEL_SLOTS      (1 << OS_CALLOUT_WHEEL_BITS)
+#define OS_CALLOUT_WHEEL_MASK       (OS_CALLOUT_WHEEL_SLOTS - 1)
+#define OS_CALLOUT_WHEEL_LEVELS     (32 / OS_CALLOUT_WHEEL_BITS)
+
+static struct os_callout *
+os_callout_wheel[OS_CALLOUT_WHEEL_LEVELS][OS_CALLOUT_WHEEL_SLOTS];
+static uint16_t os_callout_wheel_map[OS_CALLOUT_WHEEL_LEVELS];
+
+/* Next tick to be processed by os_callout_tick(). */
+static os_time_t os_callout_wheel_time;
+
+/* Callouts that have expired but whose events have not been posted yet. */
+static struct os_callout *os_callout_expired;
+#else
 struct os_callout_list g_callout_list;
+#endif
+
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+
+static void
+os_callout_link(struct os_callout **head, struct os_callout *c)
+{
+    c->c_next.tqe_next = *head;
+    if (*head != NULL) {
+        (*head)->c_next.tqe_prev = &c->c_next.tqe_next;
+    }
+    *head = c;
+    c->c_next.tqe_prev = head;
+}
+
+static void
+os_callout_unlink(struct os_callout *c)
+{
+    struct os_callout **prev;
+    int idx;
+
+    prev = c->c_next.tqe_prev;
+    if (c->c_next.tqe_next != NULL) {
+        c->c_next.tqe_next->c_next.tqe_prev = prev;
+    }
+    *prev = c->c_next.tqe_next;
+    c->c_next.tqe_prev = NULL;
+
+    /* If this emptied a wheel slot, clear its bit in the level bitmap. */
+    if (*prev == NULL &&
+        prev >= &os_callout_wheel[0][0] &&
+        prev < &os_callout_wheel[0][0] +
+               OS_CALLOUT_WHEEL_LEVELS * OS_CALLOUT_WHEEL_SLOTS) {
+
+        idx = prev - &os_callout_wheel[0][0];
+        os_callout_wheel_map[idx / OS_CALLOUT_WHEEL_SLOTS] &=
+            ~(1 << (idx % OS_CALLOUT_WHEEL_SLOTS));
+    }
+}
+
+static void
+os_callout_wheel_insert(struct os_callout *c)
+{
+    os_time_t delta;
+    int level;
+    int slot;
+
+    delta = c->c_ticks - os_callout_wheel_time;
+    if ((int32_t)delta <= 0) {
+        /* Expires on the next processed tick. */
+        level = 0;
+        slot = os_callout_wheel_time & OS_CALLOUT_WHEEL_MASK;
+    } else {
+        for (level = 0; level < OS_CALLOUT_WHEEL_LEVELS - 1; level++) {
+            if ((delta >> ((level + 1) * OS_CALLOUT_WHEEL_BITS)) == 0) {
+                break;
+            }
+        }
+        slot = (c->c_ticks >> (level * OS_CALLOUT_WHEEL_BITS)) &
+               OS_CALLOUT_WHEEL_MASK;
+    }
+
+    os_callout_link(&os_callout_wheel[level][slot], c);
+    os_callout_wheel_map[level] |= 1 << slot;
+}
+
+/**
+ * Returns the index of the first bit set in the 16-bit map, starting at bit
+ * 'start' and wrapping around, as an offset from 'start'.  Returns -1 if the
+ * map is empty.
+ */
+static int
+os_callout_wheel_map_next(uint16_t map, int start)
+{
+    uint32_t rot;
+
+    if (map == 0) {
+        return -1;
+    }
+
+    rot = ((uint32_t)map | ((uint32_t)map << OS_CALLOUT_WHEEL_SLOTS)) >> start;
+    return __builtin_ctz(rot);
+}
+
+/**
+ * Returns the number of ticks from os_callout_wheel_time to the next tick at
+ * which the wheel has work to do: either a level 0 slot whose callouts expire
+ * on that tick, or a non-empty slot of a higher level that needs to be
+ * cascaded.  Returns OS_TIMEOUT_NEVER if no callouts are queued.
+ */
+static os_time_t
+os_callout_wheel_next_event(void)
+{
+    os_time_t now;
+    os_time_t rt;
+    os_time_t dt;
+    int shift;
+    int level;
+    int off;
+
+    now = os_callout_wheel_time;
+    rt = OS_TIMEOUT_NEVER;
+
+    off = os_callout_wheel_map_next(os_callout_wheel_map[0],
+                                    now & OS_CALLOUT_WHEEL_MASK);
+    if (off >= 0) {
+        rt = off;
+    }
+
+    for (level = 1; level < OS_CALLOUT_WHEEL_LEVELS; level++) {
+        shift = level * OS_CALLOUT_WHEEL_BITS;
+
+        /* The slot for the current time was cascaded when the wheel time
+         * reached it, so the search starts with the following slot.
+         */
+        off = os_callout_wheel_map_next(os_callout_wheel_map[level],
+                                        ((now >> shift) + 1) &
+                                        OS_CALLOUT_WHEEL_MASK);
+        if (off >= 0) {
+            dt = ((os_time_t)((now >> shift) + off + 1) << shift) - now;
+            if (dt < rt) {
+                rt = dt;
+            }
+        }
+    }
+
+    return rt;
+}
+
+/**
+ * Sets the wheel time and cascades every level whose slot boundary it is on.
+ */
+static void
+os_callout_wheel_set_time(os_time_t now)
+{
+    struct os_callout *list;
+    struct os_callout *c;
+    int shift;
+    int level;
+    int slot;
+
+    os_callout_wheel_time = now;
+
+    for (level = 1; level < OS_CALLOUT_WHEEL_LEVELS; level++) {
+        shift = level * OS_CALLOUT_WHEEL_BITS;
+        if ((now & ((1UL << shift) - 1)) != 0) {
+            break;
+        }
+
+        slot = (now >> shift) & OS_CALLOUT_WHEEL_MASK;
+        if (os_callout_wheel[level][slot] == NULL) {
+            continue;
+        }
+
+        /* Reverse the slot list so that callouts are requeued in the order
+         * they were armed.
+         */
+        list = NULL;
+        while ((c = os_callout_wheel[level][slot]) != NULL) {
+            os_callout_unlink(c);
+            os_callout_link(&list, c);
+        }
+        while ((c = list) != NULL) {
+            os_callout_unlink(c);
+            os_callout_wheel_insert(c);
+        }
+    }
+}
+
+#endif
+
+void
+os_callout_module_init(void)
+{
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    memset(os_callout_wheel, 0, sizeof os_callout_wheel);
+    memset(os_callout_wheel_map, 0, sizeof os_callout_wheel_map);
+    os_callout_expired = NULL;
+    os_callout_wheel_time = os_time_get();
+#else
+    TAILQ_INIT(&g_callout_list);
+#endif
+}
 
 void os_callout_init(struct os_callout *c, struct os_eventq *evq,
                      os_event_fn *ev_cb, void *ev_arg)
@@ -41,6 +257,43 @@ void os_callout_init(struct os_callout *c, struct os_eventq *evq,
     os_trace_api_ret(OS_TRACE_ID_CALLOUT_INIT);
 }
 
+#if MYNEWT_VAL(OS_CALLOUT_SLACK)
+void
+os_callout_set_slack(struct os_callout *c, os_time_t slack)
+{
+    assert(slack <= INT32_MAX);
+    c->c_slack = slack;
+}
+
+/**
+ * Returns the tick within [ticks, ticks + slack] that has the most low-order
+ * zero bits.  Unrelated callouts whose windows overlap thus tend to end up
+ * on the same tick.
+ */
+static os_time_t
+os_callout_apply_slack(os_time_t ticks, os_time_t slack)
+{
+    os_time_t limit;
+    os_time_t mask;
+
+    if (slack == 0) {
+        return ticks;
+    }
+
+    limit = ticks + slack;
+
+    /* Every bit above the highest bit in which ticks - 1 and the limit
+     * differ is the same for all ticks in the window; the limit with all
+     * bits below that one cleared is the first tick in the window at which
+     * it is set.
+     */
+    mask = (ticks - 1) ^ limit;
+    mask = (1UL << (31 - __builtin_clz(mask))) - 1;
+
+    return limit & ~mask;
+}
+#endif
+
 void
 os_callout_stop(struct os_callout *c)
 {
@@ -51,8 +304,12 @@ os_callout_stop(struct os_callout *c)
     OS_ENTER_CRITICAL(sr);
 
     if (os_callout_queued(c)) {
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+        os_callout_unlink(c);
+#else
         TAILQ_REMOVE(&g_callout_list, c, c_next);
         c->c_next.tqe_prev = NULL;
+#endif
     }
 
     if (c->c_evq) {
@@ -67,7 +324,9 @@ os_callout_stop(struct os_callout *c)
 int
 os_callout_reset(struct os_callout *c, os_time_t ticks)
 {
+#if !MYNEWT_VAL(OS_CALLOUT_WHEEL)
     struct os_callout *entry;
+#endif
     os_sr_t sr;
     int ret;
 
@@ -90,7 +349,13 @@ os_callout_reset(struct os_callout *c, os_time_t ticks)
     }
 
     c->c_ticks = os_time_get() + ticks;
+#if MYNEWT_VAL(OS_CALLOUT_SLACK)
+    c->c_ticks = os_callout_apply_slack(c->c_ticks, c->c_slack);
+#endif
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    os_callout_wheel_insert(c);
+#else
     entry = NULL;
     TAILQ_FOREACH(entry, &g_callout_list, c_next) {
         if (OS_TIME_TICK_LT(c->c_ticks, entry->c_ticks)) {
@@ -103,6 +368,7 @@ os_callout_reset(struct os_callout *c, os_time_t ticks)
     } else {
         TAILQ_INSERT_TAIL(&g_callout_list, c, c_next);
     }
+#endif
 
     OS_EXIT_CRITICAL(sr);
 
@@ -120,6 +386,92 @@ err:
  * to run, it posts an event for each callout that's ready to run,
  * to the event queue provided to os_callout_init().
  */
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+
+static void
+os_callout_fire(struct os_callout *c)
+{
+    if (c->c_evq) {
+        os_eventq_put(c->c_evq, &c->c_ev);
+    } else {
+        c->c_ev.ev_cb(&c->c_ev);
+    }
+}
+
+void
+os_callout_tick(void)
+{
+    struct os_callout *c;
+    os_time_t now;
+    os_time_t dt;
+    os_sr_t sr;
+    int slot;
+
+    os_trace_api_void(OS_TRACE_ID_CALLOUT_TICK);
+
+    now = os_time_get();
+
+    /*
+     * Advance the wheel one event at a time rather than one tick at a time,
+     * so that catching up after a long tickless idle period only costs as
+     * much as the number of slots that actually hold callouts.  All callouts
+     * expiring on the same tick are posted as one batch.
+     */
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+
+        if (OS_TIME_TICK_GT(os_callout_wheel_time, now)) {
+            OS_EXIT_CRITICAL(sr);
+            break;
+        }
+
+        dt = os_callout_wheel_next_event();
+        if (dt == OS_TIMEOUT_NEVER ||
+            OS_TIME_TICK_GT(os_callout_wheel_time + dt, now)) {
+
+            os_callout_wheel_set_time(now + 1);
+            OS_EXIT_CRITICAL(sr);
+            break;
+        }
+
+        if (dt != 0) {
+            os_callout_wheel_set_time(os_callout_wheel_time + dt);
+            OS_EXIT_CRITICAL(sr);
+            continue;
+        }
+
+        /* Move the callouts expiring now to the expired list, reversing the
+         * slot list so that they fire in the order they were armed.
+         */
+        slot = os_callout_wheel_time & OS_CALLOUT_WHEEL_MASK;
+        while ((c = os_callout_wheel[0][slot]) != NULL) {
+            os_callout_unlink(c);
+            os_callout_link(&os_callout_expired, c);
+        }
+        os_callout_wheel_set_time(os_callout_wheel_time + 1);
+
+        OS_EXIT_CRITICAL(sr);
+
+        while (1) {
+            OS_ENTER_CRITICAL(sr);
+            c = os_callout_expired;
+            if (c) {
+                os_callout_unlink(c);
+            }
+            OS_EXIT_CRITICAL(sr);
+
+            if (c == NULL) {
+                break;
+            }
+            os_callout_fire(c);
+        }
+    }
+
+    os_trace_api_ret(OS_TRACE_ID_CALLOUT_TICK);
+}
+
+#else
+
 void
 os_callout_tick(void)
 {
@@ -158,10 +510,17 @@ os_callout_tick(void)
     os_trace_api_ret(OS_TRACE_ID_CALLOUT_TICK);
 }
 
+#endif
+
 /*
  * Returns the number of ticks to the first pending callout. If there are no
  * pending callouts then return OS_TIMEOUT_NEVER instead.
  *
+ * With OS_CALLOUT_WHEEL, a callout queued in a higher wheel level is only
+ * known to expire within the range covered by its slot.  The returned value
+ * is then the time at which that slot gets cascaded, i.e. the system may wake
+ * up somewhat before the callout actually expires, but never after.
+ *
  * @param now The time now
  *
  * @return Number of ticks to first pending callout
@@ -170,6 +529,24 @@ os_time_t
 os_callout_wakeup_ticks(os_time_t now)
 {
     os_time_t rt;
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    os_time_t dt;
+
+    OS_ASSERT_CRITICAL();
+
+    if (os_callout_expired != NULL) {
+        return 0;
+    }
+
+    dt = os_callout_wheel_next_event();
+    if (dt == OS_TIMEOUT_NEVER) {
+        rt = OS_TIMEOUT_NEVER;
+    } else if (OS_TIME_TICK_GEQ(os_callout_wheel_time + dt, now)) {
+        rt = os_callout_wheel_time + dt - now;
+    } else {
+        rt = 0;     /* callout time is in the past */
+    }
+#else
     struct os_callout *c;
 
     OS_ASSERT_CRITICAL();
@@ -184,6 +561,7 @@ os_callout_wakeup_ticks(os_time_t now)
     } else {
         rt = OS_TIMEOUT_NEVER;
     }
+#endif
 
     return (rt);
 }
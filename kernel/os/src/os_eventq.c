@@ -92,14 +92,18 @@ struct os_event *
 os_eventq_get_no_wait(struct os_eventq *evq)
 {
     struct os_event *ev;
+    os_sr_t sr;
 
     os_trace_api_u32(OS_TRACE_ID_EVENTQ_GET_NO_WAIT, (uint32_t)evq);
 
+    /* Producers may be interrupt handlers. */
+    OS_ENTER_CRITICAL(sr);
     ev = STAILQ_FIRST(&evq->evq_list);
     if (ev) {
         STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
         ev->ev_queued = 0;
     }
+    OS_EXIT_CRITICAL(sr);
 
     os_trace_api_ret_u32(OS_TRACE_ID_EVENTQ_GET_NO_WAIT, (uint32_t)ev);
 
@@ -179,16 +183,14 @@ os_eventq_mon_find(struct os_eventq *evq, struct os_event *ev)
 }
 #endif
 
-void
-os_eventq_run(struct os_eventq *evq)
+static void
+os_eventq_run_ev(struct os_eventq *evq, struct os_event *ev)
 {
-    struct os_event *ev;
 #if MYNEWT_VAL(OS_EVENTQ_MONITOR)
     struct os_eventq_mon *mon;
     uint32_t ticks;
 #endif
 
-    ev = os_eventq_get(evq);
     assert(ev->ev_cb != NULL);
 #if MYNEWT_VAL(OS_EVENTQ_MONITOR)
     ticks = os_cputime_get32();
@@ -215,6 +217,40 @@ os_eventq_run(struct os_eventq *evq)
 #endif
 }
 
+void
+os_eventq_run(struct os_eventq *evq)
+{
+    struct os_event *ev;
+
+    ev = os_eventq_get(evq);
+    os_eventq_run_ev(evq, ev);
+}
+
+int
+os_eventq_run_batch(struct os_eventq *evq, int max)
+{
+    struct os_event *ev;
+    int cnt;
+
+    assert(max > 0);
+
+    ev = os_eventq_get(evq);
+    os_eventq_run_ev(evq, ev);
+
+    for (cnt = 1; cnt < max; cnt++) {
+        ev = os_eventq_get_no_wait(evq);
+        if (ev == NULL) {
+            break;
+        }
+#if MYNEWT_VAL(OS_EVENTQ_DEBUG)
+        evq->evq_prev = ev;
+#endif
+        os_eventq_run_ev(evq, ev);
+    }
+
+    return cnt;
+}
+
 static struct os_event *
 os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
 {
@@ -18,8 +18,14 @@
  */
 
 #include <assert.h>
+#include <stddef.h>
+#include <string.h>
 #include "os/mynewt.h"
 
+#if MYNEWT_VAL(OS_HEAP_STATS)
+#include "stats/stats.h"
+#endif
+
 #if MYNEWT_VAL(OS_SCHEDULING)
 static struct os_mutex os_malloc_mutex;
 #endif
@@ -50,6 +56,683 @@ os_malloc_unlock(void)
 #endif
 }
 
+#if MYNEWT_VAL(OS_HEAP_TLSF)
+/*
+ * Two-level segregated fit allocator.
+ *
+ * Free blocks are kept in size-segregated lists.  The first level splits the
+ * sizes into powers of two, the second level splits each power of two into
+ * OS_HEAP_SL_COUNT equal ranges.  A bitmap per level records which lists are
+ * non-empty, so finding a free block that is large enough, as well as
+ * allocating, freeing and coalescing, take a constant number of steps
+ * regardless of the state of the heap.
+ *
+ * Every block starts with a header holding its size; the two lowest bits of
+ * the size hold the block's own free flag and the free flag of the block
+ * physically preceding it.  Payloads are aligned for any type (at least 8
+ * bytes, as the ARM EABI requires for doubles and 64-bit integers).  As the
+ * header of the next block directly follows a payload, every block size plus
+ * the header is a multiple of the alignment; on 32-bit targets block sizes
+ * are thus 4 modulo 8.  A free block also links itself into its free
+ * list, and stores a pointer to itself in the last word of its payload, where
+ * the next block finds it as prev_phys when coalescing.  An allocated block
+ * thus costs one word of overhead.
+ *
+ * Memory is taken from _sbrk() in chunks of at least OS_HEAP_TLSF_GROW_SIZE
+ * bytes.  Each chunk ends with a zero-sized allocated block, which stops
+ * coalescing at the chunk boundary.  A chunk that directly follows the
+ * previous one extends it instead, reusing its end block.
+ */
+struct os_heap_block {
+    /* Only valid if the previous block is free. */
+    struct os_heap_block *prev_phys;
+    /* Size of the payload, and OS_HEAP_BLOCK_F_* flags. */
+    size_t size;
+    /* Only valid if this block is free. */
+    struct os_heap_block *next_free;
+    struct os_heap_block *prev_free;
+};
+
+#define OS_HEAP_BLOCK_F_FREE        (1)
+#define OS_HEAP_BLOCK_F_PREV_FREE   (2)
+#define OS_HEAP_BLOCK_F_MASK        (3)
+
+#define OS_HEAP_ALIGN               (_Alignof(max_align_t) > 8 ? \
+                                     _Alignof(max_align_t) : 8)
+
+/* Overhead of an allocated block: its size field. */
+#define OS_HEAP_BLOCK_OVERHEAD      (sizeof(size_t))
+/* Offset of the payload from the start of the block structure. */
+#define OS_HEAP_BLOCK_START         (offsetof(struct os_heap_block, size) + \
+                                     sizeof(size_t))
+/* A free block must be able to hold its list links and prev_phys of the
+ * next block.  os_heap_size_round_up() keeps larger blocks properly sized.
+ */
+#define OS_HEAP_BLOCK_SIZE_MIN      (sizeof(struct os_heap_block) -       \
+                                     sizeof(struct os_heap_block *))
+
+#define OS_HEAP_SL_LOG2             (4)
+#define OS_HEAP_SL_COUNT            (1 << OS_HEAP_SL_LOG2)
+#define OS_HEAP_FL_SHIFT            (OS_HEAP_SL_LOG2 + \
+                                     __builtin_ctz(OS_HEAP_ALIGN))
+#define OS_HEAP_FL_MAX              MYNEWT_VAL(OS_HEAP_TLSF_FL_MAX)
+#define OS_HEAP_FL_COUNT            (OS_HEAP_FL_MAX - OS_HEAP_FL_SHIFT + 1)
+/* Sizes below this are all in first level 0, split linearly. */
+#define OS_HEAP_SMALL_BLOCK         (1 << OS_HEAP_FL_SHIFT)
+#define OS_HEAP_BLOCK_SIZE_MAX      ((size_t)1 << OS_HEAP_FL_MAX)
+
+struct os_heap {
+    uint32_t fl_map;
+    uint32_t sl_map[OS_HEAP_FL_COUNT];
+    struct os_heap_block *blocks[OS_HEAP_FL_COUNT][OS_HEAP_SL_COUNT];
+
+    /* End of the most recently added region, and its zero-sized block. */
+    uint8_t *region_end;
+    struct os_heap_block *sentinel;
+
+    size_t total;
+    size_t used;
+    size_t used_max;
+    size_t free;
+    uint32_t free_blocks;
+};
+
+static struct os_heap os_heap;
+
+#if MYNEWT_VAL(OS_HEAP_STATS)
+STATS_SECT_START(os_heap_stats)
+    STATS_SECT_ENTRY(allocs)
+    STATS_SECT_ENTRY(frees)
+    STATS_SECT_ENTRY(reallocs)
+    STATS_SECT_ENTRY(alloc_fails)
+    STATS_SECT_ENTRY(grows)
+    STATS_SECT_ENTRY(bytes_total)
+    STATS_SECT_ENTRY(bytes_used)
+    STATS_SECT_ENTRY(bytes_used_max)
+    STATS_SECT_ENTRY(bytes_free)
+    STATS_SECT_ENTRY(free_blocks)
+STATS_SECT_END
+
+STATS_SECT_DECL(os_heap_stats) os_heap_stats;
+
+STATS_NAME_START(os_heap_stats)
+    STATS_NAME(os_heap_stats, allocs)
+    STATS_NAME(os_heap_stats, frees)
+    STATS_NAME(os_heap_stats, reallocs)
+    STATS_NAME(os_heap_stats, alloc_fails)
+    STATS_NAME(os_heap_stats, grows)
+    STATS_NAME(os_heap_stats, bytes_total)
+    STATS_NAME(os_heap_stats, bytes_used)
+    STATS_NAME(os_heap_stats, bytes_used_max)
+    STATS_NAME(os_heap_stats, bytes_free)
+    STATS_NAME(os_heap_stats, free_blocks)
+STATS_NAME_END(os_heap_stats)
+
+#define OS_HEAP_STATS_INC(__var)    STATS_INC(os_heap_stats, __var)
+
+static void
+os_heap_stats_update(void)
+{
+    STATS_SET(os_heap_stats, bytes_total, os_heap.total);
+    STATS_SET(os_heap_stats, bytes_used, os_heap.used);
+    STATS_SET(os_heap_stats, bytes_used_max, os_heap.used_max);
+    STATS_SET(os_heap_stats, bytes_free, os_heap.free);
+    STATS_SET(os_heap_stats, free_blocks, os_heap.free_blocks);
+}
+
+void
+os_heap_stats_init(void)
+{
+    int rc;
+
+    rc = stats_init_and_reg(STATS_HDR(os_heap_stats),
+                            STATS_SIZE_INIT_PARMS(os_heap_stats, STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(os_heap_stats), "os_heap");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    os_malloc_lock();
+    os_heap_stats_update();
+    os_malloc_unlock();
+}
+#else
+#define OS_HEAP_STATS_INC(__var)
+#define os_heap_stats_update()
+#endif
+
+extern void *_sbrk(int incr);
+
+static int
+os_heap_fls(size_t x)
+{
+    return (int)(sizeof(unsigned long) * 8) - 1 -
+           __builtin_clzl((unsigned long)x);
+}
+
+static size_t
+os_heap_block_size(const struct os_heap_block *b)
+{
+    return b->size & ~(size_t)OS_HEAP_BLOCK_F_MASK;
+}
+
+static void
+os_heap_block_set_size(struct os_heap_block *b, size_t size)
+{
+    b->size = size | (b->size & OS_HEAP_BLOCK_F_MASK);
+}
+
+/**
+ * Rounds a block size up so that the payload of the next block is aligned.
+ */
+static size_t
+os_heap_size_round_up(size_t size)
+{
+    return ((size + OS_HEAP_BLOCK_OVERHEAD + OS_HEAP_ALIGN - 1) &
+            ~(OS_HEAP_ALIGN - 1)) - OS_HEAP_BLOCK_OVERHEAD;
+}
+
+/**
+ * Rounds a block size down so that the payload of the next block is aligned.
+ */
+static size_t
+os_heap_size_round_down(size_t size)
+{
+    return ((size + OS_HEAP_BLOCK_OVERHEAD) & ~(OS_HEAP_ALIGN - 1)) -
+           OS_HEAP_BLOCK_OVERHEAD;
+}
+
+static void *
+os_heap_block_to_ptr(struct os_heap_block *b)
+{
+    return (uint8_t *)b + OS_HEAP_BLOCK_START;
+}
+
+static struct os_heap_block *
+os_heap_ptr_to_block(void *ptr)
+{
+    return (struct os_heap_block *)((uint8_t *)ptr - OS_HEAP_BLOCK_START);
+}
+
+static struct os_heap_block *
+os_heap_block_next(struct os_heap_block *b)
+{
+    return (struct os_heap_block *)((uint8_t *)os_heap_block_to_ptr(b) +
+                                    os_heap_block_size(b) -
+                                    OS_HEAP_BLOCK_OVERHEAD);
+}
+
+/**
+ * Returns the block following b, after pointing its prev_phys at b.
+ */
+static struct os_heap_block *
+os_heap_block_link_next(struct os_heap_block *b)
+{
+    struct os_heap_block *next;
+
+    next = os_heap_block_next(b);
+    next->prev_phys = b;
+    return next;
+}
+
+static void
+os_heap_block_mark_free(struct os_heap_block *b)
+{
+    struct os_heap_block *next;
+
+    next = os_heap_block_link_next(b);
+    next->size |= OS_HEAP_BLOCK_F_PREV_FREE;
+    b->size |= OS_HEAP_BLOCK_F_FREE;
+}
+
+static void
+os_heap_block_mark_used(struct os_heap_block *b)
+{
+    struct os_heap_block *next;
+
+    next = os_heap_block_next(b);
+    next->size &= ~(size_t)OS_HEAP_BLOCK_F_PREV_FREE;
+    b->size &= ~(size_t)OS_HEAP_BLOCK_F_FREE;
+}
+
+/**
+ * Computes the free list that blocks of the given size belong to.
+ */
+static void
+os_heap_mapping_insert(size_t size, int *fl, int *sl)
+{
+    int f;
+
+    if (size < OS_HEAP_SMALL_BLOCK) {
+        *fl = 0;
+        *sl = size / (OS_HEAP_SMALL_BLOCK / OS_HEAP_SL_COUNT);
+    } else {
+        f = os_heap_fls(size);
+        *sl = (size >> (f - OS_HEAP_SL_LOG2)) ^ OS_HEAP_SL_COUNT;
+        *fl = f - (OS_HEAP_FL_SHIFT - 1);
+    }
+}
+
+/**
+ * Computes the first free list whose blocks are all at least the given size,
+ * rounding the size up accordingly.
+ */
+static void
+os_heap_mapping_search(size_t size, int *fl, int *sl)
+{
+    if (size >= OS_HEAP_SMALL_BLOCK) {
+        size += ((size_t)1 << (os_heap_fls(size) - OS_HEAP_SL_LOG2)) - 1;
+    }
+    os_heap_mapping_insert(size, fl, sl);
+}
+
+static struct os_heap_block *
+os_heap_find_suitable(int *fl, int *sl)
+{
+    uint32_t fl_map;
+    uint32_t sl_map;
+
+    sl_map = os_heap.sl_map[*fl] & (~0UL << *sl);
+    if (sl_map == 0) {
+        fl_map = os_heap.fl_map & (~0UL << (*fl + 1));
+        if (fl_map == 0) {
+            return NULL;
+        }
+        *fl = __builtin_ctz(fl_map);
+        sl_map = os_heap.sl_map[*fl];
+    }
+    *sl = __builtin_ctz(sl_map);
+
+    return os_heap.blocks[*fl][*sl];
+}
+
+static void
+os_heap_remove_free(struct os_heap_block *b, int fl, int sl)
+{
+    if (b->prev_free != NULL) {
+        b->prev_free->next_free = b->next_free;
+    } else {
+        os_heap.blocks[fl][sl] = b->next_free;
+        if (b->next_free == NULL) {
+            os_heap.sl_map[fl] &= ~(1UL << sl);
+            if (os_heap.sl_map[fl] == 0) {
+                os_heap.fl_map &= ~(1UL << fl);
+            }
+        }
+    }
+    if (b->next_free != NULL) {
+        b->next_free->prev_free = b->prev_free;
+    }
+
+    os_heap.free -= os_heap_block_size(b);
+    os_heap.free_blocks--;
+}
+
+static void
+os_heap_remove_block(struct os_heap_block *b)
+{
+    int fl;
+    int sl;
+
+    os_heap_mapping_insert(os_heap_block_size(b), &fl, &sl);
+    os_heap_remove_free(b, fl, sl);
+}
+
+static void
+os_heap_insert_block(struct os_heap_block *b)
+{
+    int fl;
+    int sl;
+
+    os_heap_mapping_insert(os_heap_block_size(b), &fl, &sl);
+
+    b->prev_free = NULL;
+    b->next_free = os_heap.blocks[fl][sl];
+    if (b->next_free != NULL) {
+        b->next_free->prev_free = b;
+    }
+    os_heap.blocks[fl][sl] = b;
+    os_heap.sl_map[fl] |= 1UL << sl;
+    os_heap.fl_map |= 1UL << fl;
+
+    os_heap.free += os_heap_block_size(b);
+    os_heap.free_blocks++;
+}
+
+/**
+ * Merges a free block that is not on any list with the free blocks around
+ * it, and puts the result on its free list.
+ */
+static void
+os_heap_release(struct os_heap_block *b)
+{
+    struct os_heap_block *prev;
+    struct os_heap_block *next;
+
+    if (b->size & OS_HEAP_BLOCK_F_PREV_FREE) {
+        prev = b->prev_phys;
+        os_heap_remove_block(prev);
+        os_heap_block_set_size(prev, os_heap_block_size(prev) +
+                                     os_heap_block_size(b) +
+                                     OS_HEAP_BLOCK_OVERHEAD);
+        b = prev;
+    }
+
+    next = os_heap_block_next(b);
+    if (next->size & OS_HEAP_BLOCK_F_FREE) {
+        os_heap_remove_block(next);
+        os_heap_block_set_size(b, os_heap_block_size(b) +
+                                  os_heap_block_size(next) +
+                                  OS_HEAP_BLOCK_OVERHEAD);
+    }
+
+    os_heap_block_mark_free(b);
+    os_heap_insert_block(b);
+}
+
+/**
+ * Shrinks an allocated block to the given size, returning the remainder to
+ * the heap if it is large enough to form a block of its own.
+ */
+static void
+os_heap_trim(struct os_heap_block *b, size_t size)
+{
+    struct os_heap_block *rem;
+
+    if (os_heap_block_size(b) < size + sizeof(struct os_heap_block)) {
+        return;
+    }
+
+    rem = (struct os_heap_block *)((uint8_t *)os_heap_block_to_ptr(b) + size -
+                                   OS_HEAP_BLOCK_OVERHEAD);
+    rem->size = os_heap_block_size(b) - size - OS_HEAP_BLOCK_OVERHEAD;
+    os_heap_block_set_size(b, size);
+
+    os_heap_release(rem);
+}
+
+/**
+ * Adds a chunk of memory to the heap.
+ */
+static void
+os_heap_add_region(void *mem, size_t len)
+{
+    struct os_heap_block *b;
+    uintptr_t start;
+    uintptr_t end;
+    size_t size;
+
+    end = (uintptr_t)mem + len;
+
+    if (os_heap.sentinel != NULL && (uint8_t *)mem == os_heap.region_end) {
+        /* Turn the end block of the previous region into a block spanning
+         * the new memory.
+         */
+        b = os_heap.sentinel;
+        start = (uintptr_t)os_heap_block_to_ptr(b);
+        size = end - start - OS_HEAP_BLOCK_OVERHEAD;
+        if (size > OS_HEAP_BLOCK_SIZE_MAX - OS_HEAP_ALIGN) {
+            size = OS_HEAP_BLOCK_SIZE_MAX - OS_HEAP_ALIGN;
+        }
+        os_heap_block_set_size(b, os_heap_size_round_down(size));
+        os_heap.total += len;
+    } else {
+        /* Align the payload, which follows the block's size field. */
+        start = ((uintptr_t)mem + OS_HEAP_BLOCK_OVERHEAD + OS_HEAP_ALIGN - 1) &
+                ~(OS_HEAP_ALIGN - 1);
+        size = end - start - OS_HEAP_BLOCK_OVERHEAD;
+        if (size > OS_HEAP_BLOCK_SIZE_MAX - OS_HEAP_ALIGN) {
+            size = OS_HEAP_BLOCK_SIZE_MAX - OS_HEAP_ALIGN;
+        }
+
+        /* The block's prev_phys falls before the region; it is never used,
+         * as there is no previous block.
+         */
+        b = os_heap_ptr_to_block((void *)start);
+        b->size = os_heap_size_round_down(size);
+        os_heap.total += len;
+    }
+
+    os_heap.sentinel = os_heap_block_next(b);
+    os_heap.sentinel->size = 0;
+    os_heap.region_end = (uint8_t *)end;
+
+    os_heap_release(b);
+}
+
+/**
+ * Gets memory for a block of at least the given size from the system.
+ */
+static int
+os_heap_grow(size_t size)
+{
+    size_t len;
+    void *mem;
+
+    /* Leave room for the sentinel and for aligning the region. */
+    len = size + 2 * OS_HEAP_BLOCK_OVERHEAD + 2 * OS_HEAP_ALIGN;
+    if (len < MYNEWT_VAL(OS_HEAP_TLSF_GROW_SIZE)) {
+        len = MYNEWT_VAL(OS_HEAP_TLSF_GROW_SIZE);
+    }
+    if (len > INT32_MAX) {
+        return OS_ENOMEM;
+    }
+
+    mem = _sbrk(len);
+    if (mem == NULL || mem == (void *)-1) {
+        return OS_ENOMEM;
+    }
+
+    os_heap_add_region(mem, len);
+    OS_HEAP_STATS_INC(grows);
+
+    return 0;
+}
+
+static size_t
+os_heap_adjust_size(size_t size)
+{
+    if (size < OS_HEAP_BLOCK_SIZE_MIN) {
+        size = OS_HEAP_BLOCK_SIZE_MIN;
+    }
+    return os_heap_size_round_up(size);
+}
+
+static void *
+os_heap_malloc(size_t size)
+{
+    struct os_heap_block *b;
+    int fl;
+    int sl;
+
+    if (size > OS_HEAP_BLOCK_SIZE_MAX / 2) {
+        return NULL;
+    }
+    size = os_heap_adjust_size(size);
+
+    os_heap_mapping_search(size, &fl, &sl);
+    b = os_heap_find_suitable(&fl, &sl);
+    if (b == NULL) {
+        /* Ask for enough to be sure the new block is on a list that
+         * mapping_search() accepts.
+         */
+        if (os_heap_grow(size + (size >> OS_HEAP_SL_LOG2)) != 0) {
+            return NULL;
+        }
+        os_heap_mapping_search(size, &fl, &sl);
+        b = os_heap_find_suitable(&fl, &sl);
+        if (b == NULL) {
+            return NULL;
+        }
+    }
+
+    os_heap_remove_free(b, fl, sl);
+    os_heap_block_mark_used(b);
+    os_heap_trim(b, size);
+
+    os_heap.used += os_heap_block_size(b);
+    if (os_heap.used > os_heap.used_max) {
+        os_heap.used_max = os_heap.used;
+    }
+
+    return os_heap_block_to_ptr(b);
+}
+
+static void
+os_heap_free(void *ptr)
+{
+    struct os_heap_block *b;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    b = os_heap_ptr_to_block(ptr);
+    assert(!(b->size & OS_HEAP_BLOCK_F_FREE));
+
+    os_heap.used -= os_heap_block_size(b);
+    os_heap_release(b);
+}
+
+static void *
+os_heap_realloc(void *ptr, size_t size)
+{
+    struct os_heap_block *b;
+    struct os_heap_block *next;
+    size_t cur;
+    size_t adj;
+    void *new_ptr;
+
+    if (ptr == NULL) {
+        return os_heap_malloc(size);
+    }
+    if (size == 0) {
+        os_heap_free(ptr);
+        return NULL;
+    }
+    if (size > OS_HEAP_BLOCK_SIZE_MAX / 2) {
+        return NULL;
+    }
+
+    b = os_heap_ptr_to_block(ptr);
+    assert(!(b->size & OS_HEAP_BLOCK_F_FREE));
+
+    cur = os_heap_block_size(b);
+    adj = os_heap_adjust_size(size);
+
+    if (adj > cur) {
+        /* Try to grow in place into the following block. */
+        next = os_heap_block_next(b);
+        if (!(next->size & OS_HEAP_BLOCK_F_FREE) ||
+            cur + OS_HEAP_BLOCK_OVERHEAD + os_heap_block_size(next) < adj) {
+
+            new_ptr = os_heap_malloc(size);
+            if (new_ptr != NULL) {
+                memcpy(new_ptr, ptr, cur);
+                os_heap_free(ptr);
+            }
+            return new_ptr;
+        }
+
+        os_heap_remove_block(next);
+        os_heap_block_set_size(b, cur + OS_HEAP_BLOCK_OVERHEAD +
+                                  os_heap_block_size(next));
+        os_heap_block_mark_used(b);
+    }
+
+    os_heap_trim(b, adj);
+
+    os_heap.used += os_heap_block_size(b) - cur;
+    if (os_heap.used > os_heap.used_max) {
+        os_heap.used_max = os_heap.used;
+    }
+
+    return ptr;
+}
+
+int
+os_heap_info_get(struct os_heap_info *info)
+{
+    struct os_heap_block *b;
+    size_t largest;
+    int fl;
+    int sl;
+
+    os_malloc_lock();
+
+    info->ohi_total = os_heap.total;
+    info->ohi_used = os_heap.used;
+    info->ohi_used_max = os_heap.used_max;
+    info->ohi_free = os_heap.free;
+    info->ohi_free_blocks = os_heap.free_blocks;
+
+    /* The largest free block is on the highest non-empty list. */
+    largest = 0;
+    if (os_heap.fl_map != 0) {
+        fl = os_heap_fls(os_heap.fl_map);
+        sl = os_heap_fls(os_heap.sl_map[fl]);
+        for (b = os_heap.blocks[fl][sl]; b != NULL; b = b->next_free) {
+            if (os_heap_block_size(b) > largest) {
+                largest = os_heap_block_size(b);
+            }
+        }
+    }
+    info->ohi_largest_free = largest;
+
+    os_malloc_unlock();
+
+    return 0;
+}
+
+void *
+os_malloc(size_t size)
+{
+    void *ptr;
+
+    os_malloc_lock();
+    ptr = os_heap_malloc(size);
+    if (ptr != NULL) {
+        OS_HEAP_STATS_INC(allocs);
+    } else {
+        OS_HEAP_STATS_INC(alloc_fails);
+    }
+    os_heap_stats_update();
+    os_malloc_unlock();
+
+    return ptr;
+}
+
+void
+os_free(void *mem)
+{
+    if (mem == NULL) {
+        return;
+    }
+
+    os_malloc_lock();
+    os_heap_free(mem);
+    OS_HEAP_STATS_INC(frees);
+    os_heap_stats_update();
+    os_malloc_unlock();
+}
+
+void *
+os_realloc(void *ptr, size_t size)
+{
+    void *new_ptr;
+
+    os_malloc_lock();
+    new_ptr = os_heap_realloc(ptr, size);
+    OS_HEAP_STATS_INC(reallocs);
+    if (new_ptr == NULL && size != 0) {
+        OS_HEAP_STATS_INC(alloc_fails);
+    }
+    os_heap_stats_update();
+    os_malloc_unlock();
+
+    return new_ptr;
+}
+
+#else
+
 void *
 os_malloc(size_t size)
 {
@@ -82,3 +765,4 @@ os_realloc(void *ptr, size_t size)
     return new_ptr;
 }
 
+#endif
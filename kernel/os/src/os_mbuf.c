@@ -115,6 +115,9 @@ os_mbuf_pool_init(struct os_mbuf_pool *omp, struct os_mempool *mp,
 {
     omp->omp_databuf_len = buf_len - sizeof(struct os_mbuf);
     omp->omp_pool = mp;
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    omp->omp_clone_pool = NULL;
+#endif
 
     return (0);
 }
@@ -143,6 +146,10 @@ os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
     om->om_len = 0;
     om->om_data = (&om->om_databuf[0] + leadingspace);
     om->om_omp = omp;
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    om->om_ref = NULL;
+    om->om_refcnt = 1;
+#endif
 
 done:
     os_trace_api_ret_u32(OS_TRACE_ID_MBUF_GET, (uint32_t)om);
@@ -182,15 +189,71 @@ done:
     return om;
 }
 
+/**
+ * Returns the pool that new data mbufs for the given mbuf's chain should come
+ * from.  A clone's own block may come from a clone pool, whose buffers are too
+ * small to hold data, so use the pool of the mbuf that owns the data.
+ */
+static inline struct os_mbuf_pool *
+os_mbuf_data_pool(const struct os_mbuf *om)
+{
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    if (om->om_ref != NULL) {
+        return om->om_ref->om_omp;
+    }
+#endif
+    return om->om_omp;
+}
+
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+/**
+ * Drops one reference to an mbuf's memory block, and returns the block to its
+ * pool if that was the last one.
+ */
+static int
+os_mbuf_release(struct os_mbuf *om)
+{
+    uint16_t refcnt;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    refcnt = --om->om_refcnt;
+    OS_EXIT_CRITICAL(sr);
+
+    if (refcnt != 0) {
+        return 0;
+    }
+
+    return os_memblock_put(om->om_omp->omp_pool, om);
+}
+#endif
+
 int
 os_mbuf_free(struct os_mbuf *om)
 {
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    int rc2;
+#endif
     int rc;
 
     os_trace_api_u32(OS_TRACE_ID_MBUF_FREE, (uint32_t)om);
 
     if (om->om_omp != NULL) {
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+        /* Release this mbuf's own block even if releasing the data it refers
+         * to fails; report the first error.
+         */
+        rc = 0;
+        if (om->om_ref != NULL) {
+            rc = os_mbuf_release(om->om_ref);
+        }
+        rc2 = os_mbuf_release(om);
+        if (rc == 0) {
+            rc = rc2;
+        }
+#else
         rc = os_memblock_put(om->om_omp->omp_pool, om);
+#endif
         if (rc != 0) {
             goto done;
         }
@@ -276,7 +339,7 @@ os_mbuf_append(struct os_mbuf *om, const void *data,  uint16_t len)
         goto err;
     }
 
-    omp = om->om_omp;
+    omp = os_mbuf_data_pool(om);
 
     /* Scroll to last mbuf in the chain */
     last = om;
@@ -371,7 +434,7 @@ os_mbuf_dup(struct os_mbuf *om)
     struct os_mbuf *head;
     struct os_mbuf *copy;
 
-    omp = om->om_omp;
+    omp = os_mbuf_data_pool(om);
 
     head = NULL;
     copy = NULL;
@@ -408,6 +471,121 @@ err:
     return (NULL);
 }
 
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+void
+os_mbuf_pool_set_clone_pool(struct os_mbuf_pool *omp,
+                            struct os_mbuf_pool *clone_omp)
+{
+    omp->omp_clone_pool = clone_omp;
+}
+
+struct os_mbuf *
+os_mbuf_clone(struct os_mbuf *om)
+{
+    struct os_mbuf_pool *omp;
+    struct os_mbuf *owner;
+    struct os_mbuf *head;
+    struct os_mbuf *copy;
+    struct os_mbuf *prev;
+    os_sr_t sr;
+
+    head = NULL;
+    prev = NULL;
+
+    for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
+        omp = os_mbuf_data_pool(om)->omp_clone_pool;
+        if (omp == NULL || omp->omp_databuf_len < om->om_pkthdr_len) {
+            omp = os_mbuf_data_pool(om);
+        }
+
+        copy = os_mbuf_get(omp, 0);
+        if (copy == NULL) {
+            os_mbuf_free_chain(head);
+            return NULL;
+        }
+
+        if (head == NULL) {
+            if (OS_MBUF_IS_PKTHDR(om)) {
+                _os_mbuf_copypkthdr(copy, om);
+            }
+            head = copy;
+        } else {
+            SLIST_NEXT(prev, om_next) = copy;
+        }
+        prev = copy;
+
+        /* Always refer to the mbuf that actually holds the data, so that
+         * clones of clones do not form chains of references.
+         */
+        owner = om->om_ref != NULL ? om->om_ref : om;
+
+        OS_ENTER_CRITICAL(sr);
+        owner->om_refcnt++;
+        OS_EXIT_CRITICAL(sr);
+
+        copy->om_ref = owner;
+        copy->om_flags = om->om_flags;
+        copy->om_data = om->om_data;
+        copy->om_len = om->om_len;
+    }
+
+    return head;
+}
+
+/**
+ * Gives an mbuf a private copy of its data, if the data is shared with any
+ * other mbuf, so that it can be modified in place.
+ */
+static int
+os_mbuf_unshare(struct os_mbuf *om)
+{
+    struct os_mbuf *owner;
+    struct os_mbuf *data_om;
+    uint8_t *dptr;
+
+    owner = om->om_ref != NULL ? om->om_ref : om;
+    if (owner->om_refcnt == 1) {
+        /* Sole user of the data. */
+        return 0;
+    }
+
+    if (om->om_ref != NULL && om->om_refcnt == 1 &&
+        om->om_omp->omp_databuf_len >= owner->om_omp->omp_databuf_len &&
+        om->om_omp->omp_databuf_len - om->om_pkthdr_len >= om->om_len) {
+
+        /* Nobody refers to this mbuf's own buffer, and it is a full data
+         * buffer rather than a clone pool header; move the data back in.
+         */
+        dptr = om->om_databuf + om->om_pkthdr_len;
+        memcpy(dptr, om->om_data, om->om_len);
+        om->om_data = dptr;
+        om->om_ref = NULL;
+    } else {
+        /* Move the data to a buffer of its own, which this mbuf holds the only
+         * reference to.
+         */
+        data_om = os_mbuf_get(owner->om_omp, 0);
+        if (data_om == NULL) {
+            return OS_ENOMEM;
+        }
+        memcpy(data_om->om_databuf, om->om_data, om->om_len);
+        om->om_data = data_om->om_databuf;
+        om->om_ref = data_om;
+        if (owner == om) {
+            return 0;
+        }
+    }
+
+    return os_mbuf_release(owner);
+}
+#else
+struct os_mbuf *
+os_mbuf_clone(struct os_mbuf *om)
+{
+    return os_mbuf_dup(om);
+}
+#endif
+
 struct os_mbuf *
 os_mbuf_off(const struct os_mbuf *om, int off, uint16_t *out_off)
 {
@@ -470,6 +648,97 @@ os_mbuf_copydata(const struct os_mbuf *m, int off, int len, void *dst)
     return (len > 0 ? -1 : 0);
 }
 
+int
+os_mbuf_iter_init(struct os_mbuf_iter *iter, const struct os_mbuf *om,
+                  int off, int len)
+{
+    uint16_t rel_off;
+
+    if (off < 0 || len < 0) {
+        return -1;
+    }
+
+    iter->omi_om = os_mbuf_off(om, off, &rel_off);
+    iter->omi_off = rel_off;
+    iter->omi_rem = len;
+
+    if (iter->omi_om == NULL) {
+        iter->omi_rem = 0;
+        return -1;
+    }
+
+    /* Make sure the chain holds the whole range up front, so that a caller
+     * never acts on part of the data before discovering it is short.
+     */
+    len += rel_off;
+    for (om = iter->omi_om; om != NULL && len > 0;
+         om = SLIST_NEXT(om, om_next)) {
+        len -= om->om_len;
+    }
+    if (len > 0) {
+        iter->omi_rem = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+int
+os_mbuf_iter_next(struct os_mbuf_iter *iter, struct os_mbuf_iovec *seg)
+{
+    const struct os_mbuf *om;
+    uint16_t len;
+
+    om = iter->omi_om;
+    while (iter->omi_rem > 0 && om != NULL) {
+        if (iter->omi_off < om->om_len) {
+            len = om->om_len - iter->omi_off;
+            if (len > iter->omi_rem) {
+                len = iter->omi_rem;
+            }
+
+            seg->omv_data = om->om_data + iter->omi_off;
+            seg->omv_len = len;
+
+            iter->omi_off += len;
+            iter->omi_rem -= len;
+            iter->omi_om = om;
+            return 0;
+        }
+
+        om = SLIST_NEXT(om, om_next);
+        iter->omi_om = om;
+        iter->omi_off = 0;
+    }
+
+    return OS_ENOENT;
+}
+
+int
+os_mbuf_to_iovec(const struct os_mbuf *om, int off, int len,
+                 struct os_mbuf_iovec *iov, int max_iov)
+{
+    struct os_mbuf_iter iter;
+    struct os_mbuf_iovec seg;
+    int cnt;
+    int rc;
+
+    rc = os_mbuf_iter_init(&iter, om, off, len);
+    if (rc != 0) {
+        return -1;
+    }
+
+    cnt = 0;
+    while (os_mbuf_iter_next(&iter, &seg) == 0) {
+        if (cnt < max_iov) {
+            iov[cnt] = seg;
+        }
+        cnt++;
+    }
+
+    return cnt;
+}
+
 void
 os_mbuf_adj(struct os_mbuf *mp, int req_len)
 {
@@ -665,10 +934,10 @@ os_mbuf_prepend(struct os_mbuf *om, int len)
 
         /* The current head didn't have enough space; allocate a new head. */
         if (OS_MBUF_IS_PKTHDR(om)) {
-            p = os_mbuf_get_pkthdr(om->om_omp,
+            p = os_mbuf_get_pkthdr(os_mbuf_data_pool(om),
                 om->om_pkthdr_len - sizeof (struct os_mbuf_pkthdr));
         } else {
-            p = os_mbuf_get(om->om_omp, 0);
+            p = os_mbuf_get(os_mbuf_data_pool(om), 0);
         }
         if (p == NULL) {
             os_mbuf_free_chain(om);
@@ -730,6 +999,12 @@ os_mbuf_copyinto(struct os_mbuf *om, int off, const void *src, int len)
     while (1) {
         copylen = min(cur->om_len - cur_off, len);
         if (copylen > 0) {
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+            rc = os_mbuf_unshare(cur);
+            if (rc != 0) {
+                return rc;
+            }
+#endif
             memcpy(cur->om_data + cur_off, sptr, copylen);
             sptr += copylen;
             len -= copylen;
@@ -807,9 +1082,11 @@ os_mbuf_extend(struct os_mbuf *om, uint16_t len)
 {
     struct os_mbuf *newm;
     struct os_mbuf *last;
+    struct os_mbuf_pool *omp;
     void *data;
 
-    if (len > om->om_omp->omp_databuf_len) {
+    omp = os_mbuf_data_pool(om);
+    if (len > omp->omp_databuf_len) {
         return NULL;
     }
 
@@ -820,7 +1097,7 @@ os_mbuf_extend(struct os_mbuf *om, uint16_t len)
     }
 
     if (OS_MBUF_TRAILINGSPACE(last) < len) {
-        newm = os_mbuf_get(om->om_omp, 0);
+        newm = os_mbuf_get(omp, 0);
         if (newm == NULL) {
             return NULL;
         }
@@ -849,7 +1126,7 @@ os_mbuf_pullup(struct os_mbuf *om, uint16_t len)
     int count;
     int space;
 
-    omp = om->om_omp;
+    omp = os_mbuf_data_pool(om);
 
     /*
      * If first mbuf has no cluster, and has room for len bytes
@@ -857,6 +1134,12 @@ os_mbuf_pullup(struct os_mbuf *om, uint16_t len)
      * otherwise allocate a new mbuf to prepend to the chain.
      */
     if (om->om_len >= len) {
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+        /* The caller may write to the data in place. */
+        if (OS_MBUF_IS_SHARED(om) && os_mbuf_unshare(om) != 0) {
+            goto bad;
+        }
+#endif
         return (om);
     }
     if (om->om_len + OS_MBUF_TRAILINGSPACE(om) >= len &&
@@ -990,7 +1273,7 @@ os_mbuf_widen(struct os_mbuf *om, uint16_t off, uint16_t len)
     first_new = NULL;
     prev = NULL;
     while (rem_len > 0) {
-        cur = os_mbuf_get(om->om_omp, 0);
+        cur = os_mbuf_get(os_mbuf_data_pool(om), 0);
         if (cur == NULL) {
             /* Free only the mbufs that this function allocated. */
             os_mbuf_free_chain(first_new);
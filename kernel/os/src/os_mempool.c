@@ -38,6 +38,152 @@
 
 STAILQ_HEAD(, os_mempool) g_os_mempool_list;
 
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || \
+    defined(__ARM_ARCH_8M_MAIN__)
+/*
+ * Load-exclusive / store-exclusive.  The store fails if the free list head
+ * was written, or if an exception was taken, since the load; this also
+ * rules out the ABA problem on pop.
+ */
+#define OS_MEMPOOL_LF_LLSC  (1)
+#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8) && __SIZEOF_POINTER__ == 4
+/*
+ * Double-word compare-and-swap of the free list head and a generation count
+ * that is incremented on every update, so that a pop racing with a pop/push
+ * sequence of the same block cannot succeed (ABA).
+ */
+#define OS_MEMPOOL_LF_DCAS  (1)
+#endif
+#endif
+
+#if defined(OS_MEMPOOL_LF_LLSC)
+
+static inline uint32_t
+os_mempool_ldrex(volatile uint32_t *addr)
+{
+    uint32_t val;
+
+    __asm__ volatile ("ldrex %0, [%1]" : "=r" (val) : "r" (addr) : "memory");
+    return val;
+}
+
+static inline uint32_t
+os_mempool_strex(uint32_t val, volatile uint32_t *addr)
+{
+    uint32_t rc;
+
+    __asm__ volatile ("strex %0, %2, [%1]"
+                      : "=&r" (rc) : "r" (addr), "r" (val) : "memory");
+    return rc;
+}
+
+static inline void
+os_mempool_clrex(void)
+{
+    __asm__ volatile ("clrex" ::: "memory");
+}
+
+static struct os_memblock *
+os_mempool_lf_pop(struct os_mempool *mp)
+{
+    volatile uint32_t *head;
+    struct os_memblock *block;
+
+    head = (volatile uint32_t *)&SLIST_FIRST(mp);
+    do {
+        block = (struct os_memblock *)os_mempool_ldrex(head);
+        if (block == NULL) {
+            os_mempool_clrex();
+            return NULL;
+        }
+    } while (os_mempool_strex((uint32_t)SLIST_NEXT(block, mb_next), head));
+
+    return block;
+}
+
+static void
+os_mempool_lf_push(struct os_mempool *mp, struct os_memblock *block)
+{
+    volatile uint32_t *head;
+
+    head = (volatile uint32_t *)&SLIST_FIRST(mp);
+    do {
+        SLIST_NEXT(block, mb_next) =
+            (struct os_memblock *)os_mempool_ldrex(head);
+    } while (os_mempool_strex((uint32_t)block, head));
+}
+
+#elif defined(OS_MEMPOOL_LF_DCAS)
+
+static struct os_memblock *
+os_mempool_lf_pop(struct os_mempool *mp)
+{
+    struct os_mempool old;
+    struct os_mempool new;
+
+    old.mp_head_word = __atomic_load_n(&mp->mp_head_word, __ATOMIC_ACQUIRE);
+    do {
+        if (SLIST_FIRST(&old) == NULL) {
+            return NULL;
+        }
+        /* The block may already have been taken by someone else, in which
+         * case this reads garbage; the generation count makes the swap fail.
+         */
+        SLIST_FIRST(&new) = SLIST_NEXT(SLIST_FIRST(&old), mb_next);
+        new.mp_head_gen = old.mp_head_gen + 1;
+    } while (!__atomic_compare_exchange_n(&mp->mp_head_word,
+                                          &old.mp_head_word, new.mp_head_word,
+                                          0, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE));
+
+    return SLIST_FIRST(&old);
+}
+
+static void
+os_mempool_lf_push(struct os_mempool *mp, struct os_memblock *block)
+{
+    struct os_mempool old;
+    struct os_mempool new;
+
+    old.mp_head_word = __atomic_load_n(&mp->mp_head_word, __ATOMIC_ACQUIRE);
+    do {
+        SLIST_NEXT(block, mb_next) = SLIST_FIRST(&old);
+        SLIST_FIRST(&new) = block;
+        new.mp_head_gen = old.mp_head_gen + 1;
+    } while (!__atomic_compare_exchange_n(&mp->mp_head_word,
+                                          &old.mp_head_word, new.mp_head_word,
+                                          0, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE));
+}
+
+#endif
+
+#if defined(OS_MEMPOOL_LF_LLSC) || defined(OS_MEMPOOL_LF_DCAS)
+/*
+ * The free counter is incremented before a block is pushed and decremented
+ * after one is popped, so that it never drops below the actual number of
+ * blocks on the free list.
+ */
+static void
+os_mempool_lf_num_free_dec(struct os_mempool *mp)
+{
+    uint16_t num_free;
+    uint16_t min_free;
+
+    num_free = __atomic_sub_fetch(&mp->mp_num_free, 1, __ATOMIC_RELAXED);
+
+    min_free = __atomic_load_n(&mp->mp_min_free, __ATOMIC_RELAXED);
+    while (num_free < min_free) {
+        if (__atomic_compare_exchange_n(&mp->mp_min_free, &min_free, num_free,
+                                        0, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+}
+#endif
+
 #if MYNEWT_VAL(OS_MEMPOOL_POISON)
 static uint32_t os_mem_poison = 0xde7ec7ed;
 
@@ -336,6 +482,13 @@ os_memblock_get(struct os_mempool *mp)
     /* Check to make sure they passed in a memory pool (or something) */
     block = NULL;
     if (mp) {
+#if defined(OS_MEMPOOL_LF_LLSC) || defined(OS_MEMPOOL_LF_DCAS)
+        (void)sr;
+        block = os_mempool_lf_pop(mp);
+        if (block) {
+            os_mempool_lf_num_free_dec(mp);
+        }
+#else
         OS_ENTER_CRITICAL(sr);
         /* Check for any free */
         if (mp->mp_num_free) {
@@ -352,6 +505,7 @@ os_memblock_get(struct os_mempool *mp)
             }
         }
         OS_EXIT_CRITICAL(sr);
+#endif
 
         if (block) {
             os_mempool_poison_check(mp, block);
@@ -377,6 +531,11 @@ os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
     os_mempool_poison(mp, block_addr);
 
     block = (struct os_memblock *)block_addr;
+#if defined(OS_MEMPOOL_LF_LLSC) || defined(OS_MEMPOOL_LF_DCAS)
+    (void)sr;
+    __atomic_add_fetch(&mp->mp_num_free, 1, __ATOMIC_RELAXED);
+    os_mempool_lf_push(mp, block);
+#else
     OS_ENTER_CRITICAL(sr);
 
     /* Chain current free list pointer to this block; make this block head */
@@ -388,6 +547,7 @@ os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
     mp->mp_num_free++;
 
     OS_EXIT_CRITICAL(sr);
+#endif
 
     os_trace_api_ret_u32(OS_TRACE_ID_MEMBLOCK_PUT_FROM_CB, (uint32_t)OS_OK);
 
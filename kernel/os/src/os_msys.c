@@ -25,6 +25,17 @@
 static STAILQ_HEAD(, os_mbuf_pool) g_msys_pool_list =
     STAILQ_HEAD_INITIALIZER(g_msys_pool_list);
 
+/*
+ * Size class n covers data sizes in (2^(n-1), 2^n]; class 0 covers sizes 0
+ * and 1.  Each entry points to the smallest registered pool whose buffers are
+ * larger than the lower bound of the class, so a best-fit lookup only has to
+ * step past pools that fall inside the class itself.  NULL means no pool is
+ * large enough.
+ */
+#define OS_MSYS_SIZE_CLASSES    (17)
+
+static struct os_mbuf_pool *os_msys_size_class[OS_MSYS_SIZE_CLASSES];
+
 #if MYNEWT_VAL(MSYS_1_BLOCK_COUNT) > 0
 #define SYSINIT_MSYS_1_MEMBLOCK_SIZE                \
     OS_ALIGN(MYNEWT_VAL(MSYS_1_BLOCK_SIZE), 4)
@@ -55,6 +66,33 @@ static struct os_mempool os_msys_2_mempool;
 static struct os_sanity_check os_msys_sc;
 #endif
 
+static int
+os_msys_size_class_idx(uint16_t dsize)
+{
+    if (dsize <= 1) {
+        return 0;
+    }
+
+    return 32 - __builtin_clz(dsize - 1);
+}
+
+static void
+os_msys_size_class_build(void)
+{
+    struct os_mbuf_pool *pool;
+    uint32_t min_len;
+    int i;
+
+    pool = STAILQ_FIRST(&g_msys_pool_list);
+    for (i = 0; i < OS_MSYS_SIZE_CLASSES; i++) {
+        min_len = i == 0 ? 0 : (1 << (i - 1)) + 1;
+        while (pool != NULL && pool->omp_databuf_len < min_len) {
+            pool = STAILQ_NEXT(pool, omp_next);
+        }
+        os_msys_size_class[i] = pool;
+    }
+}
+
 int
 os_msys_register(struct os_mbuf_pool *new_pool)
 {
@@ -77,6 +115,8 @@ os_msys_register(struct os_mbuf_pool *new_pool)
         STAILQ_INSERT_HEAD(&g_msys_pool_list, new_pool, omp_next);
     }
 
+    os_msys_size_class_build();
+
     return (0);
 }
 
@@ -84,6 +124,7 @@ void
 os_msys_reset(void)
 {
     STAILQ_INIT(&g_msys_pool_list);
+    os_msys_size_class_build();
 }
 
 static struct os_mbuf_pool *
@@ -98,11 +139,9 @@ os_msys_find_pool(uint16_t dsize)
 {
     struct os_mbuf_pool *pool;
 
-    pool = NULL;
-    STAILQ_FOREACH(pool, &g_msys_pool_list, omp_next) {
-        if (dsize <= pool->omp_databuf_len) {
-            break;
-        }
+    pool = os_msys_size_class[os_msys_size_class_idx(dsize)];
+    while (pool != NULL && dsize > pool->omp_databuf_len) {
+        pool = STAILQ_NEXT(pool, omp_next);
     }
 
     if (!pool) {
@@ -112,7 +151,6 @@ os_msys_find_pool(uint16_t dsize)
     return (pool);
 }
 
-
 struct os_mbuf *
 os_msys_get(uint16_t dsize, uint16_t leadingspace)
 {
@@ -133,6 +171,11 @@ os_msys_get(uint16_t dsize, uint16_t leadingspace)
     }
 
     m = os_mbuf_get(pool, leadingspace);
+#if MYNEWT_VAL(MSYS_SPILL_TO_LARGER)
+    while (m == NULL && (pool = STAILQ_NEXT(pool, omp_next)) != NULL) {
+        m = os_mbuf_get(pool, leadingspace);
+    }
+#endif
     return (m);
 err:
     return (NULL);
@@ -161,11 +204,62 @@ os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len)
     }
 
     m = os_mbuf_get_pkthdr(pool, user_hdr_len);
+#if MYNEWT_VAL(MSYS_SPILL_TO_LARGER)
+    while (m == NULL && (pool = STAILQ_NEXT(pool, omp_next)) != NULL) {
+        m = os_mbuf_get_pkthdr(pool, user_hdr_len);
+    }
+#endif
     return (m);
 err:
     return (NULL);
 }
 
+struct os_mbuf *
+os_msys_get_chain(uint16_t total_len, uint16_t user_hdr_len)
+{
+    struct os_mbuf *head;
+    struct os_mbuf *prev;
+    struct os_mbuf *m;
+    uint16_t space;
+    uint16_t rem;
+
+    /* An empty request still needs a packet header. */
+    head = os_msys_get_pkthdr(total_len ? total_len : 1, user_hdr_len);
+    if (!head) {
+        return (NULL);
+    }
+
+    rem = total_len;
+    prev = NULL;
+    m = head;
+    while (1) {
+        space = OS_MBUF_TRAILINGSPACE(m);
+        if (space > rem) {
+            space = rem;
+        }
+        m->om_len = space;
+        rem -= space;
+
+        if (prev) {
+            SLIST_NEXT(prev, om_next) = m;
+        }
+        if (rem == 0) {
+            break;
+        }
+
+        prev = m;
+        m = os_msys_get(rem, 0);
+        if (!m) {
+            os_mbuf_free_chain(head);
+            return (NULL);
+        }
+    }
+
+    OS_MBUF_PKTHDR(head)->omp_len = total_len;
+
+    return (head);
+}
+
 int
 os_msys_count(void)
 {
@@ -93,8 +93,7 @@ os_mutex_release(struct os_mutex *mu)
 
     /* Restore owner task's priority; resort list if different  */
     if (current->t_prio != mu->mu_prio) {
-        current->t_prio = mu->mu_prio;
-        os_sched_resort(current);
+        os_sched_set_prio(current, mu->mu_prio);
     }
 
     /* Check if tasks are waiting for the mutex */
@@ -190,8 +189,7 @@ os_mutex_pend(struct os_mutex *mu, os_time_t timeout)
 
     /* Change priority of owner if needed */
     if (mu->mu_owner->t_prio > current->t_prio) {
-        mu->mu_owner->t_prio = current->t_prio;
-        os_sched_resort(mu->mu_owner);
+        os_sched_set_prio(mu->mu_owner, current->t_prio);
     }
 
     /* Link current task to tasks waiting for mutex */
@@ -32,11 +32,16 @@ extern "C" {
 #define OS_RUN_UNPRIV       (1)
 
 extern struct os_task g_idle_task;
+#if !MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
 extern struct os_task_list g_os_run_list;
+#endif
 extern struct os_task_list g_os_sleep_list;
 extern struct os_task_stailq g_os_task_list;
+#if !MYNEWT_VAL(OS_CALLOUT_WHEEL)
 extern struct os_callout_list g_callout_list;
+#endif
 
+void os_callout_module_init(void);
 void os_mempool_module_init(void);
 void os_msys_init(void);
 
@@ -18,17 +18,342 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "os/mynewt.h"
 #include "os_priv.h"
 
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+/*
+ * Ready tasks are kept in one FIFO list per priority.  Priorities with at
+ * least one ready task are tracked in a two-level bitmap: bit (31 - n) of
+ * os_sched_prio_map[w] is set if priority (w * 32 + n) is non-empty, and bit
+ * (31 - w) of os_sched_prio_grp is set if os_sched_prio_map[w] is non-zero.
+ * The highest priority ready task is then found with two count-leading-zeros
+ * operations.
+ */
+#define OS_SCHED_PRIO_CNT       (256)
+#define OS_SCHED_PRIO_WORDS     (OS_SCHED_PRIO_CNT / 32)
+
+static struct os_task_list os_sched_prio_list[OS_SCHED_PRIO_CNT];
+static uint32_t os_sched_prio_map[OS_SCHED_PRIO_WORDS];
+static uint32_t os_sched_prio_grp;
+#else
 struct os_task_list g_os_run_list = TAILQ_HEAD_INITIALIZER(g_os_run_list);
+#endif
 struct os_task_list g_os_sleep_list = TAILQ_HEAD_INITIALIZER(g_os_sleep_list);
 
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+/*
+ * Tasks sleeping with a timeout are kept in a pairing heap keyed on
+ * t_next_wakeup; g_os_sleep_list then only holds tasks sleeping forever.
+ */
+static struct os_task *os_sched_sleep_heap;
+#endif
+
+#if MYNEWT_VAL(OS_SCHED_TIMER_EXP_MONITOR)
+struct os_sched_timer_mon g_os_sched_timer_mon;
+#endif
+
 struct os_task *g_current_task;
 
 extern os_time_t g_os_time;
 os_time_t g_os_last_ctx_sw_time;
 
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+
+static void
+os_sched_run_list_insert(struct os_task *t)
+{
+    uint8_t prio;
+
+    prio = t->t_prio;
+    TAILQ_INSERT_TAIL(&os_sched_prio_list[prio], t, t_os_list);
+    os_sched_prio_map[prio >> 5] |= 0x80000000UL >> (prio & 0x1f);
+    os_sched_prio_grp |= 0x80000000UL >> (prio >> 5);
+}
+
+static void
+os_sched_run_list_remove(struct os_task *t)
+{
+    uint8_t prio;
+
+    prio = t->t_prio;
+    TAILQ_REMOVE(&os_sched_prio_list[prio], t, t_os_list);
+    if (TAILQ_EMPTY(&os_sched_prio_list[prio])) {
+        os_sched_prio_map[prio >> 5] &= ~(0x80000000UL >> (prio & 0x1f));
+        if (os_sched_prio_map[prio >> 5] == 0) {
+            os_sched_prio_grp &= ~(0x80000000UL >> (prio >> 5));
+        }
+    }
+}
+
+/**
+ * Finds the priority whose ready list holds a task, regardless of the
+ * task's current t_prio.  Only the priorities flagged in the bitmap are
+ * visited, so the cost is bounded by the number of ready tasks.
+ *
+ * @return                      The priority, or -1 if the task is not ready.
+ */
+static int
+os_sched_run_list_find_prio(const struct os_task *t)
+{
+    const struct os_task *entry;
+    uint32_t grp;
+    uint32_t map;
+    uint32_t word;
+    uint32_t bit;
+    int prio;
+
+    grp = os_sched_prio_grp;
+    while (grp != 0) {
+        word = __builtin_clz(grp);
+        grp &= ~(0x80000000UL >> word);
+
+        map = os_sched_prio_map[word];
+        while (map != 0) {
+            bit = __builtin_clz(map);
+            map &= ~(0x80000000UL >> bit);
+
+            prio = (word << 5) + bit;
+            TAILQ_FOREACH(entry, &os_sched_prio_list[prio], t_os_list) {
+                if (entry == t) {
+                    return prio;
+                }
+            }
+        }
+    }
+
+    return -1;
+}
+
+static struct os_task *
+os_sched_run_list_first(void)
+{
+    uint32_t word;
+    uint32_t bit;
+
+    if (os_sched_prio_grp == 0) {
+        return NULL;
+    }
+
+    word = __builtin_clz(os_sched_prio_grp);
+    bit = __builtin_clz(os_sched_prio_map[word]);
+
+    return TAILQ_FIRST(&os_sched_prio_list[(word << 5) + bit]);
+}
+
+#else
+
+static void
+os_sched_run_list_insert(struct os_task *t)
+{
+    struct os_task *entry;
+
+    TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
+        if (t->t_prio < entry->t_prio) {
+            break;
+        }
+    }
+    if (entry) {
+        TAILQ_INSERT_BEFORE(entry, t, t_os_list);
+    } else {
+        TAILQ_INSERT_TAIL(&g_os_run_list, t, t_os_list);
+    }
+}
+
+static void
+os_sched_run_list_remove(struct os_task *t)
+{
+    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+}
+
+static struct os_task *
+os_sched_run_list_first(void)
+{
+    return TAILQ_FIRST(&g_os_run_list);
+}
+
+#endif
+
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+
+/**
+ * Melds two detached heaps; the root with the later wakeup time becomes the
+ * first child of the other one.
+ */
+static struct os_task *
+os_sched_heap_meld(struct os_task *a, struct os_task *b)
+{
+    struct os_task *tmp;
+
+    if (a == NULL) {
+        return b;
+    }
+    if (b == NULL) {
+        return a;
+    }
+
+    if (OS_TIME_TICK_LT(b->t_next_wakeup, a->t_next_wakeup)) {
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    b->t_sleep_prev = a;
+    b->t_sleep_next = a->t_sleep_child;
+    if (a->t_sleep_child != NULL) {
+        a->t_sleep_child->t_sleep_prev = b;
+    }
+    a->t_sleep_child = b;
+
+    return a;
+}
+
+/**
+ * Combines a list of sibling heaps into a single heap, using the standard
+ * two-pass pairing: meld pairs left to right, then meld the results right to
+ * left.
+ */
+static struct os_task *
+os_sched_heap_merge_pairs(struct os_task *first)
+{
+    struct os_task *pairs;
+    struct os_task *root;
+    struct os_task *next;
+    struct os_task *a;
+    struct os_task *b;
+
+    pairs = NULL;
+    while (first != NULL) {
+        a = first;
+        b = a->t_sleep_next;
+        next = b != NULL ? b->t_sleep_next : NULL;
+
+        a->t_sleep_next = NULL;
+        a->t_sleep_prev = NULL;
+        if (b != NULL) {
+            b->t_sleep_next = NULL;
+            b->t_sleep_prev = NULL;
+        }
+
+        /* Push the melded pair on a stack threaded through t_sleep_next. */
+        a = os_sched_heap_meld(a, b);
+        a->t_sleep_next = pairs;
+        pairs = a;
+
+        first = next;
+    }
+
+    root = NULL;
+    while (pairs != NULL) {
+        next = pairs->t_sleep_next;
+        pairs->t_sleep_next = NULL;
+        root = os_sched_heap_meld(root, pairs);
+        pairs = next;
+    }
+
+    return root;
+}
+
+static void
+os_sched_heap_insert(struct os_task *t)
+{
+    t->t_sleep_child = NULL;
+    t->t_sleep_next = NULL;
+    t->t_sleep_prev = NULL;
+    os_sched_sleep_heap = os_sched_heap_meld(os_sched_sleep_heap, t);
+}
+
+static void
+os_sched_heap_remove(struct os_task *t)
+{
+    struct os_task *sub;
+
+    if (t == os_sched_sleep_heap) {
+        os_sched_sleep_heap = os_sched_heap_merge_pairs(t->t_sleep_child);
+    } else {
+        /* Unlink from the parent's child list. */
+        if (t->t_sleep_prev->t_sleep_child == t) {
+            t->t_sleep_prev->t_sleep_child = t->t_sleep_next;
+        } else {
+            t->t_sleep_prev->t_sleep_next = t->t_sleep_next;
+        }
+        if (t->t_sleep_next != NULL) {
+            t->t_sleep_next->t_sleep_prev = t->t_sleep_prev;
+        }
+
+        sub = os_sched_heap_merge_pairs(t->t_sleep_child);
+        os_sched_sleep_heap = os_sched_heap_meld(os_sched_sleep_heap, sub);
+    }
+
+    t->t_sleep_child = NULL;
+    t->t_sleep_next = NULL;
+    t->t_sleep_prev = NULL;
+}
+
+#endif
+
+static void
+os_sched_sleep_list_remove(struct os_task *t)
+{
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    if (!(t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
+        os_sched_heap_remove(t);
+        return;
+    }
+#endif
+    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+}
+
+/**
+ * Returns the sleeping task with the earliest wakeup time, or NULL if no task
+ * is sleeping with a timeout.
+ */
+static struct os_task *
+os_sched_sleep_list_first(void)
+{
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    return os_sched_sleep_heap;
+#else
+    struct os_task *t;
+
+    t = TAILQ_FIRST(&g_os_sleep_list);
+    if (t == NULL || (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
+        return NULL;
+    }
+    return t;
+#endif
+}
+
+/**
+ * os sched init
+ *
+ * Empties the run and sleep lists.  Called by os_init() before any task is
+ * created.
+ */
+void
+os_sched_init(void)
+{
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+    int i;
+
+    for (i = 0; i < OS_SCHED_PRIO_CNT; i++) {
+        TAILQ_INIT(&os_sched_prio_list[i]);
+    }
+    memset(os_sched_prio_map, 0, sizeof os_sched_prio_map);
+    os_sched_prio_grp = 0;
+#else
+    TAILQ_INIT(&g_os_run_list);
+#endif
+    TAILQ_INIT(&g_os_sleep_list);
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    os_sched_sleep_heap = NULL;
+#endif
+#if MYNEWT_VAL(OS_SCHED_TIMER_EXP_MONITOR)
+    memset(&g_os_sched_timer_mon, 0, sizeof g_os_sched_timer_mon);
+#endif
+}
+
 /**
  * os sched insert
  *
@@ -43,7 +368,6 @@ os_time_t g_os_last_ctx_sw_time;
 os_error_t
 os_sched_insert(struct os_task *t)
 {
-    struct os_task *entry;
     os_sr_t sr;
     os_error_t rc;
 
@@ -52,18 +376,8 @@ os_sched_insert(struct os_task *t)
         goto err;
     }
 
-    entry = NULL;
     OS_ENTER_CRITICAL(sr);
-    TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
-        if (t->t_prio < entry->t_prio) {
-            break;
-        }
-    }
-    if (entry) {
-        TAILQ_INSERT_BEFORE(entry, (struct os_task *) t, t_os_list);
-    } else {
-        TAILQ_INSERT_TAIL(&g_os_run_list, (struct os_task *) t, t_os_list);
-    }
+    os_sched_run_list_insert(t);
     OS_EXIT_CRITICAL(sr);
 
     return (0);
@@ -148,17 +462,22 @@ os_sched(struct os_task *next_t)
 int
 os_sched_sleep(struct os_task *t, os_time_t nticks)
 {
+#if !MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
     struct os_task *entry;
 
     entry = NULL;
+#endif
 
-    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+    os_sched_run_list_remove(t);
     t->t_state = OS_TASK_SLEEP;
     t->t_next_wakeup = os_time_get() + nticks;
     if (nticks == OS_TIMEOUT_NEVER) {
         t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
         TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
     } else {
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+        os_sched_heap_insert(t);
+#else
         TAILQ_FOREACH(entry, &g_os_sleep_list, t_os_list) {
             if ((entry->t_flags & OS_TASK_FLAG_NO_TIMEOUT) ||
                     OS_TIME_TICK_GT(entry->t_next_wakeup, t->t_next_wakeup)) {
@@ -170,6 +489,7 @@ os_sched_sleep(struct os_task *t, os_time_t nticks)
         } else {
             TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
         }
+#endif
     }
 
     os_trace_task_stop_ready(t, OS_TASK_SLEEP);
@@ -194,9 +514,9 @@ os_sched_remove(struct os_task *t)
 {
 
     if (t->t_state == OS_TASK_SLEEP) {
-        TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+        os_sched_sleep_list_remove(t);
     } else if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_run_list_remove(t);
     }
     t->t_next_wakeup = 0;
     t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
@@ -236,10 +556,10 @@ os_sched_wakeup(struct os_task *t)
     }
 
     /* Remove task from sleep list */
+    os_sched_sleep_list_remove(t);
     t->t_state = OS_TASK_READY;
     t->t_next_wakeup = 0;
     t->t_flags &= ~OS_TASK_FLAG_NO_TIMEOUT;
-    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
     os_sched_insert(t);
 
     os_trace_task_start_ready(t);
@@ -260,32 +580,53 @@ void
 os_sched_os_timer_exp(void)
 {
     struct os_task *t;
-    struct os_task *next;
     os_time_t now;
     os_sr_t sr;
+#if MYNEWT_VAL(OS_SCHED_TIMER_EXP_MONITOR)
+    uint32_t woken;
+    uint32_t ticks;
+#endif
 
     now = os_time_get();
 
     OS_ENTER_CRITICAL(sr);
 
+#if MYNEWT_VAL(OS_SCHED_TIMER_EXP_MONITOR)
+    woken = 0;
+    ticks = os_cputime_get32();
+#endif
+
     /*
-     * Wakeup any tasks that have their sleep timer expired
+     * Wakeup any tasks that have their sleep timer expired.  Tasks waiting
+     * forever are never returned by os_sched_sleep_list_first().
      */
-    t = TAILQ_FIRST(&g_os_sleep_list);
-    while (t) {
-        /* If task waiting forever, do not check next wakeup time */
-        if (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT) {
-            break;
-        }
-        next = TAILQ_NEXT(t, t_os_list);
-        if (OS_TIME_TICK_GEQ(now, t->t_next_wakeup)) {
-            os_sched_wakeup(t);
-        } else {
+    while ((t = os_sched_sleep_list_first()) != NULL) {
+        if (!OS_TIME_TICK_GEQ(now, t->t_next_wakeup)) {
             break;
         }
-        t = next;
+        os_sched_wakeup(t);
+#if MYNEWT_VAL(OS_SCHED_TIMER_EXP_MONITOR)
+        woken++;
+#endif
     }
 
+#if MYNEWT_VAL(OS_SCHED_TIMER_EXP_MONITOR)
+    ticks = os_cputime_get32() - ticks;
+
+    g_os_sched_timer_mon.stm_cnt++;
+    g_os_sched_timer_mon.stm_cum += ticks;
+    if (g_os_sched_timer_mon.stm_cnt == 1 ||
+        ticks < g_os_sched_timer_mon.stm_min) {
+        g_os_sched_timer_mon.stm_min = ticks;
+    }
+    if (ticks > g_os_sched_timer_mon.stm_max) {
+        g_os_sched_timer_mon.stm_max = ticks;
+    }
+    if (woken > g_os_sched_timer_mon.stm_woken_max) {
+        g_os_sched_timer_mon.stm_woken_max = woken;
+    }
+#endif
+
     OS_EXIT_CRITICAL(sr);
 }
 
@@ -301,8 +642,8 @@ os_sched_wakeup_ticks(os_time_t now)
 
     OS_ASSERT_CRITICAL();
 
-    t = TAILQ_FIRST(&g_os_sleep_list);
-    if (t == NULL || (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
+    t = os_sched_sleep_list_first();
+    if (t == NULL) {
         rt = OS_TIMEOUT_NEVER;
     } else if (OS_TIME_TICK_GEQ(t->t_next_wakeup, now)) {
         rt = t->t_next_wakeup - now;
@@ -316,7 +657,8 @@ os_sched_wakeup_ticks(os_time_t now)
  * os sched next task
  *
  * Returns the task that we should be running. This is the task at the head
- * of the run list.
+ * of the run list (or of the highest priority non-empty run list when
+ * OS_SCHED_PRIO_BITMAP is enabled).
  *
  * NOTE: if you want to guarantee that the os run list does not change after
  * calling this function you have to call it with interrupts disabled.
@@ -326,7 +668,7 @@ os_sched_wakeup_ticks(os_time_t now)
 struct os_task *
 os_sched_next_task(void)
 {
-    return (TAILQ_FIRST(&g_os_run_list));
+    return (os_sched_run_list_first());
 }
 
 /**
@@ -345,8 +687,51 @@ os_sched_next_task(void)
 void
 os_sched_resort(struct os_task *t)
 {
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+    uint8_t prio;
+    int old_prio;
+#endif
+
     if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+        /* The task is still queued at its old priority, which is unknown
+         * here; look for it in the non-empty ready lists.
+         */
+        prio = t->t_prio;
+        old_prio = os_sched_run_list_find_prio(t);
+        assert(old_prio >= 0);
+        t->t_prio = old_prio;
+        os_sched_run_list_remove(t);
+        t->t_prio = prio;
+#else
+        os_sched_run_list_remove(t);
+#endif
         os_sched_insert(t);
     }
 }
+
+/**
+ * os sched set prio
+ *
+ * Changes the priority of a task.  If the task is ready to run, it is moved
+ * to its new position in the run list.  Prefer this over changing t_prio and
+ * calling os_sched_resort(), as the run list can then be updated without a
+ * search.
+ *
+ * @param t     Pointer to task whose priority is changing.
+ * @param prio  New priority of the task.
+ *
+ * NOTE: this function expects interrupts to be disabled so they
+ * are not disabled here.
+ */
+void
+os_sched_set_prio(struct os_task *t, uint8_t prio)
+{
+    if (t->t_state == OS_TASK_READY) {
+        os_sched_run_list_remove(t);
+        t->t_prio = prio;
+        os_sched_run_list_insert(t);
+    } else {
+        t->t_prio = prio;
+    }
+}
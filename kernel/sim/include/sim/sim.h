@@ -48,6 +48,37 @@ void sim_restore_sr(os_sr_t osr);
 int sim_in_critical(void);
 void sim_tick_idle(os_time_t ticks);
 
+/**
+ * Counts how often the simulated CPU comes out of idle, as a stand-in for
+ * the power drawn by a real target.
+ */
+struct sim_wakeup_stats {
+    /** Number of times the idle task woke up. */
+    uint32_t sws_wakeups;
+    /** Number of those wakeups that ended a tickless sleep. */
+    uint32_t sws_tickless;
+    /** OS time at which the counters were last reset. */
+    os_time_t sws_since;
+};
+
+/**
+ * Reads the wakeup counters.
+ *
+ * @param out                   Receives the current counters.
+ */
+void sim_wakeup_stats_get(struct sim_wakeup_stats *out);
+
+/**
+ * Clears the wakeup counters and restarts the measurement period.
+ */
+void sim_wakeup_stats_reset(void);
+
+/**
+ * Returns the average number of idle wakeups per second since the counters
+ * were last reset.
+ */
+uint32_t sim_wakeups_per_sec(void);
+
 /**
  * Prints information about a crash to stdout.  This functionality is defined
  * as a macro rather than a function to ensure that it gets inlined, enforcing
@@ -45,6 +45,8 @@
 
 pid_t sim_pid;
 
+static struct sim_wakeup_stats sim_wakeup_stats;
+
 void
 sim_switch_tasks(void)
 {
@@ -235,8 +237,7 @@ sim_os_init(void)
     g_current_task = NULL;
 
     STAILQ_INIT(&g_os_task_list);
-    TAILQ_INIT(&g_os_run_list);
-    TAILQ_INIT(&g_os_sleep_list);
+    os_sched_init();
 
     sim_signals_init();
 
@@ -244,3 +245,58 @@ sim_os_init(void)
 
     return OS_OK;
 }
+
+/**
+ * Called by sim_tick_idle() each time the idle task wakes up.
+ *
+ * @param ticks                 The number of ticks the idle task asked to
+ *                                  sleep for; 0 if it waited for the next
+ *                                  periodic tick.
+ */
+void
+sim_wakeup_record(os_time_t ticks)
+{
+    OS_ASSERT_CRITICAL();
+
+    sim_wakeup_stats.sws_wakeups++;
+    if (ticks > 0) {
+        sim_wakeup_stats.sws_tickless++;
+    }
+}
+
+void
+sim_wakeup_stats_get(struct sim_wakeup_stats *out)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    *out = sim_wakeup_stats;
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+sim_wakeup_stats_reset(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    memset(&sim_wakeup_stats, 0, sizeof sim_wakeup_stats);
+    sim_wakeup_stats.sws_since = os_time_get();
+    OS_EXIT_CRITICAL(sr);
+}
+
+uint32_t
+sim_wakeups_per_sec(void)
+{
+    struct sim_wakeup_stats stats;
+    os_time_t elapsed;
+
+    sim_wakeup_stats_get(&stats);
+
+    elapsed = os_time_get() - stats.sws_since;
+    if (elapsed == 0) {
+        return 0;
+    }
+
+    return (uint64_t)stats.sws_wakeups * OS_TICKS_PER_SEC / elapsed;
+}
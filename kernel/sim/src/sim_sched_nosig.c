@@ -178,6 +178,7 @@ sim_tick_idle(os_time_t ticks)
     sigsuspend(&nosigs);        /* Wait for a signal to wake us up */
 
     block_timer();
+    sim_wakeup_record(ticks);
 
     /*
      * Call handlers for signals delivered to the process during sigsuspend().
@@ -188,6 +188,7 @@ sim_tick_idle(os_time_t ticks)
     sigemptyset(&suspsigs);
     sigsuspend(&nosigs);        /* Wait for a signal to wake us up */
     suspended = false;
+    sim_wakeup_record(ticks);
 
     /*
      * Call handlers for signals delivered to the process during sigsuspend().
@@ -37,6 +37,9 @@
 
 #include "native_sock_priv.h"
 
+/* Maximum number of mbuf segments handed to a single sendmsg() call. */
+#define NATIVE_SOCK_MAX_IOV     16
+
 static struct native_sock {
     struct mn_socket ns_sock;
     int ns_fd;
@@ -524,8 +527,13 @@ native_sock_sendto(struct mn_socket *s, struct os_mbuf *m,
     struct sockaddr_storage ss;
     struct sockaddr *sa = (struct sockaddr *)&ss;
     uint8_t tmpbuf[MYNEWT_VAL(NATIVE_SOCKETS_MAX_UDP)];
-    struct os_mbuf *o;
+    struct iovec iov[NATIVE_SOCK_MAX_IOV];
+    struct os_mbuf_iovec seg;
+    struct os_mbuf_iter iter;
+    struct msghdr msg;
+    int iov_cnt;
     int sa_len;
+    int len;
     int off;
     int rc;
 
@@ -534,16 +542,37 @@ native_sock_sendto(struct mn_socket *s, struct os_mbuf *m,
         if (rc) {
             return rc;
         }
+        len = os_mbuf_len(m);
+        if (len > sizeof(tmpbuf)) {
+            return MN_ENOBUFS;
+        }
+
+        /* Send straight out of the mbufs. */
         off = 0;
-        for (o = m; o; o = SLIST_NEXT(o, om_next)) {
-            if (off + o->om_len > sizeof(tmpbuf)) {
-                return MN_ENOBUFS;
+        iov_cnt = 0;
+        os_mbuf_iter_init(&iter, m, 0, len);
+        while (os_mbuf_iter_next(&iter, &seg) == 0) {
+            if (iov_cnt == NATIVE_SOCK_MAX_IOV - 1) {
+                /* Too fragmented; flatten whatever is left. */
+                os_mbuf_copydata(m, off, len - off, tmpbuf);
+                iov[iov_cnt].iov_base = tmpbuf;
+                iov[iov_cnt].iov_len = len - off;
+                iov_cnt++;
+                break;
             }
-            os_mbuf_copydata(o, 0, o->om_len, &tmpbuf[off]);
-            off += o->om_len;
+            iov[iov_cnt].iov_base = (void *)seg.omv_data;
+            iov[iov_cnt].iov_len = seg.omv_len;
+            iov_cnt++;
+            off += seg.omv_len;
         }
-        rc = sendto(ns->ns_fd, tmpbuf, off, 0, sa, sa_len);
-        if (rc != off) {
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = sa;
+        msg.msg_namelen = sa_len;
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_cnt;
+        rc = sendmsg(ns->ns_fd, &msg, 0);
+        if (rc != len) {
             return native_sock_err_to_mn_err(errno);
         }
         os_mbuf_free_chain(m);
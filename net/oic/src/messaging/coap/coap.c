@@ -502,6 +502,10 @@ coap_send_message(struct os_mbuf *m, int dup)
     STATS_INC(coap_stats, oframe);
 
     if (dup) {
+        /*
+         * The transaction keeps the original for retransmission, and the
+         * transport may rewrite the copy in place; don't share the data.
+         */
         m = os_mbuf_dup(m);
         if (!m) {
             STATS_INC(coap_stats, oerr);
@@ -1372,7 +1376,7 @@ coap_get_payload(struct coap_packet_rx *pkt, struct os_mbuf **mp, uint16_t *off)
 int
 coap_set_payload(coap_packet_t *pkt, struct os_mbuf *m, size_t length)
 {
-    pkt->payload_m = os_mbuf_dup(m);
+    pkt->payload_m = os_mbuf_clone(m);
     if (!pkt->payload_m) {
         return -1;
     }
@@ -120,6 +120,9 @@ oc_send_multicast_message(struct os_mbuf *m)
 
         ot = oc_transports[i];
         if (prev) {
+            /*
+             * Each transport owns its copy and may modify it in place.
+             */
             n = os_mbuf_dup(m);
             prev->ot_tx_mcast(m);
             if (!n) {
@@ -157,7 +157,8 @@ oc_send_buffer_ip6_int(struct os_mbuf *m, int is_mcast)
                 continue;
             }
 
-            n = os_mbuf_dup(m);
+            /* mn_sendto() only reads the data; share it. */
+            n = os_mbuf_clone(m);
             if (!n) {
                 STATS_INC(oc_ip_stats, oerr);
                 break;
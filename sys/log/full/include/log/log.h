@@ -62,6 +62,20 @@ struct log_offset {
     void *lo_arg;
 };
 
+/* Matches entries from every module; see struct log_filter. */
+#define LOG_FILTER_MODULE_ANY   (-1)
+
+/**
+ * Selects the entries visited by log_walk_filtered().  An entry matches if
+ * its level is at least lf_min_level and it was written by lf_module.
+ */
+struct log_filter {
+    /* Module to match, or LOG_FILTER_MODULE_ANY. */
+    int lf_module;
+    /* Lowest level to match, one of the `LOG_LEVEL_[...]` constants. */
+    uint8_t lf_min_level;
+};
+
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
 /**
  * Log storage information
@@ -96,6 +110,9 @@ typedef int (*lh_append_mbuf_body_func_t)(struct log *log,
                                           struct os_mbuf *om);
 typedef int (*lh_walk_func_t)(struct log *,
         log_walk_func_t walk_func, struct log_offset *log_offset);
+typedef int (*lh_walk_filtered_func_t)(struct log *,
+        const struct log_filter *filter, log_walk_func_t walk_func,
+        struct log_offset *log_offset);
 typedef int (*lh_flush_func_t)(struct log *);
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
 typedef int (*lh_storage_info_func_t)(struct log *, struct log_storage_info *);
@@ -115,6 +132,8 @@ struct log_handler {
     lh_append_mbuf_body_func_t log_append_mbuf_body;
     lh_walk_func_t log_walk;
     lh_walk_func_t log_walk_sector;
+    /* Optional; may skip storage that cannot hold matching entries. */
+    lh_walk_filtered_func_t log_walk_filtered;
     lh_flush_func_t log_flush;
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
     lh_storage_info_func_t log_storage_info;
@@ -131,6 +150,8 @@ struct log_handler {
 
 /* Flags used to indicate type of data in reserved payload*/
 #define LOG_FLAGS_IMG_HASH (1 << 0)
+/* The body is compressed; see log_set_compress(). */
+#define LOG_FLAGS_COMPRESSED (1 << 1)
 
 #if MYNEWT_VAL(LOG_VERSION) == 3
 struct log_entry_hdr {
@@ -192,6 +213,18 @@ STATS_SECT_START(logs)
     STATS_SECT_ENTRY(errs)
     STATS_SECT_ENTRY(lost)
     STATS_SECT_ENTRY(too_long)
+#if MYNEWT_VAL(LOG_ASYNC)
+    STATS_SECT_ENTRY(async_drops)
+#endif
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    STATS_SECT_ENTRY(erase_bg)
+    STATS_SECT_ENTRY(stall_lt1ms)
+    STATS_SECT_ENTRY(stall_lt4ms)
+    STATS_SECT_ENTRY(stall_lt16ms)
+    STATS_SECT_ENTRY(stall_lt64ms)
+    STATS_SECT_ENTRY(stall_lt256ms)
+    STATS_SECT_ENTRY(stall_ge256ms)
+#endif
 STATS_SECT_END
 
 #define LOG_STATS_INC(log, name)        STATS_INC(log->l_stats, name)
@@ -213,6 +246,12 @@ struct log {
 #if !MYNEWT_VAL(LOG_GLOBAL_IDX)
     uint32_t l_idx;
 #endif
+#if MYNEWT_VAL(LOG_ASYNC)
+    uint8_t l_async;            /* One of LOG_ASYNC_[...]. */
+#endif
+#if MYNEWT_VAL(LOG_COMPRESS)
+    uint8_t l_compress;         /* Whether to compress entry bodies. */
+#endif
 #if MYNEWT_VAL(LOG_STATS)
     STATS_SECT_DECL(logs) l_stats;
 #endif
@@ -607,6 +646,39 @@ int log_flush(struct log *log);
 int log_walk_body_section(struct log *log, log_walk_body_func_t walk_body_func,
               struct log_offset *log_offset);
 
+/**
+ * @brief Applies a callback to each log entry matching a filter.
+ *
+ * Only the header of an entry is read to decide whether it matches; the
+ * callback is not called for entries that do not.  Handlers that keep a
+ * summary of their contents (e.g., FCB logs with LOG_FCB_SECTOR_SUMMARY)
+ * skip whole sectors without reading any of their entries.
+ *
+ * @param log                   The log to iterate.
+ * @param filter                The module and level to match.
+ * @param walk_body_func        The function to apply to each matching entry.
+ * @param log_offset            Specifies the range of entries to process.
+ *                                  Entries not matching these criteria are
+ *                                  skipped during the walk.
+ *
+ * @return                      0 if the walk completed successfully;
+ *                              nonzero on error or if the walk was aborted.
+ */
+int log_walk_filtered(struct log *log, const struct log_filter *filter,
+                      log_walk_body_func_t walk_body_func,
+                      struct log_offset *log_offset);
+
+/**
+ * @brief Indicates whether a log entry header matches a filter.
+ *
+ * @param filter                The filter to apply.
+ * @param hdr                   The header of the entry to check.
+ *
+ * @return                      true if the entry matches; false otherwise.
+ */
+bool log_filter_match(const struct log_filter *filter,
+                      const struct log_entry_hdr *hdr);
+
 #if MYNEWT_VAL(LOG_MODULE_LEVELS)
 /**
  * @brief Retrieves the globally configured minimum log level for the specified
@@ -675,6 +747,169 @@ uint8_t log_get_level(const struct log *log);
  */
 void log_set_max_entry_len(struct log *log, uint16_t max_entry_len);
 
+#if MYNEWT_VAL(LOG_ASYNC)
+/* Asynchronous logging modes; the overflow policy applies when the shared
+ * ring of pending entries is full.
+ */
+#define LOG_ASYNC_NONE          0   /* Write in the caller's context. */
+#define LOG_ASYNC_DROP_NEWEST   1   /* Discard the entry being appended. */
+#define LOG_ASYNC_DROP_OLDEST   2   /* Discard the oldest pending entries. */
+#define LOG_ASYNC_BLOCK         3   /* Wait for the log task to make room. */
+
+/**
+ * @brief Makes appends to the given log asynchronous.
+ *
+ * Entries are copied into a RAM ring and written to the log by a
+ * low-priority task, so the caller never waits for the log's storage (e.g.,
+ * a flash erase).  Entry indices are assigned when the entries are written.
+ * Entries dropped because the ring is full are counted in the `async_drops`
+ * statistic of the log they belong to.  A blocking append degrades to
+ * dropping the newest entry when called from an interrupt, from the log
+ * task or before the OS is started.
+ *
+ * @param log                   The log to configure.
+ * @param mode                  One of the `LOG_ASYNC_[...]` constants.
+ */
+void log_set_async(struct log *log, uint8_t mode);
+
+/**
+ * @brief Waits until every asynchronous entry appended before the call has
+ * been written.
+ *
+ * Entries appended while the caller waits are not waited for.  Before the OS
+ * is started, the entries are written from the caller's context.
+ *
+ * @return                      0 on success; SYS_EINVAL if called from an
+ *                                  interrupt or from the log task.
+ */
+int log_async_sync(void);
+
+/* Internal; used by the asynchronous logging pipeline. */
+void log_async_init(void);
+uint32_t log_next_index(struct log *log);
+int log_async_append(struct log *log, struct log_entry_hdr *hdr,
+                     const void *body, struct os_mbuf *om, int off,
+                     uint16_t len);
+int log_write_deferred(struct log *log, struct log_entry_hdr *hdr,
+                       const void *body, uint16_t len);
+#endif
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+/**
+ * @brief Enables or disables compression of the given log's entry bodies.
+ *
+ * Each entry body of up to LOG_COMPRESS_MAX_LEN bytes is compressed on its
+ * own, and stored compressed if that makes it smaller.  Compressed entries
+ * carry the LOG_FLAGS_COMPRESSED flag; log_read_body(),
+ * log_read_mbuf_body() and log_walk_body() return their original contents
+ * and length.  Entries appended from an interrupt are stored as is.
+ *
+ * @param log                   The log to configure.
+ * @param on                    1 to compress new entries; 0 to stop.
+ */
+void log_set_compress(struct log *log, int on);
+
+/* Internal; used by the entry compression codec. */
+void log_compress_init(void);
+int log_compress_append(struct log *log, struct log_entry_hdr *hdr,
+                        const void *body, struct os_mbuf *om, int off,
+                        uint16_t len);
+int log_compress_body_len(struct log *log, const void *dptr,
+                          const struct log_entry_hdr *hdr);
+int log_compress_read(struct log *log, const void *dptr,
+                      const struct log_entry_hdr *hdr, void *buf,
+                      struct os_mbuf *om, uint16_t off, uint16_t len);
+#endif
+
+#if MYNEWT_VAL(LOG_EXPORT)
+/** Resumable position of a log export; see log_export_mbuf(). */
+struct log_export_cursor {
+    /* Entries to export; NULL exports every entry. */
+    const struct log_filter *lec_filter;
+    /* Index of the next entry to export. */
+    uint32_t lec_index;
+    /* Set if the last call reached the end of the log. */
+    uint8_t lec_done;
+};
+
+/**
+ * @brief Starts an export at the first entry with an index at least as
+ * great as the one specified.
+ *
+ * @param cursor                The cursor to initialize.
+ * @param index                 The index of the first entry to export.
+ * @param filter                The entries to export; NULL for all.  Must
+ *                                  remain valid for the whole export.
+ */
+void log_export_init(struct log_export_cursor *cursor, uint32_t index,
+                     const struct log_filter *filter);
+
+/**
+ * @brief Appends the next entries of an export to an mbuf chain.
+ *
+ * Each entry is encoded as a CBOR map with the keys used by the SMP log
+ * show command ("ts", "level", "index", "module", "type", "imghash" if
+ * present, and the body as "msg").  Entry bodies are read from the log
+ * storage straight into the chain, without an intermediate buffer.
+ *
+ * Entries are appended until the next one would take the data appended by
+ * this call over `max_len` bytes, e.g., the payload size of one transport
+ * fragment.  An entry that is larger than `max_len` on its own is appended
+ * alone.  The cursor then points at the first entry not appended, so a
+ * large log is sent one fragment at a time with constant memory use.
+ *
+ * @param log                   The log to export.
+ * @param cursor                The position of the export; updated.
+ * @param om                    The packet header mbuf to append to.
+ * @param max_len               The maximum number of bytes to append.
+ *
+ * @return                      The number of entries appended on success;
+ *                              SYS_ENOMEM if the mbuf pool is exhausted;
+ *                              other SYS_E[...] codes on failure.  Nothing
+ *                              of a partially appended entry is left in
+ *                              `om`.
+ */
+int log_export_mbuf(struct log *log, struct log_export_cursor *cursor,
+                    struct os_mbuf *om, uint16_t max_len);
+
+/** Allocates an empty packet header mbuf for the next export fragment. */
+typedef struct os_mbuf *(*log_export_alloc_func_t)(void *arg);
+
+/**
+ * Sends a full export fragment.  The callback takes ownership of the
+ * fragment, even on failure.
+ */
+typedef int (*log_export_tx_func_t)(struct os_mbuf *om, void *arg);
+
+/**
+ * @brief Exports a log to its end as a sequence of fragments.
+ *
+ * Entries are encoded as by log_export_mbuf(), in a single pass over the
+ * log.  Each fragment is filled up to `max_len` bytes (typically the
+ * transport MTU less its headers) and handed to `tx` before the next one is
+ * allocated, so only one fragment is held at a time.  The cursor is moved
+ * past the entries of each fragment once `tx` succeeds; after a failure the
+ * export can be resumed from the first entry that was not sent.
+ *
+ * With a cbmem log, the log is locked while fragments are sent.
+ *
+ * @param log                   The log to export.
+ * @param cursor                The position of the export; updated.
+ * @param max_len               The maximum size of a fragment.
+ * @param alloc                 Allocates each fragment.
+ * @param tx                    Sends each fragment.
+ * @param arg                   Passed to `alloc` and `tx`.
+ *
+ * @return                      The number of entries sent on success;
+ *                              SYS_ENOMEM if a fragment cannot be
+ *                              allocated or filled; the error returned by
+ *                              `tx`; other SYS_E[...] codes on failure.
+ */
+int log_export_stream(struct log *log, struct log_export_cursor *cursor,
+                      uint16_t max_len, log_export_alloc_func_t alloc,
+                      log_export_tx_func_t tx, void *arg);
+#endif
+
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
 /**
  * Return information about log storage
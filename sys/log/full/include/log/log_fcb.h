@@ -29,6 +29,17 @@ extern "C" {
 #include <fcb/fcb2.h>
 #endif
 
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+#include "os/os_callout.h"
+#endif
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+#include "os/os_eventq.h"
+#endif
+
+struct log;
+struct log_entry_hdr;
+struct os_mbuf;
+
 /** An individual fcb log bookmark. */
 struct log_fcb_bmark {
     /* FCB entry that the bookmark points to. */
@@ -54,8 +65,117 @@ struct log_fcb_bset {
 
     /** The index where the next bookmark will get written. */
     int lfs_next;
+
+    /**
+     * Number of appended entries between automatic bookmarks; 0 if
+     * bookmarks are added by log walks instead.
+     */
+    uint32_t lfs_spacing;
+
+    /** The spacing automatic bookmarks start with after a clear. */
+    uint32_t lfs_min_spacing;
+
+    /** Entries appended since the last automatic bookmark. */
+    uint32_t lfs_since;
 };
 
+/** Index of the entries contained in a single FCB sector. */
+struct log_fcb_sector_idx {
+    /** Index of the first entry in the sector. */
+    uint32_t lsi_first_index;
+    /**
+     * Index of the last entry in the sector.  For sectors that were full
+     * when the log was registered this is an upper bound.
+     */
+    uint32_t lsi_last_index;
+    /** Timestamp of the first entry in the sector. */
+    int64_t lsi_first_ts;
+    /** Timestamp of the last entry in the sector (upper bound, as above). */
+    int64_t lsi_last_ts;
+    /** Set if the sector contains entries and the fields above are valid. */
+    uint8_t lsi_valid;
+#if MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)
+    /** Highest level of any entry in the sector. */
+    uint8_t lsi_max_level;
+    /**
+     * Modules with entries in the sector; module m sets bit (m % 64).  A
+     * set bit may also stand for another module with the same remainder.
+     */
+    uint64_t lsi_modules;
+#endif
+};
+
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+/** RAM staging area for log entries awaiting group commit. */
+struct log_fcb_group {
+    /** Staged entries, encoded as they will be written to flash. */
+    uint8_t *lfg_buf;
+
+    /** The size of the staging buffer, in bytes. */
+    int lfg_buf_size;
+
+    /** The number of staging buffer bytes in use. */
+    int lfg_buf_used;
+
+    /** The data length of each staged entry. */
+    uint16_t *lfg_lens;
+
+    /** Receives the flash location of each entry as it is committed. */
+#if MYNEWT_VAL(LOG_FCB)
+    struct fcb_entry *lfg_locs;
+#elif MYNEWT_VAL(LOG_FCB2)
+    struct fcb2_entry *lfg_locs;
+#endif
+
+    /** The maximum number of staged entries. */
+    int lfg_cap;
+
+    /** The number of currently staged entries. */
+    int lfg_cnt;
+
+    /** Staged entries are committed after this long; 0 for no limit. */
+    os_time_t lfg_max_age;
+
+    /** Fires when the oldest staged entry reaches the maximum age. */
+    struct os_callout lfg_timer;
+
+    /** The log the entries were staged for. */
+    struct log *lfg_log;
+
+    /** Serializes staging and commits. */
+    struct os_mutex lfg_mtx;
+
+    /** Set while entries are written; appends bypass the staging buffer. */
+    uint8_t lfg_committing;
+};
+#endif
+
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+/** State of background sector erasure for an FCB-backed log. */
+struct log_fcb_pre_erase {
+    /** Queue the erase event is posted to; NULL if not enabled. */
+    struct os_eventq *lpe_evq;
+
+    /** Rotates the log until enough sectors are free. */
+    struct os_event lpe_ev;
+
+    /** The log the event operates on. */
+    struct log *lpe_log;
+
+    /** The task running the erase event. */
+    struct os_task *lpe_task;
+
+    /** Whether the erase event is running. */
+    uint8_t lpe_running;
+
+    /** The active sector when free space was last checked. */
+    int lpe_active;
+
+    /** Serializes rotations by appenders and by the erase event. */
+    struct os_mutex lpe_mtx;
+};
+#endif
+
 /**
  * fcb_log is needed as the number of entries in a log
  */
@@ -72,6 +192,16 @@ struct fcb_log {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     struct log_fcb_bset fl_bset;
 #endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    /* One element per FCB sector; NULL if no index storage was supplied. */
+    struct log_fcb_sector_idx *fl_sidx;
+#endif
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+    struct log_fcb_group fl_group;
+#endif
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    struct log_fcb_pre_erase fl_pre_erase;
+#endif
 };
 
 #elif MYNEWT_VAL(LOG_FCB2)
@@ -87,9 +217,26 @@ struct fcb_log {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     struct log_fcb_bset fl_bset;
 #endif
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+    struct log_fcb_group fl_group;
+#endif
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    struct log_fcb_pre_erase fl_pre_erase;
+#endif
 };
 #endif
 
+/**
+ * @brief Frees up space in an FCB-backed log by rotating out its oldest
+ * sector, or by erasing it while keeping the configured number of newest
+ * entries.  Called when an append finds the FCB full.
+ *
+ * @param log                   The log to operate on.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int log_fcb_make_room(struct log *log);
+
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
 
 /**
@@ -105,6 +252,12 @@ struct fcb_log {
  *
  * FCB rotation invalidates all bookmarks.  It is up to the client code to
  * clear a log's bookmarks whenever rotation occurs.
+ *
+ * Alternatively, bookmarks can be placed automatically as entries are
+ * appended (see log_fcb_init_auto_bmarks()).  A bookmark is added every
+ * "spacing" entries; when the buffer fills up, every other bookmark is
+ * dropped and the spacing doubles.  The bookmarks thus stay sorted and
+ * evenly spaced however large the log grows, and lookups binary search them.
  */
 
 /**
@@ -117,6 +270,22 @@ struct fcb_log {
 void log_fcb_init_bmarks(struct fcb_log *fcb_log,
                          struct log_fcb_bmark *buf, int bmark_count);
 
+/**
+ * @brief Configures an fcb_log to place bookmarks automatically as entries
+ * are appended, using the specified buffer.  Log walks do not add bookmarks
+ * to such a log.
+ *
+ * @param fcb_log               The log to configure.
+ * @param buf                   The buffer to use for bookmarks.
+ * @param bmark_count           The bookmark capacity of the supplied buffer;
+ *                                  must be at least 2.
+ * @param spacing               The initial number of entries between
+ *                                  bookmarks.
+ */
+void log_fcb_init_auto_bmarks(struct fcb_log *fcb_log,
+                              struct log_fcb_bmark *buf, int bmark_count,
+                              uint32_t spacing);
+
 /**
  * @brief Erases all bookmarks from the supplied fcb_log.
  *
@@ -159,6 +328,267 @@ void log_fcb_add_bmark(struct fcb_log *fcb_log, const struct fcb_entry *entry,
 void log_fcb_add_bmark(struct fcb_log *fcb_log, const struct fcb2_entry *entry,
                        uint32_t index);
 #endif
+
+/**
+ * Notifies the log's bookmarks that an entry was appended.  If automatic
+ * bookmarks are enabled, this may add a bookmark pointing to the entry.
+ *
+ * @param fcb_log               The log the entry was appended to.
+ * @param entry                 The location of the new entry.
+ * @param index                 The log entry index of the new entry.
+ */
+#if MYNEWT_VAL(LOG_FCB)
+void log_fcb_append_bmarks(struct fcb_log *fcb_log,
+                           const struct fcb_entry *entry, uint32_t index);
+#elif MYNEWT_VAL(LOG_FCB2)
+void log_fcb_append_bmarks(struct fcb_log *fcb_log,
+                           const struct fcb2_entry *entry, uint32_t index);
+#endif
+#endif
+
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+
+/**
+ * The sector index is an optimization for index-based lookups in FCB-backed
+ * logs.  For every FCB sector the log keeps the index and timestamp of the
+ * first and last entry it contains.  A lookup binary searches these ranges
+ * to find the sector holding the requested entry and only reads entry
+ * headers from that sector.
+ *
+ * The index is built when the log is registered (reading one entry header
+ * per sector, plus the active sector in full) and is kept up to date as
+ * entries are appended and sectors are rotated out.
+ */
+
+/**
+ * @brief Configures an fcb_log to use the specified buffer for its sector
+ * index.  This must be called before the log is registered.
+ *
+ * @param fcb_log               The log to configure.
+ * @param buf                   The buffer to use for the index.
+ * @param count                 The number of elements in the supplied
+ *                                  buffer; must be at least the number of
+ *                                  sectors in the FCB.
+ *
+ * @return                      0 on success; SYS_EINVAL if the buffer is
+ *                                  too small.
+ */
+int log_fcb_init_sector_idx(struct fcb_log *fcb_log,
+                            struct log_fcb_sector_idx *buf, int count);
+
+/**
+ * @brief Rebuilds the sector index from the contents of flash.  This is
+ * called when the log is registered.
+ *
+ * @param fcb_log               The log to index.
+ */
+void log_fcb_build_sector_idx(struct fcb_log *fcb_log);
+
+/**
+ * @brief Invalidates the index of every sector.
+ *
+ * @param fcb_log               The fcb_log to clear.
+ */
+void log_fcb_clear_sector_idx(struct fcb_log *fcb_log);
+
+/**
+ * @brief Invalidates the index of the oldest FCB sector.  This is meant to
+ * get called just before the sector is rotated out.
+ *
+ * @param fcb_log               The fcb_log to operate on.
+ */
+void log_fcb_rotate_sector_idx(struct fcb_log *fcb_log);
+
+/**
+ * @brief Records a newly appended entry in the sector index.
+ *
+ * @param fcb_log               The log the entry was appended to.
+ * @param entry                 The location of the new entry.
+ * @param hdr                   The header of the new entry.
+ */
+void log_fcb_update_sector_idx(struct fcb_log *fcb_log,
+                               const struct fcb_entry *entry,
+                               const struct log_entry_hdr *hdr);
+
+#if MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)
+struct log_filter;
+
+/**
+ * @brief Indicates whether an FCB sector may contain entries matching a
+ * filter, according to the sector's summary.
+ *
+ * @param fcb_log               The log to check.
+ * @param fa                    The sector to check.
+ * @param filter                The filter to apply.
+ *
+ * @return                      false if no entry in the sector matches;
+ *                              true if some entry may match.
+ */
+bool log_fcb_sector_may_match(const struct fcb_log *fcb_log,
+                              const struct flash_area *fa,
+                              const struct log_filter *filter);
+#endif
+
+/**
+ * @brief Finds the FCB sector which contains the specified log entry index.
+ *
+ * @param fcb_log               The log to search.
+ * @param index                 The log entry index to look for.
+ *
+ * @return                      The last sector whose first entry is at or
+ *                                  before the specified index;
+ *                                  NULL if there is no such sector or the
+ *                                  log has no sector index.
+ */
+struct flash_area *
+log_fcb_find_sector(const struct fcb_log *fcb_log, uint32_t index);
+#endif
+
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+
+/**
+ * Group commit trades durability for write throughput.  Instead of being
+ * written to flash one at a time, appended entries are encoded into a RAM
+ * staging buffer exactly as they will appear in flash.  The staged entries
+ * are committed with one flash write per FCB sector they span when the
+ * buffer is full, when the oldest of them reaches the maximum age, before
+ * the log is walked, or when log_fcb_commit() is called.
+ *
+ * Each entry keeps its own CRC in flash, so a commit cut short by a reset
+ * leaves the entries written before the cut readable; the FCB skips the
+ * rest when it is next initialized.  Entries still in RAM are lost.
+ */
+
+/**
+ * @brief Configures an fcb_log to stage appended entries in the specified
+ * buffers.
+ *
+ * @param fcb_log               The log to configure.
+ * @param buf                   The buffer to stage encoded entries in.
+ * @param buf_size              The size of buf, in bytes.  Entries which do
+ *                                  not fit in it are written directly.
+ * @param locs                  Scratch space for the flash locations of
+ *                                  the entries being committed.
+ * @param lens                  Storage for the lengths of staged entries.
+ * @param count                 The number of elements in locs and lens;
+ *                                  the maximum number of staged entries.
+ * @param max_age_ms            Staged entries are committed this many
+ *                                  milliseconds after the first of them
+ *                                  was appended; 0 for no limit.
+ *
+ * @return                      0 on success; SYS_EINVAL on bad arguments.
+ */
+#if MYNEWT_VAL(LOG_FCB)
+int log_fcb_init_group(struct fcb_log *fcb_log, uint8_t *buf, int buf_size,
+                       struct fcb_entry *locs, uint16_t *lens, int count,
+                       uint32_t max_age_ms);
+#elif MYNEWT_VAL(LOG_FCB2)
+int log_fcb_init_group(struct fcb_log *fcb_log, uint8_t *buf, int buf_size,
+                       struct fcb2_entry *locs, uint16_t *lens, int count,
+                       uint32_t max_age_ms);
+#endif
+
+/**
+ * @brief Writes all staged entries of an FCB-backed log to flash.
+ *
+ * @param log                   The log to commit.
+ *
+ * @return                      0 on success; nonzero on failure.  Entries
+ *                                  which could not be written stay staged.
+ */
+int log_fcb_commit(struct log *log);
+
+/**
+ * @brief Stages an entry for group commit.  Called by the FCB log
+ * handlers; the body is taken from the mbuf chain if om is not NULL.
+ *
+ * @param log                   The log to append to.
+ * @param hdr                   The entry header.
+ * @param body                  The entry body.
+ * @param om                    The mbuf chain holding the entry body.
+ * @param off                   The offset of the body within the chain.
+ * @param body_len              The length of the entry body.
+ *
+ * @return                      0 if the entry was staged;
+ *                              1 if it has to be written directly (any
+ *                                  entries staged before it have been
+ *                                  committed);
+ *                              Other value on failure.
+ */
+int log_fcb_group_append(struct log *log, const struct log_entry_hdr *hdr,
+                         const void *body, struct os_mbuf *om, int off,
+                         int body_len);
+
+/**
+ * @brief Drops all staged entries.  Called when the log is flushed.
+ *
+ * @param fcb_log               The fcb_log to operate on.
+ */
+void log_fcb_group_discard(struct fcb_log *fcb_log);
+#endif
+
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+
+/**
+ * A full log makes room for a new entry by erasing its oldest sector, which
+ * stalls the append for as long as the erase takes.  With pre-erase, the
+ * log is rotated from an event as soon as the FCB switches to a sector
+ * after which fewer than f_scratch_cnt + 1 erased sectors remain.  The
+ * next sector switch then finds an erased sector, and only appends which
+ * outpace the event stall.  The price is that the oldest sector's entries
+ * are discarded one sector early.
+ *
+ * With LOG_STATS, the time appends spend erasing is recorded in the log's
+ * stall_* histogram statistics, and background erasures are counted in
+ * erase_bg.
+ */
+
+/**
+ * @brief Enables background erasure for an FCB-backed log.
+ *
+ * @param fcb_log               The log to configure.
+ * @param evq                   The event queue to erase from; should be
+ *                                  served by a task with a lower priority
+ *                                  than the ones which log.  NULL selects
+ *                                  the default event queue.
+ */
+void log_fcb_init_pre_erase(struct fcb_log *fcb_log, struct os_eventq *evq);
+
+/**
+ * @brief Schedules background erasure if the log is running out of erased
+ * sectors.  Called by the FCB log handlers after each append.
+ *
+ * @param log                   The log which was appended to.
+ */
+void log_fcb_pre_erase_check(struct log *log);
+
+/**
+ * @brief Locks out other rotations of the log.  Called by
+ * log_fcb_make_room(); an appender and the erase event may both find the
+ * log short of space at the same time, but only one of them must rotate it.
+ *
+ * @param fcb_log               The log about to be rotated.
+ *
+ * @return                      1 if the log has room for an append by now,
+ *                                  and need not be rotated; 0 otherwise.
+ */
+int log_fcb_pre_erase_lock(struct fcb_log *fcb_log);
+
+/**
+ * @brief Releases the lock taken by log_fcb_pre_erase_lock().
+ *
+ * @param fcb_log               The log which was rotated.
+ */
+void log_fcb_pre_erase_unlock(struct fcb_log *fcb_log);
+
+/**
+ * @brief Records the time spent rotating the log.  Called by
+ * log_fcb_make_room().
+ *
+ * @param log                   The log which was rotated.
+ * @param usecs                 The duration of the rotation.
+ */
+void log_fcb_erase_done(struct log *log, uint32_t usecs);
 #endif
 
 #ifdef __cplusplus
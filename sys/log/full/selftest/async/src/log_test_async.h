@@ -0,0 +1,45 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_LOG_TEST_ASYNC_
+#define H_LOG_TEST_ASYNC_
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+#define LTAU_LOG_CNT    2
+
+void ltau_init(uint8_t mode);
+int ltau_append(int log_idx, int seq, int body_len);
+int ltau_append_mbuf(int log_idx, int seq, int body_len, uint32_t *out_idx);
+int ltau_entry_cnt(int log_idx);
+void ltau_verify_entries(int log_idx, int first_seq, int last_seq);
+void ltau_index_range(int log_idx, uint32_t *out_first, uint32_t *out_last);
+uint32_t ltau_drops(int log_idx);
+void ltau_set_async(int log_idx, uint8_t mode);
+void ltau_flush(int log_idx);
+void ltau_sync(void);
+
+TEST_CASE_DECL(log_test_case_async_order);
+TEST_CASE_DECL(log_test_case_async_drop_newest);
+TEST_CASE_DECL(log_test_case_async_drop_oldest);
+TEST_CASE_DECL(log_test_case_async_too_long);
+TEST_CASE_DECL(log_test_case_async_index);
+
+#endif
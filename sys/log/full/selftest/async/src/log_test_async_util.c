@@ -0,0 +1,225 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_async.h"
+
+#define LTAU_MAX_BODY_LEN       128
+#define LTAU_CBMEM_SIZE         (16 * 1024)
+
+struct ltau_walk_arg {
+    int next_seq;
+    uint32_t first_idx;
+    uint32_t last_idx;
+    int count;
+};
+
+static struct log ltau_logs[LTAU_LOG_CNT];
+static struct cbmem ltau_cbmems[LTAU_LOG_CNT];
+static uint8_t ltau_cbmem_bufs[LTAU_LOG_CNT][LTAU_CBMEM_SIZE];
+static const char *ltau_log_names[LTAU_LOG_CNT] = { "log0", "log1" };
+
+/**
+ * Sets up asynchronous cbmem logs.  The tests run without the OS, so
+ * nothing is written until ltau_sync() is called.
+ */
+void
+ltau_init(uint8_t mode)
+{
+    int i;
+
+    for (i = 0; i < LTAU_LOG_CNT; i++) {
+        cbmem_init(&ltau_cbmems[i], ltau_cbmem_bufs[i],
+                   sizeof ltau_cbmem_bufs[i]);
+        log_register(ltau_log_names[i], &ltau_logs[i], &log_cbmem_handler,
+                     &ltau_cbmems[i], LOG_SYSLEVEL);
+        log_set_async(&ltau_logs[i], mode);
+    }
+}
+
+static void
+ltau_fill_body(uint8_t *body, int seq, int body_len)
+{
+    TEST_ASSERT_FATAL(body_len >= (int)sizeof(uint32_t));
+    TEST_ASSERT_FATAL(body_len <= LTAU_MAX_BODY_LEN);
+
+    memset(body, seq, body_len);
+    memcpy(body, &seq, sizeof(uint32_t));
+}
+
+/**
+ * Appends an entry whose body starts with the given sequence number.
+ */
+int
+ltau_append(int log_idx, int seq, int body_len)
+{
+    uint8_t body[LTAU_MAX_BODY_LEN];
+
+    ltau_fill_body(body, seq, body_len);
+
+    return log_append_body(&ltau_logs[log_idx], 0, 255, LOG_ETYPE_BINARY,
+                           body, body_len);
+}
+
+/**
+ * Appends the same kind of entry as ltau_append(), as a fragmented mbuf with
+ * room for the header.  On success, reports the index which the log filled
+ * in to the header.
+ */
+int
+ltau_append_mbuf(int log_idx, int seq, int body_len, uint32_t *out_idx)
+{
+    uint8_t body[LTAU_MAX_BODY_LEN];
+    struct log_entry_hdr *hdr;
+    struct os_mbuf *om;
+    int rc;
+
+    ltau_fill_body(body, seq, body_len);
+
+    om = ltu_flat_to_fragged_mbuf(body, body_len, 8);
+    om = os_mbuf_prepend(om, LOG_HDR_SIZE);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    rc = log_append_mbuf_typed_no_free(&ltau_logs[log_idx], 0, 255,
+                                       LOG_ETYPE_BINARY, &om);
+    if (rc != 0) {
+        return rc;
+    }
+
+    hdr = (struct log_entry_hdr *)om->om_data;
+    *out_idx = hdr->ue_index;
+    os_mbuf_free_chain(om);
+
+    return 0;
+}
+
+static int
+ltau_walk(struct log *log, struct log_offset *log_offset,
+          const struct log_entry_hdr *hdr, const void *dptr, uint16_t len)
+{
+    struct ltau_walk_arg *arg;
+    uint8_t body[LTAU_MAX_BODY_LEN];
+    uint32_t seq;
+    int rc;
+    int i;
+
+    arg = log_offset->lo_arg;
+
+    TEST_ASSERT_FATAL(len <= LTAU_MAX_BODY_LEN);
+    rc = log_read_body(log, dptr, body, 0, len);
+    TEST_ASSERT_FATAL(rc == len);
+
+    memcpy(&seq, body, sizeof seq);
+    for (i = sizeof seq; i < len; i++) {
+        TEST_ASSERT_FATAL(body[i] == (uint8_t)seq);
+    }
+
+    if (arg->count > 0) {
+        TEST_ASSERT_FATAL(seq == arg->next_seq);
+        TEST_ASSERT_FATAL(hdr->ue_index > arg->last_idx);
+    } else {
+        arg->first_idx = hdr->ue_index;
+    }
+    arg->next_seq = seq + 1;
+    arg->last_idx = hdr->ue_index;
+    arg->count++;
+
+    return 0;
+}
+
+static struct ltau_walk_arg
+ltau_collect(int log_idx)
+{
+    struct ltau_walk_arg arg = { 0 };
+    struct log_offset log_offset = {
+        .lo_arg = &arg,
+    };
+    int rc;
+
+    rc = log_walk_body(&ltau_logs[log_idx], ltau_walk, &log_offset);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    return arg;
+}
+
+int
+ltau_entry_cnt(int log_idx)
+{
+    return ltau_collect(log_idx).count;
+}
+
+/**
+ * Verifies that the log holds exactly the entries with sequence numbers
+ * first_seq to last_seq, in order and with increasing indices.
+ */
+void
+ltau_verify_entries(int log_idx, int first_seq, int last_seq)
+{
+    struct ltau_walk_arg arg;
+
+    arg = ltau_collect(log_idx);
+    TEST_ASSERT_FATAL(arg.count == last_seq - first_seq + 1);
+    if (arg.count > 0) {
+        TEST_ASSERT_FATAL(arg.next_seq == last_seq + 1);
+    }
+}
+
+/**
+ * Reports the indices of the first and last entries in the log.
+ */
+void
+ltau_index_range(int log_idx, uint32_t *out_first, uint32_t *out_last)
+{
+    struct ltau_walk_arg arg;
+
+    arg = ltau_collect(log_idx);
+    TEST_ASSERT_FATAL(arg.count > 0);
+    *out_first = arg.first_idx;
+    *out_last = arg.last_idx;
+}
+
+uint32_t
+ltau_drops(int log_idx)
+{
+    return STATS_GET(ltau_logs[log_idx].l_stats, async_drops);
+}
+
+void
+ltau_set_async(int log_idx, uint8_t mode)
+{
+    log_set_async(&ltau_logs[log_idx], mode);
+}
+
+void
+ltau_flush(int log_idx)
+{
+    int rc;
+
+    rc = log_flush(&ltau_logs[log_idx]);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+void
+ltau_sync(void)
+{
+    int rc;
+
+    rc = log_async_sync();
+    TEST_ASSERT_FATAL(rc == 0);
+}
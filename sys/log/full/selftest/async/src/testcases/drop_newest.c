@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_async.h"
+
+TEST_CASE_SELF(log_test_case_async_drop_newest)
+{
+    int accepted;
+    int rc;
+    int i;
+
+    ltau_init(LOG_ASYNC_DROP_NEWEST);
+
+    /* Fill the ring; once full, new entries are rejected. */
+    accepted = -1;
+    for (i = 0; i < 100; i++) {
+        rc = ltau_append(0, i, 32);
+        if (rc != 0) {
+            if (accepted < 0) {
+                accepted = i;
+            }
+        } else {
+            TEST_ASSERT_FATAL(accepted < 0);
+        }
+    }
+    TEST_ASSERT_FATAL(accepted > 0);
+    TEST_ASSERT(ltau_drops(0) == 100 - accepted);
+
+    ltau_sync();
+    ltau_verify_entries(0, 0, accepted - 1);
+
+    /* Draining frees the whole ring; the next batch wraps around. */
+    for (i = 0; i < accepted; i++) {
+        rc = ltau_append(0, accepted + i, 32);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    ltau_sync();
+    ltau_verify_entries(0, 0, 2 * accepted - 1);
+
+    /* A blocking log cannot wait without the OS; it drops instead. */
+    ltau_set_async(0, LOG_ASYNC_BLOCK);
+    for (i = 0; i < 100; i++) {
+        ltau_append(0, 2 * accepted + i, 32);
+    }
+    TEST_ASSERT(ltau_drops(0) == 200 - 2 * accepted);
+}
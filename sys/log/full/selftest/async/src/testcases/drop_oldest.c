@@ -0,0 +1,57 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_async.h"
+
+TEST_CASE_SELF(log_test_case_async_drop_oldest)
+{
+    uint32_t drops;
+    int rc;
+    int i;
+
+    ltau_init(LOG_ASYNC_DROP_OLDEST);
+
+    /* Every append succeeds; the oldest pending entries make room. */
+    for (i = 0; i < 100; i++) {
+        rc = ltau_append(0, i, 32);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    drops = ltau_drops(0);
+    TEST_ASSERT_FATAL(drops > 0);
+
+    ltau_sync();
+    ltau_verify_entries(0, drops, 99);
+
+    /* The entries of other logs are dropped just the same. */
+    ltau_flush(0);
+    rc = ltau_append(1, 0, 32);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 100; i < 200; i++) {
+        rc = ltau_append(0, i, 32);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(ltau_drops(1) == 1);
+    drops = ltau_drops(0) - drops;
+
+    ltau_sync();
+    ltau_verify_entries(1, 0, -1);
+    ltau_verify_entries(0, 100 + drops, 199);
+}
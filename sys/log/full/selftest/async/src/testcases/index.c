@@ -0,0 +1,49 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_async.h"
+
+TEST_CASE_SELF(log_test_case_async_index)
+{
+    uint32_t first;
+    uint32_t last;
+    uint32_t idx0;
+    uint32_t idx1;
+    int rc;
+
+    ltau_init(LOG_ASYNC_DROP_NEWEST);
+
+    /* Queued entries are numbered right away, in the caller's header, as
+     * they would be if written directly.
+     */
+    rc = ltau_append_mbuf(0, 0, 16, &idx0);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = ltau_append_mbuf(0, 1, 16, &idx1);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(idx1 > idx0);
+    TEST_ASSERT(ltau_entry_cnt(0) == 0);
+
+    /* The entries are written with the same indices. */
+    ltau_sync();
+    ltau_verify_entries(0, 0, 1);
+    ltau_index_range(0, &first, &last);
+    TEST_ASSERT(first == idx0);
+    TEST_ASSERT(last == idx1);
+}
@@ -0,0 +1,52 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_async.h"
+
+TEST_CASE_SELF(log_test_case_async_order)
+{
+    int rc;
+    int i;
+
+    ltau_init(LOG_ASYNC_DROP_NEWEST);
+
+    for (i = 0; i < 10; i++) {
+        rc = ltau_append(i % 2, i / 2, 16);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* Nothing is written until the log task runs. */
+    TEST_ASSERT(ltau_entry_cnt(0) == 0);
+    TEST_ASSERT(ltau_entry_cnt(1) == 0);
+
+    ltau_sync();
+    ltau_verify_entries(0, 0, 4);
+    ltau_verify_entries(1, 0, 4);
+
+    /* Entries appended after the log is made synchronous again are written
+     * after the pending ones.
+     */
+    rc = ltau_append(0, 5, 16);
+    TEST_ASSERT_FATAL(rc == 0);
+    ltau_set_async(0, LOG_ASYNC_NONE);
+    rc = ltau_append(0, 6, 16);
+    TEST_ASSERT_FATAL(rc == 0);
+    ltau_verify_entries(0, 0, 6);
+}
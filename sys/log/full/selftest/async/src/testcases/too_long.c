@@ -0,0 +1,43 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_async.h"
+
+TEST_CASE_SELF(log_test_case_async_too_long)
+{
+    struct log *log;
+    int rc;
+
+    ltau_init(LOG_ASYNC_DROP_NEWEST);
+
+    /* Bodies longer than LOG_ASYNC_MAX_ENTRY_LEN are rejected. */
+    rc = ltau_append(0, 0, MYNEWT_VAL(LOG_ASYNC_MAX_ENTRY_LEN));
+    TEST_ASSERT(rc == 0);
+    rc = ltau_append(0, 1, MYNEWT_VAL(LOG_ASYNC_MAX_ENTRY_LEN) + 1);
+    TEST_ASSERT(rc == SYS_ENOMEM);
+
+    log = log_find("log0");
+    TEST_ASSERT_FATAL(log != NULL);
+    TEST_ASSERT(STATS_GET(log->l_stats, too_long) == 1);
+    TEST_ASSERT(ltau_drops(0) == 0);
+
+    ltau_sync();
+    ltau_verify_entries(0, 0, 0);
+}
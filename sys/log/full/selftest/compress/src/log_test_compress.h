@@ -0,0 +1,40 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_LOG_TEST_COMPRESS_
+#define H_LOG_TEST_COMPRESS_
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+void ltcu_init(void);
+void ltcu_set_compress(int on);
+void ltcu_append(const void *body, int len, int mbuf);
+void ltcu_append_text(int count, int mbuf);
+int ltcu_verify_entries(void);
+int ltcu_entry_cnt(void);
+int ltcu_body_bytes(void);
+int ltcu_flash_bytes(void);
+
+TEST_CASE_DECL(log_test_case_compress_text);
+TEST_CASE_DECL(log_test_case_compress_mbuf);
+TEST_CASE_DECL(log_test_case_compress_raw);
+TEST_CASE_DECL(log_test_case_compress_off);
+
+#endif
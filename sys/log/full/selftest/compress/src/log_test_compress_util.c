@@ -0,0 +1,233 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_compress.h"
+
+#define LTCU_MAX_ENTRIES        64
+#define LTCU_MAX_BODY_LEN       (MYNEWT_VAL(LOG_COMPRESS_MAX_LEN) + 1)
+
+#define LTCU_SECTOR_SIZE        (16 * 1024)
+#define LTCU_SECTOR_CNT         2
+
+struct ltcu_walk_arg {
+    int count;
+    int compressed;
+};
+
+static struct fcb_log ltcu_fcb_log;
+static struct log ltcu_log;
+
+/* Everything appended, in order. */
+static uint8_t ltcu_bodies[LTCU_MAX_ENTRIES][LTCU_MAX_BODY_LEN];
+static uint16_t ltcu_lens[LTCU_MAX_ENTRIES];
+static int ltcu_cnt;
+
+/**
+ * Sets up an empty log which compresses its entries.
+ */
+void
+ltcu_init(void)
+{
+    ltu_erase_fcb_areas(LTCU_SECTOR_SIZE, LTCU_SECTOR_CNT);
+    ltu_init_fcb(&ltcu_fcb_log, LTCU_SECTOR_CNT, 0);
+
+    log_register("log", &ltcu_log, &log_fcb_handler, &ltcu_fcb_log,
+                 LOG_SYSLEVEL);
+    log_set_compress(&ltcu_log, 1);
+
+    ltcu_cnt = 0;
+}
+
+void
+ltcu_set_compress(int on)
+{
+    log_set_compress(&ltcu_log, on);
+}
+
+/**
+ * Appends an entry, from a flat buffer or from a fragmented mbuf.
+ */
+void
+ltcu_append(const void *body, int len, int mbuf)
+{
+    struct os_mbuf *om;
+    int rc;
+
+    TEST_ASSERT_FATAL(ltcu_cnt < LTCU_MAX_ENTRIES);
+    TEST_ASSERT_FATAL(len <= LTCU_MAX_BODY_LEN);
+
+    if (mbuf) {
+        om = ltu_flat_to_fragged_mbuf(body, len, 16);
+        rc = log_append_mbuf_body(&ltcu_log, 0, 255, LOG_ETYPE_STRING, om);
+    } else {
+        rc = log_append_body(&ltcu_log, 0, 255, LOG_ETYPE_STRING, body, len);
+    }
+    TEST_ASSERT_FATAL(rc == 0);
+
+    memcpy(ltcu_bodies[ltcu_cnt], body, len);
+    ltcu_lens[ltcu_cnt] = len;
+    ltcu_cnt++;
+}
+
+/**
+ * Appends `count` lines of typical log text.
+ */
+void
+ltcu_append_text(int count, int mbuf)
+{
+    char body[LTCU_MAX_BODY_LEN];
+    int len;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        switch (i % 4) {
+        case 0:
+            len = snprintf(body, sizeof body,
+                           "connection handle=%d disconnected reason=0x%02x",
+                           i, i * 7 % 256);
+            break;
+        case 1:
+            len = snprintf(body, sizeof body,
+                           "sensor %d start; value=%d state=idle", i, i * 31);
+            break;
+        case 2:
+            len = snprintf(body, sizeof body,
+                           "flash write failed; rc=%d addr=0x%08x len=%d",
+                           -i, i * 4096, 64);
+            break;
+        default:
+            /* Long enough for extended literal and match lengths. */
+            len = snprintf(body, sizeof body,
+                           "%d: abcdefghijklmnopqrstuvwxyz0123456789 "
+                           "................................................"
+                           "................................................",
+                           i);
+            break;
+        }
+        ltcu_append(body, len, mbuf);
+    }
+}
+
+static int
+ltcu_verify_walk(struct log *log, struct log_offset *log_offset,
+                 const struct log_entry_hdr *hdr, const void *dptr,
+                 uint16_t len)
+{
+    struct ltcu_walk_arg *arg;
+    uint8_t body[LTCU_MAX_BODY_LEN];
+    int off;
+    int rc;
+
+    arg = log_offset->lo_arg;
+    TEST_ASSERT_FATAL(arg->count < ltcu_cnt);
+    TEST_ASSERT_FATAL(len == ltcu_lens[arg->count]);
+
+    if (hdr->ue_flags & LOG_FLAGS_COMPRESSED) {
+        arg->compressed++;
+    }
+
+    /* Whole, then in pieces. */
+    memset(body, 0, sizeof body);
+    rc = log_read_body(log, dptr, body, 0, len);
+    TEST_ASSERT_FATAL(rc == len);
+    TEST_ASSERT_FATAL(memcmp(body, ltcu_bodies[arg->count], len) == 0);
+
+    memset(body, 0, sizeof body);
+    for (off = 0; off < len; off += rc) {
+        rc = log_read_body(log, dptr, body + off, off, 7);
+        TEST_ASSERT_FATAL(rc > 0 && rc <= 7);
+    }
+    TEST_ASSERT_FATAL(memcmp(body, ltcu_bodies[arg->count], len) == 0);
+
+    /* Reads past the end return nothing. */
+    rc = log_read_body(log, dptr, body, len, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    arg->count++;
+
+    return 0;
+}
+
+/**
+ * Verifies that a body walk returns everything appended, unchanged.
+ * Returns the number of entries stored compressed.
+ */
+int
+ltcu_verify_entries(void)
+{
+    struct ltcu_walk_arg arg = { 0 };
+    struct log_offset log_offset = {
+        .lo_arg = &arg,
+    };
+    int rc;
+
+    rc = log_walk_body(&ltcu_log, ltcu_verify_walk, &log_offset);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(arg.count == ltcu_cnt);
+
+    return arg.compressed;
+}
+
+int
+ltcu_entry_cnt(void)
+{
+    return ltcu_cnt;
+}
+
+/**
+ * Total length of the bodies appended.
+ */
+int
+ltcu_body_bytes(void)
+{
+    int total;
+    int i;
+
+    total = 0;
+    for (i = 0; i < ltcu_cnt; i++) {
+        total += ltcu_lens[i];
+    }
+
+    return total;
+}
+
+/**
+ * Total length of the bodies as stored.
+ */
+int
+ltcu_flash_bytes(void)
+{
+    struct log_entry_hdr hdr;
+    struct fcb_entry loc;
+    int total;
+    int rc;
+
+    memset(&loc, 0, sizeof loc);
+    total = 0;
+    while (fcb_getnext(&ltcu_fcb_log.fl_fcb, &loc) == 0) {
+        rc = log_read_hdr(&ltcu_log, &loc, &hdr);
+        TEST_ASSERT_FATAL(rc == 0);
+        total += loc.fe_data_len - log_hdr_len(&hdr);
+    }
+
+    return total;
+}
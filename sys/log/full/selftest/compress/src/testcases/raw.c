@@ -0,0 +1,48 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_compress.h"
+
+TEST_CASE_SELF(log_test_case_compress_raw)
+{
+    uint8_t body[MYNEWT_VAL(LOG_COMPRESS_MAX_LEN) + 1];
+    uint32_t x;
+    int i;
+
+    ltcu_init();
+
+    /* Bodies which do not shrink, and short ones, are stored as is. */
+    x = 1;
+    for (i = 0; i < sizeof body; i++) {
+        x = x * 1103515245 + 12345;
+        body[i] = x >> 16;
+    }
+    ltcu_append(body, 100, 0);
+    ltcu_append("abc", 3, 0);
+    ltcu_append("", 0, 0);
+    TEST_ASSERT(ltcu_verify_entries() == 0);
+
+    /* So are bodies too long for the codec. */
+    memset(body, 'a', sizeof body);
+    ltcu_append(body, sizeof body, 0);
+    TEST_ASSERT(ltcu_verify_entries() == 0);
+    ltcu_append(body, sizeof body - 1, 0);
+    TEST_ASSERT(ltcu_verify_entries() == 1);
+}
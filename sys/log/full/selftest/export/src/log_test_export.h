@@ -0,0 +1,40 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_LOG_TEST_EXPORT_
+#define H_LOG_TEST_EXPORT_
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "log/log.h"
+
+void ltxu_init(void);
+void ltxu_populate_log(int count);
+void ltxu_verify_export(struct log_export_cursor *cursor, uint16_t max_len);
+void ltxu_verify_stream(struct log_export_cursor *cursor, uint16_t max_len,
+                        int fail_after);
+void ltxu_verify_nomem(void);
+
+TEST_CASE_DECL(log_test_case_export_entries);
+TEST_CASE_DECL(log_test_case_export_resume);
+TEST_CASE_DECL(log_test_case_export_filter);
+TEST_CASE_DECL(log_test_case_export_stream);
+TEST_CASE_DECL(log_test_case_export_nomem);
+
+#endif
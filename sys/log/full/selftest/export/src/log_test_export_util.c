@@ -0,0 +1,426 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "tinycbor/cbor.h"
+#include "tinycbor/cbor_buf_reader.h"
+#include "log_test_util/log_test_util.h"
+#include "log_test_export.h"
+
+#define LTXU_MAX_ENTRIES        512
+#define LTXU_MAX_BODY_LEN       150
+
+#define LTXU_SECTOR_SIZE        (16 * 1024)
+#define LTXU_SECTOR_CNT         4
+
+/* Small mbufs, so that most entry bodies span several of them. */
+#define LTXU_MBUF_DATA_LEN      128
+#define LTXU_MBUF_BLOCK_LEN     (LTXU_MBUF_DATA_LEN + \
+                                 sizeof (struct os_mbuf) + \
+                                 sizeof (struct os_mbuf_pkthdr))
+#define LTXU_MBUF_CNT           128
+
+/* Too few mbufs to export more than a couple of entries at a time. */
+#define LTXU_SMALL_MBUF_CNT     3
+
+struct ltxu_entry {
+    struct log_entry_hdr hdr;
+    uint8_t body[LTXU_MAX_BODY_LEN];
+    uint16_t len;
+};
+
+struct ltxu_stream_arg {
+    uint16_t max_len;
+    int count;
+    int pos;
+    /* Number of fragments to send before failing; -1 to never fail. */
+    int fail_after;
+};
+
+struct ltxu_collect_arg {
+    const struct log_filter *filter;
+    struct ltxu_entry *entries;
+    int count;
+};
+
+static struct ltxu_entry ltxu_entries[LTXU_MAX_ENTRIES];
+static uint8_t ltxu_buf[LTXU_MBUF_CNT * LTXU_MBUF_DATA_LEN];
+static int ltxu_num_appended;
+
+static os_membuf_t ltxu_mbuf_mem[
+    OS_MEMPOOL_SIZE(LTXU_MBUF_CNT, LTXU_MBUF_BLOCK_LEN)];
+static struct os_mempool ltxu_mempool;
+static struct os_mbuf_pool ltxu_mbuf_pool;
+
+static os_membuf_t ltxu_small_mbuf_mem[
+    OS_MEMPOOL_SIZE(LTXU_SMALL_MBUF_CNT, LTXU_MBUF_BLOCK_LEN)];
+static struct os_mempool ltxu_small_mempool;
+static struct os_mbuf_pool ltxu_small_mbuf_pool;
+
+static struct fcb_log ltxu_fcb_log;
+static struct log ltxu_log;
+
+static struct log_fcb_sector_idx ltxu_sidx[LTXU_SECTOR_CNT];
+
+static void
+ltxu_init_pool(struct os_mempool *mempool, struct os_mbuf_pool *mbuf_pool,
+               os_membuf_t *mem, int count, char *name)
+{
+    int rc;
+
+    rc = os_mempool_init(mempool, count, LTXU_MBUF_BLOCK_LEN, mem, name);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_mbuf_pool_init(mbuf_pool, mempool, LTXU_MBUF_BLOCK_LEN, count);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+void
+ltxu_init(void)
+{
+    int rc;
+
+    ltu_erase_fcb_areas(LTXU_SECTOR_SIZE, LTXU_SECTOR_CNT);
+    ltu_init_fcb(&ltxu_fcb_log, LTXU_SECTOR_CNT, 1);
+
+    rc = log_fcb_init_sector_idx(&ltxu_fcb_log, ltxu_sidx, LTXU_SECTOR_CNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ltxu_init_pool(&ltxu_mempool, &ltxu_mbuf_pool, ltxu_mbuf_mem,
+                   LTXU_MBUF_CNT, "ltxu");
+    ltxu_init_pool(&ltxu_small_mempool, &ltxu_small_mbuf_pool,
+                   ltxu_small_mbuf_mem, LTXU_SMALL_MBUF_CNT, "ltxu_small");
+
+    ltxu_num_appended = 0;
+
+    log_register("log", &ltxu_log, &log_fcb_handler, &ltxu_fcb_log,
+                 LOG_LEVEL_DEBUG);
+}
+
+/**
+ * Appends entries of every type, with bodies from empty to longer than an
+ * mbuf, from four modules and at every level.
+ */
+void
+ltxu_populate_log(int count)
+{
+    uint8_t body[LTXU_MAX_BODY_LEN];
+    int len;
+    int rc;
+    int i;
+    int j;
+
+    for (i = 0; i < count; i++) {
+        j = ltxu_num_appended++;
+
+        len = (j * 37) % LTXU_MAX_BODY_LEN;
+        memset(body, j, len);
+        rc = log_append_body(&ltxu_log, 10 + j % 4, j % 5, j % 3, body, len);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+static int
+ltxu_collect_walk(struct log *log, struct log_offset *log_offset,
+                  const struct log_entry_hdr *hdr, const void *dptr,
+                  uint16_t len)
+{
+    struct ltxu_collect_arg *arg;
+    struct ltxu_entry *entry;
+    int rc;
+
+    arg = log_offset->lo_arg;
+    if (arg->filter != NULL && !log_filter_match(arg->filter, hdr)) {
+        return 0;
+    }
+
+    TEST_ASSERT_FATAL(arg->count < LTXU_MAX_ENTRIES);
+    TEST_ASSERT_FATAL(len <= LTXU_MAX_BODY_LEN);
+
+    entry = &arg->entries[arg->count++];
+    entry->hdr = *hdr;
+    entry->len = len;
+    rc = log_read_body(log, dptr, entry->body, 0, len);
+    TEST_ASSERT_FATAL(rc == len);
+
+    return 0;
+}
+
+/**
+ * Collects the entries an export from the given cursor is expected to
+ * produce.
+ */
+static int
+ltxu_collect_entries(const struct log_export_cursor *cursor)
+{
+    struct ltxu_collect_arg arg = {
+        .filter = cursor->lec_filter,
+        .entries = ltxu_entries,
+    };
+    struct log_offset log_offset = {
+        .lo_arg = &arg,
+        .lo_index = cursor->lec_index,
+    };
+    int rc;
+
+    rc = log_walk_body(&ltxu_log, ltxu_collect_walk, &log_offset);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    return arg.count;
+}
+
+static void
+ltxu_verify_map(const CborValue *map, const struct ltxu_entry *entry)
+{
+    static const char *types[] = { "str", "cbor", "bin" };
+    uint8_t body[LTXU_MAX_BODY_LEN];
+    char type[8];
+    CborValue val;
+    size_t len;
+    int64_t i64;
+    int rc;
+
+    TEST_ASSERT_FATAL(cbor_value_is_map(map));
+    rc = cbor_value_get_map_length(map, &len);
+    TEST_ASSERT_FATAL(rc == 0 && len == 6);
+
+    rc = cbor_value_map_find_value(map, "ts", &val);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_get_int64(&val, &i64) == 0);
+    TEST_ASSERT_FATAL(i64 == entry->hdr.ue_ts);
+
+    rc = cbor_value_map_find_value(map, "level", &val);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_get_int64(&val, &i64) == 0);
+    TEST_ASSERT_FATAL(i64 == entry->hdr.ue_level);
+
+    rc = cbor_value_map_find_value(map, "index", &val);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_get_int64(&val, &i64) == 0);
+    TEST_ASSERT_FATAL(i64 == entry->hdr.ue_index);
+
+    rc = cbor_value_map_find_value(map, "module", &val);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_get_int64(&val, &i64) == 0);
+    TEST_ASSERT_FATAL(i64 == entry->hdr.ue_module);
+
+    rc = cbor_value_map_find_value(map, "type", &val);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_text_string(&val));
+    len = sizeof type;
+    rc = cbor_value_copy_text_string(&val, type, &len, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(strcmp(type, types[entry->hdr.ue_etype]) == 0);
+
+    rc = cbor_value_map_find_value(map, "msg", &val);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_byte_string(&val));
+    len = sizeof body;
+    rc = cbor_value_copy_byte_string(&val, body, &len, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(len == entry->len);
+    TEST_ASSERT_FATAL(memcmp(body, entry->body, len) == 0);
+}
+
+/**
+ * Decodes the entries in an exported chain, which a client would receive
+ * as the elements of an indefinite-length array.
+ *
+ * @return                      The number of entries decoded.
+ */
+static int
+ltxu_decode(struct os_mbuf *om, const struct ltxu_entry *entries, int count)
+{
+    struct cbor_buf_reader reader;
+    CborParser parser;
+    CborValue array;
+    CborValue map;
+    uint16_t len;
+    int rc;
+    int n;
+
+    len = OS_MBUF_PKTLEN(om);
+    TEST_ASSERT_FATAL(len + 2 <= sizeof ltxu_buf);
+
+    ltxu_buf[0] = 0x9f;
+    rc = os_mbuf_copydata(om, 0, len, ltxu_buf + 1);
+    TEST_ASSERT_FATAL(rc == 0);
+    ltxu_buf[len + 1] = 0xff;
+
+    cbor_buf_reader_init(&reader, ltxu_buf, len + 2);
+    rc = cbor_parser_init(&reader.r, 0, &parser, &array);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_array(&array));
+
+    rc = cbor_value_enter_container(&array, &map);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (n = 0; !cbor_value_at_end(&map); n++) {
+        TEST_ASSERT_FATAL(n < count);
+        ltxu_verify_map(&map, &entries[n]);
+
+        rc = cbor_value_advance(&map);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    return n;
+}
+
+/**
+ * Exports the log from the given cursor to its end, at most `max_len`
+ * bytes at a time, and verifies that exactly the expected entries are
+ * exported in order.
+ */
+void
+ltxu_verify_export(struct log_export_cursor *cursor, uint16_t max_len)
+{
+    struct os_mbuf *om;
+    int count;
+    int pos;
+    int rc;
+    int n;
+
+    count = ltxu_collect_entries(cursor);
+
+    pos = 0;
+    do {
+        om = os_mbuf_get_pkthdr(&ltxu_mbuf_pool, 0);
+        TEST_ASSERT_FATAL(om != NULL);
+
+        rc = log_export_mbuf(&ltxu_log, cursor, om, max_len);
+        TEST_ASSERT_FATAL(rc >= 0);
+
+        /* Only a lone entry may exceed the limit. */
+        TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) <= max_len || rc == 1);
+        if (!cursor->lec_done) {
+            TEST_ASSERT_FATAL(rc > 0);
+        }
+
+        n = ltxu_decode(om, &ltxu_entries[pos], count - pos);
+        TEST_ASSERT_FATAL(n == rc);
+        pos += n;
+
+        os_mbuf_free_chain(om);
+    } while (!cursor->lec_done);
+
+    TEST_ASSERT_FATAL(pos == count);
+    if (count > 0) {
+        TEST_ASSERT_FATAL(cursor->lec_index ==
+                          ltxu_entries[count - 1].hdr.ue_index + 1);
+    }
+}
+
+static struct os_mbuf *
+ltxu_stream_alloc(void *arg)
+{
+    return os_mbuf_get_pkthdr(&ltxu_mbuf_pool, 0);
+}
+
+static int
+ltxu_stream_tx(struct os_mbuf *om, void *arg)
+{
+    struct ltxu_stream_arg *sa;
+    int n;
+
+    sa = arg;
+
+    if (sa->fail_after == 0) {
+        os_mbuf_free_chain(om);
+        return SYS_EIO;
+    }
+    if (sa->fail_after > 0) {
+        sa->fail_after--;
+    }
+
+    n = ltxu_decode(om, &ltxu_entries[sa->pos], sa->count - sa->pos);
+    TEST_ASSERT_FATAL(n > 0);
+    TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) <= sa->max_len || n == 1);
+    sa->pos += n;
+
+    os_mbuf_free_chain(om);
+
+    return 0;
+}
+
+/**
+ * Streams the log from the given cursor to its end.  If `fail_after` is
+ * not negative, sending fails after that many fragments; the stream is
+ * then resumed and must pick up exactly where the last sent fragment
+ * ended.
+ */
+void
+ltxu_verify_stream(struct log_export_cursor *cursor, uint16_t max_len,
+                   int fail_after)
+{
+    struct ltxu_stream_arg sa = {
+        .max_len = max_len,
+        .fail_after = fail_after,
+    };
+    int rc;
+
+    sa.count = ltxu_collect_entries(cursor);
+
+    rc = log_export_stream(&ltxu_log, cursor, max_len, ltxu_stream_alloc,
+                           ltxu_stream_tx, &sa);
+    if (fail_after >= 0) {
+        TEST_ASSERT_FATAL(rc == SYS_EIO);
+        TEST_ASSERT_FATAL(!cursor->lec_done);
+        TEST_ASSERT_FATAL(sa.pos < sa.count);
+        /* With a filter, unmatched entries may lie in between. */
+        TEST_ASSERT_FATAL(cursor->lec_index <=
+                          ltxu_entries[sa.pos].hdr.ue_index);
+        if (sa.pos > 0) {
+            TEST_ASSERT_FATAL(cursor->lec_index ==
+                              ltxu_entries[sa.pos - 1].hdr.ue_index + 1);
+        }
+
+        sa.fail_after = -1;
+        rc = log_export_stream(&ltxu_log, cursor, max_len, ltxu_stream_alloc,
+                               ltxu_stream_tx, &sa);
+    }
+    TEST_ASSERT_FATAL(rc >= 0);
+    TEST_ASSERT_FATAL(cursor->lec_done);
+    TEST_ASSERT_FATAL(sa.pos == sa.count);
+}
+
+/**
+ * Exports from a pool that runs out part way, and verifies that the
+ * partially appended entry is removed and the export can be resumed from
+ * it.
+ */
+void
+ltxu_verify_nomem(void)
+{
+    struct log_export_cursor cursor;
+    struct os_mbuf *om;
+    int count;
+    int rc;
+    int n;
+
+    log_export_init(&cursor, 0, NULL);
+    count = ltxu_collect_entries(&cursor);
+
+    om = os_mbuf_get_pkthdr(&ltxu_small_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    rc = log_export_mbuf(&ltxu_log, &cursor, om, UINT16_MAX);
+    TEST_ASSERT_FATAL(rc == SYS_ENOMEM);
+    TEST_ASSERT_FATAL(!cursor.lec_done);
+
+    n = ltxu_decode(om, ltxu_entries, count);
+    TEST_ASSERT_FATAL(n < count);
+    TEST_ASSERT_FATAL(cursor.lec_index == ltxu_entries[n].hdr.ue_index);
+
+    os_mbuf_free_chain(om);
+
+    ltxu_verify_export(&cursor, 1024);
+}
@@ -0,0 +1,43 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_export.h"
+
+TEST_CASE_SELF(log_test_case_export_entries)
+{
+    struct log_export_cursor cursor;
+
+    ltxu_init();
+
+    /* An empty log exports nothing. */
+    log_export_init(&cursor, 0, NULL);
+    ltxu_verify_export(&cursor, 1024);
+    TEST_ASSERT(cursor.lec_index == 0);
+
+    ltxu_populate_log(60);
+
+    /* Everything fits in one call. */
+    log_export_init(&cursor, 0, NULL);
+    ltxu_verify_export(&cursor, 12 * 1024);
+
+    /* Starting part way through. */
+    log_export_init(&cursor, 25, NULL);
+    ltxu_verify_export(&cursor, 12 * 1024);
+}
@@ -0,0 +1,41 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_export.h"
+
+TEST_CASE_SELF(log_test_case_export_filter)
+{
+    static const struct log_filter filter = {
+        .lf_module = 11,
+        .lf_min_level = LOG_LEVEL_WARN,
+    };
+    struct log_export_cursor cursor;
+
+    ltxu_init();
+
+    /* Wrap the log, so that the export starts in a rotated sector. */
+    ltxu_populate_log(800);
+
+    log_export_init(&cursor, 0, &filter);
+    ltxu_verify_export(&cursor, 300);
+
+    ltxu_populate_log(40);
+    ltxu_verify_export(&cursor, 300);
+}
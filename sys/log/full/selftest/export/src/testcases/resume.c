@@ -0,0 +1,44 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_export.h"
+
+TEST_CASE_SELF(log_test_case_export_resume)
+{
+    struct log_export_cursor cursor;
+
+    ltxu_init();
+
+    ltxu_populate_log(200);
+
+    /* Fragment-sized calls, down to less than a single entry. */
+    log_export_init(&cursor, 0, NULL);
+    ltxu_verify_export(&cursor, 512);
+    log_export_init(&cursor, 0, NULL);
+    ltxu_verify_export(&cursor, 100);
+    log_export_init(&cursor, 0, NULL);
+    ltxu_verify_export(&cursor, 10);
+
+    /* A finished export picks up entries appended since. */
+    ltxu_populate_log(30);
+    ltxu_verify_export(&cursor, 256);
+    TEST_ASSERT(cursor.lec_done);
+    ltxu_verify_export(&cursor, 256);
+}
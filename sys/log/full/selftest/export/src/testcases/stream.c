@@ -0,0 +1,49 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_export.h"
+
+TEST_CASE_SELF(log_test_case_export_stream)
+{
+    static const struct log_filter filter = {
+        .lf_module = LOG_FILTER_MODULE_ANY,
+        .lf_min_level = LOG_LEVEL_ERROR,
+    };
+    struct log_export_cursor cursor;
+
+    ltxu_init();
+
+    ltxu_populate_log(200);
+
+    log_export_init(&cursor, 0, NULL);
+    ltxu_verify_stream(&cursor, 244, -1);
+    log_export_init(&cursor, 0, NULL);
+    ltxu_verify_stream(&cursor, 20, -1);
+
+    /* Sending fails part way; the stream resumes after the last fragment. */
+    log_export_init(&cursor, 0, NULL);
+    ltxu_verify_stream(&cursor, 244, 5);
+    log_export_init(&cursor, 0, &filter);
+    ltxu_verify_stream(&cursor, 244, 2);
+
+    /* A finished stream picks up entries appended since. */
+    ltxu_populate_log(30);
+    ltxu_verify_stream(&cursor, 244, -1);
+}
@@ -28,6 +28,7 @@ struct ltfbu_cfg {
     int body_len;
     int bmark_count;
     int pop_count;
+    int auto_spacing;
 };
 
 void ltfbu_populate_log(int count);
@@ -40,5 +41,7 @@ TEST_CASE_DECL(log_test_case_fcb_bookmarks_s0_l1_b1_p100);
 TEST_CASE_DECL(log_test_case_fcb_bookmarks_s10_l100_b1_p200);
 TEST_CASE_DECL(log_test_case_fcb_bookmarks_s10_l100_b10_p2000);
 TEST_CASE_DECL(log_test_case_fcb_bookmarks_s100_l500_b10_p2000);
+TEST_CASE_DECL(log_test_case_fcb_bookmarks_auto_s0_l10_b4_p500);
+TEST_CASE_DECL(log_test_case_fcb_bookmarks_auto_s10_l100_b16_p2000);
 
 #endif
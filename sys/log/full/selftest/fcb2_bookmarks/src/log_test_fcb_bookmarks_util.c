@@ -192,6 +192,46 @@ ltfbu_verify_log(uint32_t start_idx)
     TEST_ASSERT_FATAL(arg.cur == slice.count);
 }
 
+/**
+ * Verifies that automatic bookmarks are sorted, point to the entries they
+ * claim to and are no closer together than the current spacing.
+ */
+static void
+ltfbu_verify_auto_bmarks(void)
+{
+    const struct log_fcb_bmark *bmark;
+    const struct log_fcb_bset *bset;
+    struct log_entry_hdr hdr;
+    int pos;
+    int prev;
+    int rc;
+    int i;
+
+    bset = &ltfbu_fcb_log.fl_bset;
+    TEST_ASSERT_FATAL(bset->lfs_size <= bset->lfs_cap);
+    TEST_ASSERT_FATAL(bset->lfs_spacing >= ltfbu_cfg.auto_spacing);
+
+    prev = -1;
+    for (i = 0; i < bset->lfs_size; i++) {
+        bmark = &bset->lfs_bmarks[i];
+
+        rc = log_read_hdr(&ltfbu_log, &bmark->lfb_entry, &hdr);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(hdr.ue_index == bmark->lfb_index);
+
+        for (pos = 0; pos < ltfbu_num_entry_idxs; pos++) {
+            if (ltfbu_entry_idxs[pos] == bmark->lfb_index) {
+                break;
+            }
+        }
+        TEST_ASSERT_FATAL(pos < ltfbu_num_entry_idxs);
+        if (prev >= 0) {
+            TEST_ASSERT_FATAL(pos - prev >= ltfbu_cfg.auto_spacing);
+        }
+        prev = pos;
+    }
+}
+
 void
 ltfbu_init(const struct ltfbu_cfg *cfg)
 {
@@ -219,7 +259,10 @@ ltfbu_init(const struct ltfbu_cfg *cfg)
     rc = fcb2_init(&ltfbu_fcb_log.fl_fcb);
     TEST_ASSERT_FATAL(rc == 0);
 
-    if (cfg->bmark_count > 0) {
+    if (cfg->auto_spacing > 0) {
+        log_fcb_init_auto_bmarks(&ltfbu_fcb_log, ltfbu_bmarks,
+                                 cfg->bmark_count, cfg->auto_spacing);
+    } else if (cfg->bmark_count > 0) {
         log_fcb_init_bmarks(&ltfbu_fcb_log, ltfbu_bmarks, cfg->bmark_count);
     }
 
@@ -247,6 +290,9 @@ ltfbu_test_once(const struct ltfbu_cfg *cfg)
      */
     for (i = 0; i < 3; i++) {
         ltfbu_populate_log(cfg->pop_count);
+        if (cfg->auto_spacing > 0) {
+            ltfbu_verify_auto_bmarks();
+        }
 
         start_idx = 0;
         while (start_idx < ltfbu_entry_idxs[ltfbu_num_entry_idxs - 1]) {
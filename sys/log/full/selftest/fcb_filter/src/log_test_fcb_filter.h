@@ -0,0 +1,37 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_LOG_TEST_FCB_FILTER_
+#define H_LOG_TEST_FCB_FILTER_
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+void ltffu_init(void);
+void ltffu_populate_log(int count);
+void ltffu_remount(void);
+void ltffu_flush(void);
+void ltffu_verify_summary(void);
+void ltffu_verify_filters(void);
+
+TEST_CASE_DECL(log_test_case_fcb_filter_match);
+TEST_CASE_DECL(log_test_case_fcb_filter_remount);
+TEST_CASE_DECL(log_test_case_fcb_filter_flush);
+
+#endif
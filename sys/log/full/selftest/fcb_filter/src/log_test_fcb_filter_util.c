@@ -0,0 +1,302 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_fcb_filter.h"
+
+#define LTFFU_MAX_ENTRY_IDXS    8192
+#define LTFFU_BODY_LEN          80
+
+#define LTFFU_SECTOR_SIZE       (16 * 1024)
+#define LTFFU_SECTOR_CNT        4
+
+/* Entries are written in runs from one module; see ltffu_populate_log(). */
+#define LTFFU_RUN_LEN           150
+
+struct ltffu_walk_arg {
+    const struct log_filter *filter;
+    uint32_t idxs[LTFFU_MAX_ENTRY_IDXS];
+    int count;
+};
+
+/*
+ * Module 70 shares a summary bit with module 6, so sectors holding only the
+ * former still have to be read when filtering for the latter.
+ */
+static const uint8_t ltffu_modules[] = { 1, 12, 12, 70, 200, 12 };
+
+static const struct log_filter ltffu_filters[] = {
+    { .lf_module = LOG_FILTER_MODULE_ANY, .lf_min_level = LOG_LEVEL_DEBUG },
+    { .lf_module = LOG_FILTER_MODULE_ANY, .lf_min_level = LOG_LEVEL_ERROR },
+    { .lf_module = 12,  .lf_min_level = LOG_LEVEL_DEBUG },
+    { .lf_module = 12,  .lf_min_level = LOG_LEVEL_ERROR },
+    { .lf_module = 6,   .lf_min_level = LOG_LEVEL_DEBUG },
+    { .lf_module = 200, .lf_min_level = LOG_LEVEL_INFO },
+    { .lf_module = 1,   .lf_min_level = LOG_LEVEL_ERROR },
+};
+
+/* Neither module 99 nor level CRITICAL is ever written. */
+static const struct log_filter ltffu_filters_none[] = {
+    { .lf_module = 99, .lf_min_level = LOG_LEVEL_DEBUG },
+    { .lf_module = LOG_FILTER_MODULE_ANY, .lf_min_level = LOG_LEVEL_CRITICAL },
+};
+
+static struct ltffu_walk_arg ltffu_expected;
+static struct ltffu_walk_arg ltffu_actual;
+static int ltffu_num_entries;
+
+static struct fcb_log ltffu_fcb_log;
+static struct log ltffu_log;
+
+static struct log_fcb_sector_idx ltffu_sidx[LTFFU_SECTOR_CNT];
+
+static void
+ltffu_setup_fcb(void)
+{
+    int rc;
+
+    ltu_init_fcb(&ltffu_fcb_log, LTFFU_SECTOR_CNT, 1);
+
+    rc = log_fcb_init_sector_idx(&ltffu_fcb_log, ltffu_sidx,
+                                 LTFFU_SECTOR_CNT);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+void
+ltffu_init(void)
+{
+    ltu_erase_fcb_areas(LTFFU_SECTOR_SIZE, LTFFU_SECTOR_CNT);
+    ltffu_setup_fcb();
+    ltffu_num_entries = 0;
+
+    log_register("log", &ltffu_log, &log_fcb_handler, &ltffu_fcb_log,
+                 LOG_LEVEL_DEBUG);
+}
+
+/**
+ * Simulates a reboot; see ltfsu_remount() in the sector index tests.
+ */
+void
+ltffu_remount(void)
+{
+    int rc;
+
+    ltffu_setup_fcb();
+
+    rc = log_fcb_handler.log_registered(&ltffu_log);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+void
+ltffu_flush(void)
+{
+    int rc;
+
+    rc = log_flush(&ltffu_log);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+/**
+ * Appends entries in runs of LTFFU_RUN_LEN from the same module, so that
+ * most sectors hold only one or two modules.  Most entries are DEBUG or
+ * INFO; a few are ERROR, except in runs from module 70.
+ */
+void
+ltffu_populate_log(int count)
+{
+    uint8_t body[LTFFU_BODY_LEN];
+    uint8_t module;
+    uint8_t level;
+    int rc;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        module = ltffu_modules[(ltffu_num_entries / LTFFU_RUN_LEN) %
+                               ARRAY_SIZE(ltffu_modules)];
+        if (module != 70 && ltffu_num_entries % 53 == 0) {
+            level = LOG_LEVEL_ERROR;
+        } else {
+            level = ltffu_num_entries % 2;
+        }
+        ltffu_num_entries++;
+
+        memset(body, i, sizeof body);
+        rc = log_append_body(&ltffu_log, module, level, LOG_ETYPE_BINARY,
+                             body, sizeof body);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+/**
+ * Verifies that the summary of every sector with entries matches its
+ * contents exactly.
+ */
+void
+ltffu_verify_summary(void)
+{
+    const struct log_fcb_sector_idx *sidx;
+    struct log_entry_hdr hdr;
+    struct fcb_entry loc;
+    struct fcb *fcb;
+    uint64_t modules;
+    uint8_t max_level;
+    int valid;
+    int rc;
+    int i;
+
+    fcb = &ltffu_fcb_log.fl_fcb;
+
+    for (i = 0; i < LTFFU_SECTOR_CNT; i++) {
+        sidx = &ltffu_sidx[i];
+
+        memset(&loc, 0, sizeof loc);
+        loc.fe_area = &fcb->f_sectors[i];
+        valid = 0;
+        modules = 0;
+        max_level = 0;
+        while (fcb_getnext(fcb, &loc) == 0 &&
+               loc.fe_area == &fcb->f_sectors[i]) {
+
+            rc = log_read_hdr(&ltffu_log, &loc, &hdr);
+            TEST_ASSERT_FATAL(rc == 0);
+            valid = 1;
+            modules |= (uint64_t)1 << (hdr.ue_module % 64);
+            if (hdr.ue_level > max_level) {
+                max_level = hdr.ue_level;
+            }
+        }
+
+        TEST_ASSERT_FATAL(!!sidx->lsi_valid == valid);
+        if (valid) {
+            TEST_ASSERT_FATAL(sidx->lsi_modules == modules);
+            TEST_ASSERT_FATAL(sidx->lsi_max_level == max_level);
+        }
+    }
+}
+
+static int
+ltffu_collect_walk(struct log *log, struct log_offset *log_offset,
+                   const struct log_entry_hdr *hdr, const void *dptr,
+                   uint16_t len)
+{
+    struct ltffu_walk_arg *arg;
+
+    arg = log_offset->lo_arg;
+    if (arg->filter != NULL && !log_filter_match(arg->filter, hdr)) {
+        return 0;
+    }
+
+    TEST_ASSERT_FATAL(arg->count < LTFFU_MAX_ENTRY_IDXS);
+    arg->idxs[arg->count++] = hdr->ue_index;
+
+    return 0;
+}
+
+static int
+ltffu_count_walk(struct log *log, struct log_offset *log_offset,
+                 const void *dptr, uint16_t len)
+{
+    (*(int *)log_offset->lo_arg)++;
+
+    return 0;
+}
+
+/**
+ * Compares a filtered walk against a full walk that filters each entry
+ * itself.
+ */
+static void
+ltffu_verify_filter(const struct log_filter *filter, uint32_t start_idx)
+{
+    struct log_offset log_offset;
+    int rc;
+
+    ltffu_expected.filter = filter;
+    ltffu_expected.count = 0;
+    log_offset = (struct log_offset) {
+        .lo_arg = &ltffu_expected,
+        .lo_index = start_idx,
+    };
+    rc = log_walk_body(&ltffu_log, ltffu_collect_walk, &log_offset);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* The filtered walk must not rely on the callback to filter. */
+    ltffu_actual.filter = NULL;
+    ltffu_actual.count = 0;
+    log_offset = (struct log_offset) {
+        .lo_arg = &ltffu_actual,
+        .lo_index = start_idx,
+    };
+    rc = log_walk_filtered(&ltffu_log, filter, ltffu_collect_walk,
+                           &log_offset);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    TEST_ASSERT_FATAL(ltffu_actual.count == ltffu_expected.count);
+    TEST_ASSERT_FATAL(memcmp(ltffu_actual.idxs, ltffu_expected.idxs,
+                             ltffu_expected.count *
+                             sizeof ltffu_expected.idxs[0]) == 0);
+}
+
+/**
+ * Verifies filtered walks from a few starting points, and that sectors
+ * which cannot match are not read at all.
+ */
+void
+ltffu_verify_filters(void)
+{
+    struct log_offset log_offset;
+    uint32_t start_idx;
+    int visited;
+    int rc;
+    int i;
+
+    ltffu_expected.filter = NULL;
+    ltffu_expected.count = 0;
+    log_offset = (struct log_offset) {
+        .lo_arg = &ltffu_expected,
+    };
+    rc = log_walk_body(&ltffu_log, ltffu_collect_walk, &log_offset);
+    TEST_ASSERT_FATAL(rc == 0);
+    if (ltffu_expected.count == 0) {
+        start_idx = 0;
+    } else {
+        start_idx = ltffu_expected.idxs[ltffu_expected.count / 2];
+    }
+
+    for (i = 0; i < ARRAY_SIZE(ltffu_filters); i++) {
+        ltffu_verify_filter(&ltffu_filters[i], 0);
+        ltffu_verify_filter(&ltffu_filters[i], start_idx);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(ltffu_filters_none); i++) {
+        ltffu_verify_filter(&ltffu_filters_none[i], 0);
+        TEST_ASSERT_FATAL(ltffu_actual.count == 0);
+
+        visited = 0;
+        log_offset = (struct log_offset) {
+            .lo_arg = &visited,
+        };
+        rc = log_fcb_handler.log_walk_filtered(&ltffu_log,
+                                               &ltffu_filters_none[i],
+                                               ltffu_count_walk,
+                                               &log_offset);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(visited == 0);
+    }
+}
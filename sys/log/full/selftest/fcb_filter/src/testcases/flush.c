@@ -0,0 +1,36 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_fcb_filter.h"
+
+TEST_CASE_SELF(log_test_case_fcb_filter_flush)
+{
+    ltffu_init();
+
+    ltffu_populate_log(600);
+    ltffu_flush();
+    ltffu_verify_summary();
+    ltffu_verify_filters();
+
+    /* Summaries start over after a flush. */
+    ltffu_populate_log(200);
+    ltffu_verify_summary();
+    ltffu_verify_filters();
+}
@@ -0,0 +1,39 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_LOG_TEST_FCB_GROUP_
+#define H_LOG_TEST_FCB_GROUP_
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+void ltfgu_init(int buf_size, int count);
+void ltfgu_populate_log(int count, int body_len);
+int ltfgu_flash_entry_cnt(void);
+int ltfgu_staged_entry_cnt(void);
+void ltfgu_verify_entries(int count);
+void ltfgu_commit(void);
+void ltfgu_flush(void);
+
+TEST_CASE_DECL(log_test_case_fcb_group_stage_count);
+TEST_CASE_DECL(log_test_case_fcb_group_stage_size);
+TEST_CASE_DECL(log_test_case_fcb_group_rotate);
+TEST_CASE_DECL(log_test_case_fcb_group_flush);
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_fcb_group.h"
+
+#define LTFGU_MAX_BUF_SIZE      1024
+#define LTFGU_MAX_ENTRIES       32
+
+#define LTFGU_SECTOR_SIZE       (4 * 1024)
+#define LTFGU_SECTOR_CNT        4
+
+static struct fcb_log ltfgu_fcb_log;
+static struct log ltfgu_log;
+
+static uint8_t ltfgu_buf[LTFGU_MAX_BUF_SIZE];
+static uint16_t ltfgu_lens[LTFGU_MAX_ENTRIES];
+static struct fcb_entry ltfgu_locs[LTFGU_MAX_ENTRIES];
+
+/**
+ * Sets up an empty log which stages up to `count` entries in a `buf_size`
+ * byte buffer.  The age limit is disabled; entries are only committed when
+ * the buffer fills up or a commit is requested.
+ */
+void
+ltfgu_init(int buf_size, int count)
+{
+    int rc;
+
+    TEST_ASSERT_FATAL(buf_size <= LTFGU_MAX_BUF_SIZE);
+    TEST_ASSERT_FATAL(count <= LTFGU_MAX_ENTRIES);
+
+    ltu_erase_fcb_areas(LTFGU_SECTOR_SIZE, LTFGU_SECTOR_CNT);
+    ltu_init_fcb(&ltfgu_fcb_log, LTFGU_SECTOR_CNT, 1);
+
+    /* A missing buffer is rejected. */
+    rc = log_fcb_init_group(&ltfgu_fcb_log, NULL, buf_size, ltfgu_locs,
+                            ltfgu_lens, count, 0);
+    TEST_ASSERT(rc == SYS_EINVAL);
+
+    rc = log_fcb_init_group(&ltfgu_fcb_log, ltfgu_buf, buf_size, ltfgu_locs,
+                            ltfgu_lens, count, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    log_register("log", &ltfgu_log, &log_fcb_handler, &ltfgu_fcb_log,
+                 LOG_SYSLEVEL);
+}
+
+void
+ltfgu_populate_log(int count, int body_len)
+{
+    ltu_populate_log(&ltfgu_log, count, body_len);
+}
+
+/**
+ * Counts the entries which have reached flash, without committing the
+ * staged ones.
+ */
+int
+ltfgu_flash_entry_cnt(void)
+{
+    struct fcb_entry loc;
+    int cnt;
+
+    memset(&loc, 0, sizeof loc);
+    cnt = 0;
+    while (fcb_getnext(&ltfgu_fcb_log.fl_fcb, &loc) == 0) {
+        cnt++;
+    }
+
+    return cnt;
+}
+
+int
+ltfgu_staged_entry_cnt(void)
+{
+    return ltfgu_fcb_log.fl_group.lfg_cnt;
+}
+
+/**
+ * Verifies the log contents as ltu_verify_entries() does; the walk must
+ * also have committed whatever was staged.
+ */
+void
+ltfgu_verify_entries(int count)
+{
+    ltu_verify_entries(&ltfgu_log, count);
+    TEST_ASSERT(ltfgu_staged_entry_cnt() == 0);
+}
+
+void
+ltfgu_commit(void)
+{
+    int rc;
+
+    rc = log_fcb_commit(&ltfgu_log);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+void
+ltfgu_flush(void)
+{
+    int rc;
+
+    rc = log_flush(&ltfgu_log);
+    TEST_ASSERT_FATAL(rc == 0);
+}
@@ -0,0 +1,43 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_fcb_group.h"
+
+TEST_CASE_SELF(log_test_case_fcb_group_stage_size)
+{
+    /* Entries are committed once the buffer is full. */
+    ltfgu_init(128, 32);
+
+    ltfgu_populate_log(2, 40);
+    TEST_ASSERT(ltfgu_flash_entry_cnt() == 0);
+
+    ltfgu_populate_log(1, 40);
+    TEST_ASSERT(ltfgu_flash_entry_cnt() == 2);
+    TEST_ASSERT(ltfgu_staged_entry_cnt() == 1);
+
+    /* An entry larger than the buffer is written directly, after the staged
+     * ones.
+     */
+    ltfgu_populate_log(1, 120);
+    TEST_ASSERT(ltfgu_flash_entry_cnt() == 4);
+    TEST_ASSERT(ltfgu_staged_entry_cnt() == 0);
+
+    ltfgu_verify_entries(4);
+}
@@ -0,0 +1,42 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_LOG_TEST_FCB_PRE_ERASE_
+#define H_LOG_TEST_FCB_PRE_ERASE_
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+void ltpeu_init(void);
+void ltpeu_populate_log(int count, int body_len);
+int ltpeu_free_sector_cnt(void);
+int ltpeu_run_events(void);
+int ltpeu_stall_cnt(void);
+void ltpeu_erase_task(void *arg);
+int ltpeu_lock(void);
+void ltpeu_unlock(void);
+int ltpeu_erase_bg_cnt(void);
+void ltpeu_verify_entries(void);
+
+TEST_CASE_DECL(log_test_case_fcb_pre_erase_schedule);
+TEST_CASE_DECL(log_test_case_fcb_pre_erase_no_stall);
+TEST_CASE_DECL(log_test_case_fcb_pre_erase_stall);
+TEST_CASE_DECL(log_test_case_fcb_pre_erase_concurrent);
+
+#endif
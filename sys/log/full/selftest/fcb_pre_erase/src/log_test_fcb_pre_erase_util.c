@@ -0,0 +1,125 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_fcb_pre_erase.h"
+
+#define LTPEU_SECTOR_SIZE       (4 * 1024)
+#define LTPEU_SECTOR_CNT        4
+
+static struct fcb_log ltpeu_fcb_log;
+static struct log ltpeu_log;
+static struct os_eventq ltpeu_evq;
+
+/**
+ * Sets up an empty log which erases from a private event queue.  The OS is
+ * not running, so the test runs the queued events itself.
+ */
+void
+ltpeu_init(void)
+{
+    ltu_erase_fcb_areas(LTPEU_SECTOR_SIZE, LTPEU_SECTOR_CNT);
+    ltu_init_fcb(&ltpeu_fcb_log, LTPEU_SECTOR_CNT, 1);
+
+    os_eventq_init(&ltpeu_evq);
+    log_fcb_init_pre_erase(&ltpeu_fcb_log, &ltpeu_evq);
+
+    log_register("log", &ltpeu_log, &log_fcb_handler, &ltpeu_fcb_log,
+                 LOG_SYSLEVEL);
+}
+
+void
+ltpeu_populate_log(int count, int body_len)
+{
+    ltu_populate_log(&ltpeu_log, count, body_len);
+}
+
+int
+ltpeu_free_sector_cnt(void)
+{
+    return fcb_free_sector_cnt(&ltpeu_fcb_log.fl_fcb);
+}
+
+/**
+ * Runs the queued erase events; returns how many there were.
+ */
+int
+ltpeu_run_events(void)
+{
+    struct os_event *ev;
+    int cnt;
+
+    cnt = 0;
+    while ((ev = os_eventq_get_no_wait(&ltpeu_evq)) != NULL) {
+        ev->ev_cb(ev);
+        cnt++;
+    }
+
+    return cnt;
+}
+
+/**
+ * Counts the appends which had to erase a sector themselves.
+ */
+int
+ltpeu_stall_cnt(void)
+{
+    return STATS_GET(ltpeu_log.l_stats, stall_lt1ms) +
+           STATS_GET(ltpeu_log.l_stats, stall_lt4ms) +
+           STATS_GET(ltpeu_log.l_stats, stall_lt16ms) +
+           STATS_GET(ltpeu_log.l_stats, stall_lt64ms) +
+           STATS_GET(ltpeu_log.l_stats, stall_lt256ms) +
+           STATS_GET(ltpeu_log.l_stats, stall_ge256ms);
+}
+
+/**
+ * Serves one erase event; meant to run as a background task.
+ */
+void
+ltpeu_erase_task(void *arg)
+{
+    struct os_event *ev;
+
+    ev = os_eventq_get(&ltpeu_evq);
+    ev->ev_cb(ev);
+}
+
+int
+ltpeu_lock(void)
+{
+    return log_fcb_pre_erase_lock(&ltpeu_fcb_log);
+}
+
+void
+ltpeu_unlock(void)
+{
+    log_fcb_pre_erase_unlock(&ltpeu_fcb_log);
+}
+
+int
+ltpeu_erase_bg_cnt(void)
+{
+    return STATS_GET(ltpeu_log.l_stats, erase_bg);
+}
+
+void
+ltpeu_verify_entries(void)
+{
+    ltu_verify_entries(&ltpeu_log, -1);
+}
@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "taskpool/taskpool.h"
+#include "log_test_fcb_pre_erase.h"
+
+static int ltpe_append_cnt;
+static int ltpe_append_done;
+
+static void
+ltpe_append_task(void *arg)
+{
+    ltpeu_populate_log(ltpe_append_cnt, 60);
+    ltpe_append_done = 1;
+}
+
+TEST_CASE_TASK(log_test_case_fcb_pre_erase_concurrent)
+{
+    uint8_t prio;
+    int sector_cnt;
+
+    ltpeu_init();
+
+    /* Fill the log up to its last erased sector, which schedules an erase.
+     * Count the entries which fit in the middle sector along the way.
+     */
+    sector_cnt = 0;
+    while (ltpeu_free_sector_cnt() > 1) {
+        ltpeu_populate_log(1, 60);
+        if (ltpeu_free_sector_cnt() == 2) {
+            sector_cnt++;
+        }
+    }
+
+    /* Hold the rotation lock, as if the log were being rotated.  The erase
+     * task, and then an appender which fills the last sector, both find the
+     * log short of space and wait for the lock.  The erase task has the
+     * higher priority, so it gets the lock first.
+     */
+    prio = os_sched_get_current_task()->t_prio;
+    TEST_ASSERT_FATAL(ltpeu_lock() == 0);
+    taskpool_alloc_assert(ltpeu_erase_task, prio - 2);
+    ltpe_append_cnt = sector_cnt;
+    ltpe_append_done = 0;
+    taskpool_alloc_assert(ltpe_append_task, prio - 1);
+    TEST_ASSERT(!ltpe_append_done);
+    TEST_ASSERT(ltpeu_free_sector_cnt() == 1);
+
+    ltpeu_unlock();
+    taskpool_wait_assert(OS_TICKS_PER_SEC);
+
+    /* The erase task rotated the log once; the appender found room when it
+     * got the lock, and did not rotate it again.
+     */
+    TEST_ASSERT(ltpe_append_done);
+    TEST_ASSERT(ltpeu_erase_bg_cnt() == 1);
+    TEST_ASSERT(ltpeu_stall_cnt() == 0);
+    TEST_ASSERT(ltpeu_free_sector_cnt() == 1);
+    TEST_ASSERT(ltpeu_run_events() == 1);
+    TEST_ASSERT(ltpeu_free_sector_cnt() == 2);
+    ltpeu_verify_entries();
+}
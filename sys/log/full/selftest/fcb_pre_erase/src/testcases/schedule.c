@@ -0,0 +1,52 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_fcb_pre_erase.h"
+
+TEST_CASE_SELF(log_test_case_fcb_pre_erase_schedule)
+{
+    int free_cnt;
+
+    ltpeu_init();
+    TEST_ASSERT(ltpeu_free_sector_cnt() == 3);
+
+    /* Nothing is scheduled while two or more erased sectors remain. */
+    while (ltpeu_free_sector_cnt() > 1) {
+        ltpeu_populate_log(1, 60);
+        free_cnt = ltpeu_free_sector_cnt();
+        if (free_cnt > 1) {
+            TEST_ASSERT(ltpeu_run_events() == 0);
+        }
+    }
+
+    /* Taking the next to last erased sector into use schedules one erase,
+     * which frees the oldest sector.
+     */
+    TEST_ASSERT(ltpeu_run_events() == 1);
+    TEST_ASSERT(ltpeu_free_sector_cnt() == 2);
+    TEST_ASSERT(ltpeu_erase_bg_cnt() == 1);
+    TEST_ASSERT(ltpeu_stall_cnt() == 0);
+
+    /* Appends within the same sector do not schedule more. */
+    ltpeu_populate_log(1, 60);
+    TEST_ASSERT(ltpeu_run_events() == 0);
+
+    ltpeu_verify_entries();
+}
@@ -0,0 +1,43 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_fcb_pre_erase.h"
+
+TEST_CASE_SELF(log_test_case_fcb_pre_erase_stall)
+{
+    int cnt;
+
+    ltpeu_init();
+
+    /* Appends which outpace the erase events erase inline, and get
+     * counted.
+     */
+    ltpeu_populate_log(300, 60);
+    TEST_ASSERT(ltpeu_stall_cnt() > 0);
+    TEST_ASSERT(ltpeu_erase_bg_cnt() == 0);
+    ltpeu_verify_entries();
+
+    /* The events which were queued meanwhile restore the reserve. */
+    cnt = ltpeu_stall_cnt();
+    TEST_ASSERT(ltpeu_run_events() == 1);
+    TEST_ASSERT(ltpeu_free_sector_cnt() == 2);
+    TEST_ASSERT(ltpeu_stall_cnt() == cnt);
+    ltpeu_verify_entries();
+}
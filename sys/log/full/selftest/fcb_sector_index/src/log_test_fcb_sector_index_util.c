@@ -0,0 +1,288 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_fcb_sector_index.h"
+
+#define LTFSU_MAX_ENTRY_IDXS    8192
+#define LTFSU_MAX_BODY_LEN      256
+
+#define LTFSU_SECTOR_SIZE       (16 * 1024)
+#define LTFSU_SECTOR_CNT        4
+
+struct ltfsu_walk_arg {
+    const uint32_t *idxs;
+    int count;
+    int cur;
+};
+
+static uint32_t ltfsu_entry_idxs[LTFSU_MAX_ENTRY_IDXS];
+static int ltfsu_num_entry_idxs;
+
+static struct fcb_log ltfsu_fcb_log;
+static struct log ltfsu_log;
+
+static struct log_fcb_sector_idx ltfsu_sidx[LTFSU_SECTOR_CNT];
+
+static struct flash_area ltfsu_fcb_areas[LTFSU_SECTOR_CNT] = {
+    [0] = {
+        .fa_off = 0 * LTFSU_SECTOR_SIZE,
+        .fa_size = LTFSU_SECTOR_SIZE,
+    },
+    [1] = {
+        .fa_off = 1 * LTFSU_SECTOR_SIZE,
+        .fa_size = LTFSU_SECTOR_SIZE,
+    },
+    [2] = {
+        .fa_off = 2 * LTFSU_SECTOR_SIZE,
+        .fa_size = LTFSU_SECTOR_SIZE,
+    },
+    [3] = {
+        .fa_off = 3 * LTFSU_SECTOR_SIZE,
+        .fa_size = LTFSU_SECTOR_SIZE,
+    },
+};
+
+static void
+ltfsu_setup_fcb(void)
+{
+    int rc;
+
+    ltfsu_fcb_log = (struct fcb_log) {
+        .fl_fcb.f_scratch_cnt = 1,
+        .fl_fcb.f_sectors = ltfsu_fcb_areas,
+        .fl_fcb.f_sector_cnt = LTFSU_SECTOR_CNT,
+        .fl_fcb.f_magic = 0x7EADBADF,
+        .fl_fcb.f_version = 0,
+    };
+
+    rc = fcb_init(&ltfsu_fcb_log.fl_fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = log_fcb_init_sector_idx(&ltfsu_fcb_log, ltfsu_sidx,
+                                 LTFSU_SECTOR_CNT);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+void
+ltfsu_init(void)
+{
+    int rc;
+    int i;
+
+    /* Ensure tests are repeatable. */
+    srand(0);
+
+    for (i = 0; i < LTFSU_SECTOR_CNT; i++) {
+        rc = flash_area_erase(&ltfsu_fcb_areas[i], 0,
+                              ltfsu_fcb_areas[i].fa_size);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    ltfsu_setup_fcb();
+
+    /* A buffer smaller than the FCB is rejected. */
+    rc = log_fcb_init_sector_idx(&ltfsu_fcb_log, ltfsu_sidx,
+                                 LTFSU_SECTOR_CNT - 1);
+    TEST_ASSERT(rc == SYS_EINVAL);
+
+    log_register("log", &ltfsu_log, &log_fcb_handler, &ltfsu_fcb_log,
+                 LOG_SYSLEVEL);
+}
+
+/**
+ * Simulates a reboot: the FCB state and the sector index are rebuilt from
+ * the contents of flash.  Logs cannot be registered again once they have
+ * been written to, so the handler's registration callback is invoked
+ * directly.
+ */
+void
+ltfsu_remount(void)
+{
+    int rc;
+
+    ltfsu_setup_fcb();
+
+    rc = log_fcb_handler.log_registered(&ltfsu_log);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+void
+ltfsu_flush(void)
+{
+    int rc;
+
+    rc = log_flush(&ltfsu_log);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+void
+ltfsu_populate_log(int count, int skip_mod, int body_len)
+{
+    uint8_t body[LTFSU_MAX_BODY_LEN];
+    int rc;
+    int i;
+
+    TEST_ASSERT_FATAL(body_len <= LTFSU_MAX_BODY_LEN);
+
+    for (i = 0; i < count; i++) {
+        if (skip_mod != 0) {
+            g_log_info.li_next_index += rand() % skip_mod;
+        }
+
+        memset(body, i, body_len);
+        rc = log_append_body(&ltfsu_log, 0, 255, LOG_ETYPE_BINARY, body,
+                             body_len);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+static int
+ltfsu_collect_walk(struct log *log, struct log_offset *log_offset,
+                   const struct log_entry_hdr *hdr, const void *dptr,
+                   uint16_t len)
+{
+    TEST_ASSERT_FATAL(ltfsu_num_entry_idxs < LTFSU_MAX_ENTRY_IDXS);
+    ltfsu_entry_idxs[ltfsu_num_entry_idxs++] = hdr->ue_index;
+
+    return 0;
+}
+
+static int
+ltfsu_verify_walk(struct log *log, struct log_offset *log_offset,
+                  const struct log_entry_hdr *hdr, const void *dptr,
+                  uint16_t len)
+{
+    struct ltfsu_walk_arg *arg;
+
+    arg = log_offset->lo_arg;
+
+    TEST_ASSERT_FATAL(arg->cur < arg->count);
+    TEST_ASSERT_FATAL(hdr->ue_index == arg->idxs[arg->cur]);
+    arg->cur++;
+
+    return 0;
+}
+
+static void
+ltfsu_collect_entries(void)
+{
+    struct log_offset log_offset = { 0 };
+    int rc;
+    int i;
+
+    /* A walk from index 0 starts at the oldest entry without the index. */
+    ltfsu_num_entry_idxs = 0;
+    rc = log_walk_body(&ltfsu_log, ltfsu_collect_walk, &log_offset);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 1; i < ltfsu_num_entry_idxs; i++) {
+        TEST_ASSERT_FATAL(ltfsu_entry_idxs[i] > ltfsu_entry_idxs[i - 1]);
+    }
+}
+
+/**
+ * Verifies that every valid index element matches the sector contents.
+ */
+void
+ltfsu_verify_index(void)
+{
+    const struct log_fcb_sector_idx *sidx;
+    struct log_entry_hdr hdr;
+    struct fcb_entry loc;
+    struct fcb *fcb;
+    uint32_t last;
+    int valid;
+    int rc;
+    int i;
+
+    fcb = &ltfsu_fcb_log.fl_fcb;
+
+    for (i = 0; i < LTFSU_SECTOR_CNT; i++) {
+        sidx = &ltfsu_sidx[i];
+
+        memset(&loc, 0, sizeof loc);
+        loc.fe_area = &ltfsu_fcb_areas[i];
+        valid = 0;
+        last = 0;
+        while (fcb_getnext(fcb, &loc) == 0 &&
+               loc.fe_area == &ltfsu_fcb_areas[i]) {
+
+            rc = log_read_hdr(&ltfsu_log, &loc, &hdr);
+            TEST_ASSERT_FATAL(rc == 0);
+            if (!valid) {
+                TEST_ASSERT_FATAL(sidx->lsi_valid);
+                TEST_ASSERT_FATAL(sidx->lsi_first_index == hdr.ue_index);
+                valid = 1;
+            }
+            last = hdr.ue_index;
+        }
+
+        if (valid) {
+            TEST_ASSERT_FATAL(sidx->lsi_last_index >= last);
+            if (&ltfsu_fcb_areas[i] == fcb->f_active.fe_area) {
+                TEST_ASSERT_FATAL(sidx->lsi_last_index == last);
+            }
+        } else {
+            TEST_ASSERT_FATAL(!sidx->lsi_valid);
+        }
+    }
+}
+
+/**
+ * Verifies that a walk starting at any index visits exactly the entries
+ * with an index at least as great.
+ */
+void
+ltfsu_verify_seeks(void)
+{
+    struct ltfsu_walk_arg arg;
+    struct log_offset log_offset;
+    uint32_t start_idx;
+    uint32_t end_idx;
+    int first;
+    int rc;
+
+    ltfsu_collect_entries();
+    if (ltfsu_num_entry_idxs == 0) {
+        return;
+    }
+
+    first = 0;
+    end_idx = ltfsu_entry_idxs[ltfsu_num_entry_idxs - 1] + 2;
+    for (start_idx = 0; start_idx <= end_idx; start_idx += rand() % 8 + 1) {
+        while (first < ltfsu_num_entry_idxs &&
+               ltfsu_entry_idxs[first] < start_idx) {
+            first++;
+        }
+
+        arg = (struct ltfsu_walk_arg) {
+            .idxs = &ltfsu_entry_idxs[first],
+            .count = ltfsu_num_entry_idxs - first,
+        };
+        log_offset = (struct log_offset) {
+            .lo_arg = &arg,
+            .lo_index = start_idx,
+        };
+
+        rc = log_walk_body(&ltfsu_log, ltfsu_verify_walk, &log_offset);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(arg.cur == arg.count);
+    }
+}
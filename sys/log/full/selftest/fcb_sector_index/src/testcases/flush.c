@@ -0,0 +1,39 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+#include "log_test_fcb_sector_index.h"
+
+TEST_CASE_SELF(log_test_case_fcb_sector_index_flush)
+{
+    ltfsu_init();
+
+    ltfsu_populate_log(600, 2, 80);
+    ltfsu_verify_seeks();
+
+    ltfsu_flush();
+
+    /* Flushing invalidates the index of every sector. */
+    ltfsu_verify_index();
+    ltfsu_verify_seeks();
+
+    ltfsu_populate_log(50, 2, 80);
+    ltfsu_verify_index();
+    ltfsu_verify_seeks();
+}
@@ -50,6 +50,16 @@ void ltu_setup_2fcbs(struct fcb_log *fcb_log1, struct log *log1,
 void ltu_setup_cbmem(struct cbmem *cbmem, struct log *log);
 void ltu_verify_contents(struct log *log);
 
+#if MYNEWT_VAL(LOG_FCB)
+/* Maximum number of sectors ltu_erase_fcb_areas() can lay out. */
+#define LTU_MAX_SECTOR_CNT      4
+
+void ltu_erase_fcb_areas(uint32_t sector_size, int sector_cnt);
+void ltu_init_fcb(struct fcb_log *fcb_log, int sector_cnt, int scratch_cnt);
+#endif
+void ltu_populate_log(struct log *log, int count, int body_len);
+void ltu_verify_entries(struct log *log, int count);
+
 TEST_SUITE_DECL(log_test_suite_cbmem_flat);
 TEST_CASE_DECL(log_test_case_cbmem_append);
 TEST_CASE_DECL(log_test_case_cbmem_append_body);
@@ -43,6 +43,19 @@ static struct flash_sector_range fcb_range = {
 };
 #endif
 
+#if MYNEWT_VAL(LOG_FCB)
+/* Laid out by ltu_erase_fcb_areas(). */
+static struct flash_area ltu_fcb_areas[LTU_MAX_SECTOR_CNT];
+#endif
+
+/* Largest body ltu_populate_log() writes. */
+#define LTU_MAX_BODY_LEN        128
+
+struct ltu_entries_walk_arg {
+    uint32_t next_idx;
+    int count;
+};
+
 static int ltu_str_idx = 0;
 static int ltu_str_max_idx = 0;
 
@@ -323,3 +336,125 @@ ltu_verify_contents(struct log *log)
     rc = log_walk(log, ltu_walk_empty, &log_offset);
     TEST_ASSERT(rc == 0);
 }
+
+#if MYNEWT_VAL(LOG_FCB)
+/**
+ * Lays out `sector_cnt` contiguous sectors of `sector_size` bytes from the
+ * start of flash, and erases them.
+ */
+void
+ltu_erase_fcb_areas(uint32_t sector_size, int sector_cnt)
+{
+    int rc;
+    int i;
+
+    TEST_ASSERT_FATAL(sector_cnt <= LTU_MAX_SECTOR_CNT);
+
+    for (i = 0; i < sector_cnt; i++) {
+        ltu_fcb_areas[i] = (struct flash_area) {
+            .fa_off = i * sector_size,
+            .fa_size = sector_size,
+        };
+        rc = flash_area_erase(&ltu_fcb_areas[i], 0, sector_size);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+/**
+ * Initializes an FCB log over the first `sector_cnt` sectors laid out by
+ * ltu_erase_fcb_areas().  Whatever the sectors already hold is kept, so
+ * calling this again simulates a reboot.
+ */
+void
+ltu_init_fcb(struct fcb_log *fcb_log, int sector_cnt, int scratch_cnt)
+{
+    int rc;
+
+    *fcb_log = (struct fcb_log) {
+        .fl_fcb.f_scratch_cnt = scratch_cnt,
+        .fl_fcb.f_sectors = ltu_fcb_areas,
+        .fl_fcb.f_sector_cnt = sector_cnt,
+        .fl_fcb.f_magic = 0x7EADBADF,
+        .fl_fcb.f_version = 0,
+    };
+
+    rc = fcb_init(&fcb_log->fl_fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+#endif
+
+/**
+ * Appends `count` entries; the body of each is filled with the low byte of
+ * its index.
+ */
+void
+ltu_populate_log(struct log *log, int count, int body_len)
+{
+    uint8_t body[LTU_MAX_BODY_LEN];
+    int rc;
+    int i;
+
+    TEST_ASSERT_FATAL(body_len <= LTU_MAX_BODY_LEN);
+
+    for (i = 0; i < count; i++) {
+        memset(body, g_log_info.li_next_index, body_len);
+        rc = log_append_body(log, 0, 255, LOG_ETYPE_BINARY, body, body_len);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+static int
+ltu_walk_entries(struct log *log, struct log_offset *log_offset,
+                 const struct log_entry_hdr *hdr, const void *dptr,
+                 uint16_t len)
+{
+    struct ltu_entries_walk_arg *arg;
+    uint8_t body[LTU_MAX_BODY_LEN];
+    int rc;
+    int i;
+
+    arg = log_offset->lo_arg;
+
+    /* Entries are contiguous; only the oldest ones may have been erased. */
+    if (arg->count > 0) {
+        TEST_ASSERT_FATAL(hdr->ue_index == arg->next_idx);
+    }
+    arg->next_idx = hdr->ue_index + 1;
+    arg->count++;
+
+    TEST_ASSERT_FATAL(len <= LTU_MAX_BODY_LEN);
+    rc = log_read_body(log, dptr, body, 0, len);
+    TEST_ASSERT_FATAL(rc == len);
+    for (i = 0; i < len; i++) {
+        TEST_ASSERT_FATAL(body[i] == (uint8_t)hdr->ue_index);
+    }
+
+    return 0;
+}
+
+/**
+ * Verifies that a walk returns the `count` most recent entries written by
+ * ltu_populate_log(), or, if `count` is negative, an unbroken run ending at
+ * the most recent entry.
+ */
+void
+ltu_verify_entries(struct log *log, int count)
+{
+    struct ltu_entries_walk_arg arg = { 0 };
+    struct log_offset log_offset = {
+        .lo_arg = &arg,
+    };
+    int rc;
+
+    rc = log_walk_body(log, ltu_walk_entries, &log_offset);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    if (count >= 0) {
+        TEST_ASSERT_FATAL(arg.count == count);
+    } else {
+        TEST_ASSERT_FATAL(arg.count > 0);
+    }
+    if (arg.count > 0) {
+        TEST_ASSERT_FATAL(arg.next_idx == g_log_info.li_next_index);
+    }
+}
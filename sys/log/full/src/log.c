@@ -81,6 +81,18 @@ STATS_NAME_START(logs)
   STATS_NAME(logs, errs)
   STATS_NAME(logs, lost)
   STATS_NAME(logs, too_long)
+#if MYNEWT_VAL(LOG_ASYNC)
+  STATS_NAME(logs, async_drops)
+#endif
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+  STATS_NAME(logs, erase_bg)
+  STATS_NAME(logs, stall_lt1ms)
+  STATS_NAME(logs, stall_lt4ms)
+  STATS_NAME(logs, stall_lt16ms)
+  STATS_NAME(logs, stall_lt64ms)
+  STATS_NAME(logs, stall_lt256ms)
+  STATS_NAME(logs, stall_ge256ms)
+#endif
 STATS_NAME_END(logs)
 #endif
 
@@ -162,6 +174,14 @@ log_init(void)
     log_console_init();
 #endif
 
+#if MYNEWT_VAL(LOG_ASYNC)
+    log_async_init();
+#endif
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+    log_compress_init();
+#endif
+
 #if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
 #if MYNEWT_VAL(LOG_PERSIST_WATERMARK)
     rc = conf_register(&log_conf);
@@ -393,6 +413,12 @@ log_register(const char *name, struct log *log, const struct log_handler *lh,
 #if !MYNEWT_VAL(LOG_GLOBAL_IDX)
     log->l_idx = 0;
 #endif
+#if MYNEWT_VAL(LOG_ASYNC)
+    log->l_async = LOG_ASYNC_NONE;
+#endif
+#if MYNEWT_VAL(LOG_COMPRESS)
+    log->l_compress = 0;
+#endif
 
     if (!log_registered(log)) {
         STAILQ_INSERT_TAIL(&g_log_list, log, l_next);
@@ -495,12 +521,28 @@ log_chk_max_entry_len(struct log *log, uint16_t len)
     return rc;
 }
 
+uint32_t
+log_next_index(struct log *log)
+{
+    uint32_t idx;
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(LOG_GLOBAL_IDX)
+    idx = g_log_info.li_next_index++;
+#else
+    idx = log->l_idx++;
+#endif
+    OS_EXIT_CRITICAL(sr);
+
+    return idx;
+}
+
 static int
 log_append_prepare(struct log *log, uint8_t module, uint8_t level,
                    uint8_t etype, struct log_entry_hdr *ue)
 {
     int rc;
-    int sr;
     struct os_timeval tv;
     uint32_t idx;
 
@@ -538,13 +580,17 @@ log_append_prepare(struct log *log, uint8_t module, uint8_t level,
         goto err;
     }
 
-    OS_ENTER_CRITICAL(sr);
-#if MYNEWT_VAL(LOG_GLOBAL_IDX)
-    idx = g_log_info.li_next_index++;
-#else
-    idx = log->l_idx++;
+#if MYNEWT_VAL(LOG_ASYNC)
+    /* Deferred entries are numbered when they are queued, so that the
+     * indices follow the queue order.
+     */
+    if (log->l_async != LOG_ASYNC_NONE) {
+        idx = 0;
+    } else
 #endif
-    OS_EXIT_CRITICAL(sr);
+    {
+        idx = log_next_index(log);
+    }
 
     /* Try to get UTC Time */
     rc = os_gettimeofday(&tv, NULL);
@@ -613,7 +659,22 @@ log_append_typed(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
         goto err;
     }
 
-    rc = log->l_log->log_append(log, data, len + log_hdr_len(hdr));
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async != LOG_ASYNC_NONE) {
+        return log_async_append(log, hdr,
+                                (uint8_t *)data + log_hdr_len(hdr), NULL, 0,
+                                len);
+    }
+#endif
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+    rc = log_compress_append(log, hdr, (uint8_t *)data + log_hdr_len(hdr),
+                             NULL, 0, len);
+    if (rc > 0)
+#endif
+    {
+        rc = log->l_log->log_append(log, data, len + log_hdr_len(hdr));
+    }
     if (rc != 0) {
         LOG_STATS_INC(log, errs);
         goto err;
@@ -646,7 +707,19 @@ log_append_body(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
         return rc;
     }
 
-    rc = log->l_log->log_append_body(log, &hdr, body, body_len);
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async != LOG_ASYNC_NONE) {
+        return log_async_append(log, &hdr, body, NULL, 0, body_len);
+    }
+#endif
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+    rc = log_compress_append(log, &hdr, body, NULL, 0, body_len);
+    if (rc > 0)
+#endif
+    {
+        rc = log->l_log->log_append_body(log, &hdr, body, body_len);
+    }
     if (rc != 0) {
         LOG_STATS_INC(log, errs);
         return rc;
@@ -676,12 +749,12 @@ log_append_mbuf_typed_no_free(struct log *log, uint8_t module, uint8_t level,
         goto err;
     }
 
-    hdr = (struct log_entry_hdr *)om->om_data;
-
     /*
      * We do a pull up twice, once so that the base header is
      * contiguous, so that we read the flags correctly, second
      * time is so that we account for the image hash as well.
+     * A pull up may move the data (e.g., out of a shared buffer), so the
+     * header pointer is only taken afterwards.
      */
     om = os_mbuf_pullup(om, LOG_BASE_ENTRY_HDR_SIZE);
     if (!om) {
@@ -689,6 +762,7 @@ log_append_mbuf_typed_no_free(struct log *log, uint8_t module, uint8_t level,
         goto err;
     }
 
+    hdr = (struct log_entry_hdr *)om->om_data;
     hdr_len = log_hdr_len(hdr);
 
     om = os_mbuf_pullup(om, hdr_len);
@@ -697,6 +771,8 @@ log_append_mbuf_typed_no_free(struct log *log, uint8_t module, uint8_t level,
         goto err;
     }
 
+    hdr = (struct log_entry_hdr *)om->om_data;
+
     /*
      * Check that the log body length is less than the maximum entry. This code
      * may appear a bit odd in that it checks that the length is greater than
@@ -718,7 +794,26 @@ log_append_mbuf_typed_no_free(struct log *log, uint8_t module, uint8_t level,
         goto drop;
     }
 
-    rc = log->l_log->log_append_mbuf(log, om);
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async != LOG_ASYNC_NONE) {
+        rc = log_async_append(log, hdr, NULL, om, hdr_len,
+                              len > hdr_len ? len - hdr_len : 0);
+        if (rc != 0) {
+            goto drop;
+        }
+        *om_ptr = om;
+        return 0;
+    }
+#endif
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+    rc = log_compress_append(log, hdr, NULL, om, hdr_len,
+                             len > hdr_len ? len - hdr_len : 0);
+    if (rc > 0)
+#endif
+    {
+        rc = log->l_log->log_append_mbuf(log, om);
+    }
     if (rc != 0) {
         goto err;
     }
@@ -739,6 +834,34 @@ drop:
     return rc;
 }
 
+#if MYNEWT_VAL(LOG_ASYNC)
+/**
+ * Writes an entry appended to an asynchronous log.
+ */
+int
+log_write_deferred(struct log *log, struct log_entry_hdr *hdr,
+                   const void *body, uint16_t len)
+{
+    int rc;
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+    rc = log_compress_append(log, hdr, body, NULL, 0, len);
+    if (rc > 0)
+#endif
+    {
+        rc = log->l_log->log_append_body(log, hdr, body, len);
+    }
+    if (rc != 0) {
+        LOG_STATS_INC(log, errs);
+        return rc;
+    }
+
+    log_call_append_cb(log, hdr->ue_index);
+
+    return 0;
+}
+#endif
+
 int
 log_append_mbuf_typed(struct log *log, uint8_t module, uint8_t level,
                       uint8_t etype, struct os_mbuf *om)
@@ -781,7 +904,19 @@ log_append_mbuf_body_no_free(struct log *log, uint8_t module, uint8_t level,
         goto drop;
     }
 
-    rc = log->l_log->log_append_mbuf_body(log, &hdr, om);
+#if MYNEWT_VAL(LOG_ASYNC)
+    if (log->l_async != LOG_ASYNC_NONE) {
+        return log_async_append(log, &hdr, NULL, om, 0, len);
+    }
+#endif
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+    rc = log_compress_append(log, &hdr, NULL, om, 0, len);
+    if (rc > 0)
+#endif
+    {
+        rc = log->l_log->log_append_mbuf_body(log, &hdr, om);
+    }
     if (rc != 0) {
         goto err;
     }
@@ -851,6 +986,9 @@ struct log_walk_body_arg {
 
     /** The original argument passed to `log_walk`. */
     void *arg;
+
+    /** Entries not matching this filter are skipped; NULL matches all. */
+    const struct log_filter *filter;
 };
 
 /**
@@ -875,8 +1013,22 @@ log_walk_body_fn(struct log *log, struct log_offset *log_offset, const void *dpt
     if (rc != 0) {
         return rc;
     }
+    if (lwba->filter != NULL && !log_filter_match(lwba->filter, &ueh)) {
+        return 0;
+    }
     if (log_offset->lo_index <= ueh.ue_index) {
-        len -= log_hdr_len(&ueh);
+#if MYNEWT_VAL(LOG_COMPRESS)
+        if (ueh.ue_flags & LOG_FLAGS_COMPRESSED) {
+            rc = log_compress_body_len(log, dptr, &ueh);
+            if (rc < 0) {
+                return rc;
+            }
+            len = rc;
+        } else
+#endif
+        {
+            len -= log_hdr_len(&ueh);
+        }
 
         /* Pass the wrapped callback argument to the body walk function. */
         log_offset->lo_arg = lwba->arg;
@@ -934,6 +1086,42 @@ err:
     return rc;
 }
 
+bool
+log_filter_match(const struct log_filter *filter,
+                 const struct log_entry_hdr *hdr)
+{
+    if (hdr->ue_level < filter->lf_min_level) {
+        return false;
+    }
+
+    return filter->lf_module == LOG_FILTER_MODULE_ANY ||
+           filter->lf_module == hdr->ue_module;
+}
+
+int
+log_walk_filtered(struct log *log, const struct log_filter *filter,
+                  log_walk_body_func_t walk_body_func,
+                  struct log_offset *log_offset)
+{
+    struct log_walk_body_arg lwba = {
+        .fn = walk_body_func,
+        .arg = log_offset->lo_arg,
+        .filter = filter,
+    };
+    int rc;
+
+    log_offset->lo_arg = &lwba;
+    if (log->l_log->log_walk_filtered != NULL) {
+        rc = log->l_log->log_walk_filtered(log, filter, log_walk_body_fn,
+                                           log_offset);
+    } else {
+        rc = log->l_log->log_walk(log, log_walk_body_fn, log_offset);
+    }
+    log_offset->lo_arg = lwba.arg;
+
+    return rc;
+}
+
 /**
  * Reads from the specified log.
  *
@@ -983,6 +1171,12 @@ log_read_body(struct log *log, const void *dptr, void *buf, uint16_t off,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_COMPRESS)
+    if (hdr.ue_flags & LOG_FLAGS_COMPRESSED) {
+        return log_compress_read(log, dptr, &hdr, buf, NULL, off, len);
+    }
+#endif
+
     return log_read(log, dptr, buf, log_hdr_len(&hdr) + off, len);
 }
 
@@ -1013,6 +1207,15 @@ log_read_mbuf_body(struct log *log, const void *dptr, struct os_mbuf *om,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_COMPRESS)
+    if (hdr.ue_flags & LOG_FLAGS_COMPRESSED) {
+        if (!om) {
+            return 0;
+        }
+        return log_compress_read(log, dptr, &hdr, NULL, om, off, len);
+    }
+#endif
+
     return log_read_mbuf(log, dptr, om, log_hdr_len(&hdr) + off, len);
 }
 
@@ -1021,6 +1224,13 @@ log_flush(struct log *log)
 {
     int rc;
 
+#if MYNEWT_VAL(LOG_ASYNC)
+    /* Entries appended before the flush must not outlive it. */
+    if (log->l_async != LOG_ASYNC_NONE) {
+        log_async_sync();
+    }
+#endif
+
     rc = log->l_log->log_flush(log);
     if (rc != 0) {
         goto err;
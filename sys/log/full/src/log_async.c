@@ -0,0 +1,447 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_ASYNC)
+
+#include "log/log.h"
+
+/*
+ * Deferred log entries are kept in a byte ring shared by all asynchronous
+ * logs.  Producers reserve a record with interrupts briefly disabled, copy
+ * the entry into it with interrupts enabled and then mark it ready; the log
+ * task consumes records strictly in ring order.  A record which does not fit
+ * before the end of the buffer is preceded by a padding record (or, if there
+ * is no room even for that, by unused space) and placed at the start.
+ *
+ * An entry is numbered when its record is reserved, in the same critical
+ * section, so the caller's header carries the index as it would on the
+ * direct path.  Since records are consumed in ring order, each log's indices
+ * still reach the handler in increasing order, however producers interleave.
+ */
+
+#define LOG_ASYNC_BUF_SIZE      MYNEWT_VAL(LOG_ASYNC_BUF_SIZE)
+#define LOG_ASYNC_MAX_ENTRY_LEN MYNEWT_VAL(LOG_ASYNC_MAX_ENTRY_LEN)
+
+#define LOG_ASYNC_REC_WRITING   0
+#define LOG_ASYNC_REC_READY     1
+#define LOG_ASYNC_REC_READING   2
+#define LOG_ASYNC_REC_PAD       3
+
+struct log_async_rec {
+    struct log *lar_log;
+    struct log_entry_hdr lar_hdr;
+    uint16_t lar_len;           /* Body length. */
+    uint16_t lar_size;          /* Record size, including padding. */
+    uint8_t lar_state;
+};
+
+#define LOG_ASYNC_REC_SIZE(len) \
+    OS_ALIGN(sizeof(struct log_async_rec) + (len), OS_ALIGNMENT)
+
+#if LOG_ASYNC_BUF_SIZE % OS_ALIGNMENT != 0
+#error "LOG_ASYNC_BUF_SIZE must be a multiple of OS_ALIGNMENT"
+#endif
+
+static os_membuf_t log_async_buf[LOG_ASYNC_BUF_SIZE / sizeof(os_membuf_t)];
+
+/* Free-running byte counts; their difference is the amount in use. */
+static uint32_t log_async_head;
+static uint32_t log_async_tail;
+
+/* Position up to which every record has been written or dropped; trails
+ * log_async_head while the log task writes an entry.
+ */
+static uint32_t log_async_done;
+static bool log_async_writing;
+
+/* Number of tasks waiting for space or for entries to be written. */
+static uint16_t log_async_waiters;
+static struct os_sem log_async_sem;
+
+static struct os_eventq log_async_evq;
+static struct os_event log_async_ev;
+static struct os_task log_async_task;
+static os_stack_t log_async_stack[OS_STACK_ALIGN(
+    MYNEWT_VAL(LOG_ASYNC_TASK_STACK_SIZE))];
+
+/* Entry being written by the log task; copied out of the ring so producers
+ * can reuse the space while the handler runs.
+ */
+static struct log_async_rec log_async_cur;
+static uint8_t log_async_body[LOG_ASYNC_MAX_ENTRY_LEN];
+
+static struct log_async_rec *
+log_async_rec_at(uint32_t pos)
+{
+    return (struct log_async_rec *)
+        ((uint8_t *)log_async_buf + pos % LOG_ASYNC_BUF_SIZE);
+}
+
+/**
+ * Number of bytes from the given position to the end of the buffer.
+ */
+static uint32_t
+log_async_contig(uint32_t pos)
+{
+    return LOG_ASYNC_BUF_SIZE - pos % LOG_ASYNC_BUF_SIZE;
+}
+
+static bool
+log_async_in_log_task(void)
+{
+    return os_started() && os_sched_get_current_task() == &log_async_task;
+}
+
+/**
+ * Wakes up every waiting task, so that each can check whether it can
+ * proceed.  Called with interrupts disabled.
+ */
+static void
+log_async_wake(void)
+{
+    uint16_t tokens;
+
+    for (tokens = os_sem_get_count(&log_async_sem);
+         tokens < log_async_waiters;
+         tokens++) {
+
+        os_sem_release(&log_async_sem);
+    }
+}
+
+/**
+ * Consumes the given number of bytes at the head of the ring, and wakes up
+ * the tasks waiting for space or for entries to be written.  Called with
+ * interrupts disabled.
+ */
+static void
+log_async_advance(uint32_t len)
+{
+    log_async_head += len;
+    if (!log_async_writing) {
+        log_async_done = log_async_head;
+    }
+    log_async_wake();
+}
+
+/**
+ * Drops the oldest record, unless it is still being written or read.
+ * Called with interrupts disabled.
+ *
+ * @return                      true if space was freed.
+ */
+static bool
+log_async_drop_oldest(void)
+{
+    struct log_async_rec *rec;
+
+    while (log_async_head != log_async_tail) {
+        if (log_async_contig(log_async_head) < sizeof *rec) {
+            log_async_advance(log_async_contig(log_async_head));
+            continue;
+        }
+
+        rec = log_async_rec_at(log_async_head);
+        if (rec->lar_state == LOG_ASYNC_REC_PAD) {
+            log_async_advance(rec->lar_size);
+            continue;
+        }
+        if (rec->lar_state != LOG_ASYNC_REC_READY) {
+            return false;
+        }
+
+        LOG_STATS_INC(rec->lar_log, async_drops);
+        log_async_advance(rec->lar_size);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Reserves a record for a body of the given length and numbers the entry.
+ * Applies the log's overflow policy if the ring is full.
+ */
+static struct log_async_rec *
+log_async_reserve(struct log *log, struct log_entry_hdr *hdr, uint16_t len)
+{
+    struct log_async_rec *rec;
+    uint32_t contig;
+    uint32_t need;
+    uint16_t size;
+    bool can_block;
+    int sr;
+
+    size = LOG_ASYNC_REC_SIZE(len);
+
+    /* Blocking requires a running log task other than the caller. */
+    can_block = log->l_async == LOG_ASYNC_BLOCK && os_started() &&
+                !os_arch_in_isr() && !log_async_in_log_task();
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+
+        contig = log_async_contig(log_async_tail);
+        need = size;
+        if (contig < size) {
+            need += contig;
+        }
+
+        if (LOG_ASYNC_BUF_SIZE - (log_async_tail - log_async_head) >= need) {
+            if (contig < size) {
+                if (contig >= sizeof *rec) {
+                    rec = log_async_rec_at(log_async_tail);
+                    rec->lar_size = contig;
+                    rec->lar_state = LOG_ASYNC_REC_PAD;
+                }
+                log_async_tail += contig;
+            }
+
+            rec = log_async_rec_at(log_async_tail);
+            rec->lar_size = size;
+            rec->lar_state = LOG_ASYNC_REC_WRITING;
+            log_async_tail += size;
+
+            /* Numbered in the same critical section, so that the records
+             * are written in index order.
+             */
+            hdr->ue_index = log_next_index(log);
+
+            OS_EXIT_CRITICAL(sr);
+            return rec;
+        }
+
+        if (log->l_async == LOG_ASYNC_DROP_OLDEST && log_async_drop_oldest()) {
+            OS_EXIT_CRITICAL(sr);
+            continue;
+        }
+
+        if (!can_block) {
+            OS_EXIT_CRITICAL(sr);
+            LOG_STATS_INC(log, async_drops);
+            return NULL;
+        }
+
+        log_async_waiters++;
+        OS_EXIT_CRITICAL(sr);
+
+        os_sem_pend(&log_async_sem, OS_TIMEOUT_NEVER);
+
+        OS_ENTER_CRITICAL(sr);
+        log_async_waiters--;
+        OS_EXIT_CRITICAL(sr);
+    }
+}
+
+int
+log_async_append(struct log *log, struct log_entry_hdr *hdr,
+                 const void *body, struct os_mbuf *om, int off, uint16_t len)
+{
+    struct log_async_rec *rec;
+    int rc;
+    int sr;
+
+    if (len > LOG_ASYNC_MAX_ENTRY_LEN ||
+        LOG_ASYNC_REC_SIZE(len) > LOG_ASYNC_BUF_SIZE) {
+        LOG_STATS_INC(log, too_long);
+        return SYS_ENOMEM;
+    }
+
+    rec = log_async_reserve(log, hdr, len);
+    if (rec == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    rec->lar_log = log;
+    rec->lar_hdr = *hdr;
+    rec->lar_len = len;
+    rc = 0;
+    if (om != NULL) {
+        rc = os_mbuf_copydata(om, off, len, rec + 1);
+    } else {
+        memcpy(rec + 1, body, len);
+    }
+    if (rc != 0) {
+        /* Still has to be consumed in order; have the log task skip it. */
+        OS_ENTER_CRITICAL(sr);
+        rec->lar_state = LOG_ASYNC_REC_PAD;
+        OS_EXIT_CRITICAL(sr);
+        return SYS_EINVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    rec->lar_state = LOG_ASYNC_REC_READY;
+    OS_EXIT_CRITICAL(sr);
+
+    os_eventq_put(&log_async_evq, &log_async_ev);
+
+    return 0;
+}
+
+/**
+ * Writes every ready record to its log, stopping at the first one which is
+ * still being written; its producer posts the event again when done.
+ */
+static void
+log_async_drain(void)
+{
+    struct log_async_rec *rec;
+    int sr;
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+
+        if (log_async_head == log_async_tail) {
+            OS_EXIT_CRITICAL(sr);
+            break;
+        }
+        if (log_async_contig(log_async_head) < sizeof *rec) {
+            log_async_advance(log_async_contig(log_async_head));
+            OS_EXIT_CRITICAL(sr);
+            continue;
+        }
+
+        rec = log_async_rec_at(log_async_head);
+        if (rec->lar_state == LOG_ASYNC_REC_PAD) {
+            log_async_advance(rec->lar_size);
+            OS_EXIT_CRITICAL(sr);
+            continue;
+        }
+        if (rec->lar_state != LOG_ASYNC_REC_READY) {
+            OS_EXIT_CRITICAL(sr);
+            break;
+        }
+        rec->lar_state = LOG_ASYNC_REC_READING;
+
+        OS_EXIT_CRITICAL(sr);
+
+        log_async_cur = *rec;
+        memcpy(log_async_body, rec + 1, rec->lar_len);
+
+        OS_ENTER_CRITICAL(sr);
+        log_async_writing = true;
+        log_async_advance(rec->lar_size);
+        OS_EXIT_CRITICAL(sr);
+
+        log_write_deferred(log_async_cur.lar_log, &log_async_cur.lar_hdr,
+                           log_async_body, log_async_cur.lar_len);
+
+        /* Everything before the head has now been written or dropped. */
+        OS_ENTER_CRITICAL(sr);
+        log_async_writing = false;
+        log_async_done = log_async_head;
+        log_async_wake();
+        OS_EXIT_CRITICAL(sr);
+    }
+}
+
+static void
+log_async_event_cb(struct os_event *ev)
+{
+    log_async_drain();
+}
+
+static void
+log_async_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&log_async_evq);
+    }
+}
+
+void
+log_set_async(struct log *log, uint8_t mode)
+{
+    assert(log);
+    assert(mode <= LOG_ASYNC_BLOCK);
+
+    if (log->l_async != LOG_ASYNC_NONE && mode == LOG_ASYNC_NONE) {
+        /* Keep this log's entries in order. */
+        log_async_sync();
+    }
+    log->l_async = mode;
+}
+
+int
+log_async_sync(void)
+{
+    uint32_t target;
+    int sr;
+
+    if (os_arch_in_isr() || log_async_in_log_task()) {
+        return SYS_EINVAL;
+    }
+
+    if (!os_started()) {
+        /* No log task yet; write the entries from the caller's context. */
+        log_async_drain();
+        return 0;
+    }
+
+    /* Only wait for the entries appended so far; others may keep logging
+     * while this task waits.
+     */
+    OS_ENTER_CRITICAL(sr);
+    target = log_async_tail;
+    while ((int32_t)(log_async_done - target) < 0) {
+        log_async_waiters++;
+        OS_EXIT_CRITICAL(sr);
+
+        os_eventq_put(&log_async_evq, &log_async_ev);
+        os_sem_pend(&log_async_sem, OS_TIMEOUT_NEVER);
+
+        OS_ENTER_CRITICAL(sr);
+        log_async_waiters--;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}
+
+void
+log_async_init(void)
+{
+    int rc;
+
+    log_async_head = 0;
+    log_async_tail = 0;
+    log_async_done = 0;
+    log_async_writing = false;
+    log_async_waiters = 0;
+
+    rc = os_sem_init(&log_async_sem, 0);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    os_eventq_init(&log_async_evq);
+    log_async_ev = (struct os_event) {
+        .ev_cb = log_async_event_cb,
+    };
+
+    rc = os_task_init(&log_async_task, "log", log_async_task_handler, NULL,
+                      MYNEWT_VAL(LOG_ASYNC_TASK_PRIO), OS_WAIT_FOREVER,
+                      log_async_stack,
+                      MYNEWT_VAL(LOG_ASYNC_TASK_STACK_SIZE));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+#endif
@@ -0,0 +1,468 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_COMPRESS)
+
+#include "log/log.h"
+
+/*
+ * Entry bodies are compressed one at a time, so that any entry can be read
+ * on its own.  The codec is a greedy LZ77 in the LZ4 block format: each
+ * sequence is a token byte holding a literal count and a match length
+ * (each extended by 255-continued bytes when 15), the literals, and a
+ * two-byte little-endian distance back to the match.  The final sequence
+ * has no match.  Matches may reach back into a fixed dictionary which
+ * precedes every body, which is what makes short entries compressible.
+ *
+ * A compressed body is stored as its original length (two bytes, little
+ * endian) followed by the sequences.  The most recently decompressed body
+ * is kept, so that reading an entry piecemeal decompresses it only once.
+ */
+
+#define LOG_COMPRESS_MAX_LEN    MYNEWT_VAL(LOG_COMPRESS_MAX_LEN)
+#define LOG_COMPRESS_HASH_BITS  MYNEWT_VAL(LOG_COMPRESS_HASH_BITS)
+#define LOG_COMPRESS_HASH_SIZE  (1 << LOG_COMPRESS_HASH_BITS)
+
+#define LOG_COMPRESS_MIN_MATCH  4
+#define LOG_COMPRESS_LEN_SZ     2
+#define LOG_COMPRESS_NO_POS     0xffff
+
+static const char log_compress_dict[] =
+    "0x00000000 failed; rc=-1 error: status=0 invalid timeout\n"
+    "connection handle=0 disconnected reason=0x0 addr=00:00:00:00:00:00 "
+    "state=idle start stop done reset init config value=true false len=";
+
+#define LOG_COMPRESS_DICT_LEN   (sizeof log_compress_dict - 1)
+#define LOG_COMPRESS_WIN_SIZE   (LOG_COMPRESS_DICT_LEN + LOG_COMPRESS_MAX_LEN)
+
+/* Window positions, with room for the dictionary, are 16 bits. */
+#if LOG_COMPRESS_MAX_LEN > 32768
+#error "LOG_COMPRESS_MAX_LEN is too large"
+#endif
+
+static struct os_mutex log_compress_mtx;
+
+/* The dictionary followed by the body being (de)compressed. */
+static uint8_t log_compress_win[LOG_COMPRESS_WIN_SIZE];
+
+/* A compressed body, with its length prefix. */
+static uint8_t log_compress_packed[LOG_COMPRESS_LEN_SZ + LOG_COMPRESS_MAX_LEN];
+
+static uint16_t log_compress_hash[LOG_COMPRESS_HASH_SIZE];
+
+/* Identifies the body in log_compress_win, if it was decompressed. */
+static struct log *log_compress_cached_log;
+static uint32_t log_compress_cached_idx;
+static int64_t log_compress_cached_ts;
+static uint16_t log_compress_cached_len;
+
+static int
+log_compress_lock(void)
+{
+    int rc;
+
+    if (os_arch_in_isr()) {
+        return -1;
+    }
+    rc = os_mutex_pend(&log_compress_mtx, OS_WAIT_FOREVER);
+    if (rc != 0 && rc != OS_NOT_STARTED) {
+        return -1;
+    }
+    return 0;
+}
+
+static void
+log_compress_unlock(void)
+{
+    os_mutex_release(&log_compress_mtx);
+}
+
+static unsigned int
+log_compress_hash_at(const uint8_t *p)
+{
+    uint32_t v;
+
+    v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    return (v * 2654435761u) >> (32 - LOG_COMPRESS_HASH_BITS);
+}
+
+/**
+ * Writes a length extension; returns the new output offset, or -1 if out
+ * of room.
+ */
+static int
+log_compress_put_len(uint8_t *out, int op, int out_max, int len)
+{
+    for (; len >= 255; len -= 255) {
+        if (op >= out_max) {
+            return -1;
+        }
+        out[op++] = 255;
+    }
+    if (op >= out_max) {
+        return -1;
+    }
+    out[op++] = len;
+    return op;
+}
+
+/**
+ * Writes one sequence; a zero match_len ends the stream.  Returns the new
+ * output offset, or -1 if out of room.
+ */
+static int
+log_compress_put_seq(uint8_t *out, int op, int out_max, const uint8_t *lit,
+                     int lit_len, int dist, int match_len)
+{
+    uint8_t *token;
+    int ml;
+
+    if (op >= out_max) {
+        return -1;
+    }
+    token = &out[op++];
+    *token = (lit_len < 15 ? lit_len : 15) << 4;
+    if (lit_len >= 15) {
+        op = log_compress_put_len(out, op, out_max, lit_len - 15);
+        if (op < 0) {
+            return -1;
+        }
+    }
+    if (op + lit_len > out_max) {
+        return -1;
+    }
+    memcpy(&out[op], lit, lit_len);
+    op += lit_len;
+
+    if (match_len == 0) {
+        return op;
+    }
+    if (op + 2 > out_max) {
+        return -1;
+    }
+    out[op++] = dist;
+    out[op++] = dist >> 8;
+    ml = match_len - LOG_COMPRESS_MIN_MATCH;
+    *token |= ml < 15 ? ml : 15;
+    if (ml >= 15) {
+        op = log_compress_put_len(out, op, out_max, ml - 15);
+    }
+    return op;
+}
+
+/**
+ * Compresses win[start, end) into out, with win[0, start) as history.
+ * Returns the compressed length, or -1 if it would exceed out_max.
+ */
+static int
+log_compress_encode(const uint8_t *win, int start, int end, uint8_t *out,
+                    int out_max)
+{
+    unsigned int h;
+    int anchor;
+    int cand;
+    int len;
+    int op;
+    int p;
+
+    memset(log_compress_hash, 0xff, sizeof log_compress_hash);
+    for (p = 0; p + LOG_COMPRESS_MIN_MATCH <= start; p++) {
+        log_compress_hash[log_compress_hash_at(&win[p])] = p;
+    }
+
+    op = 0;
+    anchor = start;
+    p = start;
+    while (p + LOG_COMPRESS_MIN_MATCH <= end) {
+        h = log_compress_hash_at(&win[p]);
+        cand = log_compress_hash[h];
+        log_compress_hash[h] = p;
+        if (cand == LOG_COMPRESS_NO_POS ||
+            memcmp(&win[cand], &win[p], LOG_COMPRESS_MIN_MATCH) != 0) {
+            p++;
+            continue;
+        }
+
+        len = LOG_COMPRESS_MIN_MATCH;
+        while (p + len < end && win[cand + len] == win[p + len]) {
+            len++;
+        }
+        op = log_compress_put_seq(out, op, out_max, &win[anchor], p - anchor,
+                                  p - cand, len);
+        if (op < 0) {
+            return -1;
+        }
+
+        /* Index the matched positions too, for later matches. */
+        for (p++, len--; len > 0; p++, len--) {
+            if (p + LOG_COMPRESS_MIN_MATCH <= end) {
+                log_compress_hash[log_compress_hash_at(&win[p])] = p;
+            }
+        }
+        anchor = p;
+    }
+
+    return log_compress_put_seq(out, op, out_max, &win[anchor], end - anchor,
+                                0, 0);
+}
+
+/**
+ * Reads a length extension.  Returns the new input offset, or -1 if the
+ * input is truncated.
+ */
+static int
+log_compress_get_len(const uint8_t *in, int ip, int in_len, int *len)
+{
+    uint8_t b;
+
+    do {
+        if (ip >= in_len) {
+            return -1;
+        }
+        b = in[ip++];
+        *len += b;
+    } while (b == 255);
+    return ip;
+}
+
+/**
+ * Decompresses in into win[start, end_max), with win[0, start) as history.
+ * Returns the decompressed length, or -1 if the input is corrupt.
+ */
+static int
+log_compress_decode(const uint8_t *in, int in_len, uint8_t *win, int start,
+                    int end_max)
+{
+    uint8_t token;
+    int dist;
+    int len;
+    int ip;
+    int op;
+
+    ip = 0;
+    op = start;
+    while (ip < in_len) {
+        token = in[ip++];
+
+        len = token >> 4;
+        if (len == 15) {
+            ip = log_compress_get_len(in, ip, in_len, &len);
+            if (ip < 0) {
+                return -1;
+            }
+        }
+        if (len > in_len - ip || len > end_max - op) {
+            return -1;
+        }
+        memcpy(&win[op], &in[ip], len);
+        ip += len;
+        op += len;
+        if (ip == in_len) {
+            break;
+        }
+
+        if (in_len - ip < 2) {
+            return -1;
+        }
+        dist = in[ip] | (in[ip + 1] << 8);
+        ip += 2;
+        len = (token & 0x0f) + LOG_COMPRESS_MIN_MATCH;
+        if ((token & 0x0f) == 15) {
+            ip = log_compress_get_len(in, ip, in_len, &len);
+            if (ip < 0) {
+                return -1;
+            }
+        }
+        if (dist == 0 || dist > op || len > end_max - op) {
+            return -1;
+        }
+        /* Byte by byte; the match may overlap its own output. */
+        for (; len > 0; len--, op++) {
+            win[op] = win[op - dist];
+        }
+    }
+
+    return op - start;
+}
+
+void
+log_set_compress(struct log *log, int on)
+{
+    log->l_compress = !!on;
+}
+
+int
+log_compress_append(struct log *log, struct log_entry_hdr *hdr,
+                    const void *body, struct os_mbuf *om, int off,
+                    uint16_t len)
+{
+    uint8_t *data;
+    int rc;
+
+    /* Streams (e.g., the console) are never read back. */
+    if (!log->l_compress || log->l_log->log_type == LOG_TYPE_STREAM ||
+        !log->l_log->log_append_body ||
+        len <= LOG_COMPRESS_MIN_MATCH || len > LOG_COMPRESS_MAX_LEN) {
+        return 1;
+    }
+    if (log_compress_lock() != 0) {
+        return 1;
+    }
+
+    log_compress_cached_log = NULL;
+    data = &log_compress_win[LOG_COMPRESS_DICT_LEN];
+    memcpy(log_compress_win, log_compress_dict, LOG_COMPRESS_DICT_LEN);
+    if (om != NULL) {
+        if (os_mbuf_copydata(om, off, len, data) != 0) {
+            rc = 1;
+            goto done;
+        }
+    } else {
+        memcpy(data, body, len);
+    }
+
+    /* Only store it compressed if that saves space. */
+    rc = log_compress_encode(log_compress_win, LOG_COMPRESS_DICT_LEN,
+                             LOG_COMPRESS_DICT_LEN + len,
+                             &log_compress_packed[LOG_COMPRESS_LEN_SZ],
+                             len - LOG_COMPRESS_LEN_SZ - 1);
+    if (rc < 0) {
+        rc = 1;
+        goto done;
+    }
+    log_compress_packed[0] = len;
+    log_compress_packed[1] = len >> 8;
+
+    hdr->ue_flags |= LOG_FLAGS_COMPRESSED;
+    rc = log->l_log->log_append_body(log, hdr, log_compress_packed,
+                                     LOG_COMPRESS_LEN_SZ + rc);
+
+done:
+    log_compress_unlock();
+    return rc;
+}
+
+int
+log_compress_body_len(struct log *log, const void *dptr,
+                      const struct log_entry_hdr *hdr)
+{
+    uint8_t buf[LOG_COMPRESS_LEN_SZ];
+    int rc;
+
+    rc = log_read(log, dptr, buf, log_hdr_len(hdr), sizeof buf);
+    if (rc != sizeof buf) {
+        return SYS_EIO;
+    }
+    return buf[0] | (buf[1] << 8);
+}
+
+/**
+ * Decompresses the given entry into log_compress_win, unless it is there
+ * already.  Called with the codec locked.
+ */
+static int
+log_compress_load(struct log *log, const void *dptr,
+                  const struct log_entry_hdr *hdr)
+{
+    int packed_len;
+    int len;
+
+    if (log_compress_cached_log == log &&
+        log_compress_cached_idx == hdr->ue_index &&
+        log_compress_cached_ts == hdr->ue_ts) {
+        return 0;
+    }
+
+    packed_len = log_read(log, dptr, log_compress_packed, log_hdr_len(hdr),
+                          sizeof log_compress_packed);
+    if (packed_len < LOG_COMPRESS_LEN_SZ) {
+        return SYS_EIO;
+    }
+
+    memcpy(log_compress_win, log_compress_dict, LOG_COMPRESS_DICT_LEN);
+    len = log_compress_decode(&log_compress_packed[LOG_COMPRESS_LEN_SZ],
+                              packed_len - LOG_COMPRESS_LEN_SZ,
+                              log_compress_win, LOG_COMPRESS_DICT_LEN,
+                              LOG_COMPRESS_WIN_SIZE);
+    if (len < 0 ||
+        len != (log_compress_packed[0] | (log_compress_packed[1] << 8))) {
+        return SYS_EIO;
+    }
+
+    log_compress_cached_log = log;
+    log_compress_cached_idx = hdr->ue_index;
+    log_compress_cached_ts = hdr->ue_ts;
+    log_compress_cached_len = len;
+
+    return 0;
+}
+
+int
+log_compress_read(struct log *log, const void *dptr,
+                  const struct log_entry_hdr *hdr, void *buf,
+                  struct os_mbuf *om, uint16_t off, uint16_t len)
+{
+    int rc;
+
+    if (log_compress_lock() != 0) {
+        return SYS_EINVAL;
+    }
+
+    rc = log_compress_load(log, dptr, hdr);
+    if (rc != 0) {
+        goto done;
+    }
+
+    if (off >= log_compress_cached_len) {
+        rc = 0;
+        goto done;
+    }
+    if (len > log_compress_cached_len - off) {
+        len = log_compress_cached_len - off;
+    }
+
+    if (om != NULL) {
+        rc = os_mbuf_append(om, &log_compress_win[LOG_COMPRESS_DICT_LEN + off],
+                            len);
+        if (rc != 0) {
+            rc = SYS_ENOMEM;
+            goto done;
+        }
+    } else {
+        memcpy(buf, &log_compress_win[LOG_COMPRESS_DICT_LEN + off], len);
+    }
+    rc = len;
+
+done:
+    log_compress_unlock();
+    return rc;
+}
+
+void
+log_compress_init(void)
+{
+    os_mutex_init(&log_compress_mtx);
+    log_compress_cached_log = NULL;
+}
+
+#endif
@@ -0,0 +1,359 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_EXPORT)
+
+#include "log/log.h"
+
+/*
+ * Everything an entry is encoded as, except for the body: a map head, the
+ * header fields and the head of the "msg" byte string.  The body follows
+ * it, read from storage into the destination chain.
+ */
+#define LOG_EXPORT_PREFIX_MAX   80
+
+#define LOG_EXPORT_CBOR_UINT    0
+#define LOG_EXPORT_CBOR_NINT    1
+#define LOG_EXPORT_CBOR_BSTR    2
+#define LOG_EXPORT_CBOR_TSTR    3
+#define LOG_EXPORT_CBOR_MAP     5
+
+struct log_export_arg {
+    struct log_export_cursor *cursor;
+    struct os_mbuf *om;
+    uint32_t max_len;
+    uint32_t used;
+    /* Entries in `om`, and the index following the last of them. */
+    int frag_count;
+    uint32_t next_index;
+    /* Entries in fragments handed over to the caller. */
+    int count;
+    log_export_alloc_func_t alloc;
+    log_export_tx_func_t tx;
+    void *cb_arg;
+    int full;
+    int rc;
+};
+
+static int
+log_export_put_head(uint8_t *buf, uint8_t major, uint64_t val)
+{
+    major <<= 5;
+
+    if (val < 24) {
+        buf[0] = major | val;
+        return 1;
+    }
+    if (val <= UINT8_MAX) {
+        buf[0] = major | 24;
+        buf[1] = val;
+        return 2;
+    }
+    if (val <= UINT16_MAX) {
+        buf[0] = major | 25;
+        put_be16(buf + 1, val);
+        return 3;
+    }
+    if (val <= UINT32_MAX) {
+        buf[0] = major | 26;
+        put_be32(buf + 1, val);
+        return 5;
+    }
+
+    buf[0] = major | 27;
+    put_be64(buf + 1, val);
+    return 9;
+}
+
+static int
+log_export_put_str(uint8_t *buf, uint8_t major, const void *str, int len)
+{
+    int off;
+
+    off = log_export_put_head(buf, major, len);
+    memcpy(buf + off, str, len);
+
+    return off + len;
+}
+
+static int
+log_export_put_key(uint8_t *buf, const char *key)
+{
+    return log_export_put_str(buf, LOG_EXPORT_CBOR_TSTR, key, strlen(key));
+}
+
+static int
+log_export_put_int(uint8_t *buf, int64_t val)
+{
+    if (val < 0) {
+        return log_export_put_head(buf, LOG_EXPORT_CBOR_NINT, -1 - val);
+    }
+
+    return log_export_put_head(buf, LOG_EXPORT_CBOR_UINT, val);
+}
+
+static const char *
+log_export_type_str(uint8_t etype)
+{
+    switch (etype) {
+    case LOG_ETYPE_STRING:
+        return "str";
+    case LOG_ETYPE_CBOR:
+        return "cbor";
+    default:
+        return "bin";
+    }
+}
+
+/**
+ * Encodes everything but the body of an entry.
+ *
+ * @return                      The number of bytes written to `buf`.
+ */
+static int
+log_export_encode_prefix(uint8_t *buf, const struct log_entry_hdr *hdr,
+                         uint16_t body_len)
+{
+    const char *type;
+    int imghash;
+    int off;
+
+    imghash = (hdr->ue_flags & LOG_FLAGS_IMG_HASH) != 0;
+    type = log_export_type_str(hdr->ue_etype);
+
+    off = log_export_put_head(buf, LOG_EXPORT_CBOR_MAP, 6 + imghash);
+
+    off += log_export_put_key(buf + off, "ts");
+    off += log_export_put_int(buf + off, hdr->ue_ts);
+    off += log_export_put_key(buf + off, "level");
+    off += log_export_put_int(buf + off, hdr->ue_level);
+    off += log_export_put_key(buf + off, "index");
+    off += log_export_put_int(buf + off, hdr->ue_index);
+    off += log_export_put_key(buf + off, "module");
+    off += log_export_put_int(buf + off, hdr->ue_module);
+    off += log_export_put_key(buf + off, "type");
+    off += log_export_put_str(buf + off, LOG_EXPORT_CBOR_TSTR, type,
+                              strlen(type));
+    if (imghash) {
+        off += log_export_put_key(buf + off, "imghash");
+        off += log_export_put_str(buf + off, LOG_EXPORT_CBOR_BSTR,
+                                  hdr->ue_imghash, LOG_IMG_HASHLEN);
+    }
+
+    /* The body is last, so that it can be streamed into the chain. */
+    off += log_export_put_key(buf + off, "msg");
+    off += log_export_put_head(buf + off, LOG_EXPORT_CBOR_BSTR, body_len);
+
+    return off;
+}
+
+/**
+ * Hands the current fragment over to the transmit callback and allocates
+ * the next one.
+ */
+static int
+log_export_next_frag(struct log_export_arg *arg)
+{
+    int rc;
+
+    rc = arg->tx(arg->om, arg->cb_arg);
+    arg->om = NULL;
+    if (rc != 0) {
+        return rc;
+    }
+
+    arg->count += arg->frag_count;
+    arg->cursor->lec_index = arg->next_index;
+
+    arg->om = arg->alloc(arg->cb_arg);
+    if (arg->om == NULL) {
+        return SYS_ENOMEM;
+    }
+    arg->used = 0;
+    arg->frag_count = 0;
+
+    return 0;
+}
+
+static int
+log_export_walk(struct log *log, struct log_offset *log_offset,
+                const struct log_entry_hdr *hdr, const void *dptr,
+                uint16_t len)
+{
+    uint8_t prefix[LOG_EXPORT_PREFIX_MAX];
+    struct log_export_arg *arg;
+    uint16_t start_len;
+    int prefix_len;
+    int rc;
+
+    arg = log_offset->lo_arg;
+
+    prefix_len = log_export_encode_prefix(prefix, hdr, len);
+    if (arg->frag_count > 0 && arg->used + prefix_len + len > arg->max_len) {
+        if (arg->tx == NULL) {
+            /* Doesn't fit; the next call resumes with this entry. */
+            arg->full = 1;
+            return 1;
+        }
+
+        rc = log_export_next_frag(arg);
+        if (rc != 0) {
+            arg->rc = rc;
+            return 1;
+        }
+    }
+
+    start_len = OS_MBUF_PKTLEN(arg->om);
+
+    rc = os_mbuf_append(arg->om, prefix, prefix_len);
+    if (rc == 0 && len > 0) {
+        rc = log_read_mbuf_body(log, dptr, arg->om, 0, len);
+        rc = rc == len ? 0 : SYS_ENOMEM;
+    }
+    if (rc != 0) {
+        os_mbuf_adj(arg->om, start_len - OS_MBUF_PKTLEN(arg->om));
+        arg->rc = SYS_ENOMEM;
+        return 1;
+    }
+
+    arg->used += prefix_len + len;
+    arg->frag_count++;
+    arg->next_index = hdr->ue_index + 1;
+
+    return 0;
+}
+
+static int
+log_export_run(struct log *log, struct log_export_arg *arg)
+{
+    struct log_export_cursor *cursor;
+    struct log_offset log_offset;
+
+    cursor = arg->cursor;
+    log_offset = (struct log_offset) {
+        .lo_arg = arg,
+        .lo_index = cursor->lec_index,
+    };
+
+    if (cursor->lec_filter != NULL) {
+        return log_walk_filtered(log, cursor->lec_filter, log_export_walk,
+                                 &log_offset);
+    } else {
+        return log_walk_body(log, log_export_walk, &log_offset);
+    }
+}
+
+void
+log_export_init(struct log_export_cursor *cursor, uint32_t index,
+                const struct log_filter *filter)
+{
+    *cursor = (struct log_export_cursor) {
+        .lec_filter = filter,
+        .lec_index = index,
+    };
+}
+
+int
+log_export_mbuf(struct log *log, struct log_export_cursor *cursor,
+                struct os_mbuf *om, uint16_t max_len)
+{
+    struct log_export_arg arg = {
+        .cursor = cursor,
+        .om = om,
+        .max_len = max_len,
+    };
+    int rc;
+
+    if (!OS_MBUF_IS_PKTHDR(om)) {
+        return SYS_EINVAL;
+    }
+
+    rc = log_export_run(log, &arg);
+
+    /* Whatever made it into the chain is the caller's now. */
+    if (arg.frag_count > 0) {
+        cursor->lec_index = arg.next_index;
+    }
+
+    if (rc != 0) {
+        return rc;
+    }
+    if (arg.rc != 0) {
+        return arg.rc;
+    }
+
+    /*
+     * Entries appended to the log later are exported by the next call, even
+     * if this one reached the end.
+     */
+    cursor->lec_done = !arg.full;
+
+    return arg.frag_count;
+}
+
+int
+log_export_stream(struct log *log, struct log_export_cursor *cursor,
+                  uint16_t max_len, log_export_alloc_func_t alloc,
+                  log_export_tx_func_t tx, void *arg)
+{
+    struct log_export_arg lea = {
+        .cursor = cursor,
+        .max_len = max_len,
+        .alloc = alloc,
+        .tx = tx,
+        .cb_arg = arg,
+    };
+    int rc;
+
+    lea.om = alloc(arg);
+    if (lea.om == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    rc = log_export_run(log, &lea);
+    if (rc == 0) {
+        rc = lea.rc;
+    }
+
+    /* Send what is left over; the cursor stays before any unsent entry. */
+    if (rc == 0 && lea.frag_count > 0) {
+        rc = lea.tx(lea.om, arg);
+        lea.om = NULL;
+        if (rc == 0) {
+            lea.count += lea.frag_count;
+            cursor->lec_index = lea.next_index;
+        }
+    }
+    os_mbuf_free_chain(lea.om);
+
+    if (rc != 0) {
+        cursor->lec_done = 0;
+        return rc;
+    }
+
+    cursor->lec_done = 1;
+
+    return lea.count;
+}
+
+#endif
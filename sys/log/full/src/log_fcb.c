@@ -46,7 +46,9 @@ static int log_fcb_rtr_erase(struct log *log);
  *
  * The "index" field corresponds to a log entry index.
  *
- * If bookmarks are enabled, this function uses them in the search.
+ * If the sector index is enabled, the search is limited to the sector which
+ * contains the requested index.  If bookmarks are enabled, this function uses
+ * them in the search.
  *
  * @return                      0 if an entry was found
  *                              SYS_ENOENT if there are no suitable entries.
@@ -58,6 +60,11 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
 {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     const struct log_fcb_bmark *bmark;
+#endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    const struct log_fcb_sector_idx *sidx;
+    struct flash_area *fa;
+    int i;
 #endif
     struct log_entry_hdr hdr;
     struct fcb_log *fcb_log;
@@ -95,8 +102,38 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
         return SYS_ENOENT;
     }
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    fa = log_fcb_find_sector(fcb_log, log_offset->lo_index);
+    if (fa != NULL) {
+        sidx = &fcb_log->fl_sidx[fa - fcb->f_sectors];
+        if (sidx->lsi_last_index < log_offset->lo_index) {
+            /* The entry is the first one in the following sector. */
+            i = fa - fcb->f_sectors + 1;
+            if (i >= fcb->f_sector_cnt) {
+                i = 0;
+            }
+            fa = &fcb->f_sectors[i];
+        }
+
+        memset(out_entry, 0, sizeof *out_entry);
+        out_entry->fe_area = fa;
+        rc = fcb_getnext(fcb, out_entry);
+        if (rc != 0) {
+            return SYS_EUNKNOWN;
+        }
+    }
+#endif
+
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     bmark = log_fcb_closest_bmark(fcb_log, log_offset->lo_index);
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    /* Only use the bookmark if it is past the start of the sector. */
+    if (bmark != NULL && fa != NULL &&
+        (bmark->lfb_entry.fe_area != fa ||
+         bmark->lfb_entry.fe_elem_off < out_entry->fe_elem_off)) {
+        bmark = NULL;
+    }
+#endif
     if (bmark != NULL) {
         *out_entry = bmark->lfb_entry;
     }
@@ -118,74 +155,125 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
 }
 
 static int
-log_fcb_start_append(struct log *log, int len, struct fcb_entry *loc)
+log_fcb_rotate(struct log *log)
 {
     struct fcb *fcb;
     struct fcb_log *fcb_log;
     struct flash_area *old_fa;
-    int rc = 0;
+    int rc;
 #if MYNEWT_VAL(LOG_STATS)
     int cnt;
 #endif
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    int64_t start;
+#endif
 
     fcb_log = (struct fcb_log *)log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
-    while (1) {
-        rc = fcb_append(fcb, len, loc);
-        if (rc == 0) {
-            break;
-        }
-
-        if (rc != FCB_ERR_NOSPACE) {
-            goto err;
-        }
-
-        if (fcb_log->fl_entries) {
-            rc = log_fcb_rtr_erase(log);
-            if (rc) {
-                goto err;
-            }
-            continue;
-        }
+    if (fcb_log->fl_entries) {
+        return log_fcb_rtr_erase(log);
+    }
 
-        old_fa = fcb->f_oldest;
-        (void)old_fa; /* to avoid #ifdefs everywhere... */
+    old_fa = fcb->f_oldest;
+    (void)old_fa; /* to avoid #ifdefs everywhere... */
 
 #if MYNEWT_VAL(LOG_STATS)
-        rc = fcb_area_info(fcb, NULL, &cnt, NULL);
-        if (rc == 0) {
-            LOG_STATS_INCN(log, lost, cnt);
-        }
+    rc = fcb_area_info(fcb, NULL, &cnt, NULL);
+    if (rc == 0) {
+        LOG_STATS_INCN(log, lost, cnt);
+    }
 #endif
 
-        /* Notify upper layer that a rotation is about to occur */
-        if (log->l_rotate_notify_cb != NULL) {
-            fcb_append_to_scratch(fcb);
-            log->l_rotate_notify_cb(log);
-        }
+    /* Notify upper layer that a rotation is about to occur */
+    if (log->l_rotate_notify_cb != NULL) {
+        fcb_append_to_scratch(fcb);
+        log->l_rotate_notify_cb(log);
+    }
 
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
-        /* The FCB needs to be rotated. */
-        log_fcb_rotate_bmarks(fcb_log);
+    /* The FCB needs to be rotated. */
+    log_fcb_rotate_bmarks(fcb_log);
+#endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_rotate_sector_idx(fcb_log);
 #endif
 
-        rc = fcb_rotate(fcb);
-        if (rc) {
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    start = os_get_uptime_usec();
+#endif
+    rc = fcb_rotate(fcb);
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    log_fcb_erase_done(log, os_get_uptime_usec() - start);
+#endif
+    if (rc) {
+        return rc;
+    }
+
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+    /*
+     * FCB was rotated successfully so let's check if watermark was within
+     * oldest flash area which was erased. If yes, then move watermark to
+     * beginning of current oldest area.
+     */
+    if ((fcb_log->fl_watermark_off >= old_fa->fa_off) &&
+        (fcb_log->fl_watermark_off < old_fa->fa_off + old_fa->fa_size)) {
+        fcb_log->fl_watermark_off = fcb->f_oldest->fa_off;
+    }
+#endif
+
+    return 0;
+}
+
+int
+log_fcb_make_room(struct log *log)
+{
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    struct fcb_log *fcb_log;
+    int rc;
+
+    fcb_log = log->l_arg;
+    if (log_fcb_pre_erase_lock(fcb_log)) {
+        /* The erase event made room while this task waited. */
+        rc = 0;
+    } else {
+        rc = log_fcb_rotate(log);
+    }
+    log_fcb_pre_erase_unlock(fcb_log);
+
+    return rc;
+#else
+    return log_fcb_rotate(log);
+#endif
+}
+
+static int
+log_fcb_start_append(struct log *log, int len, struct fcb_entry *loc)
+{
+    struct fcb *fcb;
+    struct fcb_log *fcb_log;
+    int rc = 0;
+
+    fcb_log = (struct fcb_log *)log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+
+    while (1) {
+        rc = fcb_append(fcb, len, loc);
+        if (rc == 0) {
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+            log_fcb_pre_erase_check(log);
+#endif
+            break;
+        }
+
+        if (rc != FCB_ERR_NOSPACE) {
             goto err;
         }
 
-#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
-        /*
-         * FCB was rotated successfully so let's check if watermark was within
-         * oldest flash area which was erased. If yes, then move watermark to
-         * beginning of current oldest area.
-         */
-        if ((fcb_log->fl_watermark_off >= old_fa->fa_off) &&
-            (fcb_log->fl_watermark_off < old_fa->fa_off + old_fa->fa_size)) {
-            fcb_log->fl_watermark_off = fcb->f_oldest->fa_off;
+        rc = log_fcb_make_room(log);
+        if (rc) {
+            goto err;
         }
-#endif
     }
 
 err:
@@ -235,6 +323,13 @@ log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
         return SYS_ENOTSUP;
     }
 
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+    rc = log_fcb_group_append(log, hdr, body, NULL, 0, body_len);
+    if (rc != 1) {
+        return rc;
+    }
+#endif
+
     hdr_len = log_hdr_len(hdr);
 
     rc = log_fcb_start_append(log, hdr_len + body_len, &loc);
@@ -290,6 +385,13 @@ log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
+    log_fcb_append_bmarks(fcb_log, &loc, hdr->ue_index);
+#endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_update_sector_idx(fcb_log, &loc, hdr);
+#endif
+
     return 0;
 }
 
@@ -305,27 +407,38 @@ log_fcb_append(struct log *log, void *buf, int len)
 }
 
 static int
-log_fcb_write_mbuf(struct fcb_entry *loc, struct os_mbuf *om)
+log_fcb_write_mbuf(struct fcb_entry *loc, struct os_mbuf *om, int off)
 {
+    struct os_mbuf_iovec seg;
+    struct os_mbuf_iter iter;
     int rc;
 
-    while (om) {
-        rc = flash_area_write(loc->fe_area, loc->fe_data_off, om->om_data,
-                              om->om_len);
+    rc = os_mbuf_iter_init(&iter, om, off, os_mbuf_len(om) - off);
+    if (rc != 0) {
+        return SYS_EINVAL;
+    }
+
+    /* Write straight out of each mbuf; no intermediate copy. */
+    while (os_mbuf_iter_next(&iter, &seg) == 0) {
+        rc = flash_area_write(loc->fe_area, loc->fe_data_off, seg.omv_data,
+                              seg.omv_len);
         if (rc != 0) {
             return SYS_EIO;
         }
 
-        loc->fe_data_off += om->om_len;
-        om = SLIST_NEXT(om, om_next);
+        loc->fe_data_off += seg.omv_len;
     }
 
     return 0;
 }
 
+/**
+ * Appends an entry whose body is the contents of the mbuf chain starting
+ * "off" bytes in.
+ */
 static int
-log_fcb_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
-                         struct os_mbuf *om)
+log_fcb_append_mbuf_body_off(struct log *log, const struct log_entry_hdr *hdr,
+                             struct os_mbuf *om, int off)
 {
     struct fcb *fcb;
     struct fcb_entry loc;
@@ -336,6 +449,13 @@ log_fcb_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
     fcb_log = (struct fcb_log *)log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+    rc = log_fcb_group_append(log, hdr, NULL, om, off, os_mbuf_len(om) - off);
+    if (rc != 1) {
+        return rc;
+    }
+#endif
+
     /* This function expects to be able to write each mbuf without any
      * buffering.
      */
@@ -343,7 +463,7 @@ log_fcb_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
         return SYS_ENOTSUP;
     }
 
-    len = log_hdr_len(hdr) + os_mbuf_len(om);
+    len = log_hdr_len(hdr) + os_mbuf_len(om) - off;
     rc = log_fcb_start_append(log, len, &loc);
     if (rc != 0) {
         return rc;
@@ -365,7 +485,7 @@ log_fcb_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
         }
         loc.fe_data_off += LOG_IMG_HASHLEN;
     }
-    rc = log_fcb_write_mbuf(&loc, om);
+    rc = log_fcb_write_mbuf(&loc, om, off);
     if (rc != 0) {
         return rc;
     }
@@ -375,13 +495,26 @@ log_fcb_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
+    log_fcb_append_bmarks(fcb_log, &loc, hdr->ue_index);
+#endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_update_sector_idx(fcb_log, &loc, hdr);
+#endif
+
     return 0;
 }
 
+static int
+log_fcb_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
+                         struct os_mbuf *om)
+{
+    return log_fcb_append_mbuf_body_off(log, hdr, om, 0);
+}
+
 static int
 log_fcb_append_mbuf(struct log *log, struct os_mbuf *om)
 {
-    int rc;
     uint16_t mlen;
     uint16_t hdr_len;
     struct log_entry_hdr hdr;
@@ -392,32 +525,18 @@ log_fcb_append_mbuf(struct log *log, struct os_mbuf *om)
     }
 
     /*
-     * We do a pull up twice, once so that the base header is
-     * contiguous, so that we read the flags correctly, second
-     * time is so that we account for the image hash as well.
-     */
-    om = os_mbuf_pullup(om, LOG_BASE_ENTRY_HDR_SIZE);
-
-    /*
-     * We can just pass the om->om_data ptr as the log_entry_hdr
-     * because the log_entry_hdr is a packed struct and does not
-     * cause any alignment or padding issues
+     * Copy out the base header first so that we can read the flags, then
+     * the full header so that we account for the image hash as well.  The
+     * body is written straight from the mbuf chain, which is left untouched.
      */
-    hdr_len = log_hdr_len((struct log_entry_hdr *)om->om_data);
-
-    om = os_mbuf_pullup(om, hdr_len);
-
-    memcpy(&hdr, om->om_data, hdr_len);
-
-    os_mbuf_adj(om, hdr_len);
-
-    rc = log_fcb_append_mbuf_body(log, &hdr, om);
-
-    os_mbuf_prepend(om, hdr_len);
-
-    memcpy(om->om_data, &hdr, hdr_len);
+    os_mbuf_copydata(om, 0, LOG_BASE_ENTRY_HDR_SIZE, &hdr);
+    hdr_len = log_hdr_len(&hdr);
+    if (mlen < hdr_len) {
+        return SYS_ENOMEM;
+    }
+    os_mbuf_copydata(om, 0, hdr_len, &hdr);
 
-    return rc;
+    return log_fcb_append_mbuf_body_off(log, &hdr, om, hdr_len);
 }
 
 static int
@@ -445,9 +564,10 @@ log_fcb_read_mbuf(struct log *log, const void *dptr, struct os_mbuf *om,
                   uint16_t offset, uint16_t len)
 {
     struct fcb_entry *loc;
-    uint8_t data[128];
+    struct os_mbuf *last;
     uint16_t read_len;
     uint16_t rem_len;
+    uint8_t *data;
     int rc;
 
     loc = (struct fcb_entry *)dptr;
@@ -458,15 +578,29 @@ log_fcb_read_mbuf(struct log *log, const void *dptr, struct os_mbuf *om,
 
     rem_len = len;
 
+    /*
+     * Flash is read straight into the chain: into the free space of its last
+     * mbuf, or into a new mbuf once that is full.
+     */
+    last = om;
     while (rem_len > 0) {
-        read_len = min(rem_len, sizeof(data));
-        rc = flash_area_read(loc->fe_area, loc->fe_data_off + offset, data,
-                             read_len);
-        if (rc) {
+        while (SLIST_NEXT(last, om_next) != NULL) {
+            last = SLIST_NEXT(last, om_next);
+        }
+        read_len = OS_MBUF_TRAILINGSPACE(last);
+        if (read_len == 0) {
+            read_len = om->om_omp->omp_databuf_len;
+        }
+        read_len = min(rem_len, read_len);
+
+        data = os_mbuf_extend(om, read_len);
+        if (data == NULL) {
             goto done;
         }
-        rc = os_mbuf_append(om, data, read_len);
+        rc = flash_area_read(loc->fe_area, loc->fe_data_off + offset, data,
+                             read_len);
         if (rc) {
+            os_mbuf_adj(om, -read_len);
             goto done;
         }
 
@@ -478,6 +612,44 @@ done:
     return len - rem_len;
 }
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)
+/**
+ * Advances `loc` past the sectors whose summary shows that none of their
+ * entries match `filter`.
+ *
+ * @return                      0 if `loc` points to an entry in a sector
+ *                                  that may match; SYS_ENOENT if no
+ *                                  remaining sector may match.
+ */
+static int
+log_fcb_skip_sectors(struct fcb_log *fcb_log, const struct log_filter *filter,
+                     struct fcb_entry *loc)
+{
+    struct fcb *fcb;
+    int i;
+
+    fcb = &fcb_log->fl_fcb;
+
+    while (!log_fcb_sector_may_match(fcb_log, loc->fe_area, filter)) {
+        if (loc->fe_area == fcb->f_active.fe_area) {
+            return SYS_ENOENT;
+        }
+
+        i = loc->fe_area - fcb->f_sectors + 1;
+        if (i >= fcb->f_sector_cnt) {
+            i = 0;
+        }
+        loc->fe_area = &fcb->f_sectors[i];
+        loc->fe_elem_off = 0;
+        if (fcb_getnext(fcb, loc) != 0) {
+            return SYS_ENOENT;
+        }
+    }
+
+    return 0;
+}
+#endif
+
 /**
  * @brief Common function for walking a single area or the full logs
  *
@@ -485,22 +657,35 @@ done:
  * @param[in]  The walk function
  * @param      The log offset
  * @param[in]  Reading either a single area or the full log
+ * @param[in]  Entries to walk; sectors that cannot match are skipped
  *
  * @return     { description_of_the_return_value }
  */
 static int
 log_fcb_walk_impl(struct log *log, log_walk_func_t walk_func,
-             struct log_offset *log_offset, bool area)
+             struct log_offset *log_offset, bool area,
+             const struct log_filter *filter)
 {
     struct fcb *fcb;
     struct fcb_log *fcb_log;
     struct fcb_entry loc;
     struct flash_area *fap;
+#if MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)
+    struct flash_area *skip_checked;
+#endif
     int rc;
 
     fcb_log = log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+    /* Staged entries have to be in flash for the walk to see them. */
+    rc = log_fcb_commit(log);
+    if (rc != 0) {
+        return rc;
+    }
+#endif
+
     /* Locate the starting point of the walk. */
     rc = log_fcb_find_gte(log, log_offset, &loc);
     switch (rc) {
@@ -524,7 +709,19 @@ log_fcb_walk_impl(struct log *log, log_walk_func_t walk_func,
     }
 #endif
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)
+    skip_checked = NULL;
+#endif
     do {
+#if MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)
+        if (filter != NULL && loc.fe_area != skip_checked) {
+            if (log_fcb_skip_sectors(fcb_log, filter, &loc) != 0) {
+                return 0;
+            }
+            skip_checked = loc.fe_area;
+        }
+#endif
+
         if (area) {
             if (fap != loc.fe_area) {
                 return 0;
@@ -548,16 +745,25 @@ static int
 log_fcb_walk(struct log *log, log_walk_func_t walk_func,
              struct log_offset *log_offset)
 {
-    return log_fcb_walk_impl(log, walk_func, log_offset, false);
+    return log_fcb_walk_impl(log, walk_func, log_offset, false, NULL);
 }
 
 static int
 log_fcb_walk_area(struct log *log, log_walk_func_t walk_func,
              struct log_offset *log_offset)
 {
-    return log_fcb_walk_impl(log, walk_func, log_offset, true);
+    return log_fcb_walk_impl(log, walk_func, log_offset, true, NULL);
 }
 
+#if MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)
+static int
+log_fcb_walk_filtered(struct log *log, const struct log_filter *filter,
+                      log_walk_func_t walk_func, struct log_offset *log_offset)
+{
+    return log_fcb_walk_impl(log, walk_func, log_offset, false, filter);
+}
+#endif
+
 static int
 log_fcb_flush(struct log *log)
 {
@@ -570,6 +776,12 @@ log_fcb_flush(struct log *log)
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     log_fcb_clear_bmarks(fcb_log);
 #endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_clear_sector_idx(fcb_log);
+#endif
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+    log_fcb_group_discard(fcb_log);
+#endif
 
     return fcb_clear(fcb);
 }
@@ -601,6 +813,9 @@ log_fcb_registered(struct log *log)
     /* Initialize watermark to designated unknown value*/
     fl->fl_watermark_off = 0xffffffff;
 #endif
+#endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_build_sector_idx(log->l_arg);
 #endif
     return 0;
 }
@@ -832,7 +1047,8 @@ static int
 log_fcb_rtr_erase(struct log *log)
 {
     struct fcb_log *fcb_log;
-    struct fcb fcb_scratch;
+    struct fcb_log scratch_log;
+    struct fcb *fcb_scratch;
     struct fcb *fcb;
     const struct flash_area *ptr;
     struct fcb_entry entry;
@@ -848,19 +1064,24 @@ log_fcb_rtr_erase(struct log *log)
     fcb_log = log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
-    memset(&fcb_scratch, 0, sizeof(fcb_scratch));
+    /*
+     * The scratch FCB is temporarily used as the log's backing store while
+     * entries are copied, so it has to be a complete (empty) fcb_log.
+     */
+    memset(&scratch_log, 0, sizeof(scratch_log));
+    fcb_scratch = &scratch_log.fl_fcb;
 
     if (flash_area_open(FLASH_AREA_IMAGE_SCRATCH, &ptr)) {
         goto err;
     }
     sector = *ptr;
-    fcb_scratch.f_sectors = &sector;
-    fcb_scratch.f_sector_cnt = 1;
-    fcb_scratch.f_magic = 0x7EADBADF;
-    fcb_scratch.f_version = g_log_info.li_version;
+    fcb_scratch->f_sectors = &sector;
+    fcb_scratch->f_sector_cnt = 1;
+    fcb_scratch->f_magic = 0x7EADBADF;
+    fcb_scratch->f_version = g_log_info.li_version;
 
     flash_area_erase(&sector, 0, sector.fa_size);
-    rc = fcb_init(&fcb_scratch);
+    rc = fcb_init(fcb_scratch);
     if (rc) {
         goto err;
     }
@@ -872,7 +1093,7 @@ log_fcb_rtr_erase(struct log *log)
     }
 
     /* Copy to scratch */
-    rc = log_fcb_copy(log, fcb, &fcb_scratch, entry.fe_elem_off);
+    rc = log_fcb_copy(log, fcb, fcb_scratch, entry.fe_elem_off);
     if (rc) {
         goto err;
     }
@@ -884,7 +1105,7 @@ log_fcb_rtr_erase(struct log *log)
     }
 
     /* Copy back from scratch */
-    rc = log_fcb_copy(log, &fcb_scratch, fcb, 0);
+    rc = log_fcb_copy(log, fcb_scratch, fcb, 0);
 
 err:
     return (rc);
@@ -900,6 +1121,9 @@ const struct log_handler log_fcb_handler = {
     .log_append_mbuf_body = log_fcb_append_mbuf_body,
     .log_walk             = log_fcb_walk,
     .log_walk_sector      = log_fcb_walk_area,
+#if MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)
+    .log_walk_filtered    = log_fcb_walk_filtered,
+#endif
     .log_flush            = log_fcb_flush,
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
     .log_storage_info     = log_fcb_storage_info,
@@ -125,71 +125,119 @@ log_fcb2_find_gte(struct log *log, struct log_offset *log_offset,
 }
 
 static int
-log_fcb2_start_append(struct log *log, int len, struct fcb2_entry *loc)
+log_fcb_rotate(struct log *log)
 {
     struct fcb2 *fcb;
     struct fcb_log *fcb_log;
 #if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
     int old_sec;
 #endif
-    int rc = 0;
+    int rc;
 #if MYNEWT_VAL(LOG_STATS)
     int cnt;
 #endif
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    int64_t start;
+#endif
 
     fcb_log = (struct fcb_log *)log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
-    while (1) {
-        rc = fcb2_append(fcb, len, loc);
-        if (rc == 0) {
-            break;
-        }
-
-        if (rc != FCB2_ERR_NOSPACE) {
-            goto err;
-        }
-
-        if (fcb_log->fl_entries) {
-            rc = log_fcb2_rtr_erase(log);
-            if (rc) {
-                goto err;
-            }
-            continue;
-        }
+    if (fcb_log->fl_entries) {
+        return log_fcb2_rtr_erase(log);
+    }
 
 #if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
-        old_sec = fcb->f_oldest_sec;
+    old_sec = fcb->f_oldest_sec;
 #endif
 
 #if MYNEWT_VAL(LOG_STATS)
-        rc = fcb2_area_info(fcb, FCB2_SECTOR_OLDEST, &cnt, NULL);
-        if (rc == 0) {
-            LOG_STATS_INCN(log, lost, cnt);
-        }
+    rc = fcb2_area_info(fcb, FCB2_SECTOR_OLDEST, &cnt, NULL);
+    if (rc == 0) {
+        LOG_STATS_INCN(log, lost, cnt);
+    }
 #endif
 
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
-        /* The FCB needs to be rotated. */
-        log_fcb_rotate_bmarks(fcb_log);
+    /* The FCB needs to be rotated. */
+    log_fcb_rotate_bmarks(fcb_log);
 #endif
 
-        rc = fcb2_rotate(fcb);
-        if (rc) {
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    start = os_get_uptime_usec();
+#endif
+    rc = fcb2_rotate(fcb);
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    log_fcb_erase_done(log, os_get_uptime_usec() - start);
+#endif
+    if (rc) {
+        return rc;
+    }
+
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+    /*
+     * FCB was rotated successfully so let's check if watermark was within
+     * oldest flash area which was erased. If yes, then move watermark to
+     * beginning of current oldest area.
+     */
+    if (fcb_log->fl_watermark_sec == old_sec) {
+        fcb_log->fl_watermark_sec = fcb->f_oldest_sec;
+        fcb_log->fl_watermark_off = 0;
+    }
+#endif
+
+    return 0;
+}
+
+int
+log_fcb_make_room(struct log *log)
+{
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    struct fcb_log *fcb_log;
+    int rc;
+
+    fcb_log = log->l_arg;
+    if (log_fcb_pre_erase_lock(fcb_log)) {
+        /* The erase event made room while this task waited. */
+        rc = 0;
+    } else {
+        rc = log_fcb_rotate(log);
+    }
+    log_fcb_pre_erase_unlock(fcb_log);
+
+    return rc;
+#else
+    return log_fcb_rotate(log);
+#endif
+}
+
+static int
+log_fcb2_start_append(struct log *log, int len, struct fcb2_entry *loc)
+{
+    struct fcb2 *fcb;
+    struct fcb_log *fcb_log;
+    int rc = 0;
+
+    fcb_log = (struct fcb_log *)log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+
+    while (1) {
+        rc = fcb2_append(fcb, len, loc);
+        if (rc == 0) {
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+            log_fcb_pre_erase_check(log);
+#endif
+            break;
+        }
+
+        if (rc != FCB2_ERR_NOSPACE) {
             goto err;
         }
 
-#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
-        /*
-         * FCB was rotated successfully so let's check if watermark was within
-         * oldest flash area which was erased. If yes, then move watermark to
-         * beginning of current oldest area.
-         */
-        if (fcb_log->fl_watermark_sec == old_sec) {
-            fcb_log->fl_watermark_sec = fcb->f_oldest_sec;
-            fcb_log->fl_watermark_off = 0;
+        rc = log_fcb_make_room(log);
+        if (rc) {
+            goto err;
         }
-#endif
     }
 
 err:
@@ -230,6 +278,13 @@ log_fcb2_append_body(struct log *log, const struct log_entry_hdr *hdr,
     int rc;
     uint16_t hdr_len;
 
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+    rc = log_fcb_group_append(log, hdr, body, NULL, 0, body_len);
+    if (rc != 1) {
+        return rc;
+    }
+#endif
+
     hdr_len = log_hdr_len(hdr);
 
     rc = log_fcb2_start_append(log, hdr_len + body_len, &loc);
@@ -284,6 +339,10 @@ log_fcb2_append_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
+    log_fcb_append_bmarks(log->l_arg, &loc, hdr->ue_index);
+#endif
+
     return 0;
 }
 
@@ -336,6 +395,13 @@ log_fcb2_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
     }
 #endif
 
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+    rc = log_fcb_group_append(log, hdr, NULL, om, 0, os_mbuf_len(om));
+    if (rc != 1) {
+        return rc;
+    }
+#endif
+
     len = log_hdr_len(hdr) + os_mbuf_len(om);
     rc = log_fcb2_start_append(log, len, &loc);
     if (rc != 0) {
@@ -366,6 +432,10 @@ log_fcb2_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
+    log_fcb_append_bmarks(log->l_arg, &loc, hdr->ue_index);
+#endif
+
     return 0;
 }
 
@@ -435,9 +505,10 @@ log_fcb2_read_mbuf(struct log *log, const void *dptr, struct os_mbuf *om,
                    uint16_t off, uint16_t len)
 {
     struct fcb2_entry *loc;
-    uint8_t data[128];
+    struct os_mbuf *last;
     uint16_t read_len;
     uint16_t rem_len;
+    uint8_t *data;
     int rc;
 
     loc = (struct fcb2_entry *)dptr;
@@ -448,15 +519,28 @@ log_fcb2_read_mbuf(struct log *log, const void *dptr, struct os_mbuf *om,
 
     rem_len = len;
 
+    /*
+     * Flash is read straight into the chain: into the free space of its last
+     * mbuf, or into a new mbuf once that is full.
+     */
+    last = om;
     while (rem_len > 0) {
-        read_len = min(rem_len, sizeof(data));
-        rc = fcb2_read(loc, off, data, read_len);
-        if (rc) {
-            goto done;
+        while (SLIST_NEXT(last, om_next) != NULL) {
+            last = SLIST_NEXT(last, om_next);
         }
+        read_len = OS_MBUF_TRAILINGSPACE(last);
+        if (read_len == 0) {
+            read_len = om->om_omp->omp_databuf_len;
+        }
+        read_len = min(rem_len, read_len);
 
-        rc = os_mbuf_append(om, data, read_len);
+        data = os_mbuf_extend(om, read_len);
+        if (data == NULL) {
+            goto done;
+        }
+        rc = fcb2_read(loc, off, data, read_len);
         if (rc) {
+            os_mbuf_adj(om, -read_len);
             goto done;
         }
 
@@ -480,6 +564,14 @@ log_fcb2_walk(struct log *log, log_walk_func_t walk_func,
     fcb_log = log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+    /* Staged entries have to be in flash for the walk to see them. */
+    rc = log_fcb_commit(log);
+    if (rc != 0) {
+        return rc;
+    }
+#endif
+
     /* Locate the starting point of the walk. */
     rc = log_fcb2_find_gte(log, log_off, &loc);
     switch (rc) {
@@ -528,6 +620,9 @@ log_fcb2_flush(struct log *log)
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     log_fcb_clear_bmarks(fcb_log);
 #endif
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+    log_fcb_group_discard(fcb_log);
+#endif
 
     return fcb2_clear(fcb);
 }
@@ -820,7 +915,8 @@ static int
 log_fcb2_rtr_erase(struct log *log)
 {
     struct fcb_log *fcb_log;
-    struct fcb2 fcb_scratch;
+    struct fcb_log scratch_log;
+    struct fcb2 *fcb_scratch;
     struct fcb2 *fcb;
     struct fcb2_entry entry;
     int rc;
@@ -836,21 +932,26 @@ log_fcb2_rtr_erase(struct log *log)
     fcb_log = log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
-    memset(&fcb_scratch, 0, sizeof(fcb_scratch));
+    /*
+     * The scratch FCB is temporarily used as the log's backing store while
+     * entries are copied, so it has to be a complete (empty) fcb_log.
+     */
+    memset(&scratch_log, 0, sizeof(scratch_log));
+    fcb_scratch = &scratch_log.fl_fcb;
 
     range_cnt = 1;
     if (flash_area_to_sector_ranges(FLASH_AREA_IMAGE_SCRATCH, &range_cnt,
                                     &range)) {
         goto err;
     }
-    fcb_scratch.f_ranges = &range;
-    fcb_scratch.f_sector_cnt = 1;
-    fcb_scratch.f_range_cnt = 1;
-    fcb_scratch.f_magic = 0x7EADBAE0;
-    fcb_scratch.f_version = g_log_info.li_version;
+    fcb_scratch->f_ranges = &range;
+    fcb_scratch->f_sector_cnt = 1;
+    fcb_scratch->f_range_cnt = 1;
+    fcb_scratch->f_magic = 0x7EADBAE0;
+    fcb_scratch->f_version = g_log_info.li_version;
 
     flash_area_erase(&range.fsr_flash_area, 0, range.fsr_flash_area.fa_size);
-    rc = fcb2_init(&fcb_scratch);
+    rc = fcb2_init(fcb_scratch);
     if (rc) {
         goto err;
     }
@@ -862,7 +963,7 @@ log_fcb2_rtr_erase(struct log *log)
     }
 
     /* Copy to scratch */
-    rc = log_fcb2_copy(log, fcb, &fcb_scratch, &entry);
+    rc = log_fcb2_copy(log, fcb, fcb_scratch, &entry);
     if (rc) {
         goto err;
     }
@@ -874,12 +975,12 @@ log_fcb2_rtr_erase(struct log *log)
     }
 
     memset(&entry, 0, sizeof(entry));
-    rc = fcb2_getnext(&fcb_scratch, &entry);
+    rc = fcb2_getnext(fcb_scratch, &entry);
     if (rc) {
         goto err;
     }
     /* Copy back from scratch */
-    rc = log_fcb2_copy(log, &fcb_scratch, fcb, &entry);
+    rc = log_fcb2_copy(log, fcb_scratch, fcb, &entry);
 
 err:
     return (rc);
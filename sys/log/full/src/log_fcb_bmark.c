@@ -35,33 +35,58 @@ log_fcb_init_bmarks(struct fcb_log *fcb_log,
     };
 }
 
+void
+log_fcb_init_auto_bmarks(struct fcb_log *fcb_log,
+                         struct log_fcb_bmark *buf, int bmark_count,
+                         uint32_t spacing)
+{
+    log_fcb_init_bmarks(fcb_log, buf, bmark_count);
+
+    /* Thinning needs room for at least two bookmarks. */
+    if (bmark_count >= 2 && spacing > 0) {
+        fcb_log->fl_bset.lfs_spacing = spacing;
+        fcb_log->fl_bset.lfs_min_spacing = spacing;
+    }
+}
+
+static bool
+log_fcb_bmark_in_oldest(const struct fcb_log *fcb_log,
+                        const struct log_fcb_bmark *bmark)
+{
+#if MYNEWT_VAL(LOG_FCB)
+    return bmark->lfb_entry.fe_area == fcb_log->fl_fcb.f_oldest;
+#elif MYNEWT_VAL(LOG_FCB2)
+    return bmark->lfb_entry.fe_sector == fcb_log->fl_fcb.f_oldest_sec;
+#endif
+}
+
 void
 log_fcb_rotate_bmarks(struct fcb_log *fcb_log)
 {
-    int i;
-    struct log_fcb_bmark *bmark;
     struct log_fcb_bset *bset;
+    int i;
+    int j;
 
     bset = &fcb_log->fl_bset;
 
+    /*
+     * Drop the bookmarks in the oldest area.  The rest keep their relative
+     * order so that automatic bookmarks stay sorted and evenly spaced.
+     */
+    j = 0;
     for (i = 0; i < bset->lfs_size; i++) {
-        bmark = &bset->lfs_bmarks[i];
-#if MYNEWT_VAL(LOG_FCB)
-        if (bmark->lfb_entry.fe_area != fcb_log->fl_fcb.f_oldest) {
+        if (log_fcb_bmark_in_oldest(fcb_log, &bset->lfs_bmarks[i])) {
             continue;
         }
-#endif
-#if MYNEWT_VAL(LOG_FCB2)
-        if (bmark->lfb_entry.fe_sector != fcb_log->fl_fcb.f_oldest_sec) {
-            continue;
-        }
-#endif
-        if (i != bset->lfs_size - 1) {
-            *bmark = bset->lfs_bmarks[bset->lfs_size - 1];
-            i--;
+        if (i != j) {
+            bset->lfs_bmarks[j] = bset->lfs_bmarks[i];
         }
-        bset->lfs_size--;
-        bset->lfs_next = bset->lfs_size;
+        j++;
+    }
+
+    if (j != bset->lfs_size) {
+        bset->lfs_size = j;
+        bset->lfs_next = j;
     }
 }
 
@@ -70,6 +95,33 @@ log_fcb_clear_bmarks(struct fcb_log *fcb_log)
 {
     fcb_log->fl_bset.lfs_size = 0;
     fcb_log->fl_bset.lfs_next = 0;
+    fcb_log->fl_bset.lfs_spacing = fcb_log->fl_bset.lfs_min_spacing;
+    fcb_log->fl_bset.lfs_since = 0;
+}
+
+static const struct log_fcb_bmark *
+log_fcb_closest_auto_bmark(const struct log_fcb_bset *bset, uint32_t index)
+{
+    const struct log_fcb_bmark *closest;
+    int lo;
+    int hi;
+    int mid;
+
+    /* Automatic bookmarks are sorted by index. */
+    closest = NULL;
+    lo = 0;
+    hi = bset->lfs_size - 1;
+    while (lo <= hi) {
+        mid = lo + (hi - lo) / 2;
+        if (bset->lfs_bmarks[mid].lfb_index <= index) {
+            closest = &bset->lfs_bmarks[mid];
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    return closest;
 }
 
 const struct log_fcb_bmark *
@@ -81,6 +133,10 @@ log_fcb_closest_bmark(const struct fcb_log *fcb_log, uint32_t index)
     uint32_t diff;
     int i;
 
+    if (fcb_log->fl_bset.lfs_spacing != 0) {
+        return log_fcb_closest_auto_bmark(&fcb_log->fl_bset, index);
+    }
+
     min_diff = UINT32_MAX;
     closest = NULL;
 
@@ -112,7 +168,8 @@ log_fcb_add_bmark(struct fcb_log *fcb_log, const struct fcb2_entry *entry,
 
     bset = &fcb_log->fl_bset;
 
-    if (bset->lfs_cap == 0) {
+    /* Automatic bookmarks are placed by appends only. */
+    if (bset->lfs_cap == 0 || bset->lfs_spacing != 0) {
         return;
     }
 
@@ -131,4 +188,55 @@ log_fcb_add_bmark(struct fcb_log *fcb_log, const struct fcb2_entry *entry,
     }
 }
 
+#if MYNEWT_VAL(LOG_FCB)
+void
+log_fcb_append_bmarks(struct fcb_log *fcb_log, const struct fcb_entry *entry,
+                      uint32_t index)
+#elif MYNEWT_VAL(LOG_FCB2)
+void
+log_fcb_append_bmarks(struct fcb_log *fcb_log, const struct fcb2_entry *entry,
+                      uint32_t index)
+#endif
+{
+    struct log_fcb_bset *bset;
+    int i;
+
+    bset = &fcb_log->fl_bset;
+
+    if (bset->lfs_spacing == 0) {
+        return;
+    }
+
+    bset->lfs_since++;
+    if (bset->lfs_size > 0 && bset->lfs_since < bset->lfs_spacing) {
+        return;
+    }
+
+    if (bset->lfs_size == bset->lfs_cap) {
+        /*
+         * The set is full: keep every other bookmark and double the spacing.
+         * If the newest bookmark is dropped, the distance to the one before
+         * it is what counts from here on.
+         */
+        if (bset->lfs_size % 2 == 0) {
+            bset->lfs_since += bset->lfs_spacing;
+        }
+        for (i = 0; 2 * i < bset->lfs_size; i++) {
+            bset->lfs_bmarks[i] = bset->lfs_bmarks[2 * i];
+        }
+        bset->lfs_size = i;
+        bset->lfs_spacing *= 2;
+
+        if (bset->lfs_since < bset->lfs_spacing) {
+            return;
+        }
+    }
+
+    bset->lfs_bmarks[bset->lfs_size++] = (struct log_fcb_bmark) {
+        .lfb_entry = *entry,
+        .lfb_index = index,
+    };
+    bset->lfs_since = 0;
+}
+
 #endif /* MYNEWT_VAL(LOG_FCB_BOOKMARKS) */
@@ -0,0 +1,327 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_FCB_GROUP_COMMIT)
+
+#include "log/log.h"
+
+#if MYNEWT_VAL(LOG_FCB)
+#define log_fcb_elem_size           fcb_element_size
+#define log_fcb_elem_encode         fcb_element_encode
+#define log_fcb_elem_encode_finish  fcb_element_encode_finish
+#define log_fcb_append_batch        fcb_append_batch
+#define LOG_FCB_ERR_NOSPACE         FCB_ERR_NOSPACE
+#elif MYNEWT_VAL(LOG_FCB2)
+#define log_fcb_elem_size           fcb2_element_size
+#define log_fcb_elem_encode         fcb2_element_encode
+#define log_fcb_elem_encode_finish  fcb2_element_encode_finish
+#define log_fcb_append_batch        fcb2_append_batch
+#define LOG_FCB_ERR_NOSPACE         FCB2_ERR_NOSPACE
+#endif
+
+static void
+log_fcb_group_lock(struct log_fcb_group *grp)
+{
+    int rc;
+
+    rc = os_mutex_pend(&grp->lfg_mtx, OS_WAIT_FOREVER);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+}
+
+static void
+log_fcb_group_unlock(struct log_fcb_group *grp)
+{
+    int rc;
+
+    rc = os_mutex_release(&grp->lfg_mtx);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+}
+
+/**
+ * Updates the bookmarks and the sector index with a committed entry.
+ */
+static void
+log_fcb_group_committed(struct fcb_log *fcb_log, int idx, const uint8_t *elem)
+{
+    struct log_entry_hdr hdr;
+    int data_off;
+
+#if MYNEWT_VAL(LOG_FCB)
+    data_off = fcb_log->fl_group.lfg_locs[idx].fe_data_off -
+               fcb_log->fl_group.lfg_locs[idx].fe_elem_off;
+#else
+    data_off = 0;
+#endif
+    memcpy(&hdr, elem + data_off, LOG_BASE_ENTRY_HDR_SIZE);
+
+#if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
+    log_fcb_append_bmarks(fcb_log, &fcb_log->fl_group.lfg_locs[idx],
+                          hdr.ue_index);
+#endif
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+    log_fcb_update_sector_idx(fcb_log, &fcb_log->fl_group.lfg_locs[idx], &hdr);
+#endif
+    (void)hdr;
+}
+
+/**
+ * Writes the staged entries to flash.  Called with the group locked.
+ */
+static int
+log_fcb_group_write(struct log *log)
+{
+    struct log_fcb_group *grp;
+    struct fcb_log *fcb_log;
+    int off;
+    int cnt;
+    int rc;
+    int i;
+
+    fcb_log = log->l_arg;
+    grp = &fcb_log->fl_group;
+
+    /* Appends made while rotating (e.g., by log_fcb_rtr_erase()) go
+     * straight to flash.
+     */
+    grp->lfg_committing = 1;
+
+    rc = 0;
+    off = 0;
+    i = 0;
+    while (i < grp->lfg_cnt) {
+        cnt = log_fcb_append_batch(&fcb_log->fl_fcb, grp->lfg_buf + off,
+                                   &grp->lfg_lens[i], grp->lfg_cnt - i,
+                                   &grp->lfg_locs[i]);
+        if (cnt == LOG_FCB_ERR_NOSPACE) {
+            rc = log_fcb_make_room(log);
+            if (rc != 0) {
+                break;
+            }
+            continue;
+        }
+        if (cnt < 0) {
+            rc = SYS_EIO;
+            break;
+        }
+
+        for (cnt += i; i < cnt; i++) {
+            log_fcb_group_committed(fcb_log, i, grp->lfg_buf + off);
+            off += log_fcb_elem_size(&fcb_log->fl_fcb, grp->lfg_lens[i]);
+        }
+    }
+
+    /* Keep whatever could not be written. */
+    if (i > 0) {
+        memmove(grp->lfg_buf, grp->lfg_buf + off, grp->lfg_buf_used - off);
+        memmove(grp->lfg_lens, grp->lfg_lens + i,
+                (grp->lfg_cnt - i) * sizeof(grp->lfg_lens[0]));
+        grp->lfg_buf_used -= off;
+        grp->lfg_cnt -= i;
+    }
+    if (grp->lfg_cnt == 0) {
+        os_callout_stop(&grp->lfg_timer);
+    }
+
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+    log_fcb_pre_erase_check(log);
+#endif
+
+    grp->lfg_committing = 0;
+
+    return rc;
+}
+
+static void
+log_fcb_group_timer_cb(struct os_event *ev)
+{
+    struct fcb_log *fcb_log;
+
+    fcb_log = ev->ev_arg;
+    log_fcb_commit(fcb_log->fl_group.lfg_log);
+}
+
+#if MYNEWT_VAL(LOG_FCB)
+int
+log_fcb_init_group(struct fcb_log *fcb_log, uint8_t *buf, int buf_size,
+                   struct fcb_entry *locs, uint16_t *lens, int count,
+                   uint32_t max_age_ms)
+#elif MYNEWT_VAL(LOG_FCB2)
+int
+log_fcb_init_group(struct fcb_log *fcb_log, uint8_t *buf, int buf_size,
+                   struct fcb2_entry *locs, uint16_t *lens, int count,
+                   uint32_t max_age_ms)
+#endif
+{
+    struct log_fcb_group *grp;
+    int rc;
+
+    if (buf == NULL || buf_size <= 0 || count <= 0) {
+        return SYS_EINVAL;
+    }
+
+    grp = &fcb_log->fl_group;
+    memset(grp, 0, sizeof(*grp));
+
+    rc = os_time_ms_to_ticks(max_age_ms, &grp->lfg_max_age);
+    if (rc != 0) {
+        return SYS_EINVAL;
+    }
+
+    grp->lfg_buf = buf;
+    grp->lfg_buf_size = buf_size;
+    grp->lfg_locs = locs;
+    grp->lfg_lens = lens;
+    grp->lfg_cap = count;
+    os_mutex_init(&grp->lfg_mtx);
+    os_callout_init(&grp->lfg_timer, os_eventq_dflt_get(),
+                    log_fcb_group_timer_cb, fcb_log);
+
+    return 0;
+}
+
+int
+log_fcb_commit(struct log *log)
+{
+    struct log_fcb_group *grp;
+    struct fcb_log *fcb_log;
+    int rc;
+
+    fcb_log = log->l_arg;
+    grp = &fcb_log->fl_group;
+    if (grp->lfg_buf == NULL) {
+        return 0;
+    }
+
+    log_fcb_group_lock(grp);
+    rc = 0;
+    if (!grp->lfg_committing && grp->lfg_cnt > 0) {
+        rc = log_fcb_group_write(log);
+    }
+    log_fcb_group_unlock(grp);
+
+    return rc;
+}
+
+int
+log_fcb_group_append(struct log *log, const struct log_entry_hdr *hdr,
+                     const void *body, struct os_mbuf *om, int off,
+                     int body_len)
+{
+    struct log_fcb_group *grp;
+    struct fcb_log *fcb_log;
+    uint8_t *elem;
+    uint16_t hdr_len;
+    uint16_t len;
+    int data_off;
+    int elem_sz;
+    int rc;
+
+    fcb_log = log->l_arg;
+    grp = &fcb_log->fl_group;
+    if (grp->lfg_buf == NULL) {
+        return 1;
+    }
+
+    hdr_len = log_hdr_len(hdr);
+    len = hdr_len + body_len;
+    elem_sz = log_fcb_elem_size(&fcb_log->fl_fcb, len);
+    if (elem_sz < 0) {
+        /* Let the direct path report the error. */
+        return 1;
+    }
+
+    log_fcb_group_lock(grp);
+
+    if (grp->lfg_committing) {
+        rc = 1;
+        goto done;
+    }
+
+    if (grp->lfg_cnt == grp->lfg_cap ||
+        grp->lfg_buf_used + elem_sz > grp->lfg_buf_size) {
+        rc = log_fcb_group_write(log);
+        if (rc != 0) {
+            goto done;
+        }
+    }
+    if (elem_sz > grp->lfg_buf_size) {
+        rc = 1;
+        goto done;
+    }
+
+    elem = grp->lfg_buf + grp->lfg_buf_used;
+    data_off = log_fcb_elem_encode(&fcb_log->fl_fcb, elem, len);
+    if (data_off < 0) {
+        rc = SYS_EINVAL;
+        goto done;
+    }
+    memcpy(elem + data_off, hdr, LOG_BASE_ENTRY_HDR_SIZE);
+    if (hdr->ue_flags & LOG_FLAGS_IMG_HASH) {
+        memcpy(elem + data_off + LOG_BASE_ENTRY_HDR_SIZE, hdr->ue_imghash,
+               LOG_IMG_HASHLEN);
+    }
+    if (om != NULL) {
+        rc = os_mbuf_copydata(om, off, body_len, elem + data_off + hdr_len);
+        if (rc != 0) {
+            rc = SYS_EINVAL;
+            goto done;
+        }
+    } else {
+        memcpy(elem + data_off + hdr_len, body, body_len);
+    }
+    log_fcb_elem_encode_finish(&fcb_log->fl_fcb, elem, len);
+
+    grp->lfg_lens[grp->lfg_cnt++] = len;
+    grp->lfg_buf_used += elem_sz;
+    grp->lfg_log = log;
+    if (grp->lfg_cnt == 1 && grp->lfg_max_age != 0) {
+        os_callout_reset(&grp->lfg_timer, grp->lfg_max_age);
+    }
+    rc = 0;
+
+done:
+    log_fcb_group_unlock(grp);
+    return rc;
+}
+
+void
+log_fcb_group_discard(struct fcb_log *fcb_log)
+{
+    struct log_fcb_group *grp;
+
+    grp = &fcb_log->fl_group;
+    if (grp->lfg_buf == NULL) {
+        return;
+    }
+
+    log_fcb_group_lock(grp);
+    /* A commit may flush the log to make room; keep its entries. */
+    if (!grp->lfg_committing) {
+        grp->lfg_cnt = 0;
+        grp->lfg_buf_used = 0;
+        os_callout_stop(&grp->lfg_timer);
+    }
+    log_fcb_group_unlock(grp);
+}
+
+#endif
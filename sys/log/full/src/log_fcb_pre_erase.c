@@ -0,0 +1,184 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_FCB_PRE_ERASE)
+
+#include "log/log.h"
+
+#if MYNEWT_VAL(LOG_FCB)
+#define log_fcb_free_sectors(fcb)   fcb_free_sector_cnt(fcb)
+#define log_fcb_active_sec(fcb)     ((fcb)->f_active.fe_area - (fcb)->f_sectors)
+#define log_fcb_oldest_sec(fcb)     ((fcb)->f_oldest - (fcb)->f_sectors)
+#elif MYNEWT_VAL(LOG_FCB2)
+#define log_fcb_free_sectors(fcb)   fcb2_free_sector_cnt(fcb)
+#define log_fcb_active_sec(fcb)     ((fcb)->f_active.fe_sector)
+#define log_fcb_oldest_sec(fcb)     ((fcb)->f_oldest_sec)
+#endif
+
+/**
+ * Whether the log has to be rotated for its next sector switch to find an
+ * erased sector.
+ */
+static bool
+log_fcb_pre_erase_needed(struct fcb_log *fcb_log)
+{
+    /* Logs which keep their newest entries across rotations are erased in
+     * one go, when full.
+     */
+    if (fcb_log->fl_entries) {
+        return false;
+    }
+
+    /* Never erase the sector being written to. */
+    if (log_fcb_oldest_sec(&fcb_log->fl_fcb) ==
+        log_fcb_active_sec(&fcb_log->fl_fcb)) {
+        return false;
+    }
+
+    return log_fcb_free_sectors(&fcb_log->fl_fcb) <
+           fcb_log->fl_fcb.f_scratch_cnt + 1;
+}
+
+static void
+log_fcb_pre_erase_ev_cb(struct os_event *ev)
+{
+    struct log_fcb_pre_erase *pe;
+    struct fcb_log *fcb_log;
+
+    fcb_log = ev->ev_arg;
+    pe = &fcb_log->fl_pre_erase;
+
+    /* Keep appenders from rotating the log between the check and the
+     * rotation; log_fcb_make_room() takes the lock again, which nests.
+     */
+    log_fcb_pre_erase_lock(fcb_log);
+    pe->lpe_task = os_sched_get_current_task();
+    pe->lpe_running = 1;
+    while (log_fcb_pre_erase_needed(fcb_log)) {
+        if (log_fcb_make_room(pe->lpe_log) != 0) {
+            break;
+        }
+    }
+    pe->lpe_running = 0;
+    log_fcb_pre_erase_unlock(fcb_log);
+}
+
+void
+log_fcb_init_pre_erase(struct fcb_log *fcb_log, struct os_eventq *evq)
+{
+    struct log_fcb_pre_erase *pe;
+
+    pe = &fcb_log->fl_pre_erase;
+    *pe = (struct log_fcb_pre_erase) {
+        .lpe_evq = evq != NULL ? evq : os_eventq_dflt_get(),
+        .lpe_ev = {
+            .ev_cb = log_fcb_pre_erase_ev_cb,
+            .ev_arg = fcb_log,
+        },
+        .lpe_active = -1,
+    };
+    os_mutex_init(&pe->lpe_mtx);
+}
+
+int
+log_fcb_pre_erase_lock(struct fcb_log *fcb_log)
+{
+    struct log_fcb_pre_erase *pe;
+
+    pe = &fcb_log->fl_pre_erase;
+    if (pe->lpe_evq == NULL || fcb_log->fl_entries) {
+        /* The erase event never rotates this log.  Logs which keep their
+         * newest entries re-append them through the group path when
+         * rotated, so locking here would invert the order with the group
+         * lock.
+         */
+        return 0;
+    }
+
+    os_mutex_pend(&pe->lpe_mtx, OS_TIMEOUT_NEVER);
+
+    /* Another task may have rotated the log while this one waited. */
+    return log_fcb_free_sectors(&fcb_log->fl_fcb) >
+           fcb_log->fl_fcb.f_scratch_cnt;
+}
+
+void
+log_fcb_pre_erase_unlock(struct fcb_log *fcb_log)
+{
+    struct log_fcb_pre_erase *pe;
+
+    pe = &fcb_log->fl_pre_erase;
+    if (pe->lpe_evq != NULL && !fcb_log->fl_entries) {
+        os_mutex_release(&pe->lpe_mtx);
+    }
+}
+
+void
+log_fcb_pre_erase_check(struct log *log)
+{
+    struct log_fcb_pre_erase *pe;
+    struct fcb_log *fcb_log;
+    int active;
+
+    fcb_log = log->l_arg;
+    pe = &fcb_log->fl_pre_erase;
+    if (pe->lpe_evq == NULL) {
+        return;
+    }
+
+    /* Free space only changes when the active sector does. */
+    active = log_fcb_active_sec(&fcb_log->fl_fcb);
+    if (active == pe->lpe_active) {
+        return;
+    }
+    pe->lpe_active = active;
+    pe->lpe_log = log;
+
+    if (log_fcb_pre_erase_needed(fcb_log)) {
+        os_eventq_put(pe->lpe_evq, &pe->lpe_ev);
+    }
+}
+
+void
+log_fcb_erase_done(struct log *log, uint32_t usecs)
+{
+    struct fcb_log *fcb_log;
+
+    fcb_log = log->l_arg;
+    if (fcb_log->fl_pre_erase.lpe_running &&
+        fcb_log->fl_pre_erase.lpe_task == os_sched_get_current_task()) {
+        LOG_STATS_INC(log, erase_bg);
+    } else if (usecs < 1000) {
+        LOG_STATS_INC(log, stall_lt1ms);
+    } else if (usecs < 4000) {
+        LOG_STATS_INC(log, stall_lt4ms);
+    } else if (usecs < 16000) {
+        LOG_STATS_INC(log, stall_lt16ms);
+    } else if (usecs < 64000) {
+        LOG_STATS_INC(log, stall_lt64ms);
+    } else if (usecs < 256000) {
+        LOG_STATS_INC(log, stall_lt256ms);
+    } else {
+        LOG_STATS_INC(log, stall_ge256ms);
+    }
+}
+
+#endif
@@ -0,0 +1,280 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_FCB_SECTOR_INDEX)
+
+#include "flash_map/flash_map.h"
+#include "log/log.h"
+
+static int
+log_fcb_sidx_read_hdr(const struct fcb_entry *loc, struct log_entry_hdr *hdr)
+{
+    if (loc->fe_data_len < LOG_BASE_ENTRY_HDR_SIZE) {
+        return SYS_EINVAL;
+    }
+
+    /* Index and timestamp are part of the base header. */
+    return flash_area_read(loc->fe_area, loc->fe_data_off, hdr,
+                           LOG_BASE_ENTRY_HDR_SIZE);
+}
+
+static struct log_fcb_sector_idx *
+log_fcb_sidx_get(const struct fcb_log *fcb_log, const struct flash_area *fa)
+{
+    return &fcb_log->fl_sidx[fa - fcb_log->fl_fcb.f_sectors];
+}
+
+static void
+log_fcb_sidx_add(struct log_fcb_sector_idx *sidx,
+                 const struct log_entry_hdr *hdr)
+{
+    if (!sidx->lsi_valid) {
+        sidx->lsi_first_index = hdr->ue_index;
+        sidx->lsi_first_ts = hdr->ue_ts;
+        sidx->lsi_valid = 1;
+#if MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)
+        sidx->lsi_max_level = 0;
+        sidx->lsi_modules = 0;
+#endif
+    }
+    sidx->lsi_last_index = hdr->ue_index;
+    sidx->lsi_last_ts = hdr->ue_ts;
+
+#if MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)
+    if (hdr->ue_level > sidx->lsi_max_level) {
+        sidx->lsi_max_level = hdr->ue_level;
+    }
+    sidx->lsi_modules |= (uint64_t)1 << (hdr->ue_module % 64);
+#endif
+}
+
+int
+log_fcb_init_sector_idx(struct fcb_log *fcb_log,
+                        struct log_fcb_sector_idx *buf, int count)
+{
+    if (count < fcb_log->fl_fcb.f_sector_cnt) {
+        return SYS_EINVAL;
+    }
+
+    fcb_log->fl_sidx = buf;
+    log_fcb_clear_sector_idx(fcb_log);
+
+    return 0;
+}
+
+void
+log_fcb_clear_sector_idx(struct fcb_log *fcb_log)
+{
+    if (fcb_log->fl_sidx == NULL) {
+        return;
+    }
+
+    memset(fcb_log->fl_sidx, 0,
+           fcb_log->fl_fcb.f_sector_cnt * sizeof *fcb_log->fl_sidx);
+}
+
+void
+log_fcb_build_sector_idx(struct fcb_log *fcb_log)
+{
+    struct log_fcb_sector_idx *prev;
+    struct log_fcb_sector_idx *sidx;
+    struct log_entry_hdr hdr;
+    struct flash_area *fa;
+    struct fcb_entry loc;
+    struct fcb *fcb;
+    int i;
+
+    if (fcb_log->fl_sidx == NULL) {
+        return;
+    }
+
+    log_fcb_clear_sector_idx(fcb_log);
+
+    fcb = &fcb_log->fl_fcb;
+    if (fcb->f_oldest == NULL || fcb->f_active.fe_area == NULL) {
+        return;
+    }
+
+    /*
+     * Only the first entry of each full sector is read; the start of the
+     * following sector bounds its last entry.  The active sector is scanned
+     * in full so that appends can extend it exactly.  Sector summaries need
+     * every header, so with them enabled all sectors are scanned.
+     */
+    prev = NULL;
+    fa = fcb->f_oldest;
+    while (1) {
+        memset(&loc, 0, sizeof loc);
+        loc.fe_area = fa;
+        if (fcb_getnext(fcb, &loc) == 0 && loc.fe_area == fa &&
+            log_fcb_sidx_read_hdr(&loc, &hdr) == 0) {
+
+            sidx = log_fcb_sidx_get(fcb_log, fa);
+            log_fcb_sidx_add(sidx, &hdr);
+
+            if (prev != NULL && hdr.ue_index > prev->lsi_first_index) {
+                prev->lsi_last_index = hdr.ue_index - 1;
+                prev->lsi_last_ts = hdr.ue_ts;
+            }
+
+            if (fa == fcb->f_active.fe_area ||
+                MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)) {
+
+                while (fcb_getnext(fcb, &loc) == 0 && loc.fe_area == fa) {
+                    if (log_fcb_sidx_read_hdr(&loc, &hdr) == 0) {
+                        log_fcb_sidx_add(sidx, &hdr);
+                    }
+                }
+                prev = NULL;
+            } else {
+                prev = sidx;
+            }
+        }
+
+        if (fa == fcb->f_active.fe_area) {
+            break;
+        }
+
+        i = fa - fcb->f_sectors + 1;
+        if (i >= fcb->f_sector_cnt) {
+            i = 0;
+        }
+        fa = &fcb->f_sectors[i];
+    }
+}
+
+void
+log_fcb_rotate_sector_idx(struct fcb_log *fcb_log)
+{
+    if (fcb_log->fl_sidx == NULL) {
+        return;
+    }
+
+    log_fcb_sidx_get(fcb_log, fcb_log->fl_fcb.f_oldest)->lsi_valid = 0;
+}
+
+void
+log_fcb_update_sector_idx(struct fcb_log *fcb_log,
+                          const struct fcb_entry *entry,
+                          const struct log_entry_hdr *hdr)
+{
+    struct log_fcb_sector_idx *sidx;
+
+    if (fcb_log->fl_sidx == NULL) {
+        return;
+    }
+
+    sidx = log_fcb_sidx_get(fcb_log, entry->fe_area);
+    log_fcb_sidx_add(sidx, hdr);
+}
+
+#if MYNEWT_VAL(LOG_FCB_SECTOR_SUMMARY)
+bool
+log_fcb_sector_may_match(const struct fcb_log *fcb_log,
+                         const struct flash_area *fa,
+                         const struct log_filter *filter)
+{
+    const struct log_fcb_sector_idx *sidx;
+
+    if (fcb_log->fl_sidx == NULL) {
+        return true;
+    }
+
+    /* Without a summary the sector has to be read to find out. */
+    sidx = log_fcb_sidx_get(fcb_log, fa);
+    if (!sidx->lsi_valid) {
+        return true;
+    }
+
+    if (sidx->lsi_max_level < filter->lf_min_level) {
+        return false;
+    }
+
+    if (filter->lf_module != LOG_FILTER_MODULE_ANY &&
+        !(sidx->lsi_modules & ((uint64_t)1 << (filter->lf_module % 64)))) {
+        return false;
+    }
+
+    return true;
+}
+#endif
+
+struct flash_area *
+log_fcb_find_sector(const struct fcb_log *fcb_log, uint32_t index)
+{
+    const struct log_fcb_sector_idx *sidx;
+    const struct fcb *fcb;
+    int oldest;
+    int found;
+    int count;
+    int lo;
+    int hi;
+    int mid;
+    int i;
+
+    if (fcb_log->fl_sidx == NULL) {
+        return NULL;
+    }
+
+    fcb = &fcb_log->fl_fcb;
+    if (fcb->f_oldest == NULL || fcb->f_active.fe_area == NULL) {
+        return NULL;
+    }
+
+    /*
+     * Sectors are searched by their position relative to the oldest one.
+     * First indices increase from oldest to active; a sector without
+     * entries can only be at the end of that range and is treated as if it
+     * started after every index.
+     */
+    oldest = fcb->f_oldest - fcb->f_sectors;
+    count = fcb->f_active.fe_area - fcb->f_oldest;
+    if (count < 0) {
+        count += fcb->f_sector_cnt;
+    }
+    count++;
+
+    found = -1;
+    lo = 0;
+    hi = count - 1;
+    while (lo <= hi) {
+        mid = lo + (hi - lo) / 2;
+
+        i = (oldest + mid) % fcb->f_sector_cnt;
+        sidx = &fcb_log->fl_sidx[i];
+        if (sidx->lsi_valid && sidx->lsi_first_index <= index) {
+            found = i;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    if (found < 0) {
+        return NULL;
+    }
+
+    return &fcb->f_sectors[found];
+}
+
+#endif
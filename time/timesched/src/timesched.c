@@ -154,4 +154,7 @@ timesched_init(void)
 {
     os_callout_init(&g_timesched_co, os_eventq_dflt_get(),
                     timesched_timer_co_cb, NULL);
+    os_callout_set_slack(&g_timesched_co,
+                         os_time_ms_to_ticks32(
+                             MYNEWT_VAL(TIMESCHED_WAKEUP_SLACK_MS)));
 }
@@ -103,6 +103,142 @@ int cbmem_walk(struct cbmem *cbmem, cbmem_walk_func_t walk_func, void *arg);
 
 int cbmem_flush(struct cbmem *);
 
+/*
+ * Lock-free variant.
+ *
+ * A struct cbmem_lf is a ring of variable-length entries that can be
+ * appended to from any context, including interrupt handlers, and read
+ * without taking any lock.  Each entry header carries a sequence number:
+ * the entry's position in the stream of bytes written to the ring.  Writers
+ * move the ring's tail past the oldest entries before overwriting them;
+ * readers check the tail after every read, and when they find that the data
+ * they have just read has been overwritten, they skip ahead to the tail
+ * instead.
+ *
+ * By default the ring has a single writer, which appends without any
+ * synchronization at all.  With CBMEM_LF_F_MULTI_WRITER, several tasks and
+ * interrupt handlers may append; space is then reserved in a short critical
+ * section, but the entry itself is copied in with interrupts enabled.  An
+ * append that would overwrite an entry another writer is still copying in
+ * fails with SYS_EBUSY.
+ */
+
+/** Allow appends from more than one task or interrupt handler. */
+#define CBMEM_LF_F_MULTI_WRITER     0x01
+
+struct cbmem_lf_entry_hdr {
+    /* Position of the entry in the stream; bit 0 is set while the entry is
+     * still being written.
+     */
+    uint32_t clh_seq;
+    uint16_t clh_len;
+    uint16_t clh_flags;
+};
+
+struct cbmem_lf {
+    uint8_t *cl_buf;
+    uint32_t cl_size;
+    /* Stream positions wrap at this multiple of cl_size. */
+    uint32_t cl_wrap;
+    /* Position of the oldest intact entry. */
+    uint32_t cl_tail;
+    /* Position the next entry is written at. */
+    uint32_t cl_head;
+    uint8_t cl_flags;
+};
+
+/**
+ * An entry returned by cbmem_lf_iter_next().  It only identifies the entry;
+ * the data is read with cbmem_lf_read(), which fails once the entry has been
+ * overwritten.
+ */
+struct cbmem_lf_entry {
+    uint32_t cle_seq;
+    uint16_t cle_len;
+};
+
+struct cbmem_lf_iter {
+    uint32_t cli_pos;
+    uint32_t cli_end;
+    /* Number of times the iterator was overtaken by a writer and had to skip
+     * ahead.
+     */
+    uint32_t cli_resyncs;
+};
+
+typedef int (*cbmem_lf_walk_func_t)(struct cbmem_lf *,
+                                    const struct cbmem_lf_entry *, void *arg);
+
+/**
+ * @brief Initializes a lock-free cbmem.
+ *
+ * @param cbmem                 The cbmem to initialize.
+ * @param buf                   Backing storage; any bytes needed to align it
+ *                                  to 4 bytes are left unused.
+ * @param buf_len               Size of buf, in bytes.
+ * @param flags                 0 or CBMEM_LF_F_MULTI_WRITER.
+ *
+ * @return                      0 on success; SYS_EINVAL if the buffer is too
+ *                                  small.
+ */
+int cbmem_lf_init(struct cbmem_lf *cbmem, void *buf, uint32_t buf_len,
+                  uint8_t flags);
+
+/**
+ * @brief Appends an entry, overwriting the oldest entries if necessary.
+ *
+ * @return                      0 on success;
+ *                              SYS_EINVAL if the entry can never fit;
+ *                              SYS_EBUSY if it would overwrite an entry
+ *                                  that is still being appended.
+ */
+int cbmem_lf_append(struct cbmem_lf *cbmem, const void *data, uint16_t len);
+int cbmem_lf_append_mbuf(struct cbmem_lf *cbmem, const struct os_mbuf *om);
+int cbmem_lf_append_scat_gath(struct cbmem_lf *cbmem,
+                              const struct cbmem_scat_gath *sg);
+
+void cbmem_lf_iter_start(struct cbmem_lf *cbmem, struct cbmem_lf_iter *iter);
+
+/**
+ * @brief Retrieves the next entry.
+ *
+ * Iteration stops at the entry that was the newest one when the iterator was
+ * started, or earlier at an entry that is still being appended.  If a writer
+ * has overwritten the iterator's position, it continues from the oldest
+ * intact entry and cli_resyncs is incremented.
+ *
+ * @return                      0 if an entry was retrieved; SYS_ENOENT if
+ *                                  there are no more entries.
+ */
+int cbmem_lf_iter_next(struct cbmem_lf *cbmem, struct cbmem_lf_iter *iter,
+                       struct cbmem_lf_entry *entry);
+
+/**
+ * @brief Reads data from an entry.
+ *
+ * @return                      The number of bytes read; SYS_EINVAL if off
+ *                                  is past the end of the entry; SYS_ENOENT
+ *                                  if the entry has been overwritten, in
+ *                                  which case buf contents are undefined.
+ */
+int cbmem_lf_read(struct cbmem_lf *cbmem, const struct cbmem_lf_entry *entry,
+                  void *buf, uint16_t off, uint16_t len);
+
+/**
+ * @brief Calls walk_func for every entry, oldest first, until it returns 1.
+ *
+ * @return                      The number of times the walk was overtaken
+ *                                  by a writer and skipped ahead.
+ */
+int cbmem_lf_walk(struct cbmem_lf *cbmem, cbmem_lf_walk_func_t walk_func,
+                  void *arg);
+
+/**
+ * @brief Discards every entry.  Entries that are still being appended are
+ * kept.  With a single writer, this must be called from the writer's context.
+ */
+int cbmem_lf_flush(struct cbmem_lf *cbmem);
+
 #ifdef __cplusplus
 }
 #endif
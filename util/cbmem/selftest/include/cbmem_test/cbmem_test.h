@@ -45,6 +45,11 @@ TEST_CASE_DECL(cbmem_test_case_2);
 TEST_CASE_DECL(cbmem_test_case_3);
 TEST_SUITE_DECL(cbmem_test_suite);
 
+TEST_CASE_DECL(cbmem_lf_test_wrap);
+TEST_CASE_DECL(cbmem_lf_test_resync);
+TEST_CASE_DECL(cbmem_lf_test_stress);
+TEST_SUITE_DECL(cbmem_lf_test_suite);
+
 int cbmem_test_case_1_walk(struct cbmem *cbmem,
                            struct cbmem_entry_hdr *hdr, void *arg);
 
@@ -88,9 +88,17 @@ TEST_SUITE(cbmem_test_suite)
     cbmem_test_case_3();
 }
 
+TEST_SUITE(cbmem_lf_test_suite)
+{
+    cbmem_lf_test_wrap();
+    cbmem_lf_test_resync();
+    cbmem_lf_test_stress();
+}
+
 int
 main(int argc, char **argv)
 {
     cbmem_test_suite();
+    cbmem_lf_test_suite();
     return tu_any_failed;
 }
@@ -0,0 +1,107 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cbmem_test/cbmem_test.h"
+
+/* Twelve 16-byte entries, with their 8-byte headers, fill the buffer
+ * exactly.
+ */
+#define CLTR_ENTRY_LEN      16
+#define CLTR_BUF_SIZE       (12 * (8 + CLTR_ENTRY_LEN))
+
+static void
+cltr_append(struct cbmem_lf *cbmem, int first, int count)
+{
+    uint8_t data[CLTR_ENTRY_LEN];
+    int rc;
+    int i;
+
+    for (i = first; i < first + count; i++) {
+        memset(data, i, sizeof(data));
+        rc = cbmem_lf_append(cbmem, data, sizeof(data));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+static void
+cltr_expect(struct cbmem_lf *cbmem, struct cbmem_lf_iter *iter, int val)
+{
+    struct cbmem_lf_entry entry;
+    uint8_t data[CLTR_ENTRY_LEN];
+    int rc;
+
+    rc = cbmem_lf_iter_next(cbmem, iter, &entry);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = cbmem_lf_read(cbmem, &entry, data, 0, sizeof(data));
+    TEST_ASSERT_FATAL(rc == CLTR_ENTRY_LEN);
+    TEST_ASSERT_FATAL(data[0] == val && data[CLTR_ENTRY_LEN - 1] == val,
+                      "expected entry %d, got %d", val, data[0]);
+}
+
+TEST_CASE_SELF(cbmem_lf_test_resync)
+{
+    static uint32_t buf[CLTR_BUF_SIZE / 4];
+    struct cbmem_lf_entry entry;
+    struct cbmem_lf_entry old;
+    struct cbmem_lf_iter iter;
+    struct cbmem_lf cbmem;
+    uint8_t data[CLTR_ENTRY_LEN];
+    int rc;
+    int i;
+
+    rc = cbmem_lf_init(&cbmem, buf, sizeof(buf), 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    cltr_append(&cbmem, 0, 10);
+
+    cbmem_lf_iter_start(&cbmem, &iter);
+    for (i = 0; i < 2; i++) {
+        cltr_expect(&cbmem, &iter, i);
+    }
+    rc = cbmem_lf_iter_next(&cbmem, &iter, &old);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Overwrite entries 0 to 3 while the reader holds entry 2. */
+    cltr_append(&cbmem, 10, 6);
+
+    rc = cbmem_lf_read(&cbmem, &old, data, 0, sizeof(data));
+    TEST_ASSERT_FATAL(rc == SYS_ENOENT);
+
+    /* The reader skips to the oldest entry left, and stops at the newest
+     * entry there was when it started.
+     */
+    for (i = 4; i < 10; i++) {
+        cltr_expect(&cbmem, &iter, i);
+    }
+    rc = cbmem_lf_iter_next(&cbmem, &iter, &entry);
+    TEST_ASSERT_FATAL(rc == SYS_ENOENT);
+    TEST_ASSERT_FATAL(iter.cli_resyncs == 1);
+
+    /* A reader that has been lapped completely finds nothing. */
+    cbmem_lf_iter_start(&cbmem, &iter);
+    cltr_append(&cbmem, 16, 12);
+    rc = cbmem_lf_iter_next(&cbmem, &iter, &entry);
+    TEST_ASSERT_FATAL(rc == SYS_ENOENT);
+    TEST_ASSERT_FATAL(iter.cli_resyncs == 1);
+
+    cbmem_lf_iter_start(&cbmem, &iter);
+    for (i = 16; i < 28; i++) {
+        cltr_expect(&cbmem, &iter, i);
+    }
+}
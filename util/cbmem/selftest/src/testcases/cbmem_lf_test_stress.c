@@ -0,0 +1,212 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cbmem_test/cbmem_test.h"
+
+/*
+ * Two writers, one of which preempts the other every tick, append to a small
+ * ring while a reader at the lowest priority walks it and checks every entry
+ * it manages to read before the entry is overwritten.
+ */
+
+#define CLTS_HI_PRIO            10
+#define CLTS_LO_PRIO            20
+#define CLTS_READ_PRIO          200
+
+#define CLTS_STACK_SIZE         OS_STACK_ALIGN(1024)
+
+#define CLTS_BUF_SIZE           1000
+#define CLTS_MAX_BODY           100
+#define CLTS_BURST              16
+#define CLTS_RUN_TICKS          (OS_TICKS_PER_SEC / 2)
+
+struct clts_hdr {
+    uint16_t id;
+    uint16_t len;
+    uint32_t cnt;
+};
+
+struct clts_writer {
+    struct os_task task;
+    os_stack_t stack[CLTS_STACK_SIZE];
+    uint16_t id;
+    uint32_t cnt;
+    uint32_t busy;
+};
+
+static struct clts_writer clts_writers[2];
+static struct os_task clts_read_task;
+static os_stack_t clts_read_stack[CLTS_STACK_SIZE];
+
+static struct cbmem_lf clts_cbmem;
+static uint8_t clts_buf[CLTS_BUF_SIZE];
+
+static volatile int clts_stop;
+static int clts_stopped;
+
+static uint32_t clts_reads;
+static uint32_t clts_gone;
+static uint32_t clts_resyncs;
+static uint32_t clts_bad;
+
+static uint8_t
+clts_byte(const struct clts_hdr *hdr, int off)
+{
+    return hdr->id * 31 + hdr->cnt * 7 + off;
+}
+
+static void
+clts_idle(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    clts_stopped++;
+    OS_EXIT_CRITICAL(sr);
+
+    while (1) {
+        os_time_delay(OS_TIMEOUT_NEVER);
+    }
+}
+
+static void
+clts_write_task(void *arg)
+{
+    struct clts_writer *writer;
+    struct clts_hdr hdr;
+    uint8_t data[sizeof(hdr) + CLTS_MAX_BODY];
+    int rc;
+    int i;
+    int j;
+
+    writer = arg;
+    while (!clts_stop) {
+        for (i = 0; i < CLTS_BURST; i++) {
+            hdr.id = writer->id;
+            hdr.cnt = writer->cnt;
+            hdr.len = sizeof(hdr) + (writer->cnt * 13 + i) % CLTS_MAX_BODY;
+
+            memcpy(data, &hdr, sizeof(hdr));
+            for (j = sizeof(hdr); j < hdr.len; j++) {
+                data[j] = clts_byte(&hdr, j);
+            }
+
+            rc = cbmem_lf_append(&clts_cbmem, data, hdr.len);
+            if (rc == SYS_EBUSY) {
+                writer->busy++;
+            } else {
+                TEST_ASSERT_FATAL(rc == 0);
+                writer->cnt++;
+            }
+        }
+        os_time_delay(1);
+    }
+
+    clts_idle();
+}
+
+static int
+clts_walk(struct cbmem_lf *cbmem, const struct cbmem_lf_entry *entry,
+          void *arg)
+{
+    uint8_t data[sizeof(struct clts_hdr) + CLTS_MAX_BODY];
+    struct clts_hdr hdr;
+    uint32_t *last;
+    int rc;
+    int i;
+
+    last = arg;
+
+    rc = cbmem_lf_read(cbmem, entry, data, 0, sizeof(data));
+    if (rc == SYS_ENOENT) {
+        clts_gone++;
+        return 0;
+    }
+    clts_reads++;
+
+    memcpy(&hdr, data, sizeof(hdr));
+    if (rc != entry->cle_len || hdr.len != rc || hdr.id > 1) {
+        clts_bad++;
+        return 0;
+    }
+    for (i = sizeof(hdr); i < hdr.len; i++) {
+        if (data[i] != clts_byte(&hdr, i)) {
+            clts_bad++;
+            return 0;
+        }
+    }
+
+    /* Each writer's entries come out in the order they were appended. */
+    if (last[hdr.id] != UINT32_MAX && hdr.cnt <= last[hdr.id]) {
+        clts_bad++;
+    }
+    last[hdr.id] = hdr.cnt;
+
+    return 0;
+}
+
+static void
+clts_read_task_handler(void *arg)
+{
+    uint32_t last[2];
+
+    while (!clts_stop) {
+        last[0] = UINT32_MAX;
+        last[1] = UINT32_MAX;
+        clts_resyncs += cbmem_lf_walk(&clts_cbmem, clts_walk, last);
+    }
+
+    clts_idle();
+}
+
+TEST_CASE_TASK(cbmem_lf_test_stress)
+{
+    uint8_t prios[2] = { CLTS_HI_PRIO, CLTS_LO_PRIO };
+    int rc;
+    int i;
+
+    rc = cbmem_lf_init(&clts_cbmem, clts_buf, sizeof(clts_buf),
+                       CBMEM_LF_F_MULTI_WRITER);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < 2; i++) {
+        clts_writers[i].id = i;
+        rc = os_task_init(&clts_writers[i].task, "clts_write",
+                          clts_write_task, &clts_writers[i], prios[i],
+                          OS_WAIT_FOREVER, clts_writers[i].stack,
+                          CLTS_STACK_SIZE);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rc = os_task_init(&clts_read_task, "clts_read", clts_read_task_handler,
+                      NULL, CLTS_READ_PRIO, OS_WAIT_FOREVER, clts_read_stack,
+                      CLTS_STACK_SIZE);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    os_time_delay(CLTS_RUN_TICKS);
+
+    clts_stop = 1;
+    while (clts_stopped < 3) {
+        os_time_delay(1);
+    }
+
+    TEST_ASSERT(clts_bad == 0, "%u of %u entries read were corrupt",
+                (unsigned)clts_bad, (unsigned)clts_reads);
+    TEST_ASSERT(clts_reads > 0);
+    TEST_ASSERT(clts_writers[0].cnt > 0 && clts_writers[1].cnt > 0);
+}
@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cbmem_test/cbmem_test.h"
+
+#define CLTW_BUF_SIZE       250
+#define CLTW_ENTRY_COUNT    200
+
+static int
+cltw_entry_len(uint8_t val)
+{
+    return 1 + val % 23;
+}
+
+static int
+cltw_walk(struct cbmem_lf *cbmem, const struct cbmem_lf_entry *entry,
+          void *arg)
+{
+    uint8_t buf[32];
+    int *count;
+    int rc;
+    int i;
+
+    count = arg;
+
+    rc = cbmem_lf_read(cbmem, entry, buf, 0, sizeof(buf));
+    TEST_ASSERT_FATAL(rc == entry->cle_len);
+    TEST_ASSERT_FATAL(rc == cltw_entry_len(buf[0]));
+    for (i = 1; i < rc; i++) {
+        TEST_ASSERT_FATAL(buf[i] == buf[0]);
+    }
+
+    /* Entries come out oldest first, and the newest one is the last one
+     * appended.
+     */
+    TEST_ASSERT_FATAL(buf[0] == CLTW_ENTRY_COUNT - *count);
+    *count -= 1;
+
+    return 0;
+}
+
+TEST_CASE_SELF(cbmem_lf_test_wrap)
+{
+    static uint8_t buf[CLTW_BUF_SIZE];
+    struct cbmem_lf_entry entry;
+    struct cbmem_lf_iter iter;
+    struct cbmem_lf cbmem;
+    uint8_t data[32];
+    int count;
+    int rc;
+    int i;
+
+    rc = cbmem_lf_init(&cbmem, buf, sizeof(buf), 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Entries of every length from 1 to 23 bytes; the buffer wraps at every
+     * possible offset.
+     */
+    for (i = 0; i < CLTW_ENTRY_COUNT; i++) {
+        memset(data, i, sizeof(data));
+        rc = cbmem_lf_append(&cbmem, data, cltw_entry_len(i));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    count = 0;
+    cbmem_lf_iter_start(&cbmem, &iter);
+    while (cbmem_lf_iter_next(&cbmem, &iter, &entry) == 0) {
+        count++;
+    }
+    TEST_ASSERT_FATAL(iter.cli_resyncs == 0);
+    TEST_ASSERT_FATAL(count > CLTW_BUF_SIZE / (8 + 24));
+
+    rc = cbmem_lf_walk(&cbmem, cltw_walk, &count);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(count == 0);
+
+    /* Too big to ever fit. */
+    rc = cbmem_lf_append(&cbmem, buf, CLTW_BUF_SIZE);
+    TEST_ASSERT_FATAL(rc == SYS_EINVAL);
+
+    rc = cbmem_lf_flush(&cbmem);
+    TEST_ASSERT_FATAL(rc == 0);
+    cbmem_lf_iter_start(&cbmem, &iter);
+    rc = cbmem_lf_iter_next(&cbmem, &iter, &entry);
+    TEST_ASSERT_FATAL(rc == SYS_ENOENT);
+
+    memset(data, 7, sizeof(data));
+    rc = cbmem_lf_append(&cbmem, data, cltw_entry_len(7));
+    TEST_ASSERT_FATAL(rc == 0);
+    cbmem_lf_iter_start(&cbmem, &iter);
+    rc = cbmem_lf_iter_next(&cbmem, &iter, &entry);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(entry.cle_len == cltw_entry_len(7));
+    rc = cbmem_lf_iter_next(&cbmem, &iter, &entry);
+    TEST_ASSERT_FATAL(rc == SYS_ENOENT);
+}
@@ -0,0 +1,456 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "cbmem/cbmem.h"
+
+/*
+ * Entries start on a 4-byte boundary.  An entry that does not fit before the
+ * end of the buffer starts over at the beginning; the space it skips is
+ * covered by a padding entry, or left implicit if it is too short to hold a
+ * header.
+ *
+ * Stream positions only ever grow (modulo cl_wrap), so a position identifies
+ * an entry for as long as it is in the buffer.  An entry is intact if the
+ * tail has not moved past its position.  Writers store the new tail before
+ * they overwrite anything, and readers check the tail after they have read;
+ * the fences in between make sure a reader that saw overwritten data also
+ * sees the tail that was moved past it.  Positions are compared modulo
+ * cl_wrap, so a reader cannot tell once it has fallen more than half of that
+ * (at least 2 GB of appends) behind.
+ */
+
+#define CBMEM_LF_HDR_SIZE       ((uint32_t)sizeof(struct cbmem_lf_entry_hdr))
+#define CBMEM_LF_ALIGN(n)       (((n) + 3) & ~3)
+
+#define CBMEM_LF_SEQ_BUSY       0x01
+
+#define CBMEM_LF_F_PAD          0x0001
+
+typedef void (cbmem_lf_copy_func_t)(void *dst, const void *data, uint16_t len);
+
+static uint32_t
+cbmem_lf_pos_add(const struct cbmem_lf *cbmem, uint32_t pos, uint32_t n)
+{
+    if (n >= cbmem->cl_wrap - pos) {
+        return n - (cbmem->cl_wrap - pos);
+    }
+    return pos + n;
+}
+
+/**
+ * Number of bytes from one position to a later one.
+ */
+static uint32_t
+cbmem_lf_pos_dist(const struct cbmem_lf *cbmem, uint32_t from, uint32_t to)
+{
+    if (to >= from) {
+        return to - from;
+    }
+    return cbmem->cl_wrap - from + to;
+}
+
+/**
+ * Indicates whether position a comes strictly before position b.
+ */
+static int
+cbmem_lf_pos_before(const struct cbmem_lf *cbmem, uint32_t a, uint32_t b)
+{
+    uint32_t dist;
+
+    dist = cbmem_lf_pos_dist(cbmem, a, b);
+    return dist != 0 && dist < cbmem->cl_wrap / 2;
+}
+
+/**
+ * If there is no room for an entry header between a position and the end of
+ * the buffer, returns the position of the start of the buffer instead.
+ */
+static uint32_t
+cbmem_lf_pos_skip(const struct cbmem_lf *cbmem, uint32_t pos)
+{
+    uint32_t left;
+
+    left = cbmem->cl_size - pos % cbmem->cl_size;
+    if (left < CBMEM_LF_HDR_SIZE) {
+        pos = cbmem_lf_pos_add(cbmem, pos, left);
+    }
+    return pos;
+}
+
+static struct cbmem_lf_entry_hdr *
+cbmem_lf_hdr(const struct cbmem_lf *cbmem, uint32_t pos)
+{
+    return (struct cbmem_lf_entry_hdr *)(cbmem->cl_buf + pos % cbmem->cl_size);
+}
+
+static uint32_t
+cbmem_lf_tail_load(const struct cbmem_lf *cbmem)
+{
+    return __atomic_load_n(&cbmem->cl_tail, __ATOMIC_ACQUIRE);
+}
+
+int
+cbmem_lf_init(struct cbmem_lf *cbmem, void *buf, uint32_t buf_len,
+              uint8_t flags)
+{
+    uintptr_t start;
+    uint32_t skip;
+
+    memset(cbmem, 0, sizeof(*cbmem));
+
+    start = (uintptr_t)buf;
+    skip = CBMEM_LF_ALIGN(start) - start;
+    if (buf_len < skip + 2 * CBMEM_LF_HDR_SIZE) {
+        return SYS_EINVAL;
+    }
+
+    cbmem->cl_buf = (uint8_t *)buf + skip;
+    cbmem->cl_size = (buf_len - skip) & ~3;
+    cbmem->cl_wrap = (UINT32_MAX / cbmem->cl_size) * cbmem->cl_size;
+    cbmem->cl_flags = flags;
+
+    return 0;
+}
+
+/**
+ * Reserves space for an entry of the given length and writes its header,
+ * marked as busy.  Must be called from a critical section if the cbmem has
+ * more than one writer.
+ */
+static int
+cbmem_lf_reserve(struct cbmem_lf *cbmem, uint16_t len, uint32_t *out_pos)
+{
+    struct cbmem_lf_entry_hdr *hdr;
+    uint32_t new_head;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t need;
+    uint32_t pad;
+    uint32_t off;
+    uint32_t pos;
+
+    need = CBMEM_LF_ALIGN(CBMEM_LF_HDR_SIZE + len);
+    if (need > cbmem->cl_size) {
+        return SYS_EINVAL;
+    }
+
+    head = cbmem->cl_head;
+    off = head % cbmem->cl_size;
+    pad = 0;
+    if (off + need > cbmem->cl_size) {
+        pad = cbmem->cl_size - off;
+    }
+    pos = cbmem_lf_pos_add(cbmem, head, pad);
+    new_head = cbmem_lf_pos_add(cbmem, pos, need);
+
+    /* Find the oldest entry that survives this one. */
+    tail = cbmem->cl_tail;
+    while (cbmem_lf_pos_dist(cbmem, tail, new_head) > cbmem->cl_size) {
+        if (tail == head) {
+            /* Everything is gone, including what the padding covers. */
+            tail = pos;
+            break;
+        }
+
+        tail = cbmem_lf_pos_skip(cbmem, tail);
+        if (tail == head) {
+            continue;
+        }
+
+        hdr = cbmem_lf_hdr(cbmem, tail);
+        if (hdr->clh_seq != tail) {
+            /* Another writer has not finished with this entry yet. */
+            return SYS_EBUSY;
+        }
+        tail = cbmem_lf_pos_add(cbmem, tail,
+                                CBMEM_LF_ALIGN(CBMEM_LF_HDR_SIZE +
+                                               hdr->clh_len));
+    }
+
+    if (tail != cbmem->cl_tail) {
+        __atomic_store_n(&cbmem->cl_tail, tail, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    if (pad >= CBMEM_LF_HDR_SIZE) {
+        hdr = cbmem_lf_hdr(cbmem, head);
+        hdr->clh_len = pad - CBMEM_LF_HDR_SIZE;
+        hdr->clh_flags = CBMEM_LF_F_PAD;
+        hdr->clh_seq = head;
+    }
+
+    hdr = cbmem_lf_hdr(cbmem, pos);
+    hdr->clh_len = len;
+    hdr->clh_flags = 0;
+    hdr->clh_seq = pos | CBMEM_LF_SEQ_BUSY;
+
+    __atomic_store_n(&cbmem->cl_head, new_head, __ATOMIC_RELEASE);
+
+    *out_pos = pos;
+    return 0;
+}
+
+static int
+cbmem_lf_append_internal(struct cbmem_lf *cbmem, const void *data,
+                         uint16_t len, cbmem_lf_copy_func_t *copy_func)
+{
+    struct cbmem_lf_entry_hdr *hdr;
+    uint32_t pos;
+    os_sr_t sr;
+    int rc;
+
+    if (cbmem->cl_flags & CBMEM_LF_F_MULTI_WRITER) {
+        OS_ENTER_CRITICAL(sr);
+        rc = cbmem_lf_reserve(cbmem, len, &pos);
+        OS_EXIT_CRITICAL(sr);
+    } else {
+        rc = cbmem_lf_reserve(cbmem, len, &pos);
+    }
+    if (rc != 0) {
+        return rc;
+    }
+
+    hdr = cbmem_lf_hdr(cbmem, pos);
+    copy_func(hdr + 1, data, len);
+
+    /* Publish the entry. */
+    __atomic_store_n(&hdr->clh_seq, pos, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+static void
+cbmem_lf_copy_flat(void *dst, const void *data, uint16_t len)
+{
+    memcpy(dst, data, len);
+}
+
+static void
+cbmem_lf_copy_mbuf(void *dst, const void *data, uint16_t len)
+{
+    os_mbuf_copydata(data, 0, len, dst);
+}
+
+static uint16_t
+cbmem_lf_scat_gath_entry_len(const struct cbmem_scat_gath_entry *entry)
+{
+    if (entry->om != NULL) {
+        return os_mbuf_len(entry->om);
+    } else {
+        return entry->flat_len;
+    }
+}
+
+static void
+cbmem_lf_copy_scat_gath(void *dst, const void *data, uint16_t len)
+{
+    const struct cbmem_scat_gath_entry *entry;
+    const struct cbmem_scat_gath *sg;
+    uint16_t entry_len;
+    uint8_t *u8p;
+    int i;
+
+    u8p = dst;
+
+    sg = data;
+    for (i = 0; i < sg->count; i++) {
+        entry = sg->entries + i;
+
+        entry_len = cbmem_lf_scat_gath_entry_len(entry);
+        if (entry->om != NULL) {
+            os_mbuf_copydata(entry->om, 0, entry_len, u8p);
+        } else {
+            memcpy(u8p, entry->flat_buf, entry_len);
+        }
+
+        u8p += entry_len;
+    }
+}
+
+int
+cbmem_lf_append(struct cbmem_lf *cbmem, const void *data, uint16_t len)
+{
+    return cbmem_lf_append_internal(cbmem, data, len, cbmem_lf_copy_flat);
+}
+
+int
+cbmem_lf_append_mbuf(struct cbmem_lf *cbmem, const struct os_mbuf *om)
+{
+    return cbmem_lf_append_internal(cbmem, om, os_mbuf_len(om),
+                                    cbmem_lf_copy_mbuf);
+}
+
+int
+cbmem_lf_append_scat_gath(struct cbmem_lf *cbmem,
+                          const struct cbmem_scat_gath *sg)
+{
+    uint16_t len;
+    int i;
+
+    len = 0;
+    for (i = 0; i < sg->count; i++) {
+        len += cbmem_lf_scat_gath_entry_len(sg->entries + i);
+    }
+
+    return cbmem_lf_append_internal(cbmem, sg, len, cbmem_lf_copy_scat_gath);
+}
+
+void
+cbmem_lf_iter_start(struct cbmem_lf *cbmem, struct cbmem_lf_iter *iter)
+{
+    iter->cli_end = __atomic_load_n(&cbmem->cl_head, __ATOMIC_ACQUIRE);
+    iter->cli_pos = cbmem_lf_tail_load(cbmem);
+    iter->cli_resyncs = 0;
+}
+
+int
+cbmem_lf_iter_next(struct cbmem_lf *cbmem, struct cbmem_lf_iter *iter,
+                   struct cbmem_lf_entry *entry)
+{
+    const struct cbmem_lf_entry_hdr *hdr;
+    uint32_t tail;
+    uint32_t seq;
+    uint32_t pos;
+    uint16_t flags;
+    uint16_t len;
+
+    pos = iter->cli_pos;
+    while (1) {
+        tail = cbmem_lf_tail_load(cbmem);
+        if (cbmem_lf_pos_before(cbmem, pos, tail)) {
+            pos = tail;
+            iter->cli_resyncs++;
+        }
+
+        pos = cbmem_lf_pos_skip(cbmem, pos);
+        if (!cbmem_lf_pos_before(cbmem, pos, iter->cli_end)) {
+            break;
+        }
+
+        hdr = cbmem_lf_hdr(cbmem, pos);
+        seq = __atomic_load_n(&hdr->clh_seq, __ATOMIC_ACQUIRE);
+        len = hdr->clh_len;
+        flags = hdr->clh_flags;
+
+        /* If the header has been overwritten while it was being read, the
+         * tail has moved past it; start over from the new tail.
+         */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (cbmem_lf_pos_before(cbmem, pos, cbmem_lf_tail_load(cbmem))) {
+            continue;
+        }
+
+        if (seq != pos) {
+            /* Still being written. */
+            break;
+        }
+
+        iter->cli_pos = cbmem_lf_pos_add(cbmem, pos,
+                                         CBMEM_LF_ALIGN(CBMEM_LF_HDR_SIZE +
+                                                        len));
+        if (flags & CBMEM_LF_F_PAD) {
+            pos = iter->cli_pos;
+            continue;
+        }
+
+        entry->cle_seq = seq;
+        entry->cle_len = len;
+        return 0;
+    }
+
+    iter->cli_pos = pos;
+    return SYS_ENOENT;
+}
+
+int
+cbmem_lf_read(struct cbmem_lf *cbmem, const struct cbmem_lf_entry *entry,
+              void *buf, uint16_t off, uint16_t len)
+{
+    const struct cbmem_lf_entry_hdr *hdr;
+
+    if (off > entry->cle_len) {
+        return SYS_EINVAL;
+    }
+    if (len > entry->cle_len - off) {
+        len = entry->cle_len - off;
+    }
+
+    hdr = cbmem_lf_hdr(cbmem, entry->cle_seq);
+    memcpy(buf, (const uint8_t *)(hdr + 1) + off, len);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (cbmem_lf_pos_before(cbmem, entry->cle_seq,
+                            cbmem_lf_tail_load(cbmem))) {
+        return SYS_ENOENT;
+    }
+
+    return len;
+}
+
+int
+cbmem_lf_walk(struct cbmem_lf *cbmem, cbmem_lf_walk_func_t walk_func,
+              void *arg)
+{
+    struct cbmem_lf_entry entry;
+    struct cbmem_lf_iter iter;
+
+    cbmem_lf_iter_start(cbmem, &iter);
+    while (cbmem_lf_iter_next(cbmem, &iter, &entry) == 0) {
+        if (walk_func(cbmem, &entry, arg) == 1) {
+            break;
+        }
+    }
+
+    return iter.cli_resyncs;
+}
+
+int
+cbmem_lf_flush(struct cbmem_lf *cbmem)
+{
+    struct cbmem_lf_entry_hdr *hdr;
+    uint32_t tail;
+    uint32_t head;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+
+    head = cbmem->cl_head;
+    tail = cbmem->cl_tail;
+    while (cbmem_lf_pos_before(cbmem, tail, head)) {
+        tail = cbmem_lf_pos_skip(cbmem, tail);
+        if (tail == head) {
+            break;
+        }
+
+        hdr = cbmem_lf_hdr(cbmem, tail);
+        if (hdr->clh_seq != tail) {
+            break;
+        }
+        tail = cbmem_lf_pos_add(cbmem, tail,
+                                CBMEM_LF_ALIGN(CBMEM_LF_HDR_SIZE +
+                                               hdr->clh_len));
+    }
+    __atomic_store_n(&cbmem->cl_tail, tail, __ATOMIC_RELEASE);
+
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}